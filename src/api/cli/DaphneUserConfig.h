@@ -18,12 +18,15 @@
 #pragma once
 
 #include <runtime/local/vectorized/LoadPartitioning.h>
+#include <runtime/local/vectorized/TaskQueueType.h>
 
 #include <vector>
 #include <string>
 #include <memory>
 #include <vector>
 
+class Profiler;
+
 /*
  * Container to pass around user configuration
  */
@@ -35,6 +38,11 @@ struct DaphneUserConfig {
     bool use_obj_ref_mgnt = true;
     bool cuda_fuse_any = false;
     bool vectorized_single_queue = false;
+    // Evaluate chains of elementwise operations in vectorized pipelines by a
+    // single fused kernel.
+    bool use_ew_fusion = true;
+    // Let kernels write their results to arguments that are not used anymore.
+    bool update_in_place = true;
 
     bool debug_llvm = false;
     bool explain_kernels = false;
@@ -47,6 +55,24 @@ struct DaphneUserConfig {
     SelfSchedulingScheme taskPartitioningScheme = STATIC;
     int numberOfThreads = -1;
     int minimumTaskSize = 1;
+    TaskQueueType taskQueueType = TaskQueueType::BLOCKING;
+    bool numaAware = false;
+
+    // Optimization levels (0-3) of the JIT compiler for the generated code
+    // and for the (hot) bodies of vectorized pipelines in particular.
+    int jit_opt_level = 0;
+    int jit_vectorized_opt_level = 2;
+    // Directory of the persistent cache of compiled modules (disabled if empty).
+    std::string jit_cache_dir;
+    // Profiling of the kernels and vectorized tasks, reported at exit.
+    bool enable_profiling = false;
+    std::string profiling_trace_file = "daphne-profile.json";
+    // The profiler, created if profiling is enabled (not a JSON parameter).
+    std::shared_ptr<Profiler> profiler;
+    // Megabytes of freed data object buffers kept for reuse (0 disables the
+    // buffer pool), and whether large buffers are backed by huge pages.
+    size_t buffer_pool_size = 1024;
+    bool use_huge_pages = false;
     
 #ifdef USE_CUDA
     // User config holds once context atm for convenience until we have proper system infrastructure
@@ -21,6 +21,7 @@
 #include <runtime/local/vectorized/LoadPartitioning.h>
 #include <compiler/execution/DaphneIrExecutor.h>
 #include <parser/config/ConfigParser.h>
+#include <runtime/local/instrumentation/Profiler.h>
 
 #include "mlir/ExecutionEngine/ExecutionEngine.h"
 #include "mlir/IR/Builders.h"
@@ -33,6 +34,7 @@
 #endif
 
 #include <exception>
+#include <fstream>
 #include <iostream>
 #include <string>
 #include <unordered_map>
@@ -91,7 +93,9 @@ main(int argc, char** argv)
                 clEnumVal(PLS, "Performance loop-based self-scheduling"),
                 clEnumVal(MSTATIC, "Modified version of Static, i.e., instead of n/p, it uses n/(4*p) where n is number of tasks and p is number of threads"),
                 clEnumVal(MFSC, "Modified version of fixed size chunk self-scheduling, i.e., MFSC does not require profiling information as FSC"),
-                clEnumVal(PSS, "Probabilistic self-scheduling")
+                clEnumVal(PSS, "Probabilistic self-scheduling"),
+                clEnumVal(AWF, "Adaptive weighted factoring, i.e., chunks are weighted by the measured speed of the workers"),
+                clEnumVal(AF, "Adaptive factoring, i.e., chunks are sized by the measured mean and variance of the task execution times")
             )
     );
 
@@ -108,13 +112,43 @@ main(int argc, char** argv)
                 "Define the minimum grain size of a task (default is 1)"
             )
     );
+    opt<TaskQueueType> taskQueueType(
+            "task-queue", cat(daphneOptions),
+            desc("Choose the task queue implementation of the vectorized execution engine:"),
+            values(
+                clEnumValN(TaskQueueType::BLOCKING, "blocking", "Mutex-protected queue (default)"),
+                clEnumValN(TaskQueueType::LOCKFREE, "lockfree", "Lock-free bounded MPMC ring buffer")
+            ),
+            llvm::cl::init(TaskQueueType::BLOCKING)
+    );
+    opt<bool> numaAware(
+            "numa", cat(daphneOptions),
+            desc(
+                "Pin the worker threads of the vectorized execution engine to NUMA nodes, use one task queue per "
+                "node and place the outputs on the nodes producing them"
+            )
+    );
     opt<bool> useVectorizedPipelines(
             "vec", cat(daphneOptions),
             desc("Enable vectorized execution engine")
     );
+    opt<bool> noEwFusion(
+            "no-ew-fusion", cat(daphneOptions),
+            desc(
+                "Lower each elementwise operation in a vectorized pipeline to a separate kernel call instead of "
+                "fusing chains of them into a single kernel"
+            )
+    );
     
     // Other options
     
+    opt<bool> noUpdateInPlace(
+            "no-update-in-place", cat(daphneOptions),
+            desc(
+                    "Always allocate new results instead of letting kernels overwrite arguments that are not used "
+                    "anymore"
+            )
+    );
     opt<bool> noObjRefMgnt(
             "no-obj-ref-mgnt", cat(daphneOptions),
             desc(
@@ -138,6 +172,49 @@ main(int argc, char** argv)
             "explain-kernels", cat(daphneOptions),
             desc("Show DaphneIR after lowering to kernel calls")
     );
+    opt<int> jitOptLevel(
+            "jit-opt", cat(daphneOptions),
+            desc("Optimization level (0-3) of the JIT compiler (default is 0)")
+    );
+    opt<int> jitVectorizedOptLevel(
+            "jit-vec-opt", cat(daphneOptions),
+            desc(
+                    "Optimization level (0-3) of the JIT compiler for the bodies of vectorized pipelines "
+                    "(default is 2)"
+            )
+    );
+    opt<string> jitCacheDir(
+            "jit-cache", cat(daphneOptions),
+            desc(
+                    "A directory for caching compiled modules, such that repeated runs of the same script "
+                    "skip their optimization"
+            ),
+            value_desc("directory")
+    );
+    opt<bool> profile(
+            "profile", cat(daphneOptions),
+            desc(
+                    "Profile the kernels and vectorized tasks; print a summary and write a Chrome trace "
+                    "(see --profile-trace) at exit"
+            )
+    );
+    opt<string> profileTrace(
+            "profile-trace", cat(daphneOptions),
+            desc("The file to write the Chrome trace of --profile to (default is daphne-profile.json)"),
+            value_desc("filename")
+    );
+    opt<size_t> bufferPoolSize(
+            "buffer-pool", cat(daphneOptions),
+            desc(
+                    "Megabytes of freed data object buffers kept for reuse by new data objects (default is 1024, "
+                    "0 disables the buffer pool)"
+            ),
+            value_desc("MB")
+    );
+    opt<bool> hugePages(
+            "huge-pages", cat(daphneOptions),
+            desc("Back large data object buffers by transparent huge pages")
+    );
     opt<bool> cuda(
             "cuda", cat(daphneOptions),
             desc("Use CUDA")
@@ -210,6 +287,30 @@ main(int argc, char** argv)
     user_config.taskPartitioningScheme = taskPartitioningScheme;
     user_config.numberOfThreads = numberOfThreads;
     user_config.minimumTaskSize = minimumTaskSize;
+    if(taskQueueType.getNumOccurrences())
+        user_config.taskQueueType = taskQueueType;
+    if(numaAware)
+        user_config.numaAware = true;
+    if(noEwFusion)
+        user_config.use_ew_fusion = false;
+    if(noUpdateInPlace)
+        user_config.update_in_place = false;
+    if(jitOptLevel.getNumOccurrences())
+        user_config.jit_opt_level = jitOptLevel;
+    if(jitVectorizedOptLevel.getNumOccurrences())
+        user_config.jit_vectorized_opt_level = jitVectorizedOptLevel;
+    if(jitCacheDir.getNumOccurrences())
+        user_config.jit_cache_dir = jitCacheDir;
+    if(profile)
+        user_config.enable_profiling = true;
+    if(profileTrace.getNumOccurrences())
+        user_config.profiling_trace_file = profileTrace;
+    if(user_config.enable_profiling)
+        user_config.profiler = std::make_shared<Profiler>();
+    if(bufferPoolSize.getNumOccurrences())
+        user_config.buffer_pool_size = bufferPoolSize;
+    if(hugePages)
+        user_config.use_huge_pages = true;
 
     if(cuda) {
         int device_count = 0;
@@ -292,5 +393,18 @@ main(int argc, char** argv)
         return StatusCode::EXECUTION_ERROR;
     }
 
+    // Report the profile (all profiled code has finished by now).
+    if(user_config.profiler) {
+        user_config.profiler->printSummary(std::cerr);
+        std::ofstream traceFile(user_config.profiling_trace_file);
+        if(traceFile) {
+            user_config.profiler->writeChromeTrace(traceFile);
+            std::cerr << "Chrome trace written to " << user_config.profiling_trace_file << std::endl;
+        }
+        else
+            std::cerr << "WARNING: could not write the Chrome trace to " << user_config.profiling_trace_file
+                      << std::endl;
+    }
+
     return StatusCode::SUCCESS;
 }
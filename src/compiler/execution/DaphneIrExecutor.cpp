@@ -18,7 +18,21 @@
 #include <ir/daphneir/Passes.h>
 #include "DaphneIrExecutor.h"
 
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/ExecutionEngine/Orc/Core.h"
+#include "llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/xxhash.h"
+#include "llvm/Target/TargetMachine.h"
 #include "mlir/Conversion/SCFToStandard/SCFToStandard.h"
 #include "mlir/Dialect/SCF/SCF.h"
 #include "mlir/Dialect/StandardOps/IR/Ops.h"
@@ -31,10 +45,127 @@
 #include <mlir/Dialect/LLVMIR/LLVMDialect.h>
 #include "mlir/Support/LogicalResult.h"
 #include "mlir/Target/LLVMIR/Dialect/LLVMIR/LLVMToLLVMIRTranslation.h"
+#include "mlir/Target/LLVMIR/Export.h"
 
+#include <algorithm>
 #include <memory>
+#include <stdexcept>
+#include <string>
 #include <utility>
 
+namespace {
+    /**
+     * @brief The symbol through which the generated code refers to the user
+     * configuration.
+     */
+    const char * const USER_CONFIG_SYMBOL = "_daphne_user_config";
+
+    /**
+     * @brief Whether the given function is the body of a vectorized pipeline
+     * (see the lowering of `VectorizedPipelineOp`).
+     */
+    bool isVectorizedPipelineBody(const llvm::Function & f)
+    {
+        return f.getName().startswith("_vect");
+    }
+
+    /**
+     * @brief Replaces the address of the user configuration, which is embedded
+     * as a constant (see `InsertDaphneContextPass`), by the address of an
+     * external symbol the JIT binds to it.
+     *
+     * Thereby, the module does not depend on where the configuration lives in
+     * this process, such that it can be cached across runs. The semantics do
+     * not change, even if some other constant happens to have the same value.
+     */
+    void externalizeUserConfig(llvm::Module & module, uint64_t address)
+    {
+        auto * i64Ty = llvm::Type::getInt64Ty(module.getContext());
+        llvm::Constant * symbolAddress = nullptr;
+        for(auto & f : module)
+            for(auto & bb : f)
+                for(auto & inst : bb) {
+                    // the case values of a switch must stay constant integers
+                    if(llvm::isa<llvm::SwitchInst>(inst))
+                        continue;
+                    for(auto & operand : inst.operands()) {
+                        auto * c = llvm::dyn_cast<llvm::ConstantInt>(operand.get());
+                        if(!c || c->getType() != i64Ty || c->getZExtValue() != address)
+                            continue;
+                        if(!symbolAddress) {
+                            auto * symbol = new llvm::GlobalVariable(
+                                    module, llvm::Type::getInt8Ty(module.getContext()), true,
+                                    llvm::GlobalValue::ExternalLinkage, nullptr, USER_CONFIG_SYMBOL
+                            );
+                            symbolAddress = llvm::ConstantExpr::getPtrToInt(symbol, i64Ty);
+                        }
+                        operand.set(symbolAddress);
+                    }
+                }
+    }
+
+    /**
+     * @brief The name of the file caching the optimized form of the given
+     * module, which identifies the module as well as everything influencing
+     * its optimization.
+     */
+    std::string getCacheFileName(const llvm::Module & module, const llvm::TargetMachine & tm,
+                                 int optLevel, int vectorizedOptLevel)
+    {
+        std::string key;
+        llvm::raw_string_ostream keyStream(key);
+        keyStream << LLVM_VERSION_STRING << ' ' << tm.getTargetTriple().str() << ' '
+                  << tm.getTargetCPU() << ' ' << tm.getTargetFeatureString() << ' '
+                  << optLevel << ' ' << vectorizedOptLevel << '\n';
+        module.print(keyStream, nullptr);
+        keyStream.flush();
+
+        std::string fileName;
+        llvm::raw_string_ostream fileNameStream(fileName);
+        fileNameStream << llvm::format_hex_no_prefix(llvm::xxHash64(key), 16) << ".bc";
+        return fileNameStream.str();
+    }
+
+    std::unique_ptr<llvm::Module> readCachedModule(const std::string & path, llvm::LLVMContext & llvmContext)
+    {
+        auto buffer = llvm::MemoryBuffer::getFile(path);
+        if(!buffer)
+            return nullptr;
+        auto module = llvm::parseBitcodeFile((*buffer)->getMemBufferRef(), llvmContext);
+        if(!module) {
+            // e.g., a file truncated by a full disk, just compile again
+            llvm::consumeError(module.takeError());
+            return nullptr;
+        }
+        return std::move(*module);
+    }
+
+    /**
+     * @brief Writes the given module to the cache, such that concurrent runs
+     * never see a partially written file.
+     */
+    void writeCachedModule(const llvm::Module & module, const std::string & dir, const std::string & path)
+    {
+        if(llvm::sys::fs::create_directories(dir))
+            return;
+        int fd;
+        llvm::SmallString<128> tmpPath;
+        if(llvm::sys::fs::createUniqueFile(dir + "/%%%%%%%%.tmp", fd, tmpPath))
+            return;
+        {
+            llvm::raw_fd_ostream os(fd, true);
+            llvm::WriteBitcodeToFile(module, os);
+            if(os.has_error()) {
+                os.clear_error();
+                llvm::sys::fs::remove(tmpPath);
+                return;
+            }
+        }
+        if(llvm::sys::fs::rename(tmpPath, path))
+            llvm::sys::fs::remove(tmpPath);
+    }
+}
+
 DaphneIrExecutor::DaphneIrExecutor(bool distributed,
                                    bool selectMatrixRepresentations,
                                    DaphneUserConfig cfg)
@@ -128,13 +259,18 @@ bool DaphneIrExecutor::runPasses(mlir::ModuleOp module)
             pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createMarkCUDAOpsPass(userConfig_));
 #endif
 
+        if(userConfig_.use_vectorized_exec && userConfig_.use_ew_fusion)
+            pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createFuseEwOpsPass());
+
         if(userConfig_.use_obj_ref_mgnt)
             pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createManageObjRefsPass());
         if(userConfig_.explain_obj_ref_mgnt)
             pm.addPass(mlir::daphne::createPrintIRPass("IR after managing object references"));
 
         pm.addPass(mlir::createCSEPass());
-        pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createRewriteToCallKernelOpPass());
+        pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createRewriteToCallKernelOpPass(userConfig_));
+        if(userConfig_.use_obj_ref_mgnt && userConfig_.update_in_place)
+            pm.addNestedPass<mlir::FuncOp>(mlir::daphne::createUpdateInPlacePass());
         if(userConfig_.explain_kernels)
             pm.addPass(mlir::daphne::createPrintIRPass("IR after kernel lowering"));
 
@@ -156,8 +292,69 @@ bool DaphneIrExecutor::runPasses(mlir::ModuleOp module)
 std::unique_ptr<mlir::ExecutionEngine> DaphneIrExecutor::createExecutionEngine(mlir::ModuleOp module)
 {
     if (module) {
-        // An optimization pipeline to use within the execution engine.
-        auto optPipeline = mlir::makeOptimizingTransformer(0, 0, nullptr);
+        const int optLevel = userConfig_.jit_opt_level;
+        const int vectorizedOptLevel = std::max(optLevel, userConfig_.jit_vectorized_opt_level);
+        if(optLevel < 0 || optLevel > 3 || vectorizedOptLevel > 3)
+            throw std::runtime_error("the optimization levels of the JIT compiler must be between 0 and 3");
+
+        // Generate code for the CPU we are running on.
+        auto tmBuilder = llvm::orc::JITTargetMachineBuilder::detectHost();
+        if (!tmBuilder) {
+            llvm::errs() << "Failed to detect the host CPU: " << tmBuilder.takeError();
+            return nullptr;
+        }
+        const auto codeGenOptLevel =
+                vectorizedOptLevel == 3 ? llvm::CodeGenOpt::Level::Aggressive : llvm::CodeGenOpt::Level::Default;
+        tmBuilder->setCodeGenOptLevel(codeGenOptLevel);
+        auto maybeTm = tmBuilder->createTargetMachine();
+        if (!maybeTm) {
+            llvm::errs() << "Failed to create the target machine: " << maybeTm.takeError();
+            return nullptr;
+        }
+        std::unique_ptr<llvm::TargetMachine> tm = std::move(*maybeTm);
+
+        // An optimization pipeline to use within the execution engine. The
+        // bodies of vectorized pipelines are optimized at their own level,
+        // functions not to be optimized at all are excluded via `optnone`.
+        auto optPipeline = mlir::makeOptimizingTransformer(vectorizedOptLevel, 0, tm.get());
+
+        // Translates the module to LLVM IR and optimizes it, or takes the
+        // optimized module from the persistent cache, if any.
+        auto buildLLVMModule = [&](mlir::ModuleOp m, llvm::LLVMContext & llvmContext) -> std::unique_ptr<llvm::Module> {
+            auto llvmModule = mlir::translateModuleToLLVMIR(m, llvmContext);
+            if (!llvmModule)
+                return nullptr;
+            externalizeUserConfig(*llvmModule, reinterpret_cast<uint64_t>(&userConfig_));
+            llvmModule->setTargetTriple(tm->getTargetTriple().str());
+            llvmModule->setDataLayout(tm->createDataLayout());
+
+            std::string cachePath;
+            if(!userConfig_.jit_cache_dir.empty()) {
+                cachePath = userConfig_.jit_cache_dir + "/" +
+                        getCacheFileName(*llvmModule, *tm, optLevel, vectorizedOptLevel);
+                if(auto cachedModule = readCachedModule(cachePath, llvmContext))
+                    return cachedModule;
+            }
+
+            for(auto & f : *llvmModule) {
+                if(f.isDeclaration())
+                    continue;
+                f.addFnAttr("target-cpu", tm->getTargetCPU());
+                f.addFnAttr("target-features", tm->getTargetFeatureString());
+                if(optLevel == 0 && vectorizedOptLevel > 0 && !isVectorizedPipelineBody(f)) {
+                    f.addFnAttr(llvm::Attribute::OptimizeNone);
+                    f.addFnAttr(llvm::Attribute::NoInline);
+                }
+            }
+            if (auto error = optPipeline(llvmModule.get())) {
+                llvm::errs() << "Failed to optimize the module: " << error;
+                return nullptr;
+            }
+
+            if(!cachePath.empty())
+                writeCachedModule(*llvmModule, userConfig_.jit_cache_dir, cachePath);
+            return llvmModule;
+        };
 
         llvm::SmallVector<llvm::StringRef, 1> sharedLibRefs;
         // TODO Find these at run-time.
@@ -178,7 +375,7 @@ std::unique_ptr<mlir::ExecutionEngine> DaphneIrExecutor::createExecutionEngine(m
         registerLLVMDialectTranslation(context_);
         // module.dump();
         auto maybeEngine = mlir::ExecutionEngine::create(
-            module, nullptr, optPipeline, llvm::CodeGenOpt::Level::Default,
+            module, buildLLVMModule, nullptr, codeGenOptLevel,
             sharedLibRefs, true, true, true);
 
         if (!maybeEngine) {
@@ -186,7 +383,15 @@ std::unique_ptr<mlir::ExecutionEngine> DaphneIrExecutor::createExecutionEngine(m
                          << maybeEngine.takeError();
             return nullptr;
         }
-        return std::move(maybeEngine.get());
+        auto engine = std::move(maybeEngine.get());
+        engine->registerSymbols([this](llvm::orc::MangleAndInterner interner) {
+            llvm::orc::SymbolMap symbolMap;
+            symbolMap[interner(USER_CONFIG_SYMBOL)] = llvm::JITEvaluatedSymbol(
+                    llvm::pointerToJITTargetAddress(&userConfig_), llvm::JITSymbolFlags::Exported
+            );
+            return symbolMap;
+        });
+        return engine;
     }
     return nullptr;
 }
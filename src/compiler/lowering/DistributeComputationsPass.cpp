@@ -33,6 +33,24 @@ struct Distribute : public OpInterfaceConversionPattern<daphne::Distributable>
 {
     using OpInterfaceConversionPattern::OpInterfaceConversionPattern;
 
+    /**
+     * Returns the result of a DistributeOp (or BroadcastOp) of the given
+     * value preceding the given operation in the same block, if any.
+     * Across blocks (e.g., loop iterations), the runtime reuses the data on
+     * the workers instead.
+     */
+    static Value findDistributed(Value operand, bool isBroadcast, Operation *op)
+    {
+        for (Operation *user : operand.getUsers()) {
+            if (user->getBlock() != op->getBlock() || !user->isBeforeInBlock(op))
+                continue;
+            if ((isBroadcast && llvm::isa<daphne::BroadcastOp>(user)) ||
+                    (!isBroadcast && llvm::isa<daphne::DistributeOp>(user)))
+                return user->getResult(0);
+        }
+        return nullptr;
+    }
+
     LogicalResult
     matchAndRewrite(daphne::Distributable op, ArrayRef<Value> operands,
                     ConversionPatternRewriter &rewriter) const override
@@ -53,6 +71,10 @@ struct Distribute : public OpInterfaceConversionPattern<daphne::Distributable>
                 // object, so we should reuse the original distributed data
                 // object.
                 distributedInputs.push_back(co.arg());
+            else if (Value reused = findDistributed(operand, isBroadcast, op))
+                // The operand has already been distributed/broadcasted the
+                // same way for a preceding operation.
+                distributedInputs.push_back(reused);
             else {
                 // The operands need to be distributed/broadcasted first.
                 Type t = daphne::HandleType::get(getContext(), operand.getType());
@@ -0,0 +1,228 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "compiler/CompilerUtils.h"
+#include "ir/daphneir/Daphne.h"
+#include "ir/daphneir/Passes.h"
+
+#include "mlir/Pass/Pass.h"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace mlir;
+
+/**
+ * @brief Replaces chains of elementwise operations (optionally followed by a
+ * row-wise aggregation) in the bodies of vectorized pipelines by a single call
+ * to the `ewFused` kernel.
+ *
+ * Otherwise, each operation becomes a separate kernel call, which writes its
+ * result to an intermediate matrix that the next one reads again. The fused
+ * kernel evaluates the whole expression in one pass over its inputs (see
+ * `EwFusedProgram` for the program it interprets).
+ *
+ * Only operations on dense matrices and scalars of the same floating-point
+ * value type are fused. An operation is fused into the one using its result
+ * if that is its only use; all other operations are left to the lowering to
+ * individual kernel calls.
+ */
+struct FuseEwOpsPass : public PassWrapper<FuseEwOpsPass, FunctionPass>
+{
+    explicit FuseEwOpsPass() {}
+    void runOnFunction() final;
+};
+
+namespace
+{
+    /**
+     * @brief The token of the given operation in the program of the fused
+     * kernel, or `nullptr` if it has none.
+     */
+    const char * getFusedToken(Operation * op) {
+        // Elementwise binary.
+        if(isa<daphne::EwAddOp>(op)) return "add";
+        if(isa<daphne::EwSubOp>(op)) return "sub";
+        if(isa<daphne::EwMulOp>(op)) return "mul";
+        if(isa<daphne::EwDivOp>(op)) return "div";
+        if(isa<daphne::EwPowOp>(op)) return "pow";
+        if(isa<daphne::EwLogOp>(op)) return "log";
+        if(isa<daphne::EwEqOp>(op)) return "eq";
+        if(isa<daphne::EwNeqOp>(op)) return "neq";
+        if(isa<daphne::EwLtOp>(op)) return "lt";
+        if(isa<daphne::EwLeOp>(op)) return "le";
+        if(isa<daphne::EwGtOp>(op)) return "gt";
+        if(isa<daphne::EwGeOp>(op)) return "ge";
+        if(isa<daphne::EwMinOp>(op)) return "min";
+        if(isa<daphne::EwMaxOp>(op)) return "max";
+        // Elementwise unary.
+        if(isa<daphne::EwSignOp>(op)) return "sign";
+        if(isa<daphne::EwSqrtOp>(op)) return "sqrt";
+        if(isa<daphne::EwExpOp>(op)) return "exp";
+        if(isa<daphne::EwAbsOp>(op)) return "abs";
+        if(isa<daphne::EwFloorOp>(op)) return "floor";
+        if(isa<daphne::EwCeilOp>(op)) return "ceil";
+        if(isa<daphne::EwRoundOp>(op)) return "round";
+        // Row-wise aggregation.
+        if(isa<daphne::RowAggSumOp>(op)) return "sumRow";
+        if(isa<daphne::RowAggMinOp>(op)) return "minRow";
+        if(isa<daphne::RowAggMaxOp>(op)) return "maxRow";
+        return nullptr;
+    }
+
+    bool isRowAgg(Operation * op) {
+        return isa<daphne::RowAggSumOp, daphne::RowAggMinOp, daphne::RowAggMaxOp>(op);
+    }
+
+    bool isDenseMatrixOf(Value v, Type vt) {
+        auto mt = v.getType().dyn_cast<daphne::MatrixType>();
+        return mt && mt.getElementType() == vt && mt.getRepresentation() == daphne::MatrixRepresentation::Dense;
+    }
+
+    /**
+     * @brief Whether the fused kernel supports the given operation.
+     */
+    bool isFusible(Operation * op) {
+        if(!getFusedToken(op) || op->getNumResults() != 1 || op->hasAttr("cuda_device"))
+            return false;
+        auto resTy = op->getResult(0).getType().dyn_cast<daphne::MatrixType>();
+        if(!resTy)
+            return false;
+        Type vt = resTy.getElementType();
+        if(!vt.isF64() && !vt.isF32())
+            return false;
+        if(!isDenseMatrixOf(op->getResult(0), vt))
+            return false;
+        for(Value operand : op->getOperands())
+            if(!isDenseMatrixOf(operand, vt) && (operand.getType() != vt || isRowAgg(op)))
+                return false;
+        return true;
+    }
+
+    /**
+     * @brief Whether the given fusible operation can be fused into the
+     * operation using its result.
+     */
+    bool isFusedIntoUser(Operation * op) {
+        if(isRowAgg(op) || !op->getResult(0).hasOneUse())
+            return false;
+        Operation * user = *op->getResult(0).getUsers().begin();
+        return user->getBlock() == op->getBlock() && isFusible(user) &&
+                user->getResult(0).getType().cast<daphne::MatrixType>().getElementType() ==
+                op->getResult(0).getType().cast<daphne::MatrixType>().getElementType();
+    }
+
+    /**
+     * @brief Replaces the given operation and all operations fused into it by
+     * a call to the fused kernel, if there is any operation to fuse.
+     */
+    void fuseInto(Operation * root, Value dctx) {
+        Type vt = root->getResult(0).getType().cast<daphne::MatrixType>().getElementType();
+
+        // Translate the tree of fused operations into a postfix program on
+        // the matrices and scalars it uses.
+        std::vector<Value> args;
+        std::vector<Value> scalars;
+        std::vector<Operation *> fusedOps;
+        std::string program;
+        std::function<void(Operation *)> emitOp = [&](Operation * op) {
+            for(Value operand : op->getOperands()) {
+                Operation * defOp = operand.getDefiningOp();
+                if(defOp && isFusible(defOp) && isFusedIntoUser(defOp)) {
+                    emitOp(defOp);
+                    fusedOps.push_back(defOp);
+                    continue;
+                }
+                std::vector<Value> & leaves = operand.getType().isa<daphne::MatrixType>() ? args : scalars;
+                auto it = std::find(leaves.begin(), leaves.end(), operand);
+                if(it == leaves.end())
+                    it = leaves.insert(leaves.end(), operand);
+                program += (&leaves == &args ? "m" : "s") + std::to_string(it - leaves.begin()) + " ";
+            }
+            program += getFusedToken(op);
+            program += " ";
+        };
+        emitOp(root);
+        if(fusedOps.empty())
+            return;
+        program.pop_back();
+
+        OpBuilder builder(root);
+        Location loc = root->getLoc();
+        MLIRContext * mctx = builder.getContext();
+        Type argTy = daphne::MatrixType::get(mctx, vt);
+        Type strTy = daphne::StringType::get(mctx);
+
+        // The operands of the kernel, see the `ewFused` kernel.
+        std::vector<Value> newOperands;
+        for(auto * leaves : {&args, &scalars}) {
+            Type contTy = leaves == &args ? argTy : vt;
+            auto cvpOp = builder.create<daphne::CreateVariadicPackOp>(
+                    loc,
+                    daphne::VariadicPackType::get(mctx, contTy),
+                    builder.getIndexAttr(leaves->size())
+            );
+            for(size_t k = 0; k < leaves->size(); k++)
+                builder.create<daphne::StoreVariadicPackOp>(loc, cvpOp, (*leaves)[k], builder.getIndexAttr(k));
+            newOperands.push_back(cvpOp);
+            newOperands.push_back(builder.create<daphne::ConstantOp>(loc, builder.getIndexAttr(leaves->size())));
+        }
+        newOperands.push_back(builder.create<daphne::ConstantOp>(loc, strTy, builder.getStringAttr(program)));
+        newOperands.push_back(dctx);
+
+        const std::string callee = "_ewFused__" +
+                CompilerUtils::mlirTypeToCppTypeName(root->getResult(0).getType()) + "__" +
+                CompilerUtils::mlirTypeToCppTypeName(argTy) + "_variadic__size_t__" +
+                CompilerUtils::mlirTypeToCppTypeName(vt) + "_variadic__size_t__" +
+                CompilerUtils::mlirTypeToCppTypeName(strTy);
+        auto kernel = builder.create<daphne::CallKernelOp>(loc, callee, newOperands, root->getResultTypes());
+        root->getResult(0).replaceAllUsesWith(kernel.getResult(0));
+
+        // Erase the fused operations, users before their operands.
+        root->erase();
+        for(auto it = fusedOps.rbegin(); it != fusedOps.rend(); ++it)
+            (*it)->erase();
+    }
+}
+
+void FuseEwOpsPass::runOnFunction()
+{
+    FuncOp func = getFunction();
+
+    func->walk([&](daphne::VectorizedPipelineOp pipeline)
+    {
+        // Find the roots of the trees of fused operations first, since
+        // fusing them changes the block.
+        std::vector<Operation *> roots;
+        for(Operation & op : pipeline.body().front())
+            if(isFusible(&op) && !isFusedIntoUser(&op))
+                roots.push_back(&op);
+        if(roots.empty())
+            return;
+
+        Value dctx = CompilerUtils::getDaphneContext(func);
+        for(Operation * root : roots)
+            fuseInto(root, dctx);
+    });
+}
+
+std::unique_ptr<Pass> daphne::createFuseEwOpsPass()
+{
+    return std::make_unique<FuseEwOpsPass>();
+}
@@ -34,6 +34,19 @@ using namespace mlir;
 // be combined into a single variadic result.
 const std::string ATTR_HASVARIADICRESULTS = "hasVariadicResults";
 
+// Optional attribute of CallKernelOp inside a vectorized pipeline, which holds
+// the index of the pipeline output the result of the kernel is returned as.
+// Such a kernel receives the view of the final result passed in by the
+// runtime (if any) instead of a null pointer as its result, such that it
+// writes there directly.
+const std::string ATTR_VECTORIZEDRESULT = "vectorizedResult";
+
+// Optional attribute of CallKernelOp, which indicates that the last operand is
+// not an argument of the kernel, but the initial value of its result, i.e., a
+// data object the kernel may overwrite (or a null pointer). See
+// UpdateInPlacePass.
+const std::string ATTR_INITRESULT = "initResult";
+
 #if 0
 // At the moment, all of these operations are lowered to kernel calls.
 template <typename BinaryOp, typename ReplIOp, typename ReplFOp>
@@ -300,6 +313,13 @@ public:
         auto module = op->getParentOfType<ModuleOp>();
         auto loc = op.getLoc();
 
+        // The initial value of the result, if it is not a null pointer.
+        Value initRes;
+        if(op->hasAttr(ATTR_INITRESULT)) {
+            initRes = operands.back();
+            operands = operands.drop_back();
+        }
+
         auto inputOutputTypes = getLLVMInputOutputTypes(
                                                         loc, rewriter.getContext(), typeConverter,
                                                         op.getResultTypes(), ValueRange(operands).getTypes(),
@@ -310,7 +330,17 @@ public:
                                                  rewriter, module, op.getCalleeAttr().getValue(),
                                                  getKernelFuncSignature(rewriter.getContext(), inputOutputTypes));
 
-        auto kernelOperands = allocOutputReferences(loc, rewriter, operands, inputOutputTypes, op->getNumResults(), hasVarRes);
+        if(auto resIdx = op->getAttrOfType<IntegerAttr>(ATTR_VECTORIZEDRESULT)) {
+            // The first argument of the pipeline function is the array of
+            // pointers to its outputs.
+            Value returnRef = op->getParentOfType<LLVM::LLVMFuncOp>().body().front().getArgument(0);
+            auto addr1 = rewriter.create<LLVM::GEPOp>(loc, returnRef.getType(), returnRef, ArrayRef<Value>(
+                    {rewriter.create<ConstantOp>(loc, rewriter.getIndexAttr(resIdx.getInt()))}));
+            auto addr2 = rewriter.create<LLVM::LoadOp>(loc, addr1);
+            initRes = rewriter.create<LLVM::LoadOp>(loc, addr2);
+        }
+
+        auto kernelOperands = allocOutputReferences(loc, rewriter, operands, inputOutputTypes, op->getNumResults(), hasVarRes, initRes);
 
         // call function
         rewriter.create<CallOp>(
@@ -362,7 +392,8 @@ private:
     std::vector<Value>
     allocOutputReferences(Location &loc, PatternRewriter &rewriter,
                           ArrayRef<Value> operands,
-                          std::vector<Type> inputOutputTypes, size_t numRes, bool hasVarRes) const
+                          std::vector<Type> inputOutputTypes, size_t numRes, bool hasVarRes,
+                          Value initRes) const
     {
 
         std::vector<Value> kernelOperands;
@@ -415,11 +446,10 @@ private:
                 // required.
                 Type elType = inputOutputTypes[i].dyn_cast<LLVM::LLVMPointerType>().getElementType();
                 if(elType.isa<LLVM::LLVMPointerType>()) {
-                    rewriter.create<LLVM::StoreOp>(
-                        loc,
-                        rewriter.create<LLVM::NullOp>(loc, elType),
-                        allocaOp
-                    );
+                    Value init = initRes
+                            ? rewriter.create<LLVM::BitcastOp>(loc, elType, initRes).getResult()
+                            : rewriter.create<LLVM::NullOp>(loc, elType).getResult();
+                    rewriter.create<LLVM::StoreOp>(loc, init, allocaOp);
                 }
             }
         }
@@ -583,6 +613,11 @@ public:
             rewriter.setInsertionPoint(oldReturn);
             for (auto i = 0u; i < oldReturn->getNumOperands(); ++i) {
                 auto retVal = oldReturn->getOperand(i);
+                // Let the kernel producing this output write to the view of
+                // the result passed in by the runtime (saves copying it).
+                if(auto kernel = retVal.getDefiningOp<daphne::CallKernelOp>())
+                    if(writesResultInPlace(kernel) && llvm::count(oldReturn->getOperands(), retVal) == 1)
+                        kernel->setAttr(ATTR_VECTORIZEDRESULT, rewriter.getIndexAttr(i));
                 // TODO: check how the GEPOp works exactly, and if this can be written better
                 auto addr1 = rewriter.create<LLVM::GEPOp>(op->getLoc(), pppI1Ty, returnRef, ArrayRef<Value>(
                         {rewriter.create<ConstantOp>(loc, rewriter.getIndexAttr(i))}));
@@ -795,6 +830,23 @@ public:
         return success();
     }
 private:
+    /**
+     * @brief Whether the given kernel can write its result to a given
+     * (possibly strided) view of a dense matrix.
+     *
+     * This holds for the elementwise kernels, which only allocate their result
+     * if none is given and respect its row skip.
+     */
+    static bool writesResultInPlace(daphne::CallKernelOp kernel)
+    {
+        if(kernel->getNumResults() != 1 || kernel->hasAttr(ATTR_HASVARIADICRESULTS))
+            return false;
+        // The callee is the kernel name followed by the types of the result
+        // and the arguments, e.g., `_ewAdd__DenseMatrix_double__...`.
+        auto nameAndTypes = kernel.getCalleeAttr().getValue().split("__");
+        return nameAndTypes.first.startswith("_ew") && nameAndTypes.second.startswith("DenseMatrix_");
+    }
+
     static Value convertToArray(Location loc, ConversionPatternRewriter &rewriter, Type valueTy, ValueRange values)
     {
         auto valuePtrTy = LLVM::LLVMPointerType::get(valueTy);
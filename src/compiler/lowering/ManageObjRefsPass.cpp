@@ -22,6 +22,8 @@
 #include <mlir/Dialect/SCF/SCF.h>
 #include <mlir/Pass/Pass.h>
 
+#include <vector>
+
 using namespace mlir;
 
 /**
@@ -243,11 +245,57 @@ void processBlock(OpBuilder builder, Block * b) {
     }
 }
 
+/**
+ * @brief Removes pairs of an `IncRefOp` and a `DecRefOp` on the same value,
+ * which cancel each other out, to save the kernel calls.
+ * 
+ * This is typically the case for casts that do not call a kernel: The
+ * reference counter of the argument is increased before the cast and
+ * decreased after it, since the cast is its last use.
+ * 
+ * The pair can only be removed if no op in between could decrease the
+ * reference counter of the same data object (through any value). Since the
+ * code of a function is executed by a single thread (vectorized pipelines
+ * finish before the next op starts), the data object cannot be released by
+ * another thread in the meantime, either.
+ * 
+ * @param b
+ */
+void removeRedundantRefOps(Block * b) {
+    std::vector<Operation *> toErase;
+    for(Operation & op : b->getOperations()) {
+        auto dro = dyn_cast<daphne::DecRefOp>(op);
+        if(!dro)
+            continue;
+        for(Operation * prev = op.getPrevNode(); prev; prev = prev->getPrevNode()) {
+            if(auto iro = dyn_cast<daphne::IncRefOp>(prev)) {
+                if(iro.arg() == dro.arg()) {
+                    toErase.push_back(prev);
+                    toErase.push_back(&op);
+                    break;
+                }
+            }
+            else if(
+                isa<daphne::DecRefOp, CallOp, daphne::GenericCallOp>(prev) ||
+                prev->getNumRegions()
+            )
+                break;
+        }
+    }
+    for(Operation * op : toErase)
+        op->erase();
+}
+
 void ManageObjRefsPass::runOnFunction()
 {
     FuncOp f = getFunction();
     OpBuilder builder(f.getContext());
     processBlock(builder, &(f.body().front()));
+    f->walk([](Operation * op) {
+        for(Region & r : op->getRegions())
+            for(Block & b : r.getBlocks())
+                removeRedundantRefOps(&b);
+    });
 }
 
 std::unique_ptr<Pass> daphne::createManageObjRefsPass()
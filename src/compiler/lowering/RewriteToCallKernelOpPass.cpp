@@ -17,6 +17,7 @@
 #include "compiler/CompilerUtils.h"
 #include "ir/daphneir/Daphne.h"
 #include "ir/daphneir/Passes.h"
+#include "runtime/local/instrumentation/Profiler.h"
 
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "mlir/Dialect/SCF/SCF.h"
@@ -30,6 +31,7 @@
 #include <stdexcept>
 #include <string_view>
 #include <tuple>
+#include <vector>
 
 using namespace mlir;
 
@@ -318,10 +320,47 @@ namespace
         }
     };
 
+    /**
+     * @brief A textual representation of the given location for profiles,
+     * ideally pointing to the DaphneDSL source code.
+     */
+    std::string getLocationString(Location loc)
+    {
+        if(auto fused = loc.dyn_cast<FusedLoc>()) {
+            for(Location inner : fused.getLocations())
+                if(inner.isa<FileLineColLoc>())
+                    return getLocationString(inner);
+        }
+        if(auto fileLoc = loc.dyn_cast<FileLineColLoc>())
+            return fileLoc.getFilename().str() + ":" + std::to_string(fileLoc.getLine()) + ":" +
+                    std::to_string(fileLoc.getColumn());
+        return "unknown";
+    }
+
+    /**
+     * @brief Wraps the given operation into calls to the kernels starting and
+     * stopping the profiling of the given call site.
+     */
+    void insertProfilingCalls(Operation * op, size_t siteId, Value dctx)
+    {
+        OpBuilder builder(op);
+        Location loc = op->getLoc();
+        Value site = builder.create<daphne::ConstantOp>(loc, builder.getIndexAttr(siteId));
+        builder.create<daphne::CallKernelOp>(
+                loc, "_startProfiling__size_t", ValueRange({site, dctx}), TypeRange()
+        );
+        builder.setInsertionPointAfter(op);
+        builder.create<daphne::CallKernelOp>(
+                loc, "_stopProfiling__size_t", ValueRange({site, dctx}), TypeRange()
+        );
+    }
+
     struct RewriteToCallKernelOpPass
     : public PassWrapper<RewriteToCallKernelOpPass, FunctionPass>
     {
-        RewriteToCallKernelOpPass() = default;
+        std::shared_ptr<Profiler> profiler;
+
+        explicit RewriteToCallKernelOpPass(const DaphneUserConfig & cfg) : profiler(cfg.profiler) {}
         void runOnFunction() final;
     };
 }
@@ -360,12 +399,34 @@ void RewriteToCallKernelOpPass::runOnFunction()
 
     // Apply conversion to CallKernelOps.
     patterns.insert<KernelReplacement>(&getContext(), dctx);
-    if (failed(applyPartialConversion(func, target, std::move(patterns))))
+    if (failed(applyPartialConversion(func, target, std::move(patterns)))) {
         signalPassFailure();
-
+        return;
+    }
+
+    // If profiling is enabled, register each kernel call (and vectorized
+    // pipeline) as a call site and measure it at run-time. The calls creating
+    // and destroying the DaphneContext cannot be measured, since the context
+    // is required for that.
+    if(profiler) {
+        std::vector<std::pair<Operation *, std::string>> sites;
+        func->walk([&](Operation * op) {
+            if(auto ck = llvm::dyn_cast<daphne::CallKernelOp>(op)) {
+                StringRef callee = ck.callee();
+                if(!callee.startswith("_createDaphneContext") && !callee.startswith("_destroyDaphneContext"))
+                    sites.emplace_back(op, callee.str());
+            }
+            else if(llvm::isa<daphne::VectorizedPipelineOp>(op))
+                sites.emplace_back(op, "vectorizedPipeline");
+        });
+        for(auto & site : sites)
+            insertProfilingCalls(
+                    site.first, profiler->registerSite(site.second, getLocationString(site.first->getLoc())), dctx
+            );
+    }
 }
 
-std::unique_ptr<Pass> daphne::createRewriteToCallKernelOpPass()
+std::unique_ptr<Pass> daphne::createRewriteToCallKernelOpPass(const DaphneUserConfig& cfg)
 {
-    return std::make_unique<RewriteToCallKernelOpPass>();
+    return std::make_unique<RewriteToCallKernelOpPass>(cfg);
 }
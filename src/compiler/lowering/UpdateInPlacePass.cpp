@@ -0,0 +1,176 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "compiler/CompilerUtils.h"
+#include "ir/daphneir/Daphne.h"
+#include "ir/daphneir/Passes.h"
+
+#include "mlir/Pass/Pass.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace mlir;
+
+/**
+ * @brief Lets kernels write their result to an argument which is not used
+ * anymore afterwards, instead of allocating a new result.
+ *
+ * This pass runs on the kernel calls, after the reference management (see
+ * `ManageObjRefsPass`). If a kernel is the last use of its argument, i.e., the
+ * argument's reference counter is decreased right after it, the argument is
+ * passed through the `reuseForResult` kernel and becomes the initial result of
+ * the kernel (see `ATTR_INITRESULT` in `LowerToLLVMPass`). At run-time,
+ * `reuseForResult` only provides the argument if no other data object refers
+ * to it, and `nullptr` otherwise, such that the kernel allocates its result as
+ * usual.
+ *
+ * This applies to the kernels on dense matrices that write their result
+ * elementwise from the same position in the argument, or copy the argument
+ * to the result otherwise (elementwise operations, `replace`, `insertRow`,
+ * and `insertCol`), and only if the argument has the value type of the
+ * result.
+ */
+struct UpdateInPlacePass : public PassWrapper<UpdateInPlacePass, FunctionPass>
+{
+    explicit UpdateInPlacePass() {}
+    void runOnFunction() final;
+};
+
+namespace
+{
+    // Optional attribute of CallKernelOp, see LowerToLLVMPass.
+    const std::string ATTR_INITRESULT = "initResult";
+
+    std::pair<StringRef, StringRef> splitCallee(daphne::CallKernelOp kernel) {
+        // The callee is the kernel name followed by the types of the result
+        // and the arguments, e.g., `_ewAdd__DenseMatrix_double__...`.
+        return kernel.getCalleeAttr().getValue().split("__");
+    }
+
+    bool isDecRef(Operation * op) {
+        auto kernel = dyn_cast<daphne::CallKernelOp>(op);
+        return kernel && splitCallee(kernel).first == "_decRef";
+    }
+
+    /**
+     * @brief Whether `reuseForResult` is instantiated for the given type.
+     */
+    bool isReusableType(Type t) {
+        auto mt = t.dyn_cast<daphne::MatrixType>();
+        if(!mt || mt.getRepresentation() != daphne::MatrixRepresentation::Dense)
+            return false;
+        Type vt = mt.getElementType();
+        return vt.isF64() || vt.isF32() || vt.isSignedInteger(64) || vt.isUnsignedInteger(64) ||
+                vt.isUnsignedInteger(8);
+    }
+
+    /**
+     * @brief The argument of the given kernel it could write its result to,
+     * or `nullptr` if there is none.
+     */
+    Value getReusableArg(daphne::CallKernelOp kernel) {
+        if(kernel->getNumResults() != 1 || kernel->getNumOperands() < 2 || kernel->hasAttr(ATTR_INITRESULT))
+            return nullptr;
+        const StringRef name = splitCallee(kernel).first;
+        // Elementwise kernels only read each position of their argument
+        // before writing the same position of their result, so the argument
+        // may even occur several times. The others might read positions of
+        // another occurrence they have overwritten already.
+        const bool isEw = name.startswith("_ew") && name != "_ewFused";
+        if(!isEw && name != "_replace" && name != "_insertRow" && name != "_insertCol")
+            return nullptr;
+
+        Value arg = kernel->getOperand(0);
+        Type resTy = kernel->getResult(0).getType();
+        if(!isReusableType(resTy) || !isReusableType(arg.getType()) ||
+                arg.getType().cast<daphne::MatrixType>().getElementType() !=
+                resTy.cast<daphne::MatrixType>().getElementType())
+            return nullptr;
+        if(!isEw && llvm::count(kernel->getOperands(), arg) != 1)
+            return nullptr;
+
+        // The kernel must be the last use of the argument, which is followed
+        // by the decrease of its reference counter. Uses in nested blocks
+        // (e.g., of a loop) are executed repeatedly, so we only consider
+        // kernels in the block of the argument.
+        Block * block = arg.getParentBlock();
+        if(kernel->getBlock() != block)
+            return nullptr;
+        bool isDecreasedAfter = false;
+        for(Operation * user : arg.getUsers()) {
+            if(user == kernel.getOperation())
+                continue;
+            Operation * ancestor = block->findAncestorOpInBlock(*user);
+            if(!ancestor)
+                return nullptr;
+            if(ancestor->isBeforeInBlock(kernel))
+                continue;
+            if(!isDecRef(ancestor))
+                return nullptr;
+            isDecreasedAfter = true;
+        }
+        return isDecreasedAfter ? arg : nullptr;
+    }
+}
+
+void UpdateInPlacePass::runOnFunction()
+{
+    FuncOp func = getFunction();
+
+    // Find the kernels first, since we replace them. The kernels in
+    // vectorized pipelines work on views, which are never reused.
+    std::vector<std::pair<daphne::CallKernelOp, Value>> kernels;
+    func->walk([&](daphne::CallKernelOp kernel)
+    {
+        if(kernel->getParentOfType<daphne::VectorizedPipelineOp>())
+            return;
+        if(Value arg = getReusableArg(kernel))
+            kernels.emplace_back(kernel, arg);
+    });
+    if(kernels.empty())
+        return;
+
+    Value dctx = CompilerUtils::getDaphneContext(func);
+    for(auto & [kernel, arg] : kernels) {
+        OpBuilder builder(kernel);
+        Location loc = kernel.getLoc();
+        Type argTy = arg.getType();
+        const std::string argTyName = CompilerUtils::mlirTypeToCppTypeName(argTy);
+        auto initRes = builder.create<daphne::CallKernelOp>(
+                loc, "_reuseForResult__" + argTyName + "__" + argTyName, ValueRange({arg, dctx}), TypeRange({argTy})
+        );
+
+        // The initial result is passed as an additional last operand.
+        std::vector<Value> operands(kernel->getOperands().begin(), kernel->getOperands().end());
+        operands.push_back(initRes.getResult(0));
+        auto newKernel = builder.create<daphne::CallKernelOp>(
+                loc, kernel.callee(), operands, kernel->getResultTypes()
+        );
+        for(NamedAttribute attr : kernel->getAttrs())
+            if(!newKernel->hasAttr(attr.first))
+                newKernel->setAttr(attr.first, attr.second);
+        newKernel->setAttr(ATTR_INITRESULT, builder.getUnitAttr());
+        kernel->replaceAllUsesWith(newKernel);
+        kernel->erase();
+    }
+}
+
+std::unique_ptr<Pass> daphne::createUpdateInPlacePass()
+{
+    return std::make_unique<UpdateInPlacePass>();
+}
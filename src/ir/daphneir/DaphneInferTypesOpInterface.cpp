@@ -238,6 +238,21 @@ void daphne::SemiJoinOp::inferTypes() {
     getResult(1).setType(daphne::MatrixType::get(ctx, builder.getIndexType()));
 }
 
+void daphne::CartesianOp::inferTypes() {
+    daphne::FrameType ftLhs = lhs().getType().dyn_cast<daphne::FrameType>();
+    daphne::FrameType ftRhs = rhs().getType().dyn_cast<daphne::FrameType>();
+    if(ftLhs && ftRhs) {
+        std::vector<Type> newColumnTypes;
+        for(Type t : ftLhs.getColumnTypes())
+            newColumnTypes.push_back(t);
+        for(Type t : ftRhs.getColumnTypes())
+            newColumnTypes.push_back(t);
+        getResult().setType(
+                daphne::FrameType::get(getContext(), newColumnTypes)
+        );
+    }
+}
+
 void daphne::InnerJoinOp::inferTypes() {
     daphne::FrameType ftLhs = lhs().getType().dyn_cast<daphne::FrameType>();
     daphne::FrameType ftRhs = rhs().getType().dyn_cast<daphne::FrameType>();
@@ -45,6 +45,10 @@ void ConfigParser::readUserConfig(const std::string& filename, DaphneUserConfig&
         config.cuda_fuse_any = jf.at(DaphneConfigJsonParams::CUDA_FUSE_ANY).get<bool>();
     if (keyExists(jf, DaphneConfigJsonParams::VECTORIZED_SINGLE_QUEUE))
         config.vectorized_single_queue = jf.at(DaphneConfigJsonParams::VECTORIZED_SINGLE_QUEUE).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::USE_EW_FUSION))
+        config.use_ew_fusion = jf.at(DaphneConfigJsonParams::USE_EW_FUSION).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::UPDATE_IN_PLACE))
+        config.update_in_place = jf.at(DaphneConfigJsonParams::UPDATE_IN_PLACE).get<bool>();
     if (keyExists(jf, DaphneConfigJsonParams::DEBUG_LLVM))
         config.debug_llvm = jf.at(DaphneConfigJsonParams::DEBUG_LLVM).get<bool>();
     if (keyExists(jf, DaphneConfigJsonParams::EXPLAIN_KERNELS))
@@ -71,6 +75,28 @@ void ConfigParser::readUserConfig(const std::string& filename, DaphneUserConfig&
         config.numberOfThreads = jf.at(DaphneConfigJsonParams::NUMBER_OF_THREADS).get<int>();
     if (keyExists(jf, DaphneConfigJsonParams::MINIMUM_TASK_SIZE))
         config.minimumTaskSize = jf.at(DaphneConfigJsonParams::MINIMUM_TASK_SIZE).get<int>();
+    if (keyExists(jf, DaphneConfigJsonParams::TASK_QUEUE_TYPE)) {
+        config.taskQueueType = jf.at(DaphneConfigJsonParams::TASK_QUEUE_TYPE).get<TaskQueueType>();
+        if (config.taskQueueType == TaskQueueType::INVALID) {
+            throw std::invalid_argument("Invalid value for enum \"TaskQueueType\"");
+        }
+    }
+    if (keyExists(jf, DaphneConfigJsonParams::NUMA_AWARE))
+        config.numaAware = jf.at(DaphneConfigJsonParams::NUMA_AWARE).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::JIT_OPT_LEVEL))
+        config.jit_opt_level = jf.at(DaphneConfigJsonParams::JIT_OPT_LEVEL).get<int>();
+    if (keyExists(jf, DaphneConfigJsonParams::JIT_VECTORIZED_OPT_LEVEL))
+        config.jit_vectorized_opt_level = jf.at(DaphneConfigJsonParams::JIT_VECTORIZED_OPT_LEVEL).get<int>();
+    if (keyExists(jf, DaphneConfigJsonParams::JIT_CACHE_DIR))
+        config.jit_cache_dir = jf.at(DaphneConfigJsonParams::JIT_CACHE_DIR).get<std::string>();
+    if (keyExists(jf, DaphneConfigJsonParams::ENABLE_PROFILING))
+        config.enable_profiling = jf.at(DaphneConfigJsonParams::ENABLE_PROFILING).get<bool>();
+    if (keyExists(jf, DaphneConfigJsonParams::PROFILING_TRACE_FILE))
+        config.profiling_trace_file = jf.at(DaphneConfigJsonParams::PROFILING_TRACE_FILE).get<std::string>();
+    if (keyExists(jf, DaphneConfigJsonParams::BUFFER_POOL_SIZE))
+        config.buffer_pool_size = jf.at(DaphneConfigJsonParams::BUFFER_POOL_SIZE).get<size_t>();
+    if (keyExists(jf, DaphneConfigJsonParams::USE_HUGE_PAGES))
+        config.use_huge_pages = jf.at(DaphneConfigJsonParams::USE_HUGE_PAGES).get<bool>();
 #ifdef USE_CUDA
     if (keyExists(jf, DaphneConfigJsonParams::CUDA_DEVICES))
         config.cuda_devices = jf.at(DaphneConfigJsonParams::CUDA_DEVICES).get<std::vector<int>>();
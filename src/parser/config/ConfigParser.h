@@ -18,6 +18,7 @@
 #pragma once
 #include <nlohmannjson/json.hpp>
 #include <runtime/local/vectorized/LoadPartitioning.h>
+#include <runtime/local/vectorized/TaskQueueType.h>
 #include <api/cli/DaphneUserConfig.h>
 #include <string>
 
@@ -35,7 +36,15 @@ NLOHMANN_JSON_SERIALIZE_ENUM(SelfSchedulingScheme, {
     {PLS, "PLS"},
     {MSTATIC, "MSTATIC"},
     {MFSC, "MFSC"},
-    {PSS, "PSS"}
+    {PSS, "PSS"},
+    {AWF, "AWF"},
+    {AF, "AF"}
+})
+
+NLOHMANN_JSON_SERIALIZE_ENUM(TaskQueueType, {
+    {TaskQueueType::INVALID, nullptr},
+    {TaskQueueType::BLOCKING, "BLOCKING"},
+    {TaskQueueType::LOCKFREE, "LOCKFREE"}
 })
 
 class ConfigParser {
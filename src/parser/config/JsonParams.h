@@ -30,6 +30,8 @@ struct DaphneConfigJsonParams {
     inline static const std::string USE_OBJ_REF_MGNT = "use_obj_ref_mgnt";
     inline static const std::string CUDA_FUSE_ANY = "cuda_fuse_any";
     inline static const std::string VECTORIZED_SINGLE_QUEUE = "vectorized_single_queue";
+    inline static const std::string USE_EW_FUSION = "use_ew_fusion";
+    inline static const std::string UPDATE_IN_PLACE = "update_in_place";
 
     inline static const std::string DEBUG_LLVM = "debug_llvm";
     inline static const std::string EXPLAIN_KERNELS = "explain_kernels";
@@ -42,6 +44,15 @@ struct DaphneConfigJsonParams {
     inline static const std::string TASK_PARTITIONING_SCHEME = "taskPartitioningScheme";
     inline static const std::string NUMBER_OF_THREADS = "numberOfThreads";
     inline static const std::string MINIMUM_TASK_SIZE = "minimumTaskSize";
+    inline static const std::string TASK_QUEUE_TYPE = "taskQueueType";
+    inline static const std::string NUMA_AWARE = "numaAware";
+    inline static const std::string JIT_OPT_LEVEL = "jit_opt_level";
+    inline static const std::string JIT_VECTORIZED_OPT_LEVEL = "jit_vectorized_opt_level";
+    inline static const std::string JIT_CACHE_DIR = "jit_cache_dir";
+    inline static const std::string ENABLE_PROFILING = "enable_profiling";
+    inline static const std::string PROFILING_TRACE_FILE = "profiling_trace_file";
+    inline static const std::string BUFFER_POOL_SIZE = "buffer_pool_size";
+    inline static const std::string USE_HUGE_PAGES = "use_huge_pages";
 
     inline static const std::string CUDA_DEVICES = "cuda_devices";
 
@@ -54,6 +65,8 @@ struct DaphneConfigJsonParams {
             USE_OBJ_REF_MGNT,
             CUDA_FUSE_ANY,
             VECTORIZED_SINGLE_QUEUE,
+            USE_EW_FUSION,
+            UPDATE_IN_PLACE,
             DEBUG_LLVM,
             EXPLAIN_KERNELS,
             EXPLAIN_LLVM,
@@ -65,6 +78,15 @@ struct DaphneConfigJsonParams {
             TASK_PARTITIONING_SCHEME,
             NUMBER_OF_THREADS,
             MINIMUM_TASK_SIZE,
+            TASK_QUEUE_TYPE,
+            NUMA_AWARE,
+            JIT_OPT_LEVEL,
+            JIT_VECTORIZED_OPT_LEVEL,
+            JIT_CACHE_DIR,
+            ENABLE_PROFILING,
+            PROFILING_TRACE_FILE,
+            BUFFER_POOL_SIZE,
+            USE_HUGE_PAGES,
             CUDA_DEVICES,
             LIB_DIR,
             LIBRARY_PATHS
@@ -22,6 +22,7 @@
 #include <stdexcept>
 #include <string>
 #include <vector>
+#include <set>
 #include <sstream>
 #include <algorithm>
 
@@ -53,6 +54,97 @@ void toggleBit(int64_t& flag, int64_t position){
     setBit(flag, position, !isBitSet(flag, position));
 }
 
+/**
+ * @brief The estimated number of rows of a frame whose number of rows is
+ * unknown at compile-time.
+ */
+const double DEFAULT_CARDINALITY = 1000;
+
+/**
+ * @brief Returns the generalExpr inside of any parentheses
+ */
+SQLGrammarParser::GeneralExprContext * unwrapParantheses(
+    SQLGrammarParser::GeneralExprContext * ctx
+)
+{
+    while(auto p = dynamic_cast<SQLGrammarParser::ParanthesesExprContext *>(ctx)){
+        ctx = p->generalExpr();
+    }
+    return ctx;
+}
+
+/**
+ * @brief Splits a condition into the conditions combined by AND
+ */
+void splitConjuncts(
+    SQLGrammarParser::GeneralExprContext * ctx,
+    std::vector<SQLGrammarParser::GeneralExprContext *> & conjuncts
+)
+{
+    if(auto a = dynamic_cast<SQLGrammarParser::AndExprContext *>(unwrapParantheses(ctx))){
+        splitConjuncts(a->lhs, conjuncts);
+        splitConjuncts(a->rhs, conjuncts);
+    }else{
+        conjuncts.push_back(ctx);
+    }
+}
+
+/**
+ * @brief Collects all column references in a part of the query
+ */
+void collectIdents(
+    antlr4::tree::ParseTree * tree,
+    std::vector<SQLGrammarParser::StringIdentContext *> & idents
+)
+{
+    if(auto ident = dynamic_cast<SQLGrammarParser::StringIdentContext *>(tree)){
+        idents.push_back(ident);
+        return;
+    }
+    for(antlr4::tree::ParseTree * child : tree->children){
+        collectIdents(child, idents);
+    }
+}
+
+/**
+ * @brief Estimates the fraction of rows satisfying a condition, using the
+ * usual default selectivities of comparisons.
+ */
+double estimateSelectivity(SQLGrammarParser::GeneralExprContext * ctx){
+    ctx = unwrapParantheses(ctx);
+    if(auto c = dynamic_cast<SQLGrammarParser::CmpExprContext *>(ctx)){
+        std::string op = c->op->getText();
+        if(op == "="){
+            return 0.1;
+        }
+        if(op == "<>"){
+            return 0.9;
+        }
+        return 1.0 / 3;
+    }
+    if(auto a = dynamic_cast<SQLGrammarParser::AndExprContext *>(ctx)){
+        return estimateSelectivity(a->lhs) * estimateSelectivity(a->rhs);
+    }
+    if(auto o = dynamic_cast<SQLGrammarParser::OrExprContext *>(ctx)){
+        double lhs = estimateSelectivity(o->lhs);
+        double rhs = estimateSelectivity(o->rhs);
+        return lhs + rhs - lhs * rhs;
+    }
+    return 0.5;
+}
+
+/**
+ * @brief Returns the type of a frame with the columns of both frames
+ */
+mlir::Type concatFrameTypes(mlir::OpBuilder & builder, mlir::Value lhs, mlir::Value rhs){
+    std::vector<mlir::Type> colTypes;
+    for(mlir::Type t : lhs.getType().dyn_cast<mlir::daphne::FrameType>().getColumnTypes())
+        colTypes.push_back(t);
+    for(mlir::Type t : rhs.getType().dyn_cast<mlir::daphne::FrameType>().getColumnTypes())
+        colTypes.push_back(t);
+    return mlir::daphne::FrameType::get(builder.getContext(), colTypes);
+}
+
 // ****************************************************************************
 // Member Helper functions
 // ****************************************************************************
@@ -301,6 +393,90 @@ mlir::Value SQLVisitor::extractMatrixFromFrame(
     ));
 }
 
+mlir::Value SQLVisitor::filterFrame(
+    mlir::Value frame,
+    SQLGrammarParser::GeneralExprContext * cond
+)
+{
+    //The result of cond is a matrix or a single value, which gets cast to a
+    //matrix. IMPORTANT: FilterRowOp takes up the work to make a int/float
+    //into a boolean for the filtering.
+    mlir::Location loc = utils.getLoc(cond->start);
+
+    currentFrame = frame;
+    mlir::Value expr = utils.valueOrError(visit(cond));
+    mlir::Value filter = castToMatrixColumn(expr);
+
+    return static_cast<mlir::Value>(
+        builder.create<mlir::daphne::FilterRowOp>(
+            loc,
+            frame.getType(),
+            frame,
+            filter
+        )
+    );
+}
+
+mlir::Value SQLVisitor::filterFrameEq(
+    mlir::Value frame,
+    SQLGrammarParser::StringIdentContext * lhs,
+    SQLGrammarParser::StringIdentContext * rhs
+)
+{
+    mlir::Location loc = utils.getLoc(lhs->start);
+
+    mlir::Value lhsCol = extractMatrixFromFrame(frame, utils.valueOrError(visit(lhs)));
+    mlir::Value rhsCol = extractMatrixFromFrame(frame, utils.valueOrError(visit(rhs)));
+    mlir::Value filter = static_cast<mlir::Value>(
+        builder.create<mlir::daphne::EwEqOp>(loc, lhsCol, rhsCol)
+    );
+
+    return static_cast<mlir::Value>(
+        builder.create<mlir::daphne::FilterRowOp>(
+            loc,
+            frame.getType(),
+            frame,
+            filter
+        )
+    );
+}
+
+mlir::Value SQLVisitor::projectFrame(
+    mlir::Value frame,
+    const std::vector<std::string> & labels
+)
+{
+    mlir::Location loc = builder.getUnknownLoc();
+
+    mlir::Type resTypeCol = mlir::daphne::FrameType::get(
+            builder.getContext(), {utils.unknownType}
+    );
+    mlir::Value res;
+    for(const std::string & label : labels){
+        mlir::Value col = static_cast<mlir::Value>(
+            builder.create<mlir::daphne::ExtractColOp>(
+                loc,
+                resTypeCol,
+                frame,
+                createStringConstant(label)
+            )
+        );
+        if(res){
+            res = static_cast<mlir::Value>(
+                builder.create<mlir::daphne::ColBindOp>(
+                    loc,
+                    concatFrameTypes(builder, res, col),
+                    res,
+                    col
+                )
+            );
+        }else{
+            res = col;
+        }
+    }
+    return res;
+}
+
 mlir::Attribute SQLVisitor::getEnum(const std::string & func){
     if(func == "count"){
         return static_cast<mlir::Attribute>(mlir::daphne::GroupEnumAttr::get(builder.getContext(), mlir::daphne::GroupEnum::COUNT));
@@ -327,6 +503,229 @@ std::string SQLVisitor::getEnumLabelExt(const std::string &func){
     return mlir::daphne::stringifyGroupEnum(getEnum(func).dyn_cast<mlir::daphne::GroupEnumAttr>().getValue()).str();
 }
 
+// ****************************************************************************
+// Query planning
+// ****************************************************************************
+
+mlir::Value SQLVisitor::addPlanTable(
+    SQLGrammarParser::TableReferenceContext * ctx
+)
+{
+    mlir::Value frame = utils.valueOrError(visit(ctx));
+
+    //The prefixed frame has no shape anymore, but the registered one might.
+    double cardinality = DEFAULT_CARDINALITY;
+    auto ft = fetchMLIR(ctx->var->getText()).getType().dyn_cast<mlir::daphne::FrameType>();
+    if(ft && ft.getNumRows() >= 0){
+        cardinality = ft.getNumRows();
+    }
+
+    std::string name = ctx->aka ? ctx->aka->getText() : ctx->var->getText();
+    planTables.push_back({fetchPrefix(name), frame, cardinality, cardinality, {}});
+    return frame;
+}
+
+size_t SQLVisitor::findPlanTable(SQLGrammarParser::StringIdentContext * ctx){
+    if(!ctx->frame){
+        return NO_TABLE;
+    }
+    std::string prefix = fetchPrefix(ctx->frame->getText());
+    for(size_t i = 0; i < planTables.size(); i++){
+        if(!prefix.empty() && planTables[i].prefix == prefix){
+            return i;
+        }
+    }
+    return NO_TABLE;
+}
+
+mlir::Value SQLVisitor::planFrom(SQLGrammarParser::SelectContext * ctx){
+    mlir::Location loc = utils.getLoc(ctx->start);
+
+    //Distribute the conditions combined by AND in the WHERE clause. Those on
+    //a single frame filter that frame, equalities between the columns of two
+    //frames become joins, and all others filter the joined frame.
+    std::vector<SQLGrammarParser::GeneralExprContext *> residual;
+    if(ctx->whereClause()){
+        std::vector<SQLGrammarParser::GeneralExprContext *> conjuncts;
+        splitConjuncts(ctx->whereClause()->cond, conjuncts);
+        for(auto cond : conjuncts){
+            std::vector<SQLGrammarParser::StringIdentContext *> idents;
+            collectIdents(cond, idents);
+            std::set<size_t> tables;
+            for(auto ident : idents){
+                tables.insert(findPlanTable(ident));
+            }
+
+            if(tables.size() == 1 && !tables.count(NO_TABLE)){
+                planTables[*tables.begin()].filters.push_back(cond);
+                continue;
+            }
+            auto cmp = dynamic_cast<SQLGrammarParser::CmpExprContext *>(unwrapParantheses(cond));
+            if(tables.size() == 2 && !tables.count(NO_TABLE) && cmp && cmp->op->getText() == "="){
+                auto lhs = dynamic_cast<SQLGrammarParser::IdentifierExprContext *>(unwrapParantheses(cmp->lhs));
+                auto rhs = dynamic_cast<SQLGrammarParser::IdentifierExprContext *>(unwrapParantheses(cmp->rhs));
+                if(lhs && rhs){
+                    auto lhsCol = dynamic_cast<SQLGrammarParser::StringIdentContext *>(lhs->selectIdent());
+                    auto rhsCol = dynamic_cast<SQLGrammarParser::StringIdentContext *>(rhs->selectIdent());
+                    joinPredicates.push_back({
+                        findPlanTable(lhsCol), lhsCol, findPlanTable(rhsCol), rhsCol, false
+                    });
+                    continue;
+                }
+            }
+            residual.push_back(cond);
+        }
+    }
+
+    //Prune the columns which are not referenced anywhere in the query before
+    //the joins. This requires all references to name their frame.
+    if(planTables.size() > 1){
+        std::vector<SQLGrammarParser::StringIdentContext *> idents;
+        collectIdents(ctx, idents);
+        std::vector<std::vector<std::string>> used(planTables.size());
+        bool prune = true;
+        for(auto ident : idents){
+            size_t t = findPlanTable(ident);
+            if(t == NO_TABLE){
+                prune = false;
+                break;
+            }
+            std::string label = planTables[t].prefix + "." + ident->var->getText();
+            if(std::find(used[t].begin(), used[t].end(), label) == used[t].end()){
+                used[t].push_back(label);
+            }
+        }
+        for(size_t t = 0; prune && t < planTables.size(); t++){
+            //A frame without referenced columns still determines the number
+            //of rows of the result.
+            if(!used[t].empty()){
+                planTables[t].frame = projectFrame(planTables[t].frame, used[t]);
+            }
+        }
+    }
+
+    //Filter the frames before joining them.
+    for(auto & table : planTables){
+        for(auto cond : table.filters){
+            table.frame = filterFrame(table.frame, cond);
+            table.cardinality *= estimateSelectivity(cond);
+        }
+    }
+
+    //Join the frames one by one. Each time, we take the frame resulting in
+    //the smallest estimated result among those we have a join predicate for.
+    //Only if there is none, we resort to the Cartesian product.
+    const size_t numTables = planTables.size();
+    std::vector<bool> joined(numTables, false);
+    auto connects = [&](const JoinPredicate & p, size_t t){
+        return !p.applied && (
+            (p.lhsTable == t && (p.rhsTable == NO_TABLE || joined[p.rhsTable])) ||
+            (p.rhsTable == t && (p.lhsTable == NO_TABLE || joined[p.lhsTable]))
+        );
+    };
+
+    size_t first = 0;
+    for(size_t t = 1; reorderJoins && t < numTables; t++){
+        if(planTables[t].cardinality < planTables[first].cardinality){
+            first = t;
+        }
+    }
+    mlir::Value res = planTables[first].frame;
+    double cardinality = planTables[first].cardinality;
+    joined[first] = true;
+
+    for(size_t i = 1; i < numTables; i++){
+        size_t next = NO_TABLE;
+        JoinPredicate * nextPredicate = nullptr;
+        double nextCardinality = 0;
+        for(size_t t = 0; t < numTables; t++){
+            if(joined[t]){
+                continue;
+            }
+            JoinPredicate * predicate = nullptr;
+            for(auto & p : joinPredicates){
+                if(connects(p, t)){
+                    predicate = &p;
+                    break;
+                }
+            }
+            double c = cardinality * planTables[t].cardinality;
+            if(predicate){
+                //Assuming a key/foreign key join, the number of distinct keys
+                //is the number of rows of the frame with the key.
+                size_t other = predicate->lhsTable == t ? predicate->rhsTable : predicate->lhsTable;
+                double keys = planTables[t].baseCardinality;
+                if(other != NO_TABLE){
+                    keys = std::max(keys, planTables[other].baseCardinality);
+                }
+                c /= keys;
+            }
+            if(
+                next == NO_TABLE
+                || (predicate && !nextPredicate)
+                || (!predicate == !nextPredicate && c < nextCardinality)
+            ){
+                next = t;
+                nextPredicate = predicate;
+                nextCardinality = c;
+            }
+            //Without reordering, we take the frames in the order of the query.
+            if(!reorderJoins){
+                break;
+            }
+        }
+
+        mlir::Value frame = planTables[next].frame;
+        mlir::Type resType = concatFrameTypes(builder, res, frame);
+        if(nextPredicate){
+            nextPredicate->applied = true;
+            //The column of the new frame goes to the right.
+            auto lhsCol = nextPredicate->lhsCol;
+            auto rhsCol = nextPredicate->rhsCol;
+            if(nextPredicate->rhsTable != next){
+                std::swap(lhsCol, rhsCol);
+            }
+            res = static_cast<mlir::Value>(
+                builder.create<mlir::daphne::InnerJoinOp>(
+                    loc,
+                    resType,
+                    res,
+                    frame,
+                    utils.valueOrError(visit(lhsCol)),
+                    utils.valueOrError(visit(rhsCol))
+                ));
+            //Further predicates between the new frame and the joined ones.
+            for(auto & p : joinPredicates){
+                if(connects(p, next)){
+                    p.applied = true;
+                    res = filterFrameEq(res, p.lhsCol, p.rhsCol);
+                }
+            }
+        }else{
+            res = static_cast<mlir::Value>(
+                builder.create<mlir::daphne::CartesianOp>(
+                    loc,
+                    resType,
+                    res,
+                    frame
+                ));
+        }
+        cardinality = nextCardinality;
+        joined[next] = true;
+    }
+
+    //Apply what is left on the joined frame.
+    for(auto & p : joinPredicates){
+        if(!p.applied){
+            res = filterFrameEq(res, p.lhsCol, p.rhsCol);
+        }
+    }
+    for(auto cond : residual){
+        res = filterFrame(res, cond);
+    }
+    return res;
+}
+
 // ****************************************************************************
 // Visitor functions wrongeedsda
 // ****************************************************************************
@@ -369,9 +768,11 @@ antlrcpp::Any SQLVisitor::visitSelect(
     //Setting Codegeneration for Where Clause
     setBit(sqlFlag, (int64_t)SQLBit::codegen, 1);
 
-    //Creating a Frame using FROM and JOIN
+    //Creating a Frame using FROM and JOIN, filtered by the where clause, if
+    //it exists.
     try{
-        currentFrame = utils.valueOrError(visit(ctx->tableExpr()));
+        visit(ctx->tableExpr());
+        currentFrame = planFrom(ctx);
     }catch(std::runtime_error & e){
         std::stringstream err_msg;
         err_msg << "Error during From statement. "
@@ -379,11 +780,6 @@ antlrcpp::Any SQLVisitor::visitSelect(
         throw std::runtime_error(err_msg.str());
     }
 
-    //If a where clause exist, filter <currentFrame> accordingly.
-    if(ctx->whereClause()){
-        currentFrame = utils.valueOrError(visit(ctx->whereClause()));
-    }
-
     //In case of a group by clause, we deactivate code generation for a moment
     //to scan the projection and havingClause for identifiers that need to be
     //included in the group. NOTE: in case the having or projection includes an
@@ -488,13 +884,17 @@ antlrcpp::Any SQLVisitor::visitTableExpr(
     SQLGrammarParser::TableExprContext * ctx
 )
 {
-    //We set the current frame as the result of the fromExpr
-    currentFrame = utils.valueOrError(visit(ctx->fromExpr()));
-    //And join other frames to the currentFrame.
+    //We collect the frames of the fromExpr and the joins, which planFrom
+    //puts together.
+    planTables.clear();
+    joinPredicates.clear();
+    reorderJoins = true;
+
+    visit(ctx->fromExpr());
     for(size_t i = 0; i < ctx->joinExpr().size(); i++){
-        currentFrame = utils.valueOrError(visit(ctx->joinExpr(i)));
+        visit(ctx->joinExpr(i));
     }
-    return currentFrame;
+    return nullptr;
 }
 
 //fromExpr
@@ -503,7 +903,7 @@ antlrcpp::Any SQLVisitor::visitTableIdentifierExpr(
 )
 {
     try{
-        mlir::Value var = utils.valueOrError(visit(ctx->var));
+        mlir::Value var = addPlanTable(ctx->var);
         return var;
     }catch(std::runtime_error &){
         std::stringstream err_msg;
@@ -516,32 +916,12 @@ antlrcpp::Any SQLVisitor::visitCartesianExpr(
     SQLGrammarParser::CartesianExprContext * ctx
 )
 {
-    //we have to at least two frames in the fromExpr. We join them together
-    //with the Cartesian product.
+    //we have to at least two frames in the fromExpr. planFrom joins them
+    //together, with the Cartesian product if there is no join predicate.
     try{
-        mlir::Location loc = utils.getLoc(ctx->start);
-        mlir::Value res;
-        mlir::Value lhs = utils.valueOrError(visit(ctx->lhs));
-        mlir::Value rhs = utils.valueOrError(visit(ctx->rhs));
-
-        std::vector<mlir::Type> colTypes;
-        for(mlir::Type t : lhs.getType().dyn_cast<mlir::daphne::FrameType>().getColumnTypes()){
-            colTypes.push_back(t);
-        }
-        for(mlir::Type t : rhs.getType().dyn_cast<mlir::daphne::FrameType>().getColumnTypes()){
-            colTypes.push_back(t);
-        }
-        mlir::Type t = mlir::daphne::FrameType::get(builder.getContext(), colTypes);
-
-        res = static_cast<mlir::Value>(
-            builder.create<mlir::daphne::CartesianOp>(
-                loc,
-                t,
-                lhs,
-                rhs
-            )
-        );
-        return res;
+        addPlanTable(ctx->lhs);
+        visit(ctx->rhs);
+        return nullptr;
     }catch(std::runtime_error &){
         throw std::runtime_error(
             "Unexpected Error during Cartesian operation"
@@ -554,35 +934,30 @@ antlrcpp::Any SQLVisitor::visitInnerJoin(
     SQLGrammarParser::InnerJoinContext * ctx
 )
 {
-    //we join to frames together. One is the currentFrame and the other is a
-    //new frame. The argument that referneces the currentFrame has to be on the
-    //left side of the Comparisons and the to be joined on the right side.
-    //This behavior could be changed here.
-    //TODO: Make the position independent
-    mlir::Location loc = utils.getLoc(ctx->start);
-
-    mlir::Value tojoin = utils.valueOrError(visit(ctx->var));
-    //rhs is join
-    //lhs is currentFrame
-    mlir::Value rhsName = utils.valueOrError(visit(ctx->rhs));
-    mlir::Value lhsName = utils.valueOrError(visit(ctx->lhs));
-
-    std::vector<mlir::Type> colTypes;
-    for(mlir::Type t : currentFrame.getType().dyn_cast<mlir::daphne::FrameType>().getColumnTypes())
-        colTypes.push_back(t);
-    for(mlir::Type t : tojoin.getType().dyn_cast<mlir::daphne::FrameType>().getColumnTypes())
-        colTypes.push_back(t);
-    mlir::Type t = mlir::daphne::FrameType::get(builder.getContext(), colTypes);
-
-    return static_cast<mlir::Value>(
-        builder.create<mlir::daphne::InnerJoinOp>(
-            loc,
-            t,
-            currentFrame,
-            tojoin,
-            rhsName,
-            lhsName
-        ));
+    //we join a new frame to the frames so far. The columns of the comparison
+    //can be given in any order, if they name their frames. Otherwise, the
+    //left one references the frames so far and the right one the new frame.
+    //NOTE: the grammar calls the left column rhs and the right one lhs.
+    size_t tojoin = planTables.size();
+    addPlanTable(ctx->var);
+
+    auto lhsCol = dynamic_cast<SQLGrammarParser::StringIdentContext *>(ctx->rhs);
+    auto rhsCol = dynamic_cast<SQLGrammarParser::StringIdentContext *>(ctx->lhs);
+    size_t lhsTable = findPlanTable(lhsCol);
+    size_t rhsTable = findPlanTable(rhsCol);
+    if(rhsTable == NO_TABLE){
+        rhsTable = tojoin;
+    }
+    if(lhsTable == NO_TABLE){
+        if(tojoin == 1){
+            lhsTable = 0;
+        }else{
+            //We don't know which of the frames so far it belongs to.
+            reorderJoins = false;
+        }
+    }
+    joinPredicates.push_back({lhsTable, lhsCol, rhsTable, rhsCol, false});
+    return nullptr;
 }
 
 
@@ -590,26 +965,9 @@ antlrcpp::Any SQLVisitor::visitWhereClause(
     SQLGrammarParser::WhereClauseContext * ctx
 )
 {
-    //Creates a FilterRowOp with the result of a generalExpr. The result is a
-    //matrix or a single value, vExpr. vExpr gets cast to a matrix, which
-    //FilterRowOp uses. IMPORTANT: FilterRowOp takes up the work to make a
-    //int/float into a boolean for the filtering.
-    mlir::Location loc = utils.getLoc(ctx->start);
-    mlir::Value filter;
-
-    antlrcpp::Any vExpr = visit(ctx->cond);
-    mlir::Value expr = utils.valueOrError(vExpr);
-    filter = castToMatrixColumn(expr);
-
-    mlir::Value v = static_cast<mlir::Value>(
-        builder.create<mlir::daphne::FilterRowOp>(
-            loc,
-            currentFrame.getType(),
-            currentFrame,
-            filter
-        )
-    );
-    return v;
+    //The where clause is split and its parts are applied where they fit
+    //best by planFrom, so it is never visited on its own.
+    throw std::runtime_error("Error: the where clause is planned by planFrom and must not be visited\n");
 }
 
 //groupByClause
@@ -124,6 +124,89 @@ class SQLVisitor : public SQLGrammarVisitor {
      */
     std::string fetchPrefix(const std::string& framename);
 
+//Query planning
+    //The FROM clause, the JOINs and the WHERE clause are not translated one
+    //by one. Instead, their frames and predicates are collected first, and
+    //planFrom() decides in which order to filter, join, and prune them.
+
+    /**
+     * @brief A frame of the FROM clause or a JOIN.
+     */
+    struct PlanTable {
+        std::string prefix; //the prefix of its column labels
+        mlir::Value frame; //the frame with prefixed column labels
+        double baseCardinality; //estimated number of rows
+        double cardinality; //estimated number of rows after the filters
+        std::vector<SQLGrammarParser::GeneralExprContext *> filters;
+    };
+
+    /**
+     * @brief An equality predicate between the columns of two frames, either
+     * from the ON of a JOIN or from the WHERE clause.
+     */
+    struct JoinPredicate {
+        size_t lhsTable; //NO_TABLE if unknown
+        SQLGrammarParser::StringIdentContext * lhsCol;
+        size_t rhsTable; //NO_TABLE if unknown
+        SQLGrammarParser::StringIdentContext * rhsCol;
+        bool applied;
+    };
+
+    static constexpr size_t NO_TABLE = static_cast<size_t>(-1);
+
+    std::vector<PlanTable> planTables;
+    std::vector<JoinPredicate> joinPredicates;
+    //false, if the frames must be joined in the order of the query, since a
+    //join predicate cannot be attributed to its frames.
+    bool reorderJoins = true;
+
+    /**
+     * @brief adds the frame of a table reference to the plan.
+     */
+    mlir::Value addPlanTable(SQLGrammarParser::TableReferenceContext * ctx);
+
+    /**
+     * @brief returns the index of the plan table a column belongs to, or
+     * NO_TABLE if the column is not qualified by a frame.
+     */
+    size_t findPlanTable(SQLGrammarParser::StringIdentContext * ctx);
+
+    /**
+     * @brief creates the frame the rest of the query works on from the
+     * collected plan tables, join predicates, and the WHERE clause.
+     *
+     * - Predicates of the WHERE clause referring to a single frame are applied
+     *   to that frame before any join.
+     * - Equality predicates between the columns of two frames become inner
+     *   joins, also if they stem from the WHERE clause.
+     * - The joins are ordered greedily by their estimated result size,
+     *   starting with the smallest frame and avoiding Cartesian products.
+     * - Columns not referenced anywhere in the query are pruned before the
+     *   joins.
+     */
+    mlir::Value planFrom(SQLGrammarParser::SelectContext * ctx);
+
+    /**
+     * @brief creates a FilterRowOp filtering the frame by a generalExpr.
+     */
+    mlir::Value filterFrame(
+        mlir::Value frame, SQLGrammarParser::GeneralExprContext * cond);
+
+    /**
+     * @brief creates a FilterRowOp keeping the rows of the frame where the two
+     * columns are equal.
+     */
+    mlir::Value filterFrameEq(
+        mlir::Value frame,
+        SQLGrammarParser::StringIdentContext * lhs,
+        SQLGrammarParser::StringIdentContext * rhs);
+
+    /**
+     * @brief creates a frame consisting of the given columns of the frame.
+     */
+    mlir::Value projectFrame(
+        mlir::Value frame, const std::vector<std::string> & labels);
+
     //TODO: Recognize Literals and somehow handle them for the group expr.
 //GROUP Information
     std::unordered_map <std::string, int8_t> grouped;
@@ -16,6 +16,8 @@
 
 #include "CallData.h"
 
+#include <runtime/local/datastructures/DataObjectFactory.h>
+
 void StoreCallData::Proceed() {
     if (status_ == CREATE)
     {
@@ -118,4 +120,98 @@ void FreeMemCallData::Proceed() {
         GPR_ASSERT(status_ == FINISH);
         delete this;
     }
-}
\ No newline at end of file
+}
+
+StoreStreamCallData::~StoreStreamCallData() {
+    // The matrix belongs to the worker only once all chunks were stored.
+    if (mat)
+        DataObjectFactory::destroy(mat);
+}
+
+void StoreStreamCallData::Proceed() {
+    if (status_ == CREATE)
+    {
+        // Make this instance progress to the PROCESS state.
+        status_ = PROCESS;
+
+        service_->RequestStoreStream(&ctx_, &reader_, cq_, cq_, this);
+    }
+    else if (status_ == PROCESS)
+    {
+        status_ = READ;
+
+        new StoreStreamCallData(worker, cq_);
+
+        reader_.Read(&chunk, this);
+    }
+    else if (status_ == READ)
+    {
+        // A chunk has been read.
+        grpc::Status status = worker->StoreChunk(chunk, mat, numCells);
+        if (status.ok())
+            reader_.Read(&chunk, this);
+        else {
+            status_ = FINISH;
+            reader_.FinishWithError(status, this);
+        }
+    }
+    else
+    {
+        GPR_ASSERT(status_ == FINISH);
+        delete this;
+    }
+}
+
+void StoreStreamCallData::ProceedNotOk() {
+    if (status_ == READ)
+    {
+        // The client has sent all chunks, or the stream broke before.
+        status_ = FINISH;
+
+        grpc::Status status = worker->StoreFinish(mat, numCells, &storedData);
+        if (status.ok()) {
+            mat = nullptr;
+            reader_.Finish(storedData, status, this);
+        }
+        else
+            reader_.FinishWithError(status, this);
+    }
+    else
+        delete this;
+}
+
+void TransferStreamCallData::Proceed() {
+    if (status_ == CREATE)
+    {
+        // Make this instance progress to the PROCESS state.
+        status_ = PROCESS;
+
+        service_->RequestTransferStream(&ctx_, &storedData, &writer_, cq_, cq_,
+                                    this);
+    }
+    else if (status_ == PROCESS || status_ == WRITE)
+    {
+        if (status_ == PROCESS)
+            new TransferStreamCallData(worker, cq_);
+        // The previous chunk has been written, unless it was the last one.
+        else if (nextCell == chunk.num_rows() * chunk.num_cols()) {
+            status_ = FINISH;
+            writer_.Finish(grpc::Status::OK, this);
+            return;
+        }
+        status_ = WRITE;
+
+        grpc::Status status = worker->TransferChunk(&storedData, nextCell, &chunk, nextCell);
+        if (status.ok())
+            writer_.Write(chunk, this);
+        else {
+            status_ = FINISH;
+            writer_.Finish(status, this);
+        }
+    }
+    else
+    {
+        GPR_ASSERT(status_ == FINISH);
+        delete this;
+    }
+}
@@ -25,6 +25,11 @@ class CallData
 {
 public:
     virtual void Proceed() = 0;
+    /**
+     * Called instead of `Proceed()` if an operation of the call did not
+     * complete normally. For a stream sent by the client, this is its end.
+     */
+    virtual void ProceedNotOk() { delete this; }
     virtual ~CallData() = default;
 };
 class StoreCallData final : public CallData
@@ -158,3 +163,77 @@ class FreeMemCallData final : public CallData
     };
     CallStatus status_; // The current serving state.
 };
+
+class StoreStreamCallData final : public CallData
+{
+public:
+    StoreStreamCallData(WorkerImpl *worker_, grpc::ServerCompletionQueue *cq)
+        : worker(worker_), service_(&worker_->service_), cq_(cq), reader_(&ctx_), status_(CREATE)
+    {
+        // Invoke the serving logic right away.
+        Proceed();
+    }
+    ~StoreStreamCallData() override;
+    void Proceed() override;
+    void ProceedNotOk() override;
+private:
+    WorkerImpl *worker;
+    distributed::Worker::AsyncService *service_;
+    // The producer-consumer queue where for asynchronous server notifications.
+    grpc::ServerCompletionQueue *cq_;
+    grpc::ServerContext ctx_;
+    // The chunk read last.
+    distributed::MatrixChunk chunk;
+    // The matrix the chunks are written into.
+    DenseMatrix<double> *mat = nullptr;
+    // The number of cells received so far.
+    size_t numCells = 0;
+    // What we send back to the client.
+    distributed::StoredData storedData;
+    // The means to get back to the client.
+    grpc::ServerAsyncReader<distributed::StoredData, distributed::MatrixChunk> reader_;
+
+    enum CallStatus
+    {
+        CREATE,
+        PROCESS,
+        READ,
+        FINISH
+    };
+    CallStatus status_; // The current serving state.
+};
+
+class TransferStreamCallData final : public CallData
+{
+public:
+    TransferStreamCallData(WorkerImpl *worker_, grpc::ServerCompletionQueue *cq)
+        : worker(worker_), service_(&worker_->service_), cq_(cq), writer_(&ctx_), status_(CREATE)
+    {
+        // Invoke the serving logic right away.
+        Proceed();
+    }
+    void Proceed() override;
+private:
+    WorkerImpl *worker;
+    distributed::Worker::AsyncService *service_;
+    // The producer-consumer queue where for asynchronous server notifications.
+    grpc::ServerCompletionQueue *cq_;
+    grpc::ServerContext ctx_;
+    // What we get from the client.
+    distributed::StoredData storedData;
+    // The chunk written last.
+    distributed::MatrixChunk chunk;
+    // The first cell of the next chunk.
+    size_t nextCell = 0;
+    // The means to get back to the client.
+    grpc::ServerAsyncWriter<distributed::MatrixChunk> writer_;
+
+    enum CallStatus
+    {
+        CREATE,
+        PROCESS,
+        WRITE,
+        FINISH
+    };
+    CallStatus status_; // The current serving state.
+};
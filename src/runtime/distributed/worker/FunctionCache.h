@@ -0,0 +1,103 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_DISTRIBUTED_WORKER_FUNCTIONCACHE_H
+#define SRC_RUNTIME_DISTRIBUTED_WORKER_FUNCTIONCACHE_H
+
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief The hash identifying the MLIR code of a distributed task.
+ *
+ * Computed by the coordinator and the workers alike, so it must not depend on
+ * the build or the platform (unlike `std::hash`). Uses 64-bit FNV-1a.
+ */
+inline uint64_t hashMlirCode(const std::string & code) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for(unsigned char c : code) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief A cache of the functions a worker has compiled, keyed by the hash of
+ * their MLIR code, which evicts the least recently used function once it
+ * holds `capacity` functions.
+ *
+ * Functions are handed out as shared pointers, such that evicting a function
+ * does not destroy it while it is still being executed.
+ */
+template<class Function>
+class FunctionCache {
+    using Entry = std::pair<uint64_t, std::shared_ptr<Function>>;
+
+    size_t capacity;
+    // most recently used first
+    std::list<Entry> entries;
+    std::unordered_map<uint64_t, typename std::list<Entry>::iterator> index;
+
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 64;
+
+    explicit FunctionCache(size_t capacity = DEFAULT_CAPACITY) : capacity(capacity ? capacity : 1) {
+    }
+
+    /**
+     * @brief Returns the function with the given hash, or `nullptr` if it is
+     * not cached.
+     */
+    std::shared_ptr<Function> get(uint64_t hash) {
+        auto it = index.find(hash);
+        if(it == index.end())
+            return nullptr;
+        entries.splice(entries.begin(), entries, it->second);
+        return it->second->second;
+    }
+
+    /**
+     * @brief Caches the given function under the given hash, replacing any
+     * function cached under it before.
+     */
+    void put(uint64_t hash, std::shared_ptr<Function> function) {
+        auto it = index.find(hash);
+        if(it != index.end()) {
+            it->second->second = std::move(function);
+            entries.splice(entries.begin(), entries, it->second);
+            return;
+        }
+        if(entries.size() == capacity) {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+        entries.emplace_front(hash, std::move(function));
+        index[hash] = entries.begin();
+    }
+
+    size_t size() const {
+        return entries.size();
+    }
+};
+
+#endif //SRC_RUNTIME_DISTRIBUTED_WORKER_FUNCTIONCACHE_H
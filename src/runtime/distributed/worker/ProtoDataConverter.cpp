@@ -16,6 +16,16 @@
 
 #include "ProtoDataConverter.h"
 
+#include <algorithm>
+#include <stdexcept>
+
+#include <cstring>
+
+// Chunks contain the cells as they are in memory.
+#if defined(__BYTE_ORDER__)
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "matrix chunks are little-endian");
+#endif
+
 void ProtoDataConverter::convertToProto(const DenseMatrix<double> *mat, distributed::Matrix *matProto)
 {
     convertToProto(mat, matProto, 0, mat->getNumRows(), 0, mat->getNumCols());
@@ -59,4 +69,63 @@ void ProtoDataConverter::convertFromProto(const distributed::Matrix &matProto,
 void ProtoDataConverter::convertFromProto(const distributed::Matrix &matProto, DenseMatrix<double> *mat)
 {
     convertFromProto(matProto, mat, 0, mat->getNumRows(), 0, mat->getNumCols());
-}
\ No newline at end of file
+}
+
+size_t ProtoDataConverter::convertToChunk(const DenseMatrix<double> *mat,
+                                          distributed::MatrixChunk *chunk,
+                                          size_t rowBegin,
+                                          size_t rowEnd,
+                                          size_t colBegin,
+                                          size_t colEnd,
+                                          size_t firstCell)
+{
+    const size_t numCols = colEnd - colBegin;
+    const size_t numCells = (rowEnd - rowBegin) * numCols;
+    const size_t endCell = std::min(numCells, firstCell + CHUNK_SIZE / sizeof(double));
+    chunk->set_num_rows(rowEnd - rowBegin);
+    chunk->set_num_cols(numCols);
+    chunk->set_first_cell(firstCell);
+
+    auto *cells = chunk->mutable_cells();
+    cells->resize((endCell - firstCell) * sizeof(double));
+    auto *dst = cells->data();
+    const double *values = mat->getValues();
+    const size_t rowSkip = mat->getRowSkip();
+    // copy row by row, the first and the last row may be partial
+    for (size_t i = firstCell; i < endCell;) {
+        const size_t r = i / numCols;
+        const size_t c = i % numCols;
+        const size_t n = std::min(numCols - c, endCell - i);
+        memcpy(dst, values + (rowBegin + r) * rowSkip + colBegin + c, n * sizeof(double));
+        dst += n * sizeof(double);
+        i += n;
+    }
+    return endCell;
+}
+
+void ProtoDataConverter::convertFromChunk(const distributed::MatrixChunk &chunk,
+                                          DenseMatrix<double> *mat,
+                                          size_t rowBegin,
+                                          size_t colBegin)
+{
+    const size_t numCols = chunk.num_cols();
+    const size_t firstCell = chunk.first_cell();
+    const auto &cells = chunk.cells();
+    if (cells.size() % sizeof(double) ||
+            rowBegin + chunk.num_rows() > mat->getNumRows() || colBegin + numCols > mat->getNumCols() ||
+            firstCell + cells.size() / sizeof(double) > chunk.num_rows() * numCols)
+        throw std::runtime_error("ProtoDataConverter: matrix chunk does not fit the matrix");
+
+    const size_t endCell = firstCell + cells.size() / sizeof(double);
+    const auto *src = cells.data();
+    double *values = mat->getValues();
+    const size_t rowSkip = mat->getRowSkip();
+    for (size_t i = firstCell; i < endCell;) {
+        const size_t r = i / numCols;
+        const size_t c = i % numCols;
+        const size_t n = std::min(numCols - c, endCell - i);
+        memcpy(values + (rowBegin + r) * rowSkip + colBegin + c, src, n * sizeof(double));
+        src += n * sizeof(double);
+        i += n;
+    }
+}
@@ -24,6 +24,11 @@
 class ProtoDataConverter
 {
 public:
+    /**
+     * The number of bytes of cells sent in one `MatrixChunk`.
+     */
+    static constexpr size_t CHUNK_SIZE = 1 << 20;
+
     static void convertToProto(const DenseMatrix<double> *mat, distributed::Matrix *matProto);
     static void convertToProto(const DenseMatrix<double> *mat,
                                distributed::Matrix *matProto,
@@ -38,6 +43,29 @@ public:
                                  size_t rowEnd,
                                  size_t colBegin,
                                  size_t colEnd);
+
+    /**
+     * Copies the cells of the given sub-matrix starting at the cell `firstCell`
+     * (in row-major order) into `chunk`, at most `CHUNK_SIZE` bytes of them.
+     * @return the index of the first cell not copied, which is the number of
+     * cells of the sub-matrix after its last chunk
+     */
+    static size_t convertToChunk(const DenseMatrix<double> *mat,
+                                 distributed::MatrixChunk *chunk,
+                                 size_t rowBegin,
+                                 size_t rowEnd,
+                                 size_t colBegin,
+                                 size_t colEnd,
+                                 size_t firstCell);
+    /**
+     * Copies the cells of `chunk` directly into the sub-matrix of `mat`
+     * starting at the row `rowBegin` and the column `colBegin`. Throws if the
+     * chunk does not fit.
+     */
+    static void convertFromChunk(const distributed::MatrixChunk &chunk,
+                                 DenseMatrix<double> *mat,
+                                 size_t rowBegin,
+                                 size_t colBegin);
 };
 
 #endif //SRC_RUNTIME_DISTRIBUTED_UTILS_PROTODATACONVERTER_H
\ No newline at end of file
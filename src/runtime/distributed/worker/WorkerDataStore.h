@@ -0,0 +1,141 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_DISTRIBUTED_WORKER_WORKERDATASTORE_H
+#define SRC_RUNTIME_DISTRIBUTED_WORKER_WORKERDATASTORE_H
+
+#include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/Matrix.h>
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief The data objects held by a worker, which are accessed by all threads
+ * serving requests.
+ *
+ * The objects are spread over shards with a lock each, such that concurrent
+ * requests for different objects rarely wait for each other. They are
+ * reference counted: `get` shares the ownership of an object, and `remove`
+ * (on `FreeMem`) only drops the reference of the store, such that an object
+ * still used by a running task is destroyed once that task has finished.
+ */
+class WorkerDataStore
+{
+public:
+    using Object = std::shared_ptr<Matrix<double>>;
+
+private:
+    static constexpr size_t NUM_SHARDS = 64;
+
+    struct Shard
+    {
+        std::mutex mtx;
+        std::unordered_map<std::string, Object> objects;
+    };
+
+    std::array<Shard, NUM_SHARDS> shards;
+    std::atomic<uint64_t> idCounter{0};
+
+    Shard &getShard(const std::string &id)
+    {
+        return shards[std::hash<std::string>{}(id) % NUM_SHARDS];
+    }
+
+public:
+    /**
+     * Takes the ownership of the given matrix, which is destroyed with its
+     * last reference.
+     */
+    static Object wrap(Matrix<double> *mat)
+    {
+        return Object(mat, [](Matrix<double> *m) {
+            if (auto dense = dynamic_cast<DenseMatrix<double> *>(m))
+                DataObjectFactory::destroy(dense);
+            else if (auto sparse = dynamic_cast<CSRMatrix<double> *>(m))
+                DataObjectFactory::destroy(sparse);
+        });
+    }
+
+    /**
+     * Stores the given matrix (taking its ownership) under a new identifier.
+     * @return the identifier
+     */
+    std::string add(Matrix<double> *mat)
+    {
+        auto id = "tmp_" + std::to_string(idCounter++);
+        auto obj = wrap(mat);
+        auto &shard = getShard(id);
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        shard.objects.emplace(id, std::move(obj));
+        return id;
+    }
+
+    /**
+     * Stores the given object under the given identifier, unless there is
+     * one already.
+     * @return the object stored under the identifier
+     */
+    Object getOrAdd(const std::string &id, Object obj)
+    {
+        auto &shard = getShard(id);
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        return shard.objects.emplace(id, std::move(obj)).first->second;
+    }
+
+    /**
+     * @return the object stored under the given identifier, or `nullptr`
+     */
+    Object get(const std::string &id)
+    {
+        auto &shard = getShard(id);
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        auto it = shard.objects.find(id);
+        return it == shard.objects.end() ? nullptr : it->second;
+    }
+
+    /**
+     * Removes the object stored under the given identifier, if any.
+     * @return whether there was an object
+     */
+    bool remove(const std::string &id)
+    {
+        Object obj;
+        auto &shard = getShard(id);
+        {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            auto it = shard.objects.find(id);
+            if (it == shard.objects.end())
+                return false;
+            obj = std::move(it->second);
+            shard.objects.erase(it);
+        }
+        // the object (if it was the last reference) is destroyed outside the lock
+        return true;
+    }
+};
+
+#endif //SRC_RUNTIME_DISTRIBUTED_WORKER_WORKERDATASTORE_H
@@ -39,9 +39,24 @@
 #include <compiler/execution/DaphneIrExecutor.h>
 #include "CallData.h"
 
+#include <thread>
+
 const std::string WorkerImpl::DISTRIBUTED_FUNCTION_NAME = "dist";
 
-WorkerImpl::WorkerImpl() : tmp_file_counter_(0), localData_()
+struct WorkerImpl::CompiledFunction
+{
+    // Declared in this order, such that the engine is destroyed before the
+    // module and the module before the context owned by the executor.
+    std::unique_ptr<DaphneIrExecutor> executor;
+    mlir::OwningModuleRef module;
+    std::unique_ptr<mlir::ExecutionEngine> engine;
+    mlir::FunctionType type;
+    // To tell apart functions whose codes have the same hash.
+    std::string mlirCode;
+};
+
+WorkerImpl::WorkerImpl(size_t functionCacheCapacity)
+    : localData_(), functionCache_(functionCacheCapacity)
 {
 }
 
@@ -54,30 +69,43 @@ WorkerImpl::~WorkerImpl() = default;
 //     cq_->Shutdown();
 //     HandleRpcsThread.join();
 // }
-void WorkerImpl::HandleRpcs() {
-    // Spawn a new CallData instance to serve new clients.
-    new StoreCallData(this, cq_.get());
-    new ComputeCallData(this, cq_.get());
-    new TransferCallData(this, cq_.get());
-    new FreeMemCallData(this, cq_.get());
-    void* tag;  // uniquely identifies a request.
-    bool ok;
-    // Block waiting to read the next event from the completion queue. The
-    // event is uniquely identified by its tag, which in this case is the
-    // memory address of a CallData instance.
-    // The return value of Next should always be checked. This return value
-    // tells us whether there is any kind of event or cq_ is shutting down.
-    while (cq_->Next(&tag, &ok)) {        
-        if(ok){         
-            // Thread pool ? with caution. For now on each worker only one thread operates (sefe IO).
-            // We might need to add locks inside Store/Compute/Transfer methods if we deploy threads
-            static_cast<CallData*>(tag)->Proceed();
-        } else {
-            // TODO maybe handle this internally ?
-            delete static_cast<CallData*>(tag);
+void WorkerImpl::HandleRpcs(size_t numThreads) {
+    if (numThreads == 0)
+        numThreads = DEFAULT_NUM_RPC_THREADS;
+    auto poll = [this]() {
+        // Spawn a new CallData instance to serve new clients. Each thread
+        // keeps one request of each kind pending, such that as many requests
+        // can be accepted at once as there are threads.
+        new StoreCallData(this, cq_.get());
+        new ComputeCallData(this, cq_.get());
+        new TransferCallData(this, cq_.get());
+        new FreeMemCallData(this, cq_.get());
+        new StoreStreamCallData(this, cq_.get());
+        new TransferStreamCallData(this, cq_.get());
+        void* tag;  // uniquely identifies a request.
+        bool ok;
+        // Block waiting to read the next event from the completion queue. The
+        // event is uniquely identified by its tag, which in this case is the
+        // memory address of a CallData instance. The events of one CallData
+        // instance never overlap, but those of different instances are
+        // handled by all threads concurrently.
+        // The return value of Next should always be checked. This return value
+        // tells us whether there is any kind of event or cq_ is shutting down.
+        while (cq_->Next(&tag, &ok)) {        
+            if(ok){         
+                static_cast<CallData*>(tag)->Proceed();
+            } else {
+                static_cast<CallData*>(tag)->ProceedNotOk();
+            }
         }
-    }
-  }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < numThreads; i++)
+        threads.emplace_back(poll);
+    poll();
+    for (auto &t : threads)
+        t.join();
+}
 
 grpc::Status WorkerImpl::Store(::grpc::ServerContext *context,
                                const ::distributed::Matrix *request,
@@ -86,8 +114,7 @@ grpc::Status WorkerImpl::Store(::grpc::ServerContext *context,
     auto *mat = DataObjectFactory::create<DenseMatrix<double>>(request->num_rows(), request->num_cols(), false);
     ProtoDataConverter::convertFromProto(*request, mat);
 
-    auto identification = "tmp_" + std::to_string(tmp_file_counter_++);
-    localData_[identification] = mat;
+    auto identification = localData_.add(mat);
 
     response->set_filename(identification);
     response->set_num_rows(mat->getNumRows());
@@ -95,49 +122,93 @@ grpc::Status WorkerImpl::Store(::grpc::ServerContext *context,
     return ::grpc::Status::OK;
 }
 
-grpc::Status WorkerImpl::Compute(::grpc::ServerContext *context,
-                                 const ::distributed::Task *request,
-                                 ::distributed::ComputeResult *response)
+grpc::Status WorkerImpl::StoreChunk(const ::distributed::MatrixChunk &chunk, DenseMatrix<double> *&mat, size_t &numCells)
 {
+    if (!mat)
+        mat = DataObjectFactory::create<DenseMatrix<double>>(chunk.num_rows(), chunk.num_cols(), false);
+    else if (mat->getNumRows() != chunk.num_rows() || mat->getNumCols() != chunk.num_cols())
+        return ::grpc::Status(::grpc::StatusCode::INVALID_ARGUMENT, "Chunks of different matrices");
+    if (chunk.first_cell() != numCells)
+        return ::grpc::Status(::grpc::StatusCode::INVALID_ARGUMENT, "Chunks out of order");
+    try {
+        ProtoDataConverter::convertFromChunk(chunk, mat, 0, 0);
+    }
+    catch (std::exception &e) {
+        return ::grpc::Status(::grpc::StatusCode::INVALID_ARGUMENT, e.what());
+    }
+    numCells += chunk.cells().size() / sizeof(double);
+    return ::grpc::Status::OK;
+}
+
+grpc::Status WorkerImpl::StoreFinish(DenseMatrix<double> *mat, size_t numCells, ::distributed::StoredData *response)
+{
+    if (!mat)
+        return ::grpc::Status(::grpc::StatusCode::INVALID_ARGUMENT, "No chunks received");
+    // The stream also ends if the client or the connection failed.
+    if (numCells != mat->getNumRows() * mat->getNumCols())
+        return ::grpc::Status(::grpc::StatusCode::DATA_LOSS,
+            "Stream ended after " + std::to_string(numCells) + " of "
+            + std::to_string(mat->getNumRows() * mat->getNumCols()) + " cells");
+    auto identification = localData_.add(mat);
+
+    response->set_filename(identification);
+    response->set_num_rows(mat->getNumRows());
+    response->set_num_cols(mat->getNumCols());
+    return ::grpc::Status::OK;
+}
+
+grpc::Status WorkerImpl::TransferChunk(const ::distributed::StoredData *request,
+                                       size_t firstCell,
+                                       ::distributed::MatrixChunk *chunk,
+                                       size_t &nextCell)
+{
+    auto mat = readOrGetMatrix(request->filename(), request->num_rows(), request->num_cols(), false);
+    auto matDense = dynamic_cast<DenseMatrix<double> *>(mat.get());
+    if (!matDense)
+        return ::grpc::Status(::grpc::StatusCode::UNIMPLEMENTED, "Transfer is only implemented for DenseMatrix");
+    nextCell = ProtoDataConverter::convertToChunk(matDense, chunk,
+        0, matDense->getNumRows(), 0, matDense->getNumCols(), firstCell);
+    return ::grpc::Status::OK;
+}
+
+grpc::Status WorkerImpl::compile(const std::string &mlirCode, std::shared_ptr<CompiledFunction> &function)
+{
+    auto fn = std::make_shared<CompiledFunction>();
     // ToDo: user config
     DaphneUserConfig cfg{false};
-    // TODO Decide if vectorized pipelines should be used on this worker.
+    // The vectorized pipelines use all cores of the worker, the few RPC
+    // threads mostly wait for requests.
+    cfg.use_vectorized_exec = true;
     // TODO Decide if selectMatrixReprs should be used on this worker.
     // TODO Once we hand over longer pipelines to the workers, we might not
     // want to hardcode insertFreeOp to false anymore. But maybe we will insert
     // the FreeOps at the coordinator already.
-    DaphneIrExecutor executor(false, false, cfg);
+    fn->executor = std::make_unique<DaphneIrExecutor>(false, false, cfg);
 
-    mlir::OwningModuleRef module(mlir::parseSourceString<mlir::ModuleOp>(request->mlir_code(), executor.getContext()));
-    if (!module) {
+    fn->module = mlir::parseSourceString<mlir::ModuleOp>(mlirCode, fn->executor->getContext());
+    if (!fn->module) {
         auto message = "Failed to parse source string.\n";
         llvm::errs() << message;
         return ::grpc::Status(::grpc::StatusCode::ABORTED, message);
     }
 
-    auto *distOp = module->lookupSymbol(DISTRIBUTED_FUNCTION_NAME);
+    auto *distOp = fn->module->lookupSymbol(DISTRIBUTED_FUNCTION_NAME);
     mlir::FuncOp distFunc;
     if (!(distFunc = llvm::dyn_cast_or_null<mlir::FuncOp>(distOp))) {
         auto message = "MLIR fragment has to contain `dist` FuncOp\n";
         llvm::errs() << message;
         return ::grpc::Status(::grpc::StatusCode::ABORTED, message);
     }
-    auto distFuncTy = distFunc.getType();
-
-    std::vector<void *> inputs;
-    std::vector<void *> outputs;
-    auto packedInputsOutputs = createPackedCInterfaceInputsOutputs(distFuncTy,
-        request->inputs(),
-        outputs,
-        inputs);
+    fn->type = distFunc.getType();
 
-    // Execution
     // TODO Before we run the passes, we should insert information on shape
     // (and potentially other properties) into the types of the arguments of
     // the DISTRIBUTED_FUNCTION_NAME function. At least the shape can be
     // obtained from the cached data partitions in localData_. Then, shape
-    // inference etc. should work within this function.
-    if (!executor.runPasses(module.get())) {
+    // inference etc. should work within this function. Note that compiled
+    // functions are cached by their code, so such information would have to
+    // become part of the cache key.
+    if (!fn->executor->runPasses(fn->module.get())) {
         std::stringstream ss;
         ss << "Module Pass Error.\n";
         // module->print(ss, llvm::None);
@@ -145,13 +216,60 @@ grpc::Status WorkerImpl::Compute(::grpc::ServerContext *context,
         return ::grpc::Status(::grpc::StatusCode::ABORTED, ss.str());
     }
 
-    mlir::registerLLVMDialectTranslation(*module->getContext());
+    mlir::registerLLVMDialectTranslation(*fn->module->getContext());
 
-    auto engine = executor.createExecutionEngine(module.get());
-    if (!engine) {
+    fn->engine = fn->executor->createExecutionEngine(fn->module.get());
+    if (!fn->engine) {
         return ::grpc::Status(::grpc::StatusCode::ABORTED, "Failed to create JIT-Execution engine");
     }
-    auto error = engine->invokePacked(DISTRIBUTED_FUNCTION_NAME,
+    fn->mlirCode = mlirCode;
+    function = std::move(fn);
+    return ::grpc::Status::OK;
+}
+
+grpc::Status WorkerImpl::Compute(::grpc::ServerContext *context,
+                                 const ::distributed::Task *request,
+                                 ::distributed::ComputeResult *response)
+{
+    // Look up the function in the cache, compile it on a miss. The
+    // coordinator sends only the hash of functions we have received before.
+    // Functions are compiled outside the lock, possibly by several threads
+    // at once.
+    std::shared_ptr<CompiledFunction> fn;
+    if (request->mlir_code().empty()) {
+        std::lock_guard<std::mutex> lock(functionCacheMutex_);
+        fn = functionCache_.get(request->mlir_hash());
+        if (!fn)
+            return ::grpc::Status(::grpc::StatusCode::NOT_FOUND, "Unknown function, the MLIR code has to be sent");
+    }
+    else {
+        const uint64_t hash = hashMlirCode(request->mlir_code());
+        {
+            std::lock_guard<std::mutex> lock(functionCacheMutex_);
+            fn = functionCache_.get(hash);
+        }
+        if (!fn || fn->mlirCode != request->mlir_code()) {
+            auto status = compile(request->mlir_code(), fn);
+            if (!status.ok())
+                return status;
+            std::lock_guard<std::mutex> lock(functionCacheMutex_);
+            functionCache_.put(hash, fn);
+        }
+    }
+    auto distFuncTy = fn->type;
+
+    std::vector<void *> inputs;
+    std::vector<void *> outputs;
+    // Keeps the inputs alive, even if they are freed by another request.
+    std::vector<WorkerDataStore::Object> inputObjects;
+    auto packedInputsOutputs = createPackedCInterfaceInputsOutputs(distFuncTy,
+        request->inputs(),
+        outputs,
+        inputs,
+        inputObjects);
+
+    // Execution
+    auto error = fn->engine->invokePacked(DISTRIBUTED_FUNCTION_NAME,
         llvm::MutableArrayRef<void *>{&packedInputsOutputs[0], (size_t)0});
 
     if (error) {
@@ -164,15 +282,13 @@ grpc::Status WorkerImpl::Compute(::grpc::ServerContext *context,
         auto output = std::get<0>(zipped);
         auto type = std::get<1>(zipped);
 
-        auto identification = "tmp_" + std::to_string(tmp_file_counter_++);
-        localData_[identification] = output;
-
         distributed::WorkData::DataCase dataCase = dataCaseForType(type);
 
         distributed::WorkData workData;
         switch (dataCase) {
         case distributed::WorkData::kStored: {
             auto mat = static_cast<DenseMatrix<double> *>(output);
+            auto identification = localData_.add(mat);
 
             workData.mutable_stored()->set_filename(identification);
             workData.mutable_stored()->set_num_rows(mat->getNumRows());
@@ -204,8 +320,8 @@ grpc::Status WorkerImpl::Transfer(::grpc::ServerContext *context,
                                   const ::distributed::StoredData *request,
                                   ::distributed::Matrix *response)
 {
-    Matrix<double> *mat = readOrGetMatrix(request->filename(), request->num_rows(), request->num_cols(), false);
-    auto matDense = dynamic_cast<DenseMatrix<double> *>(mat);
+    auto mat = readOrGetMatrix(request->filename(), request->num_rows(), request->num_cols(), false);
+    auto matDense = dynamic_cast<DenseMatrix<double> *>(mat.get());
     assert(matDense && "Transfer is only implemented for DenseMatrix");
     ProtoDataConverter::convertToProto(matDense, response);
     return ::grpc::Status::OK;
@@ -214,7 +330,8 @@ grpc::Status WorkerImpl::Transfer(::grpc::ServerContext *context,
 std::vector<void *> WorkerImpl::createPackedCInterfaceInputsOutputs(mlir::FunctionType functionType,
                                                                     google::protobuf::RepeatedPtrField<distributed::WorkData> workInputs,
                                                                     std::vector<void *> &outputs,
-                                                                    std::vector<void *> &inputs)
+                                                                    std::vector<void *> &inputs,
+                                                                    std::vector<WorkerDataStore::Object> &inputObjects)
 {
     assert(static_cast<int>(functionType.getNumInputs()) == workInputs.size()
         && "Number of inputs received have to match number of MLIR fragment inputs");
@@ -228,7 +345,8 @@ std::vector<void *> WorkerImpl::createPackedCInterfaceInputsOutputs(mlir::Functi
         auto type = std::get<0>(typeAndWorkInput);
         auto workInput = std::get<1>(typeAndWorkInput);
 
-        inputs.push_back(loadWorkInputData(type, workInput));
+        inputObjects.push_back(loadWorkInputData(type, workInput));
+        inputs.push_back(inputObjects.back().get());
         inputsAndOutputs.push_back(&inputs.back());
     }
 
@@ -240,7 +358,7 @@ std::vector<void *> WorkerImpl::createPackedCInterfaceInputsOutputs(mlir::Functi
     return inputsAndOutputs;
 }
 
-void *WorkerImpl::loadWorkInputData(mlir::Type mlirType, const distributed::WorkData &workInput)
+WorkerDataStore::Object WorkerImpl::loadWorkInputData(mlir::Type mlirType, const distributed::WorkData &workInput)
 {
     switch (workInput.data_case()) {
     case distributed::WorkData::kStored: {
@@ -257,12 +375,11 @@ void *WorkerImpl::loadWorkInputData(mlir::Type mlirType, const distributed::Work
     }
 }
 
-Matrix<double> *WorkerImpl::readOrGetMatrix(const std::string &filename, size_t numRows, size_t numCols, bool isSparse)
+WorkerDataStore::Object WorkerImpl::readOrGetMatrix(const std::string &filename, size_t numRows, size_t numCols, bool isSparse)
 {
-    auto data_it = localData_.find(filename);
-    if (data_it != localData_.end()) {
+    if (auto obj = localData_.get(filename)) {
         // Data already cached
-        return static_cast<Matrix<double> *>(data_it->second);
+        return obj;
     }
     else {
         // Data not yet loaded -> load from file
@@ -279,10 +396,9 @@ Matrix<double> *WorkerImpl::readOrGetMatrix(const std::string &filename, size_t
             readCsv<DenseMatrix<double>>(m2, filename.c_str(), numRows, numCols, delim);
             m = m2;
         }
-//        auto result = localData_.insert({filename, m});
-//        assert(result.second && "Value should always be inserted");
-        assert(localData_.insert({filename, m}).second && "Value should always be inserted");
-        return m;
+        // Another request may have loaded the same file in the meantime, then
+        // its matrix is used and ours is dropped.
+        return localData_.getOrAdd(filename, WorkerDataStore::wrap(m));
     }
 }
 
@@ -290,16 +406,7 @@ grpc::Status WorkerImpl::FreeMem(::grpc::ServerContext *context,
                                const ::distributed::StoredData *request,
                                ::distributed::Empty *emptyMessg)
 {
-    auto filename = request->filename();
-    auto data_it = localData_.find(filename);
-
-    if (data_it != localData_.end()) {
-        auto * mat = reinterpret_cast<Matrix<double> *>(data_it->second);
-        if(auto m = dynamic_cast<DenseMatrix<double> *>(mat))
-            DataObjectFactory::destroy(m);
-        else if(auto m = dynamic_cast<CSRMatrix<double> *>(mat))
-            DataObjectFactory::destroy(m);
-        localData_.erase(filename);
-    }
+    // The matrix is destroyed once running tasks do not use it anymore.
+    localData_.remove(request->filename());
     return grpc::Status::OK;
 }
@@ -18,9 +18,12 @@
 #define SRC_RUNTIME_DISTRIBUTED_WORKER_WORKERIMPL_H
 
 #include <map>
+#include <mutex>
 
 #include <mlir/IR/BuiltinTypes.h>
 
+#include <runtime/distributed/worker/FunctionCache.h>
+#include <runtime/distributed/worker/WorkerDataStore.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include "runtime/distributed/proto/worker.pb.h"
 #include "runtime/distributed/proto/worker.grpc.pb.h"
@@ -31,10 +34,23 @@ public:
     const static std::string DISTRIBUTED_FUNCTION_NAME;
     std::unique_ptr<grpc::ServerCompletionQueue> cq_;
 
-    WorkerImpl();
+    explicit WorkerImpl(size_t functionCacheCapacity = FunctionCache<CompiledFunction>::DEFAULT_CAPACITY);
     ~WorkerImpl();
     
-    void HandleRpcs();
+    // The number of threads serving requests by default, see HandleRpcs.
+    static constexpr size_t DEFAULT_NUM_RPC_THREADS = 2;
+
+    /**
+     * Serves requests on the given number of threads (including the calling
+     * one), `DEFAULT_NUM_RPC_THREADS` by default, until the completion queue
+     * is shut down.
+     *
+     * The vectorized pipelines of each computed task use all cores of the
+     * worker. More RPC threads accept more concurrent requests, e.g., stores
+     * while a task is computed, but tasks computed concurrently share the
+     * cores.
+     */
+    void HandleRpcs(size_t numThreads = 0);
     // void StartHandleThread();
     // void TerminateHandleThread();
     grpc::Status Store(::grpc::ServerContext *context,
@@ -49,25 +65,69 @@ public:
     grpc::Status FreeMem(::grpc::ServerContext *context,
                          const ::distributed::StoredData *request,
                          ::distributed::Empty *emptyMessage);
+    /**
+     * Receives one chunk of a streamed Store, creating the matrix on the first one.
+     * The chunks have to arrive in order.
+     * @param chunk The chunk received
+     * @param mat The matrix received so far, `nullptr` before the first chunk
+     * @param numCells The number of cells received so far, increased by the
+     * cells of the chunk
+     */
+    grpc::Status StoreChunk(const ::distributed::MatrixChunk &chunk, DenseMatrix<double> *&mat, size_t &numCells);
+    /**
+     * Keeps the matrix received by a streamed Store once the stream ended,
+     * unless it ended before all cells of the matrix were received.
+     */
+    grpc::Status StoreFinish(DenseMatrix<double> *mat, size_t numCells, ::distributed::StoredData *response);
+    /**
+     * Creates the chunk of a streamed Transfer starting at the cell `firstCell`.
+     * @param nextCell Set to the first cell of the next chunk, which is the number
+     * of cells of the matrix after the last chunk
+     */
+    grpc::Status TransferChunk(const ::distributed::StoredData *request,
+                               size_t firstCell,
+                               ::distributed::MatrixChunk *chunk,
+                               size_t &nextCell);
     distributed::Worker::AsyncService service_;
 private:
-    uint64_t tmp_file_counter_ = 0;
-    std::unordered_map<std::string, void *> localData_;
+    /**
+     * @brief A JIT-compiled `dist` function along with everything it depends on.
+     */
+    struct CompiledFunction;
+
+    WorkerDataStore localData_;
+    /**
+     * Functions compiled for previous tasks, such that tasks repeatedly sent
+     * with the same MLIR code (e.g., in each iteration of a loop) are only
+     * compiled once.
+     */
+    FunctionCache<CompiledFunction> functionCache_;
+    std::mutex functionCacheMutex_;
+
+    /**
+     * Parses, lowers and JIT-compiles the given MLIR code.
+     * @param mlirCode The code of a module containing the `dist` function
+     * @param function Set to the compiled function on success
+     * @return the status to respond with on failure
+     */
+    grpc::Status compile(const std::string &mlirCode, std::shared_ptr<CompiledFunction> &function);
     /**
      * Creates a vector holding pointers to the inputs as well as the outputs. This vector can directly be passed
      * to the `ExecutionEngine::invokePacked` method.
      * @param functionType Type of the function that will be invoked
      * @param workInputs Inputs send by client
      * @param outputs Reference to the vector that will hold the outputs of the invoked function
+     * @param inputObjects Reference to the vector that will keep the inputs alive during the invocation
      * @return packed pointers to inputs and outputs
      */
     std::vector<void *> createPackedCInterfaceInputsOutputs(mlir::FunctionType functionType,
                                                             google::protobuf::RepeatedPtrField<distributed::WorkData> workInputs,
                                                             std::vector<void *> &outputs,
-                                                            std::vector<void *> &inputs);
+                                                            std::vector<void *> &inputs,
+                                                            std::vector<WorkerDataStore::Object> &inputObjects);
 
-    Matrix<double> *readOrGetMatrix(const std::string &filename, size_t numRows, size_t numCols, bool isSparse);
-    void *loadWorkInputData(mlir::Type mlirType, const distributed::WorkData& workInput);
+    WorkerDataStore::Object readOrGetMatrix(const std::string &filename, size_t numRows, size_t numCols, bool isSparse);
+    WorkerDataStore::Object loadWorkInputData(mlir::Type mlirType, const distributed::WorkData& workInput);
     static distributed::WorkData::DataCase dataCaseForType(mlir::Type type);
 };
 
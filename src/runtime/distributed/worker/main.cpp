@@ -18,16 +18,19 @@
 #include <grpcpp/server_builder.h>
 
 #include <iostream>
+#include <string>
 
 #include "WorkerImpl.h"
 
 int main(int argc, char *argv[])
 {
-    if (argc != 2) {
-        std::cout << "Usage: " << argv[0] << " <Address:Port>" << std::endl;
+    if (argc != 2 && argc != 3) {
+        std::cout << "Usage: " << argv[0] << " <Address:Port> [<NumThreads>]" << std::endl;
         exit(1);
     }
     auto addr = argv[1];
+    // WorkerImpl::DEFAULT_NUM_RPC_THREADS by default
+    size_t numThreads = argc == 3 ? std::stoul(argv[2]) : 0;
     grpc::ServerBuilder builder;
     builder.AddListeningPort(addr, grpc::InsecureServerCredentials());
 
@@ -39,7 +42,7 @@ int main(int argc, char *argv[])
     std::unique_ptr<grpc::Server> server(builder.BuildAndStart());
 
     std::cout << "Started Distributed Worker on `" << addr << "`\n";
-    my_service.HandleRpcs();
+    my_service.HandleRpcs(numThreads);
     // TODO shutdown handling
     // server->Shutdown();
     // my_service.cq_->Shutdown();
@@ -27,6 +27,8 @@
 
 #include "IContext.h"
 
+class WorkerPool;
+
 #ifdef USE_CUDA
     #include "CUDAContext.h"
 #endif
@@ -55,6 +57,15 @@ struct DaphneContext {
 
     std::vector<std::unique_ptr<IContext>> cuda_contexts;
 
+    /**
+     * @brief The CPU worker threads of the vectorized execution engine.
+     *
+     * Created lazily by the first vectorized pipeline and reused by all
+     * subsequent ones. Held by a `std::shared_ptr` such that this header does
+     * not need the complete `WorkerPool` type.
+     */
+    std::shared_ptr<WorkerPool> workerPool;
+
     /**
      * @brief The user configuration (including information passed via CLI
      * arguments etc.).
@@ -73,6 +84,7 @@ struct DaphneContext {
             ctx->destroy();
         }
         cuda_contexts.clear();
+        workerPool.reset();
     }
 
 #ifdef USE_CUDA
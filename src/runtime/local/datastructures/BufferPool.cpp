@@ -0,0 +1,219 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BufferPool.h"
+#include <runtime/local/instrumentation/Profiler.h>
+
+#include <new>
+
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/mman.h>
+
+struct BufferPool::LocalCache {
+    std::vector<void *> buffers[NUM_CLASSES];
+    size_t numBytes = 0;
+
+    ~LocalCache();
+};
+
+namespace {
+    // Set when the cache of the thread has been destroyed at its exit, after
+    // which the thread's releases go to the global cache directly.
+    thread_local bool localCacheDestroyed = false;
+}
+
+BufferPool::LocalCache::~LocalCache() {
+    localCacheDestroyed = true;
+    BufferPool::instance().releaseLocalCache(*this);
+}
+
+BufferPool & BufferPool::instance() {
+    static BufferPool * pool = new BufferPool();
+    return *pool;
+}
+
+BufferPool::LocalCache * BufferPool::getLocalCache() {
+    if(localCacheDestroyed)
+        return nullptr;
+    thread_local LocalCache cache;
+    return &cache;
+}
+
+size_t BufferPool::getSizeClass(size_t numBytes) {
+    if(numBytes <= MIN_CLASS_BYTES)
+        return 0;
+    const size_t n = numBytes - 1;
+    const size_t log = 63 - __builtin_clzll(n);
+    return (log - 6) * 4 + ((n >> (log - 2)) & 3) + 1;
+}
+
+size_t BufferPool::getClassBytes(size_t sizeClass) {
+    if(sizeClass == 0)
+        return MIN_CLASS_BYTES;
+    const size_t log = (sizeClass - 1) / 4 + 6;
+    return (5 + (sizeClass - 1) % 4) << (log - 2);
+}
+
+void BufferPool::configure(size_t capacity, bool useHugePages) {
+    this->capacity = capacity;
+    this->useHugePages = useHugePages;
+    if(cachedBytes > capacity)
+        trim();
+}
+
+void * BufferPool::allocateFromSystem(size_t sizeClass, bool & isZero) {
+    const size_t classBytes = getClassBytes(sizeClass);
+    if(classBytes < MMAP_THRESHOLD) {
+        void * buffer = nullptr;
+        if(posix_memalign(&buffer, ALIGNMENT, classBytes))
+            throw std::bad_alloc();
+        isZero = false;
+        return buffer;
+    }
+
+    // Map a bit more than required to align the buffer to a (huge) page, and
+    // unmap the rest again. All classes of that size are multiples of pages.
+    const size_t mapBytes = classBytes + MMAP_THRESHOLD;
+    void * mapped = mmap(nullptr, mapBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(mapped == MAP_FAILED)
+        throw std::bad_alloc();
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(mapped);
+    const uintptr_t alignedBegin = (begin + MMAP_THRESHOLD - 1) & ~(MMAP_THRESHOLD - 1);
+    if(alignedBegin > begin)
+        munmap(mapped, alignedBegin - begin);
+    if(begin + mapBytes > alignedBegin + classBytes)
+        munmap(reinterpret_cast<void *>(alignedBegin + classBytes), begin + mapBytes - alignedBegin - classBytes);
+    void * buffer = reinterpret_cast<void *>(alignedBegin);
+#ifdef MADV_HUGEPAGE
+    // Only a hint, the buffer is fine without huge pages as well.
+    if(useHugePages)
+        madvise(buffer, classBytes, MADV_HUGEPAGE);
+#endif
+    isZero = true;
+    return buffer;
+}
+
+void BufferPool::releaseToSystem(void * buffer, size_t sizeClass) {
+    const size_t classBytes = getClassBytes(sizeClass);
+    if(classBytes < MMAP_THRESHOLD)
+        free(buffer);
+    else
+        munmap(buffer, classBytes);
+}
+
+bool BufferPool::tryReserve(size_t numBytes) {
+    uint64_t cached = cachedBytes.load();
+    do {
+        if(cached + numBytes > capacity)
+            return false;
+    } while(!cachedBytes.compare_exchange_weak(cached, cached + numBytes));
+    return true;
+}
+
+std::shared_ptr<void> BufferPool::allocate(size_t numBytes, bool zero) {
+    if(numBytes > MAX_BYTES)
+        throw std::bad_alloc();
+    const size_t sizeClass = getSizeClass(numBytes);
+    const size_t classBytes = getClassBytes(sizeClass);
+
+    void * buffer = nullptr;
+    if(LocalCache * cache = getLocalCache()) {
+        auto & freeList = cache->buffers[sizeClass];
+        if(!freeList.empty()) {
+            buffer = freeList.back();
+            freeList.pop_back();
+            cache->numBytes -= classBytes;
+        }
+    }
+    if(!buffer && cachedBytes) {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto & freeList = globalFree[sizeClass];
+        if(!freeList.empty()) {
+            buffer = freeList.back();
+            freeList.pop_back();
+        }
+    }
+
+    const bool reused = buffer;
+    if(reused) {
+        cachedBytes -= classBytes;
+        hits++;
+        if(zero)
+            memset(buffer, 0, numBytes);
+    }
+    else {
+        misses++;
+        bool isZero;
+        buffer = allocateFromSystem(sizeClass, isZero);
+        if(zero && !isZero)
+            memset(buffer, 0, numBytes);
+    }
+    Profiler::countAllocation(numBytes, reused);
+    return std::shared_ptr<void>(buffer, Releaser{this, static_cast<uint32_t>(sizeClass)});
+}
+
+std::shared_ptr<void> BufferPool::allocateUntouched(size_t numBytes) {
+    if(numBytes > MAX_BYTES)
+        throw std::bad_alloc();
+    const size_t sizeClass = getSizeClass(numBytes);
+    misses++;
+    bool isZero;
+    void * buffer = allocateFromSystem(sizeClass, isZero);
+    Profiler::countAllocation(numBytes);
+    return std::shared_ptr<void>(buffer, Releaser{this, static_cast<uint32_t>(sizeClass)});
+}
+
+void BufferPool::release(void * buffer, size_t sizeClass) {
+    const size_t classBytes = getClassBytes(sizeClass);
+    if(!tryReserve(classBytes)) {
+        evictions++;
+        releaseToSystem(buffer, sizeClass);
+        return;
+    }
+
+    LocalCache * cache = getLocalCache();
+    if(cache && cache->buffers[sizeClass].size() < LOCAL_BUFFERS_PER_CLASS &&
+            cache->numBytes + classBytes <= LOCAL_MAX_BYTES) {
+        cache->buffers[sizeClass].push_back(buffer);
+        cache->numBytes += classBytes;
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mtx);
+    globalFree[sizeClass].push_back(buffer);
+}
+
+void BufferPool::releaseLocalCache(LocalCache & cache) {
+    std::lock_guard<std::mutex> lock(mtx);
+    for(size_t c = 0; c < NUM_CLASSES; c++) {
+        globalFree[c].insert(globalFree[c].end(), cache.buffers[c].begin(), cache.buffers[c].end());
+        cache.buffers[c].clear();
+    }
+    cache.numBytes = 0;
+}
+
+void BufferPool::trim() {
+    if(LocalCache * cache = getLocalCache())
+        releaseLocalCache(*cache);
+    std::lock_guard<std::mutex> lock(mtx);
+    for(size_t c = 0; c < NUM_CLASSES; c++) {
+        for(void * buffer : globalFree[c])
+            releaseToSystem(buffer, c);
+        cachedBytes -= globalFree[c].size() * getClassBytes(c);
+        globalFree[c].clear();
+    }
+}
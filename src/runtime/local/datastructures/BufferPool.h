@@ -0,0 +1,216 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_LOCAL_DATASTRUCTURES_BUFFERPOOL_H
+#define SRC_RUNTIME_LOCAL_DATASTRUCTURES_BUFFERPOOL_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Caches the value buffers of destroyed data objects for reuse by new
+ * data objects of (about) the same size.
+ *
+ * Loops and the batches of the vectorized engine create data objects of the
+ * same shapes over and over again. Allocating their buffers from the system
+ * each time is expensive for large buffers in particular, since fresh memory
+ * from the operating system page-faults on its first use.
+ *
+ * Buffers are grouped into size classes (four per power of two, such that at
+ * most 25% of a buffer are wasted). A released buffer is kept in a small cache
+ * of the releasing thread, or in a global cache shared by all threads if the
+ * thread's cache is full. Buffers are handed out from the thread's cache
+ * first, then from the global cache, and only allocated from the system if
+ * both have none of the size class. At most `getCapacity()` bytes are kept
+ * in all caches together; buffers exceeding that are returned to the system.
+ *
+ * All buffers are aligned to `ALIGNMENT` bytes. Large buffers are mapped
+ * directly, optionally backed by transparent huge pages (see `configure`).
+ */
+class BufferPool {
+public:
+    static constexpr size_t ALIGNMENT = 64;
+
+    /**
+     * @brief Buffers of at least this size are mapped from the operating
+     * system directly.
+     */
+    static constexpr size_t MMAP_THRESHOLD = size_t(1) << 21;
+
+    /**
+     * @brief The default number of bytes kept in the caches.
+     */
+    static constexpr size_t DEFAULT_CAPACITY = size_t(1) << 30;
+
+    struct Stats {
+        // Buffers handed out from a cache.
+        uint64_t hits = 0;
+        // Buffers allocated from the system.
+        uint64_t misses = 0;
+        // Buffers returned to the system, since the caches were full.
+        uint64_t evictions = 0;
+        // Bytes currently kept in the caches.
+        uint64_t cachedBytes = 0;
+    };
+
+private:
+    // One size class up to 64 bytes, then 4 per power of two up to 2^62
+    // bytes.
+    static constexpr size_t MIN_CLASS_BYTES = 64;
+    static constexpr size_t MAX_BYTES = size_t(1) << 62;
+    static constexpr size_t NUM_CLASSES = (62 - 6) * 4 + 1;
+
+    // Limits of the cache of each thread.
+    static constexpr size_t LOCAL_BUFFERS_PER_CLASS = 4;
+    static constexpr size_t LOCAL_MAX_BYTES = size_t(1) << 26;
+
+    struct LocalCache;
+
+    /**
+     * @brief Returns a buffer to the pool it was allocated from once the last
+     * data object using it is destroyed.
+     */
+    struct Releaser {
+        BufferPool * pool;
+        uint32_t sizeClass;
+
+        void operator()(void * buffer) const {
+            pool->release(buffer, sizeClass);
+        }
+    };
+
+    std::atomic<size_t> capacity{DEFAULT_CAPACITY};
+    std::atomic<bool> useHugePages{false};
+
+    std::mutex mtx;
+    std::vector<void *> globalFree[NUM_CLASSES];
+
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> evictions{0};
+    std::atomic<uint64_t> cachedBytes{0};
+
+    BufferPool() = default;
+
+    static LocalCache * getLocalCache();
+
+    void * allocateFromSystem(size_t sizeClass, bool & isZero);
+    void releaseToSystem(void * buffer, size_t sizeClass);
+    void release(void * buffer, size_t sizeClass);
+    bool tryReserve(size_t numBytes);
+    void releaseLocalCache(LocalCache & cache);
+
+public:
+    BufferPool(const BufferPool &) = delete;
+    BufferPool & operator=(const BufferPool &) = delete;
+
+    /**
+     * @brief The pool used for the buffers of all data objects.
+     *
+     * Never destroyed, such that data objects can still be destroyed during
+     * the destruction of static and thread-local objects.
+     */
+    static BufferPool & instance();
+
+    /**
+     * @brief The smallest size class holding buffers of the given size.
+     */
+    static size_t getSizeClass(size_t numBytes);
+
+    /**
+     * @brief The size of the buffers of the given size class.
+     */
+    static size_t getClassBytes(size_t sizeClass);
+
+    /**
+     * @brief Sets the number of bytes kept in the caches (`0` disables the
+     * caching) and whether large buffers shall be backed by huge pages.
+     * Returns cached buffers exceeding the new capacity to the system.
+     */
+    void configure(size_t capacity, bool useHugePages);
+
+    size_t getCapacity() const {
+        return capacity;
+    }
+
+    /**
+     * @brief Allocates a buffer of (at least) the given number of bytes.
+     *
+     * @param numBytes The size of the buffer.
+     * @param zero Whether the buffer shall be initialized to zeros.
+     * @return The buffer, which is returned to the pool when the last copy of
+     * the returned pointer is destroyed.
+     */
+    std::shared_ptr<void> allocate(size_t numBytes, bool zero);
+
+    /**
+     * @brief Allocates a buffer for the given number of values, see
+     * `allocate(size_t, bool)`.
+     *
+     * @tparam T The element type of the returned pointer, i.e., the value
+     * type, or an array of it (`ValueType[]`).
+     */
+    template<typename T>
+    std::shared_ptr<T> allocate(size_t numValues, bool zero) {
+        using ValueType = std::remove_extent_t<T>;
+        std::shared_ptr<void> buffer = allocate(numValues * sizeof(ValueType), zero);
+        return std::shared_ptr<T>(buffer, static_cast<ValueType *>(buffer.get()));
+    }
+
+    /**
+     * @brief Allocates a fresh buffer from the system, bypassing the caches.
+     *
+     * None of the pages of the buffer has been touched yet if it is mapped
+     * (at least `MMAP_THRESHOLD` bytes), such that the threads writing them
+     * first determine the NUMA nodes they are placed on. Like other buffers,
+     * the buffer is returned to the pool once it is not used anymore.
+     */
+    std::shared_ptr<void> allocateUntouched(size_t numBytes);
+
+    /**
+     * @brief Allocates a fresh buffer for the given number of values, see
+     * `allocateUntouched(size_t)`.
+     */
+    template<typename T>
+    std::shared_ptr<T> allocateUntouched(size_t numValues) {
+        using ValueType = std::remove_extent_t<T>;
+        std::shared_ptr<void> buffer = allocateUntouched(numValues * sizeof(ValueType));
+        return std::shared_ptr<T>(buffer, static_cast<ValueType *>(buffer.get()));
+    }
+
+    /**
+     * @brief Returns all buffers in the global cache and in the cache of the
+     * calling thread to the system.
+     */
+    void trim();
+
+    Stats getStats() const {
+        Stats stats;
+        stats.hits = hits;
+        stats.misses = misses;
+        stats.evictions = evictions;
+        stats.cachedBytes = cachedBytes;
+        return stats;
+    }
+};
+
+#endif //SRC_RUNTIME_LOCAL_DATASTRUCTURES_BUFFERPOOL_H
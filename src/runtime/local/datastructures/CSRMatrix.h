@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <runtime/local/datastructures/BufferPool.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/Matrix.h>
 #include <runtime/local/datastructures/ValueTypeUtils.h>
@@ -96,16 +97,12 @@ class CSRMatrix : public Matrix<ValueType> {
             numRowsAllocated(maxNumRows),
             isRowAllocatedBefore(false),
             maxNumNonZeros(maxNumNonZeros),
-            values(new ValueType[maxNumNonZeros], std::default_delete<ValueType[]>()),
-            colIdxs(new size_t[maxNumNonZeros], std::default_delete<size_t[]>()),
-            rowOffsets(new size_t[numRows + 1], std::default_delete<size_t[]>()),
+            values(BufferPool::instance().allocate<ValueType>(maxNumNonZeros, zero)),
+            colIdxs(BufferPool::instance().allocate<size_t>(maxNumNonZeros, zero)),
+            rowOffsets(BufferPool::instance().allocate<size_t>(numRows + 1, zero)),
             lastAppendedRowIdx(0)
     {
-        if(zero) {
-            memset(values.get(), 0, maxNumNonZeros * sizeof(ValueType));
-            memset(colIdxs.get(), 0, maxNumNonZeros * sizeof(size_t));
-            memset(rowOffsets.get(), 0, (numRows + 1) * sizeof(size_t));
-        }
+        // nothing to do
     }
     
     /**
@@ -17,6 +17,7 @@
 #ifndef SRC_RUNTIME_LOCAL_DATASTRUCTURES_DATAOBJECTFACTORY_H
 #define SRC_RUNTIME_LOCAL_DATASTRUCTURES_DATAOBJECTFACTORY_H
 
+#include <atomic>
 #include <stdexcept>
 
 struct DataObjectFactory {
@@ -44,7 +45,7 @@ struct DataObjectFactory {
      * Decreases the reference counter of the given data object. If the
      * reference counter becomes zero, the data object is destroyed.
      * 
-     * The access is protected by a mutex, such that multiple threads may call
+     * The reference counter is atomic, such that multiple threads may call
      * this method concurrently.
      * 
      * @param obj The data object to destroy.
@@ -57,14 +58,13 @@ struct DataObjectFactory {
                     "DataObjectFactory::destroy() must not be called with nullptr"
             );
         
-        obj->refCounterMutex.lock();
-        obj->refCounter--;
-        if(obj->refCounter == 0) {
-            obj->refCounterMutex.unlock();
+        // All accesses to the data object through other references must have
+        // happened before its deletion (release), and the deleting thread must
+        // see them (acquire).
+        if(obj->refCounter.fetch_sub(1, std::memory_order_release) == 1) {
+            std::atomic_thread_fence(std::memory_order_acquire);
             delete obj;
         }
-        else
-            obj->refCounterMutex.unlock();
     }
 
     // TODO Simplify many places in the code (especially test cases) by using
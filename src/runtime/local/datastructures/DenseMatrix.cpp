@@ -17,6 +17,7 @@
 // TODO DenseMatrix should not be concerned about CUDA.
 
 #include "DenseMatrix.h"
+#include <runtime/local/datastructures/BufferPool.h>
 #include <chrono>
 
 #ifdef USE_CUDA
@@ -32,10 +33,8 @@ DenseMatrix<ValueType>::DenseMatrix(size_t maxNumRows, size_t numCols, bool zero
               ", dims: " << numRows << "x" << numCols << " req.mem.: " << printBufferSize() << "Mb" <<  std::endl;
 #endif
     if (type == ALLOCATION_TYPE::HOST_ALLOC) {
-        alloc_shared_values();
+        alloc_shared_values(nullptr, 0, zero);
         host_buffer_current = true;
-        if(zero)
-            memset(values.get(), 0, maxNumRows * numCols * sizeof(ValueType));
     }
     else if (type == ALLOCATION_TYPE::CUDA_ALLOC) {
         alloc_shared_cuda_buffer();
@@ -79,13 +78,13 @@ template <typename ValueType> void DenseMatrix<ValueType>::printValue(std::ostre
 }
 
 template<typename ValueType>
-void DenseMatrix<ValueType>::alloc_shared_values(std::shared_ptr<ValueType[]> src, size_t offset) {
-    // correct since C++17: Calls delete[] instead of simple delete
+void DenseMatrix<ValueType>::alloc_shared_values(std::shared_ptr<ValueType[]> src, size_t offset, bool zero) {
     if(src) {
         values = std::shared_ptr<ValueType[]>(src, src.get() + offset);
     }
-    else
-        values = std::shared_ptr<ValueType[]>(new ValueType[numRows*numCols]);
+    else {
+        values = BufferPool::instance().allocate<ValueType[]>(numRows*numCols, zero);
+    }
 }
 
 template<typename ValueType>
@@ -136,7 +136,7 @@ class DenseMatrix : public Matrix<ValueType>
 
     void printValue(std::ostream & os, ValueType val) const;
 
-    void alloc_shared_values(std::shared_ptr<ValueType[]> src = nullptr, size_t offset = 0);
+    void alloc_shared_values(std::shared_ptr<ValueType[]> src = nullptr, size_t offset = 0, bool zero = false);
 
     void alloc_shared_cuda_buffer(std::shared_ptr<ValueType> src = nullptr, size_t offset = 0);
 
@@ -186,6 +186,14 @@ public:
     std::shared_ptr<ValueType[]> getValuesSharedPtr() const {
         return values;
     }
+
+    /**
+     * @brief Whether this matrix is the only data object referring to its
+     * values, i.e., there are no views on them or other matrices sharing them.
+     */
+    bool hasExclusiveValues() const {
+        return values && values.use_count() == 1;
+    }
     
     ValueType get(size_t rowIdx, size_t colIdx) const override {
         return getValues()[pos(rowIdx, colIdx)];
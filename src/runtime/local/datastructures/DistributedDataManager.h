@@ -0,0 +1,200 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_LOCAL_DATASTRUCTURES_DISTRIBUTEDDATAMANAGER_H
+#define SRC_RUNTIME_LOCAL_DATASTRUCTURES_DISTRIBUTEDDATAMANAGER_H
+
+#include <runtime/local/datastructures/DenseMatrix.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <cstddef>
+#include <cstdlib>
+
+// Defined in Handle.h, which is only required by the code (un)packing the
+// partitions, but not by the code invalidating them.
+class DistributedPlacement;
+
+/**
+ * @brief Remembers which matrices are stored on the workers and how, such
+ * that distributing or broadcasting the same matrix again (e.g., in each
+ * iteration of a loop) reuses the partitions on the workers instead of
+ * sending the matrix again.
+ *
+ * A matrix is identified by its values (including the view on them) and its
+ * shape. The manager only observes the values, so the partitions of a matrix
+ * are kept on the workers as long as the matrix exists, or until the next
+ * use of the manager after that; they are freed once, in addition, no handle
+ * to them is left. Partitions still known to the manager when the program
+ * ends are not freed by it. Code that updates a matrix in place (see the
+ * `reuseForResult` kernel) must `invalidate` it first.
+ */
+class DistributedDataManager
+{
+public:
+    enum class Kind
+    {
+        // split into row partitions, one per worker
+        DISTRIBUTED,
+        // copied to all workers
+        BROADCAST
+    };
+
+private:
+    using Key = std::tuple<const void *, size_t, size_t, size_t, Kind>;
+
+    struct Entry
+    {
+        std::weak_ptr<const void> values;
+        std::vector<std::string> workers;
+        std::shared_ptr<DistributedPlacement> placement;
+    };
+
+    std::mutex mtx;
+    std::string workersEnv;
+    std::vector<std::string> workers;
+    std::map<Key, Entry> entries;
+
+    template<typename VT>
+    static Key getKey(const DenseMatrix<VT> *mat, Kind kind)
+    {
+        return Key(mat->getValues(), mat->getNumRows(), mat->getNumCols(), mat->getRowSkip(), kind);
+    }
+
+    const std::vector<std::string> &getWorkersLocked()
+    {
+        auto envVar = std::getenv("DISTRIBUTED_WORKERS");
+        if (!envVar)
+            throw std::runtime_error("DistributedDataManager: environment variable DISTRIBUTED_WORKERS has to be set");
+        if (workersEnv != envVar) {
+            workersEnv = envVar;
+            workers.clear();
+            std::string workersStr(envVar);
+            std::string delimiter(",");
+            size_t pos;
+            while ((pos = workersStr.find(delimiter)) != std::string::npos) {
+                workers.push_back(workersStr.substr(0, pos));
+                workersStr.erase(0, pos + delimiter.size());
+            }
+            workers.push_back(workersStr);
+        }
+        return workers;
+    }
+
+    /**
+     * Forgets the matrices that do not exist anymore, which frees their
+     * partitions on the workers unless they are still used by handles.
+     */
+    void purgeLocked()
+    {
+        for (auto it = entries.begin(); it != entries.end();)
+            if (it->second.values.expired())
+                it = entries.erase(it);
+            else
+                ++it;
+    }
+
+public:
+    /**
+     * The manager is never destroyed, since freeing the partitions it still
+     * holds would require RPCs to the workers during static destruction.
+     */
+    static DistributedDataManager &instance()
+    {
+        static DistributedDataManager *manager = new DistributedDataManager();
+        return *manager;
+    }
+
+    /**
+     * @return the addresses of the workers given by the environment variable
+     * `DISTRIBUTED_WORKERS`, which is parsed only when it changes
+     */
+    std::vector<std::string> getWorkers()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return getWorkersLocked();
+    }
+
+    /**
+     * @return the partitions of the given matrix on the current workers, or
+     * `nullptr` if the matrix has not been sent to them this way
+     */
+    template<typename VT>
+    std::shared_ptr<DistributedPlacement> lookup(const DenseMatrix<VT> *mat, Kind kind)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = entries.find(getKey(mat, kind));
+        if (it == entries.end())
+            return nullptr;
+        // the memory of a destroyed matrix may have been reused by this one
+        if (it->second.values.expired() || it->second.workers != getWorkersLocked()) {
+            entries.erase(it);
+            return nullptr;
+        }
+        return it->second.placement;
+    }
+
+    /**
+     * Remembers that the given matrix is stored on the current workers as
+     * the given partitions.
+     */
+    template<typename VT>
+    void remember(const DenseMatrix<VT> *mat, Kind kind, std::shared_ptr<DistributedPlacement> placement)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        purgeLocked();
+        entries[getKey(mat, kind)] = {
+            std::shared_ptr<const void>(mat->getValuesSharedPtr()), getWorkersLocked(), std::move(placement)};
+    }
+
+    /**
+     * Forgets the partitions of the given matrix (and of all views on the
+     * same values), which must be called before updating it in place.
+     */
+    template<typename VT>
+    void invalidate(const DenseMatrix<VT> *mat)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (entries.empty())
+            return;
+        const std::shared_ptr<const void> values(mat->getValuesSharedPtr());
+        for (auto it = entries.begin(); it != entries.end();) {
+            const auto &other = it->second.values;
+            // same control block, i.e., the same values
+            if (!other.owner_before(values) && !values.owner_before(other))
+                it = entries.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    /**
+     * Forgets all matrices.
+     */
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        entries.clear();
+    }
+};
+
+#endif //SRC_RUNTIME_LOCAL_DATASTRUCTURES_DISTRIBUTEDDATAMANAGER_H
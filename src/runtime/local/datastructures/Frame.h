@@ -17,6 +17,7 @@
 #ifndef SRC_RUNTIME_LOCAL_DATASTRUCTURES_FRAME_H
 #define SRC_RUNTIME_LOCAL_DATASTRUCTURES_FRAME_H
 
+#include <runtime/local/datastructures/BufferPool.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/datastructures/Structure.h>
@@ -147,10 +148,7 @@ class Frame : public Structure {
             this->schema[i] = schema[i];
             this->labels[i] = labels ? labels[i] : getDefaultLabel(i);
             const size_t sizeAlloc = maxNumRows * ValueTypeUtils::sizeOf(schema[i]);
-            this->columns[i] = std::shared_ptr<ColByteType>(new ColByteType[sizeAlloc],
-                    std::default_delete<ColByteType []>());
-            if(zero)
-                memset(this->columns[i].get(), 0, sizeAlloc);
+            this->columns[i] = BufferPool::instance().allocate<ColByteType>(sizeAlloc, zero);
         }
         initLabels2Idxs();
     }
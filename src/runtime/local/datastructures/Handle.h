@@ -17,8 +17,11 @@
 #ifndef SRC_RUNTIME_LOCAL_DATASTRUCTURES_HANDLE_H
 #define SRC_RUNTIME_LOCAL_DATASTRUCTURES_HANDLE_H
 
-#include <vector>
+#include <map>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <grpcpp/grpcpp.h>
 
@@ -78,16 +81,21 @@ private:
     std::shared_ptr<grpc::Channel> channel_;
 };
 
-template<class DT>
-class Handle
+/**
+ * @brief The partitions of a data object stored on the workers.
+ *
+ * Shared by all handles to the partitions (and the `DistributedDataManager`),
+ * the partitions are freed on the workers once the last of them is gone.
+ */
+class DistributedPlacement
 {
 public:
     using HandleMap = std::multimap<const DistributedIndex, DistributedData>;
 
-    Handle(HandleMap map, size_t rows, size_t cols) : map_(map), rows_(rows), cols_(cols)
+    explicit DistributedPlacement(HandleMap map) : map_(std::move(map))
     { }
 
-    ~Handle() 
+    ~DistributedPlacement()
     {
         DistributedCaller<void*, distributed::StoredData, distributed::Empty> caller;
         // Free memory on the workers
@@ -103,15 +111,38 @@ public:
         }
     }
 
-    const HandleMap getMap() const
+    const HandleMap &getMap() const
     { return map_; }
+
+private:
+    HandleMap map_;
+};
+
+template<class DT>
+class Handle
+{
+public:
+    using HandleMap = DistributedPlacement::HandleMap;
+
+    Handle(HandleMap map, size_t rows, size_t cols)
+        : placement_(std::make_shared<DistributedPlacement>(std::move(map))), rows_(rows), cols_(cols)
+    { }
+
+    Handle(std::shared_ptr<DistributedPlacement> placement, size_t rows, size_t cols)
+        : placement_(std::move(placement)), rows_(rows), cols_(cols)
+    { }
+
+    const HandleMap getMap() const
+    { return placement_->getMap(); }
+    std::shared_ptr<DistributedPlacement> getPlacement() const
+    { return placement_; }
     size_t getRows() const
     { return rows_; }
     size_t getCols() const
     { return cols_; }
 
 private:
-    HandleMap map_;
+    std::shared_ptr<DistributedPlacement> placement_;
     size_t rows_;
     size_t cols_;
 };
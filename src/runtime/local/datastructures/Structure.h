@@ -19,7 +19,7 @@
 
 #include <runtime/local/datastructures/DataObjectFactory.h>
 
-#include <mutex>
+#include <atomic>
 
 #include <cstddef>
 
@@ -29,8 +29,7 @@
 class Structure
 {
 private:
-    mutable size_t refCounter;
-    mutable std::mutex refCounterMutex;
+    mutable std::atomic<size_t> refCounter;
     
     template<class DataType>
     friend void DataObjectFactory::destroy(const DataType * obj);
@@ -49,19 +48,18 @@ public:
     virtual ~Structure() = default;
     
     size_t getRefCounter() const {
-        return refCounter;
+        return refCounter.load(std::memory_order_acquire);
     }
     
     /**
      * @brief Increases the reference counter of this data object.
      * 
-     * The access is protected by a mutex, such that multiple threads may call
+     * The reference counter is atomic, such that multiple threads may call
      * this method concurrently.
      */
     void increaseRefCounter() const {
-        refCounterMutex.lock();
-        refCounter++;
-        refCounterMutex.unlock();
+        // The caller already holds a reference, so no ordering is required.
+        refCounter.fetch_add(1, std::memory_order_relaxed);
     }
     
     // Note that there is no method for decreasing the reference counter here.
@@ -0,0 +1,437 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/datastructures/BufferPool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+/**
+ * @brief Collects run-time statistics of the kernels and vectorized tasks of
+ * a DaphneDSL script, if profiling is enabled (`--profile`).
+ *
+ * The compiler registers each kernel call site (kernel and DaphneDSL source
+ * location) and wraps the call into `beginKernel`/`endKernel`. The workers of
+ * the vectorized engine record their tasks, the rows processed, the time the
+ * tasks waited in the queues and the time the workers were idle.
+ *
+ * Each thread records into its own buffer, such that profiled threads never
+ * wait for each other. Thus, the results must only be reported once no
+ * profiled code is running anymore. Besides aggregated statistics, up to
+ * `MAX_TRACE_EVENTS_PER_THREAD` individual events per thread are kept for the
+ * Chrome trace (see `writeChromeTrace`).
+ */
+class Profiler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t MAX_TRACE_EVENTS_PER_THREAD = 1 << 20;
+
+private:
+    enum class EventKind : uint8_t {
+        KERNEL,
+        TASK,
+        IDLE
+    };
+
+    struct Site {
+        std::string kernel;
+        std::string location;
+    };
+
+    struct SiteStats {
+        uint64_t calls = 0;
+        uint64_t totalNs = 0;
+        uint64_t minNs = UINT64_MAX;
+        uint64_t maxNs = 0;
+        uint64_t allocatedBytes = 0;
+        uint64_t reusedBytes = 0;
+    };
+
+    struct WorkerStats {
+        uint64_t tasks = 0;
+        uint64_t rows = 0;
+        uint64_t busyNs = 0;
+        uint64_t idleNs = 0;
+        uint64_t queueWaitNs = 0;
+    };
+
+    struct TraceEvent {
+        EventKind kind;
+        uint32_t site;
+        uint64_t beginNs;
+        uint64_t durNs;
+        // kernels: bytes allocated, tasks: rows processed
+        uint64_t value;
+        // tasks: time waited in the queue
+        uint64_t waitNs;
+    };
+
+    struct OpenKernel {
+        size_t site;
+        uint64_t beginNs;
+        uint64_t allocatedBytes;
+        uint64_t reusedBytes;
+    };
+
+    struct ThreadBuffer {
+        size_t tid;
+        std::string name;
+        std::vector<OpenKernel> open;
+        std::vector<SiteStats> sites;
+        WorkerStats worker;
+        bool isWorker = false;
+        // rows processed by the current task so far
+        uint64_t taskRows = 0;
+        std::vector<TraceEvent> events;
+        uint64_t droppedEvents = 0;
+    };
+
+    inline static std::atomic<uint64_t> nextId{1};
+
+    // identifies this profiler in the thread-local caches of the buffers
+    const uint64_t id;
+    const Clock::time_point start;
+
+    mutable std::mutex mtx;
+    std::vector<Site> sites;
+    std::vector<std::unique_ptr<ThreadBuffer>> threads;
+
+    ThreadBuffer & getThreadBuffer() {
+        thread_local uint64_t cachedId = 0;
+        thread_local ThreadBuffer * cachedBuffer = nullptr;
+        if(cachedId != id) {
+            auto buffer = std::make_unique<ThreadBuffer>();
+            std::lock_guard<std::mutex> lock(mtx);
+            buffer->tid = threads.size();
+            buffer->name = buffer->tid ? "thread " + std::to_string(buffer->tid) : "main";
+            cachedBuffer = buffer.get();
+            cachedId = id;
+            threads.push_back(std::move(buffer));
+        }
+        return *cachedBuffer;
+    }
+
+    static void addEvent(ThreadBuffer & tb, const TraceEvent & event) {
+        if(tb.events.size() < MAX_TRACE_EVENTS_PER_THREAD)
+            tb.events.push_back(event);
+        else
+            tb.droppedEvents++;
+    }
+
+    static void writeJsonString(std::ostream & os, const std::string & str) {
+        os << '"';
+        for(char c : str) {
+            if(c == '"' || c == '\\')
+                os << '\\' << c;
+            else if(static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", c);
+                os << buf;
+            }
+            else
+                os << c;
+        }
+        os << '"';
+    }
+
+    static void writeMicros(std::ostream & os, uint64_t ns) {
+        os << ns / 1000 << '.' << std::setw(3) << std::setfill('0') << ns % 1000 << std::setfill(' ');
+    }
+
+public:
+    Profiler() : id(nextId++), start(Clock::now()) {
+    }
+
+    Profiler(const Profiler &) = delete;
+    Profiler & operator=(const Profiler &) = delete;
+
+    /**
+     * @brief The nanoseconds since the creation of this profiler.
+     */
+    uint64_t now() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    }
+
+    /**
+     * @brief The number of bytes the data objects created by the calling
+     * thread have allocated so far.
+     */
+    static uint64_t & allocatedBytes() {
+        thread_local uint64_t bytes = 0;
+        return bytes;
+    }
+
+    /**
+     * @brief The number of bytes of the allocations counted by
+     * `allocatedBytes()` that were served from the buffer pool, i.e., reused
+     * buffers of destroyed data objects (see `BufferPool`).
+     */
+    static uint64_t & reusedBytes() {
+        thread_local uint64_t bytes = 0;
+        return bytes;
+    }
+
+    /**
+     * @brief Accounts for an allocation of the given size by a data object.
+     * Called regardless of whether profiling is enabled, since it is cheap.
+     *
+     * @param numBytes The size of the allocation.
+     * @param reused Whether the allocation reused a buffer from the pool.
+     */
+    static void countAllocation(size_t numBytes, bool reused = false) {
+        allocatedBytes() += numBytes;
+        if(reused)
+            reusedBytes() += numBytes;
+    }
+
+    // ------------------------------------------------------------------------
+    // Kernels
+    // ------------------------------------------------------------------------
+
+    /**
+     * @brief Registers a kernel call site at compile-time.
+     * @return the identifier of the site
+     */
+    size_t registerSite(const std::string & kernel, const std::string & location) {
+        std::lock_guard<std::mutex> lock(mtx);
+        sites.push_back({kernel, location});
+        return sites.size() - 1;
+    }
+
+    void beginKernel(size_t site) {
+        auto & tb = getThreadBuffer();
+        tb.open.push_back({site, now(), allocatedBytes(), reusedBytes()});
+    }
+
+    void endKernel(size_t site) {
+        const uint64_t end = now();
+        auto & tb = getThreadBuffer();
+        if(tb.open.empty() || tb.open.back().site != site)
+            throw std::runtime_error("Profiler: the end of a kernel does not match its begin");
+        const OpenKernel k = tb.open.back();
+        tb.open.pop_back();
+
+        const uint64_t dur = end - k.beginNs;
+        const uint64_t bytes = allocatedBytes() - k.allocatedBytes;
+        if(site >= tb.sites.size())
+            tb.sites.resize(site + 1);
+        auto & stats = tb.sites[site];
+        stats.calls++;
+        stats.totalNs += dur;
+        stats.minNs = std::min(stats.minNs, dur);
+        stats.maxNs = std::max(stats.maxNs, dur);
+        stats.allocatedBytes += bytes;
+        stats.reusedBytes += reusedBytes() - k.reusedBytes;
+        addEvent(tb, {EventKind::KERNEL, static_cast<uint32_t>(site), k.beginNs, dur, bytes, 0});
+    }
+
+    // ------------------------------------------------------------------------
+    // Workers of the vectorized engine
+    // ------------------------------------------------------------------------
+
+    void setThreadName(const std::string & name) {
+        auto & tb = getThreadBuffer();
+        tb.name = name;
+        tb.isWorker = true;
+    }
+
+    /**
+     * @brief Accounts for rows processed by the current task of the calling
+     * worker.
+     */
+    void countRows(uint64_t numRows) {
+        getThreadBuffer().taskRows += numRows;
+    }
+
+    /**
+     * @brief Records a task executed by the calling worker.
+     *
+     * @param beginNs When the worker started the task.
+     * @param durNs How long the worker executed the task.
+     * @param waitNs How long the task waited in a queue before.
+     */
+    void recordTask(uint64_t beginNs, uint64_t durNs, uint64_t waitNs) {
+        auto & tb = getThreadBuffer();
+        tb.isWorker = true;
+        tb.worker.tasks++;
+        tb.worker.rows += tb.taskRows;
+        tb.worker.busyNs += durNs;
+        tb.worker.queueWaitNs += waitNs;
+        addEvent(tb, {EventKind::TASK, 0, beginNs, durNs, tb.taskRows, waitNs});
+        tb.taskRows = 0;
+    }
+
+    /**
+     * @brief Records that the calling worker was idle, i.e., waited for
+     * tasks.
+     */
+    void recordIdle(uint64_t beginNs, uint64_t durNs) {
+        auto & tb = getThreadBuffer();
+        tb.isWorker = true;
+        tb.worker.idleNs += durNs;
+        addEvent(tb, {EventKind::IDLE, 0, beginNs, durNs, 0, 0});
+    }
+
+    // ------------------------------------------------------------------------
+    // Reporting
+    // ------------------------------------------------------------------------
+
+    /**
+     * @brief Prints the statistics per kernel call site (most expensive
+     * first), per worker and of the buffer pool.
+     */
+    void printSummary(std::ostream & os) const {
+        std::lock_guard<std::mutex> lock(mtx);
+
+        std::vector<SiteStats> total(sites.size());
+        for(auto & tb : threads)
+            for(size_t s = 0; s < tb->sites.size(); s++) {
+                auto & t = total[s];
+                auto & stats = tb->sites[s];
+                t.calls += stats.calls;
+                t.totalNs += stats.totalNs;
+                t.minNs = std::min(t.minNs, stats.minNs);
+                t.maxNs = std::max(t.maxNs, stats.maxNs);
+                t.allocatedBytes += stats.allocatedBytes;
+                t.reusedBytes += stats.reusedBytes;
+            }
+        std::vector<size_t> order;
+        for(size_t s = 0; s < total.size(); s++)
+            if(total[s].calls)
+                order.push_back(s);
+        std::stable_sort(order.begin(), order.end(), [&total](size_t a, size_t b) {
+            return total[a].totalNs > total[b].totalNs;
+        });
+
+        const auto flags = os.flags();
+        os << std::fixed << std::setprecision(3);
+        os << "Kernels (by total time):" << std::endl;
+        os << std::setw(12) << "total [ms]" << std::setw(10) << "calls" << std::setw(12) << "mean [us]"
+           << std::setw(12) << "min [us]" << std::setw(12) << "max [us]" << std::setw(12) << "alloc [MB]"
+           << std::setw(12) << "reused [MB]" << "  kernel @ location" << std::endl;
+        for(size_t s : order) {
+            auto & t = total[s];
+            os << std::setw(12) << t.totalNs / 1e6 << std::setw(10) << t.calls
+               << std::setw(12) << t.totalNs / 1e3 / t.calls << std::setw(12) << t.minNs / 1e3
+               << std::setw(12) << t.maxNs / 1e3 << std::setw(12) << t.allocatedBytes / 1e6
+               << std::setw(12) << t.reusedBytes / 1e6 << "  " << sites[s].kernel << " @ " << sites[s].location << std::endl;
+        }
+
+        bool anyWorker = false;
+        uint64_t droppedEvents = 0;
+        for(auto & tb : threads) {
+            anyWorker |= tb->isWorker;
+            droppedEvents += tb->droppedEvents;
+        }
+        if(anyWorker) {
+            os << "Workers of the vectorized engine:" << std::endl;
+            os << std::setw(12) << "worker" << std::setw(10) << "tasks" << std::setw(14) << "rows"
+               << std::setw(12) << "busy [ms]" << std::setw(12) << "idle [ms]" << std::setw(16) << "queue wait [ms]"
+               << std::endl;
+            for(auto & tb : threads)
+                if(tb->isWorker) {
+                    auto & w = tb->worker;
+                    os << std::setw(12) << tb->name << std::setw(10) << w.tasks << std::setw(14) << w.rows
+                       << std::setw(12) << w.busyNs / 1e6 << std::setw(12) << w.idleNs / 1e6
+                       << std::setw(16) << w.queueWaitNs / 1e6 << std::endl;
+                }
+        }
+
+        const auto pool = BufferPool::instance().getStats();
+        os << "Buffer pool:" << std::endl;
+        os << std::setw(12) << "hits" << std::setw(12) << "misses" << std::setw(12) << "evictions"
+           << std::setw(14) << "cached [MB]" << std::endl;
+        os << std::setw(12) << pool.hits << std::setw(12) << pool.misses << std::setw(12) << pool.evictions
+           << std::setw(14) << pool.cachedBytes / 1e6 << std::endl;
+
+        if(droppedEvents)
+            os << "(" << droppedEvents << " events not included in the trace)" << std::endl;
+        os.flags(flags);
+    }
+
+    /**
+     * @brief Writes the recorded events in the Chrome trace event format,
+     * which can be viewed with `chrome://tracing` or Perfetto.
+     */
+    void writeChromeTrace(std::ostream & os) const {
+        std::lock_guard<std::mutex> lock(mtx);
+        os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        auto sep = [&os, &first]() {
+            if(!first)
+                os << ",\n";
+            first = false;
+        };
+        for(auto & tb : threads) {
+            sep();
+            os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tb->tid
+               << ",\"args\":{\"name\":";
+            writeJsonString(os, tb->name);
+            os << "}}";
+            for(auto & e : tb->events) {
+                sep();
+                os << "{\"name\":";
+                switch(e.kind) {
+                    case EventKind::KERNEL:
+                        writeJsonString(os, sites[e.site].kernel);
+                        os << ",\"cat\":\"kernel\"";
+                        break;
+                    case EventKind::TASK:
+                        os << "\"task\",\"cat\":\"task\"";
+                        break;
+                    case EventKind::IDLE:
+                        os << "\"idle\",\"cat\":\"idle\"";
+                        break;
+                }
+                os << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << tb->tid << ",\"ts\":";
+                writeMicros(os, e.beginNs);
+                os << ",\"dur\":";
+                writeMicros(os, e.durNs);
+                switch(e.kind) {
+                    case EventKind::KERNEL:
+                        os << ",\"args\":{\"location\":";
+                        writeJsonString(os, sites[e.site].location);
+                        os << ",\"allocatedBytes\":" << e.value << "}";
+                        break;
+                    case EventKind::TASK:
+                        os << ",\"args\":{\"rows\":" << e.value << ",\"queueWaitUs\":";
+                        writeMicros(os, e.waitNs);
+                        os << "}";
+                        break;
+                    case EventKind::IDLE:
+                        break;
+                }
+                os << "}";
+            }
+        }
+        os << "]}" << std::endl;
+    }
+};
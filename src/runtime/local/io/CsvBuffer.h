@@ -0,0 +1,243 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/io/File.h>
+#include <runtime/local/io/utils.h>
+
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief The remaining contents of a `File` (from its current position on) in
+ * a single buffer, which always ends with a newline.
+ *
+ * Regular files are memory-mapped, everything else (e.g. in-memory files) is
+ * read in large blocks.
+ */
+class CsvBuffer {
+    static constexpr size_t READ_BLOCK_SIZE = 16 * 1024 * 1024;
+
+    const char *data = nullptr;
+    size_t size = 0;
+    void *mapped = nullptr;
+    size_t mappedSize = 0;
+    std::vector<char> owned;
+
+    bool tryMap(FILE *ident) {
+        const int fd = fileno(ident);
+        struct stat st;
+        if(fd == -1 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+            return false;
+        const off_t offset = ftello(ident);
+        if(offset < 0 || offset >= st.st_size)
+            return false;
+        // the offset of a mapping must be a multiple of the page size
+        const off_t pageOffset = offset - offset % sysconf(_SC_PAGESIZE);
+        mappedSize = st.st_size - pageOffset;
+        mapped = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, pageOffset);
+        if(mapped == MAP_FAILED) {
+            mapped = nullptr;
+            return false;
+        }
+        data = static_cast<const char *>(mapped) + (offset - pageOffset);
+        size = st.st_size - offset;
+        // the parser relies on a terminating newline
+        if(data[size - 1] != '\n') {
+            munmap(mapped, mappedSize);
+            mapped = nullptr;
+            return false;
+        }
+        madvise(mapped, mappedSize, MADV_SEQUENTIAL);
+        return true;
+    }
+
+    void readAll(FILE *ident) {
+        size_t numRead;
+        do {
+            const size_t oldSize = owned.size();
+            owned.resize(oldSize + READ_BLOCK_SIZE);
+            numRead = fread(owned.data() + oldSize, 1, READ_BLOCK_SIZE, ident);
+            owned.resize(oldSize + numRead);
+        } while(numRead == READ_BLOCK_SIZE);
+        if(owned.empty() || owned.back() != '\n')
+            owned.push_back('\n');
+        data = owned.data();
+        size = owned.size();
+    }
+
+public:
+    explicit CsvBuffer(File *file) {
+        if(!tryMap(file->identifier))
+            readAll(file->identifier);
+    }
+
+    CsvBuffer(const CsvBuffer &) = delete;
+    CsvBuffer &operator=(const CsvBuffer &) = delete;
+
+    ~CsvBuffer() {
+        if(mapped)
+            munmap(mapped, mappedSize);
+    }
+
+    const char *begin() const { return data; }
+    const char *end() const { return data + size; }
+};
+
+/**
+ * @brief A range of complete lines of a `CsvBuffer`.
+ */
+struct CsvChunk {
+    const char *begin;
+    const char *end;
+    size_t firstRow;
+};
+
+/**
+ * @brief Splits the first `numRows` lines of the buffer into at most
+ * `numChunks` chunks of roughly equal size on line boundaries. Throws if the
+ * buffer has fewer lines.
+ */
+inline std::vector<CsvChunk> splitCsvBuffer(const CsvBuffer &buf, size_t numRows, size_t numChunks) {
+    const size_t size = buf.end() - buf.begin();
+    std::vector<const char *> bounds{buf.begin()};
+    for(size_t i = 1; i < numChunks; i++) {
+        const char *b = std::max(buf.begin() + size * i / numChunks, bounds.back());
+        if(b == buf.end())
+            break;
+        b = static_cast<const char *>(memchr(b, '\n', buf.end() - b)) + 1;
+        if(b != bounds.back() && b != buf.end())
+            bounds.push_back(b);
+    }
+    bounds.push_back(buf.end());
+
+    // count the lines of each chunk (in parallel) to know their first rows
+    std::vector<size_t> numLines(bounds.size() - 1, 0);
+    auto countLines = [&](size_t i) {
+        const char *p = bounds[i];
+        while(p < bounds[i + 1]) {
+            p = static_cast<const char *>(memchr(p, '\n', bounds[i + 1] - p)) + 1;
+            numLines[i]++;
+        }
+    };
+    std::vector<std::thread> threads;
+    for(size_t i = 1; i < numLines.size(); i++)
+        threads.emplace_back(countLines, i);
+    countLines(0);
+    for(auto &t : threads)
+        t.join();
+
+    std::vector<CsvChunk> chunks;
+    size_t row = 0;
+    for(size_t i = 0; i < numLines.size() && row < numRows; i++) {
+        chunks.push_back({bounds[i], bounds[i + 1], row});
+        row += numLines[i];
+    }
+    if(row < numRows)
+        throw std::runtime_error("ReadCsv: expected " + std::to_string(numRows) + " rows, but the file has only " +
+                                 std::to_string(row));
+    return chunks;
+}
+
+/**
+ * @brief Parses the first `numRows` lines of a CSV file (from its current
+ * position on) in parallel.
+ *
+ * The file is split into chunks on line boundaries, which are parsed on all
+ * cores. For each line, `parseRow(row, pos)` is called with a pointer to the
+ * beginning of the line, which it may advance up to the terminating newline
+ * (but not beyond), such that the search for the next line continues there.
+ */
+template<class ParseRow>
+void parseCsvParallel(File *file, size_t numRows, ParseRow parseRow) {
+    // parsing a chunk should clearly outweigh starting a thread
+    constexpr size_t MIN_CHUNK_SIZE = 1024 * 1024;
+
+    CsvBuffer buf(file);
+    const size_t size = buf.end() - buf.begin();
+    const size_t numChunks = std::clamp<size_t>(size / MIN_CHUNK_SIZE, 1, std::max(1u, std::thread::hardware_concurrency()));
+    const std::vector<CsvChunk> chunks = splitCsvBuffer(buf, numRows, numChunks);
+    if(chunks.empty())
+        return;
+
+    auto parseChunk = [&](const CsvChunk &chunk) {
+        const char *pos = chunk.begin;
+        for(size_t row = chunk.firstRow; row < numRows && pos < chunk.end; row++) {
+            parseRow(row, pos);
+            pos = static_cast<const char *>(memchr(pos, '\n', chunk.end - pos)) + 1;
+        }
+    };
+    std::vector<std::thread> threads;
+    std::vector<std::exception_ptr> errors(chunks.size());
+    for(size_t i = 1; i < chunks.size(); i++)
+        threads.emplace_back([&, i] {
+            try {
+                parseChunk(chunks[i]);
+            }
+            catch(...) {
+                errors[i] = std::current_exception();
+            }
+        });
+    try {
+        parseChunk(chunks[0]);
+    }
+    catch(...) {
+        errors[0] = std::current_exception();
+    }
+    for(auto &t : threads)
+        t.join();
+    for(auto &e : errors)
+        if(e)
+            std::rethrow_exception(e);
+}
+
+/**
+ * @brief Parses the field of a CSV line starting at `pos` and advances `pos`
+ * to the beginning of the next field (or to the end of the line).
+ *
+ * Uses the end of the parsed number to find the next delimiter, such that the
+ * field is usually not scanned twice. Empty fields yield NaN for floating
+ * point value types and zero otherwise.
+ */
+template<typename VT>
+inline VT parseCsvField(const char *&pos, char delim) {
+    VT val;
+    const char *p = pos;
+    while(*p == ' ' || *p == '\t')
+        p++;
+    if(*p == delim || *p == '\n' || *p == '\r')
+        val = emptyCsvField<VT>();
+    else
+        p = convertCsvField(p, &val);
+    // skip anything following the number up to the delimiter
+    while(*p != delim && *p != '\n')
+        p++;
+    pos = *p == delim ? p + 1 : p;
+    return val;
+}
@@ -17,7 +17,12 @@
 #ifndef SRC_RUNTIME_LOCAL_IO_DAPHNEFILE_H
 #define SRC_RUNTIME_LOCAL_IO_DAPHNEFILE_H
 
+#include <stdexcept>
+#include <vector>
+
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 
 
 struct DF_header {
@@ -42,4 +47,108 @@ struct DF_body_block {
 
 enum DF_body_t {empty = 0, dense = 1, sparse = 2, ultra_sparse = 3};
 
+// ----------------------------------------------------------------------------
+// Version 2
+// ----------------------------------------------------------------------------
+//
+// DF_header (version 2)
+// data type specific part: ValueTypeCode for matrices; for frames, the
+//     ValueTypeCode of each column, then each label as uint16_t length and
+//     characters
+// blocks, each starting at a multiple of DF_V2_ALIGNMENT:
+//     dense: the values of the block in row-major order
+//     sparse: nbrows + 1 row offsets (uint64_t, starting at 0), nnz column
+//         indexes (uint64_t), nnz values
+// block index: one DF_block_index per block
+// DF_footer
+//
+// Matrices are split into blocks of rows, frames into blocks of rows of each
+// column (i.e., each column is stored contiguously). Uncompressed dense
+// blocks have a size that is a multiple of DF_V2_ALIGNMENT, such that the
+// consecutive blocks of a matrix (or column) form a contiguous array.
+
+constexpr uint8_t DF_VERSION_2 = 2;
+constexpr uint64_t DF_V2_MAGIC = 0x3276666462646164ULL; // "dadbdfv2"
+constexpr size_t DF_V2_ALIGNMENT = 64;
+// the number of rows of each block is a multiple of this
+constexpr size_t DF_V2_BLOCK_ROWS_MULTIPLE = 64;
+// blocks should not be much larger than this (by default)
+constexpr size_t DF_V2_BLOCK_BYTES = 64 * 1024 * 1024;
+
+enum DF_compression_t {no_compression = 0, rle_compression = 1};
+
+struct DF_block_index {
+	uint64_t rx; // row index
+	uint64_t cx; // column index
+	uint64_t nbrows;
+	uint64_t nbcols;
+	uint64_t offset; // from the beginning of the file
+	uint64_t size; // in bytes, as stored
+	uint64_t nnz; // sparse blocks only
+	uint8_t bt; // DF_body_t
+	uint8_t compression; // DF_compression_t
+};
+
+struct DF_footer {
+	uint64_t indexOffset;
+	uint64_t numBlocks;
+	uint64_t magic;
+};
+
+/**
+ * @brief The number of rows of each block of a matrix (or frame column)
+ * whose rows take `rowBytes` bytes, for blocks of about `blockBytes` bytes.
+ */
+inline size_t dfBlockRows(size_t rowBytes, size_t blockBytes = DF_V2_BLOCK_BYTES) {
+	size_t rows = blockBytes / (rowBytes ? rowBytes : 1);
+	rows -= rows % DF_V2_BLOCK_ROWS_MULTIPLE;
+	return rows ? rows : DF_V2_BLOCK_ROWS_MULTIPLE;
+}
+
+/**
+ * @brief Run-length encodes `numElems` elements of `elemSize` bytes as a
+ * sequence of runs (uint32_t length, element).
+ *
+ * Meant for blocks with long runs of the same value (e.g., zeros).
+ */
+inline void dfRleEncode(const uint8_t *src, size_t numElems, size_t elemSize, std::vector<uint8_t> &dst) {
+	dst.clear();
+	size_t i = 0;
+	while (i < numElems) {
+		uint32_t len = 1;
+		while (i + len < numElems && len < UINT32_MAX &&
+				!memcmp(src + (i + len) * elemSize, src + i * elemSize, elemSize))
+			len++;
+		const size_t pos = dst.size();
+		dst.resize(pos + sizeof(len) + elemSize);
+		memcpy(dst.data() + pos, &len, sizeof(len));
+		memcpy(dst.data() + pos + sizeof(len), src + i * elemSize, elemSize);
+		i += len;
+	}
+}
+
+/**
+ * @brief Decodes the output of `dfRleEncode` into exactly `numElems`
+ * elements.
+ */
+inline void dfRleDecode(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t numElems, size_t elemSize) {
+	const uint8_t *end = src + srcSize;
+	size_t i = 0;
+	while (src < end) {
+		if (static_cast<size_t>(end - src) < sizeof(uint32_t) + elemSize)
+			throw std::runtime_error("DaphneFile: corrupt run-length encoded block");
+		uint32_t len;
+		memcpy(&len, src, sizeof(len));
+		if (len > numElems - i)
+			throw std::runtime_error("DaphneFile: corrupt run-length encoded block");
+		src += sizeof(len);
+		for (uint32_t j = 0; j < len; j++)
+			memcpy(dst + (i + j) * elemSize, src, elemSize);
+		src += elemSize;
+		i += len;
+	}
+	if (i != numElems)
+		throw std::runtime_error("DaphneFile: corrupt run-length encoded block");
+}
+
 #endif
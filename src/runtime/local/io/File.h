@@ -24,6 +24,9 @@ struct File {
   FILE *identifier;
   unsigned long pos;
   unsigned long read;
+  // buffer reused by all calls to getLine()
+  char *line;
+  size_t lineCapacity;
 };
 
 inline struct File *openMemFile(FILE *ident){
@@ -31,42 +34,46 @@ inline struct File *openMemFile(FILE *ident){
 
   f->identifier = ident;
   f->pos = 0;
+  f->line = NULL;
+  f->lineCapacity = 0;
 
   return f;
 }
 
 inline struct File *openFile(const char *filename) {
-  struct File *f = (struct File *)malloc(sizeof(struct File));
-
-  f->identifier = fopen(filename, "r");
-  f->pos = 0;
-
-  if (f->identifier == NULL)
+  FILE *ident = fopen(filename, "r");
+  if (ident == NULL)
     return NULL;
-  return f;
+  return openMemFile(ident);
 }
 
 inline struct File *openFileForWrite(const char *filename) {
-  struct File *f = (struct File *)malloc(sizeof(struct File));
-
-  f->identifier = fopen(filename, "w+");
-  f->pos = 0;
-  
-  if (f->identifier == NULL)
+  FILE *ident = fopen(filename, "w+");
+  if (ident == NULL)
     return NULL;
-  return f;
+  return openMemFile(ident);
 }
 
-inline void closeFile(File *f) { fclose(f->identifier); }
+inline void closeFile(File *f) {
+  fclose(f->identifier);
+  free(f->line);
+  free(f);
+}
 
+/**
+ * @brief Reads the next line of the file.
+ *
+ * The returned line is only valid until the next call to `getLine` or
+ * `closeFile` on the same file. Returns `NULL` at the end of the file.
+ */
 inline char *getLine(File *f) {
-  char *line = NULL;
-  size_t len = 0;
-
-  f->read = getline(&line, &len, f->identifier);
-  f->pos += f->read;
+  ssize_t read = getline(&f->line, &f->lineCapacity, f->identifier);
+  f->read = read;
+  if (read == -1)
+    return NULL;
+  f->pos += read;
 
-  return line;
+  return f->line;
 }
 
 #endif
@@ -224,8 +224,9 @@ inline int mm_read_mtx_crd_size(File *f, size_t *M, size_t *N, size_t *nz )
   *M = *N = *nz = 0;
   do
   {
-    num_items_read = sscanf(getLine(f), "%lu %lu %lu", M, N, nz);
-    if ((ssize_t)f->read == EOF) return MM_PREMATURE_EOF;
+    char *line = getLine(f);
+    if (line == NULL) return MM_PREMATURE_EOF;
+    num_items_read = sscanf(line, "%lu %lu %lu", M, N, nz);
   } while (num_items_read != 3);
 
   return 0;
@@ -238,8 +239,9 @@ inline int mm_read_mtx_array_size(File *f, size_t *M, size_t *N)
     *M = *N = 0;
     do
     { 
-      num_items_read = sscanf(getLine(f), "%lu %lu", M, N);
-      if ((ssize_t)f->read == EOF) return MM_PREMATURE_EOF;
+      char *line = getLine(f);
+      if (line == NULL) return MM_PREMATURE_EOF;
+      num_items_read = sscanf(line, "%lu %lu", M, N);
     } while (num_items_read != 2);
 
     return 0;
@@ -0,0 +1,199 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/datastructures/ValueTypeCode.h>
+#include <runtime/local/io/DaphneFile.h>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief A version 2 Daphne binary file mapped into memory.
+ *
+ * Data objects read from the file can wrap (parts of) the mapping instead of
+ * copying it; the mapping lives as long as any of them. The mapping is
+ * private and writable, so kernels may update such data objects in place
+ * without affecting the file. Since the operating system loads the pages of
+ * a mapping on first access, only the blocks actually used are read.
+ */
+class MappedDaphneFile {
+    std::shared_ptr<uint8_t> mapping;
+    size_t size = 0;
+    DF_header header;
+    const DF_block_index * index = nullptr;
+    size_t numBlocks = 0;
+
+    [[noreturn]] static void fail(const std::string & filename, const std::string & msg) {
+        throw std::runtime_error("ReadDaphne: " + filename + ": " + msg);
+    }
+
+public:
+    explicit MappedDaphneFile(const char * filename) {
+        const int fd = open(filename, O_RDONLY);
+        if(fd == -1)
+            fail(filename, "could not open file");
+        struct stat st;
+        if(fstat(fd, &st) != 0) {
+            close(fd);
+            fail(filename, "could not determine the size of the file");
+        }
+        size = st.st_size;
+        if(size < sizeof(DF_header) + sizeof(DF_footer)) {
+            close(fd);
+            fail(filename, "file too small");
+        }
+        void * addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if(addr == MAP_FAILED)
+            fail(filename, "could not map the file into memory");
+        const size_t mappedSize = size;
+        mapping = std::shared_ptr<uint8_t>(static_cast<uint8_t *>(addr), [mappedSize](uint8_t * p) {
+            munmap(p, mappedSize);
+        });
+
+        memcpy(&header, mapping.get(), sizeof(header));
+        if(header.version != DF_VERSION_2)
+            fail(filename, "not a version 2 file");
+        DF_footer footer;
+        memcpy(&footer, mapping.get() + size - sizeof(footer), sizeof(footer));
+        if(footer.magic != DF_V2_MAGIC)
+            fail(filename, "invalid footer");
+        if(footer.indexOffset % alignof(DF_block_index) ||
+                footer.indexOffset + footer.numBlocks * sizeof(DF_block_index) > size - sizeof(footer))
+            fail(filename, "invalid block index");
+        index = reinterpret_cast<const DF_block_index *>(mapping.get() + footer.indexOffset);
+        numBlocks = footer.numBlocks;
+        for(size_t i = 0; i < numBlocks; i++)
+            if(index[i].offset + index[i].size > footer.indexOffset || index[i].offset % DF_V2_ALIGNMENT)
+                fail(filename, "invalid block");
+    }
+
+    /**
+     * @brief Returns the version of the Daphne binary file with the given
+     * name, without mapping it.
+     */
+    static uint8_t getVersion(const char * filename) {
+        uint8_t version = 0;
+        const int fd = open(filename, O_RDONLY);
+        if(fd != -1) {
+            if(::read(fd, &version, sizeof(version)) != sizeof(version))
+                version = 0;
+            close(fd);
+        }
+        return version;
+    }
+
+    const DF_header & getHeader() const {
+        return header;
+    }
+
+    /**
+     * @brief The data type specific part of the header.
+     */
+    const uint8_t * getMeta() const {
+        return mapping.get() + sizeof(DF_header);
+    }
+
+    /**
+     * @brief The blocks of the column `cx` (for frames) overlapping the rows
+     * `[rowLower, rowUpper)`, ordered by their first row.
+     */
+    std::vector<const DF_block_index *> getBlocks(size_t cx, size_t rowLower, size_t rowUpper) const {
+        std::vector<const DF_block_index *> blocks;
+        for(size_t i = 0; i < numBlocks; i++)
+            if(index[i].cx == cx && index[i].rx < rowUpper && index[i].rx + index[i].nbrows > rowLower)
+                blocks.push_back(index + i);
+        std::sort(blocks.begin(), blocks.end(), [](const DF_block_index * a, const DF_block_index * b) {
+            return a->rx < b->rx;
+        });
+        return blocks;
+    }
+
+    /**
+     * @brief A pointer to the given byte offset of the file, which keeps the
+     * mapping alive.
+     */
+    template<typename VT>
+    std::shared_ptr<VT[]> wrap(size_t offset) const {
+        return std::shared_ptr<VT[]>(mapping, reinterpret_cast<VT *>(mapping.get() + offset));
+    }
+
+    const uint8_t * getData(const DF_block_index * block) const {
+        return mapping.get() + block->offset;
+    }
+
+    /**
+     * @brief If the given dense blocks are uncompressed and stored one after
+     * the other, returns the file offset of the row `rowLower` within them,
+     * such that they can be wrapped; otherwise, returns 0.
+     */
+    size_t getContiguousOffset(const std::vector<const DF_block_index *> & blocks, size_t rowLower, size_t rowBytes) const {
+        if(blocks.empty())
+            return 0;
+        for(size_t i = 0; i < blocks.size(); i++) {
+            if(blocks[i]->bt != DF_body_t::dense || blocks[i]->compression != DF_compression_t::no_compression)
+                return 0;
+            if(i && (blocks[i]->offset != blocks[i - 1]->offset + blocks[i - 1]->size ||
+                     blocks[i]->rx != blocks[i - 1]->rx + blocks[i - 1]->nbrows))
+                return 0;
+        }
+        return blocks[0]->offset + (rowLower - blocks[0]->rx) * rowBytes;
+    }
+
+    /**
+     * @brief Copies (or decompresses) the rows `[rowLower, rowUpper)` of the
+     * given dense block, whose rows take `rowBytes` bytes, to `dst`.
+     */
+    void copyDenseRows(const DF_block_index * block, size_t rowLower, size_t rowUpper, size_t rowBytes, size_t elemSize,
+                       uint8_t * dst) const {
+        if(block->bt != DF_body_t::dense)
+            throw std::runtime_error("ReadDaphne: expected a dense block");
+        const size_t first = std::max<size_t>(rowLower, block->rx) - block->rx;
+        const size_t last = std::min<size_t>(rowUpper, block->rx + block->nbrows) - block->rx;
+        const uint8_t * src = getData(block);
+        if(block->compression == DF_compression_t::no_compression) {
+            if(block->size != block->nbrows * rowBytes)
+                throw std::runtime_error("ReadDaphne: invalid block size");
+            memcpy(dst, src + first * rowBytes, (last - first) * rowBytes);
+        }
+        else if(block->compression == DF_compression_t::rle_compression) {
+            const size_t numElems = block->nbrows * rowBytes / elemSize;
+            if(first == 0 && last == block->nbrows)
+                dfRleDecode(src, block->size, dst, numElems, elemSize);
+            else {
+                std::vector<uint8_t> tmp(block->nbrows * rowBytes);
+                dfRleDecode(src, block->size, tmp.data(), numElems, elemSize);
+                memcpy(dst, tmp.data() + first * rowBytes, (last - first) * rowBytes);
+            }
+        }
+        else
+            throw std::runtime_error("ReadDaphne: unknown compression");
+    }
+};
@@ -23,6 +23,7 @@
 #include <runtime/local/datastructures/Handle.h>
 #include <runtime/local/kernels/DistributedCaller.h>
 
+#include <runtime/local/io/CsvBuffer.h>
 #include <runtime/local/io/File.h>
 #include <runtime/local/io/utils.h>
 
@@ -94,35 +95,14 @@ template <typename VT> struct ReadCsvFile<DenseMatrix<VT>> {
       res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
     }
 
-    char *line;
-    size_t cell = 0;
     VT * valuesRes = res->getValues();
+    const size_t rowSkip = res->getRowSkip();
 
-    for(size_t r = 0; r < numRows; r++) {
-      line = getLine(file);
-      // TODO Assuming that the given numRows is available, this should never
-      // happen.
-//      if (line == NULL)
-//        break;
-
-      size_t pos = 0;
-      for(size_t c = 0; c < numCols; c++) {
-        VT val;
-        convertCstr(line + pos, &val);
-        
-        // TODO This assumes that rowSkip == numCols.
-        valuesRes[cell++] = val;
-        
-        // TODO We could even exploit the fact that the strtoX functions can
-        // return a pointer to the first character after the parsed input, then
-        // we wouldn't have to search for that ourselves, just would need to
-        // check if it is really the delimiter.
-        if(c < numCols - 1) {
-            while(line[pos] != delim) pos++;
-            pos++; // skip delimiter
-        }
-      }
-    }
+    parseCsvParallel(file, numRows, [&](size_t r, const char *&pos) {
+      VT * rowRes = valuesRes + r * rowSkip;
+      for(size_t c = 0; c < numCols; c++)
+        rowRes[c] = parseCsvField<VT>(pos, delim);
+    });
   }
 };
 
@@ -248,9 +228,6 @@ template <> struct ReadCsvFile<Frame> {
       res = DataObjectFactory::create<Frame>(numRows, numCols, schema, nullptr, false);
     }
 
-    char *line;
-    size_t row = 0, col = 0;
-
     uint8_t ** rawCols = new uint8_t * [numCols];
     ValueTypeCode * colTypes = new ValueTypeCode[numCols];
     for(size_t i = 0; i < numCols; i++) {
@@ -258,76 +235,39 @@ template <> struct ReadCsvFile<Frame> {
         colTypes[i] = res->getColumnType(i);
     }
 
-    while (1) {
-      line = getLine(file);
-      if (line == NULL)
-        break;
-
-      size_t pos = 0;
-      while (1) {
+    parseCsvParallel(file, numRows, [&](size_t row, const char *&pos) {
+      for(size_t col = 0; col < numCols; col++) {
         switch (colTypes[col]) {
         case ValueTypeCode::SI8:
-          int8_t val_si8;
-          convertCstr(line + pos, &val_si8);
-          reinterpret_cast<int8_t *>(rawCols[col])[row] = val_si8;
+          reinterpret_cast<int8_t *>(rawCols[col])[row] = parseCsvField<int8_t>(pos, delim);
           break;
         case ValueTypeCode::SI32:
-          int32_t val_si32;
-          convertCstr(line + pos, &val_si32);
-          reinterpret_cast<int32_t *>(rawCols[col])[row] = val_si32;
+          reinterpret_cast<int32_t *>(rawCols[col])[row] = parseCsvField<int32_t>(pos, delim);
           break;
         case ValueTypeCode::SI64:
-          int64_t val_si64;
-          convertCstr(line + pos, &val_si64);
-          reinterpret_cast<int64_t *>(rawCols[col])[row] = val_si64;
+          reinterpret_cast<int64_t *>(rawCols[col])[row] = parseCsvField<int64_t>(pos, delim);
           break;
         case ValueTypeCode::UI8:
-          uint8_t val_ui8;
-          convertCstr(line + pos, &val_ui8);
-          reinterpret_cast<uint8_t *>(rawCols[col])[row] = val_ui8;
+          reinterpret_cast<uint8_t *>(rawCols[col])[row] = parseCsvField<uint8_t>(pos, delim);
           break;
         case ValueTypeCode::UI32:
-          uint32_t val_ui32;
-          convertCstr(line + pos, &val_ui32);
-          reinterpret_cast<uint32_t *>(rawCols[col])[row] = val_ui32;
+          reinterpret_cast<uint32_t *>(rawCols[col])[row] = parseCsvField<uint32_t>(pos, delim);
           break;
         case ValueTypeCode::UI64:
-          uint64_t val_ui64;
-          convertCstr(line + pos, &val_ui64);
-          reinterpret_cast<uint64_t *>(rawCols[col])[row] = val_ui64;
+          reinterpret_cast<uint64_t *>(rawCols[col])[row] = parseCsvField<uint64_t>(pos, delim);
           break;
         case ValueTypeCode::F32:
-          float val_f32;
-          convertCstr(line + pos, &val_f32);
-          reinterpret_cast<float *>(rawCols[col])[row] = val_f32;
+          reinterpret_cast<float *>(rawCols[col])[row] = parseCsvField<float>(pos, delim);
           break;
         case ValueTypeCode::F64:
-          double val_f64;
-          convertCstr(line + pos, &val_f64);
-          reinterpret_cast<double *>(rawCols[col])[row] = val_f64;
+          reinterpret_cast<double *>(rawCols[col])[row] = parseCsvField<double>(pos, delim);
           break;
         default:
           throw std::runtime_error("ReadCsvFile::apply: unknown value type code");
         }
-
-        if (++col >= numCols) {
-          break;
-        }
-        
-        // TODO We could even exploit the fact that the strtoX functions can
-        // return a pointer to the first character after the parsed input, then
-        // we wouldn't have to search for that ourselves, just would need to
-        // check if it is really the delimiter.
-        while(line[pos] != delim) pos++;
-        pos++; // skip delimiter
       }
+    });
 
-      if (++row >= numRows) {
-        break;
-      }
-      col = 0;
-    }
-    
     delete[] rawCols;
     delete[] colTypes;
   }
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <runtime/local/datastructures/BufferPool.h>
 #include <runtime/local/datastructures/ValueTypeCode.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
@@ -23,17 +24,26 @@
 #include <runtime/local/datastructures/Frame.h>
 
 #include <runtime/local/io/DaphneFile.h>
+#include <runtime/local/io/MappedDaphneFile.h>
 #include <runtime/local/io/utils.h>
 
+#include <util/DeduceType.h>
+#include <util/ParallelFor.h>
 #include <util/preprocessor_defs.h>
 
+#include <algorithm>
 #include <type_traits>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 #include <stdlib.h>
 
@@ -55,12 +65,305 @@ void readDaphne(DTRes *&res, const char *filename) {
   ReadDaphne<DTRes>::apply(res, filename);
 }
 
+// ****************************************************************************
+// Helpers for reading sparse blocks
+// ****************************************************************************
+
+/**
+ * @brief Reads consecutive items from a stream through a large buffer, since
+ * calling `std::istream::read` for each individual item is slow.
+ */
+class DaphneFileBuffer {
+  static constexpr size_t BLOCK_SIZE = 16 * 1024 * 1024;
+
+  std::istream &in;
+  std::vector<char> buf;
+  size_t pos = 0;
+  size_t end = 0;
+
+public:
+  explicit DaphneFileBuffer(std::istream &in) : in(in), buf(BLOCK_SIZE) {}
+
+  void read(void *dst, size_t n) {
+    if (end - pos >= n) {
+      memcpy(dst, buf.data() + pos, n);
+      pos += n;
+      return;
+    }
+    // item straddles the end of the buffer
+    const size_t avail = end - pos;
+    memcpy(dst, buf.data() + pos, avail);
+    dst = static_cast<char *>(dst) + avail;
+    n -= avail;
+    pos = end = 0;
+    if (n >= BLOCK_SIZE) {
+      in.read(static_cast<char *>(dst), n);
+      if (static_cast<size_t>(in.gcount()) != n)
+        throw std::runtime_error("ReadDaphne: unexpected end of file");
+      return;
+    }
+    in.read(buf.data(), BLOCK_SIZE);
+    end = in.gcount();
+    if (end < n)
+      throw std::runtime_error("ReadDaphne: unexpected end of file");
+    memcpy(dst, buf.data(), n);
+    pos = n;
+  }
+
+  template <typename T> T read() {
+    T val;
+    read(&val, sizeof(T));
+    return val;
+  }
+};
+
+/**
+ * @brief Fills the (already allocated) CSR matrix `res` with the given
+ * non-zeros in coordinate (COO) format, which may be in any order.
+ *
+ * The non-zeros are distributed to their rows by a parallel counting sort;
+ * afterwards, each row is sorted by column index. Of duplicate coordinates,
+ * the last one wins (as if set one after the other).
+ *
+ * @param colIdxs The column index of each non-zero, or `nullptr` if all
+ * non-zeros are in the first column.
+ */
+template <typename VT>
+void cooToCsr(CSRMatrix<VT> *res, const uint32_t *rowIdxs, const uint32_t *colIdxs, const VT *values, size_t nnz) {
+  const size_t numRows = res->getNumRows();
+  const size_t numCols = res->getNumCols();
+  size_t *rowOffsetsRes = res->getRowOffsets();
+  size_t *colIdxsRes = res->getColIdxs();
+  VT *valuesRes = res->getValues();
+
+  const size_t numThreads = limitThreadsByHistogram(parallelForNumThreads(nnz, 0), nnz, numRows);
+
+  // Count the non-zeros per row in each range of non-zeros.
+  std::vector<std::vector<size_t>> hist(numThreads);
+  parallelFor(numThreads, numThreads, [&](size_t t) {
+    hist[t].assign(numRows, 0);
+    for (size_t i = nnz * t / numThreads; i < nnz * (t + 1) / numThreads; i++) {
+      if (rowIdxs[i] >= numRows || (colIdxs ? colIdxs[i] : 0) >= numCols)
+        throw std::runtime_error("ReadDaphne: coordinate out of bounds");
+      hist[t][rowIdxs[i]]++;
+    }
+  });
+
+  // Turn the histograms into the positions to write to.
+  rowOffsetsRes[0] = 0;
+  for (size_t r = 0; r < numRows; r++) {
+    size_t pos = rowOffsetsRes[r];
+    for (size_t t = 0; t < numThreads; t++) {
+      const size_t cnt = hist[t][r];
+      hist[t][r] = pos;
+      pos += cnt;
+    }
+    rowOffsetsRes[r + 1] = pos;
+  }
+
+  // Scatter the non-zeros (stable, i.e., in file order within each row).
+  parallelFor(numThreads, numThreads, [&](size_t t) {
+    size_t *pos = hist[t].data();
+    for (size_t i = nnz * t / numThreads; i < nnz * (t + 1) / numThreads; i++) {
+      const size_t p = pos[rowIdxs[i]]++;
+      colIdxsRes[p] = colIdxs ? colIdxs[i] : 0;
+      valuesRes[p] = values[i];
+    }
+  });
+
+  // Sort each row by column index and remove duplicates.
+  std::vector<size_t> rowNnz(numRows);
+  const size_t numChunks = std::min(numRows, numThreads * 4);
+  parallelFor(numChunks, numThreads, [&](size_t t) {
+    std::vector<std::pair<size_t, VT>> entries;
+    for (size_t r = numRows * t / numChunks; r < numRows * (t + 1) / numChunks; r++) {
+      const size_t begin = rowOffsetsRes[r];
+      const size_t end = rowOffsetsRes[r + 1];
+      if (std::is_sorted(colIdxsRes + begin, colIdxsRes + end, std::less_equal<size_t>())) {
+        rowNnz[r] = end - begin;
+        continue;
+      }
+      entries.clear();
+      for (size_t i = begin; i < end; i++)
+        entries.emplace_back(colIdxsRes[i], valuesRes[i]);
+      std::stable_sort(entries.begin(), entries.end(),
+                       [](const std::pair<size_t, VT> &a, const std::pair<size_t, VT> &b) { return a.first < b.first; });
+      size_t p = begin;
+      for (size_t i = 0; i < entries.size(); i++) {
+        if (i + 1 < entries.size() && entries[i + 1].first == entries[i].first)
+          continue;
+        colIdxsRes[p] = entries[i].first;
+        valuesRes[p] = entries[i].second;
+        p++;
+      }
+      rowNnz[r] = p - begin;
+    }
+  });
+
+  // Close the gaps left by duplicates.
+  size_t p = 0;
+  for (size_t r = 0; r < numRows; r++) {
+    const size_t begin = rowOffsetsRes[r];
+    if (p != begin) {
+      memmove(colIdxsRes + p, colIdxsRes + begin, rowNnz[r] * sizeof(size_t));
+      memmove(valuesRes + p, valuesRes + begin, rowNnz[r] * sizeof(VT));
+    }
+    rowOffsetsRes[r] = p;
+    p += rowNnz[r];
+  }
+  rowOffsetsRes[numRows] = p;
+}
+
+// ****************************************************************************
+// Helpers for reading version 2 files
+// ****************************************************************************
+
+/**
+ * @brief Reads the rows `[rowLower, rowUpper)` of the column `cx` (0 for
+ * matrices) of a version 2 file, whose rows have `rowWidth` values.
+ *
+ * If the blocks touched are uncompressed and contiguous, the result wraps the
+ * mapped file; otherwise, only these blocks are copied (or decompressed).
+ */
+template <typename VT>
+std::shared_ptr<VT[]> readDaphneDenseRows(const MappedDaphneFile &file, size_t cx, size_t rowWidth, size_t rowLower,
+                                          size_t rowUpper) {
+  const size_t rowBytes = rowWidth * sizeof(VT);
+  const std::vector<const DF_block_index *> blocks = file.getBlocks(cx, rowLower, rowUpper);
+  size_t covered = 0;
+  for (auto b : blocks)
+    covered += std::min<size_t>(rowUpper, b->rx + b->nbrows) - std::max<size_t>(rowLower, b->rx);
+  if (covered != rowUpper - rowLower)
+    throw std::runtime_error("ReadDaphne: the blocks do not cover the requested rows");
+
+  if (const size_t offset = file.getContiguousOffset(blocks, rowLower, rowBytes))
+    return file.wrap<VT>(offset);
+
+  std::shared_ptr<VT[]> values = BufferPool::instance().allocate<VT[]>((rowUpper - rowLower) * rowWidth, false);
+  uint8_t *dst = reinterpret_cast<uint8_t *>(values.get());
+  const size_t numThreads = blocks.size() > 1 ? std::max(1u, std::thread::hardware_concurrency()) : 1;
+  parallelFor(blocks.size(), numThreads, [&](size_t i) {
+    const DF_block_index *b = blocks[i];
+    const size_t first = std::max<size_t>(rowLower, b->rx);
+    file.copyDenseRows(b, rowLower, rowUpper, rowBytes, sizeof(VT), dst + (first - rowLower) * rowBytes);
+  });
+  return values;
+}
+
+template <typename VT>
+struct ReadDaphneFrameColumn {
+  static void apply(Structure *&col, const MappedDaphneFile *file, size_t cx, size_t rowLower, size_t rowUpper) {
+    auto values = readDaphneDenseRows<VT>(*file, cx, 1, rowLower, rowUpper);
+    col = DataObjectFactory::create<DenseMatrix<VT>>(rowUpper - rowLower, 1, values);
+  }
+};
+
+template <typename VT>
+void readDaphneV2(DenseMatrix<VT> *&res, const char *filename, size_t rowLower, size_t rowUpper) {
+  MappedDaphneFile file(filename);
+  const DF_header &h = file.getHeader();
+  if (h.dt != DF_data_t::DenseMatrix_t)
+    throw std::runtime_error("ReadDaphne: the file does not contain a dense matrix");
+  if (static_cast<ValueTypeCode>(*file.getMeta()) != ValueTypeUtils::codeFor<VT>)
+    throw std::runtime_error("ReadDaphne: the file has a different value type");
+  rowUpper = std::min<size_t>(rowUpper, h.nbrows);
+  if (rowLower > rowUpper)
+    throw std::runtime_error("ReadDaphne: invalid range of rows");
+  auto values = readDaphneDenseRows<VT>(file, 0, h.nbcols, rowLower, rowUpper);
+  res = DataObjectFactory::create<DenseMatrix<VT>>(rowUpper - rowLower, static_cast<size_t>(h.nbcols), values);
+}
+
+template <typename VT>
+void readDaphneV2(CSRMatrix<VT> *&res, const char *filename) {
+  MappedDaphneFile file(filename);
+  const DF_header &h = file.getHeader();
+  if (h.dt != DF_data_t::CSRMatrix_t)
+    throw std::runtime_error("ReadDaphne: the file does not contain a sparse matrix");
+  if (static_cast<ValueTypeCode>(*file.getMeta()) != ValueTypeUtils::codeFor<VT>)
+    throw std::runtime_error("ReadDaphne: the file has a different value type");
+  const std::vector<const DF_block_index *> blocks = file.getBlocks(0, 0, h.nbrows);
+
+  // the position of each block in the arrays of the result
+  std::vector<size_t> nnzOffsets{0};
+  size_t numRows = 0;
+  for (auto b : blocks) {
+    if (b->bt != DF_body_t::sparse || b->rx != numRows ||
+        b->size != (b->nbrows + 1 + b->nnz) * sizeof(uint64_t) + b->nnz * sizeof(VT))
+      throw std::runtime_error("ReadDaphne: invalid sparse block");
+    nnzOffsets.push_back(nnzOffsets.back() + b->nnz);
+    numRows += b->nbrows;
+  }
+  if (numRows != h.nbrows)
+    throw std::runtime_error("ReadDaphne: the blocks do not cover all rows");
+
+  res = DataObjectFactory::create<CSRMatrix<VT>>(h.nbrows, h.nbcols, nnzOffsets.back(), false);
+  size_t *rowOffsets = res->getRowOffsets();
+  size_t *colIdxs = res->getColIdxs();
+  VT *values = res->getValues();
+  rowOffsets[0] = 0;
+  const size_t numThreads = blocks.size() > 1 ? std::max(1u, std::thread::hardware_concurrency()) : 1;
+  parallelFor(blocks.size(), numThreads, [&](size_t i) {
+    const DF_block_index *b = blocks[i];
+    const uint8_t *data = file.getData(b);
+    const uint64_t *offsets = reinterpret_cast<const uint64_t *>(data);
+    for (size_t r = 1; r <= b->nbrows; r++)
+      rowOffsets[b->rx + r] = nnzOffsets[i] + offsets[r];
+    static_assert(sizeof(size_t) == sizeof(uint64_t), "column indexes are stored as uint64_t");
+    memcpy(colIdxs + nnzOffsets[i], offsets + b->nbrows + 1, b->nnz * sizeof(size_t));
+    memcpy(values + nnzOffsets[i], offsets + b->nbrows + 1 + b->nnz, b->nnz * sizeof(VT));
+  });
+}
+
+inline void readDaphneV2(Frame *&res, const char *filename, size_t rowLower, size_t rowUpper) {
+  MappedDaphneFile file(filename);
+  const DF_header &h = file.getHeader();
+  if (h.dt != DF_data_t::Frame_t)
+    throw std::runtime_error("ReadDaphne: the file does not contain a frame");
+  rowUpper = std::min<size_t>(rowUpper, h.nbrows);
+  if (rowLower > rowUpper)
+    throw std::runtime_error("ReadDaphne: invalid range of rows");
+
+  const uint8_t *meta = file.getMeta();
+  std::vector<ValueTypeCode> schema(h.nbcols);
+  memcpy(schema.data(), meta, h.nbcols * sizeof(ValueTypeCode));
+  meta += h.nbcols * sizeof(ValueTypeCode);
+  std::vector<std::string> labels(h.nbcols);
+  for (size_t c = 0; c < h.nbcols; c++) {
+    uint16_t len;
+    memcpy(&len, meta, sizeof(len));
+    labels[c].assign(reinterpret_cast<const char *>(meta + sizeof(len)), len);
+    meta += sizeof(len) + len;
+  }
+
+  std::vector<Structure *> cols(h.nbcols);
+  for (size_t c = 0; c < h.nbcols; c++)
+    DeduceValueTypeAndExecute<ReadDaphneFrameColumn>::apply(schema[c], cols[c], &file, c, rowLower, rowUpper);
+  res = DataObjectFactory::create<Frame>(cols, labels.data());
+  for (auto col : cols)
+    DataObjectFactory::destroy(col);
+}
+
+/**
+ * @brief Reads only the rows `[rowLower, rowUpper)` of a dense matrix or frame
+ * from a version 2 file, touching only the blocks these rows are stored in.
+ */
+template <class DTRes>
+void readDaphneRows(DTRes *&res, const char *filename, size_t rowLower, size_t rowUpper) {
+  if (MappedDaphneFile::getVersion(filename) != DF_VERSION_2)
+    throw std::runtime_error("ReadDaphne: reading a range of rows requires a version 2 file");
+  readDaphneV2(res, filename, rowLower, rowUpper);
+}
+
 // ****************************************************************************
 // (Partial) template specializations for different data/value types
 // ****************************************************************************
 
 template <typename VT> struct ReadDaphne<DenseMatrix<VT>> {
   static void apply(DenseMatrix<VT> *&res, const char *filename) {
+    if (MappedDaphneFile::getVersion(filename) == DF_VERSION_2) {
+      readDaphneV2(res, filename, 0, std::numeric_limits<size_t>::max());
+      return;
+    }
 
     std::ifstream f;
     f.open(filename, std::ios::in|std::ios::binary);
@@ -92,7 +395,7 @@ template <typename VT> struct ReadDaphne<DenseMatrix<VT>> {
 
          size_t numItems = bb.nbrows*bb.nbcols;
          std::streamsize memBlockSize = numItems * sizeof(VT);
-         auto memblock = std::shared_ptr<VT[]>(new VT[numItems], std::default_delete<VT[]>());
+         auto memblock = BufferPool::instance().allocate<VT[]>(numItems, false);
          f.read(reinterpret_cast<char*>(memblock.get()), memBlockSize);
 		 res = DataObjectFactory::create<DenseMatrix<VT>>(static_cast<size_t>(bb.nbrows), static_cast<size_t>(bb.nbcols),
                  memblock);
@@ -108,10 +411,15 @@ exit:
 
 template <typename VT> struct ReadDaphne<CSRMatrix<VT>> {
   static void apply(CSRMatrix<VT> *&res, const char *filename) {
+    if (MappedDaphneFile::getVersion(filename) == DF_VERSION_2) {
+      readDaphneV2(res, filename);
+      return;
+    }
 
     std::ifstream f;
     f.open(filename, std::ios::in|std::ios::binary);
-    // TODO: check f.good()
+    if (!f.good())
+      throw std::runtime_error(std::string("ReadDaphne: could not open file ") + filename);
 
     // read header
     DF_header h;
@@ -141,21 +449,24 @@ template <typename VT> struct ReadDaphne<CSRMatrix<VT>> {
 		    f.read((char *)&nzb, sizeof(nzb));
 
 		    res = DataObjectFactory::create<CSRMatrix<VT>>(
-				bb.nbrows, bb.nbcols, nzb, true);
-
+				bb.nbrows, bb.nbcols, nzb, false);
+		    size_t * rowOffsets = res->getRowOffsets();
+		    size_t * colIdxs = res->getColIdxs();
+		    VT * values = res->getValues();
+
+		    // the rows are stored one after the other, so we can fill the
+		    // arrays of the CSR matrix directly
+		    DaphneFileBuffer buf(f);
+		    rowOffsets[0] = 0;
 		    for (size_t i = 0; i < bb.nbrows; i++) {
-			    uint64_t nzr;
-			    f.read((char *)&nzr, sizeof(nzr));
-
-			    for (uint64_t n = 0; n < nzr; n++) {
-				  size_t j;
-				  f.read((char *)&j, sizeof(j));
-
-				  VT val;
-				  f.read((char *)&val, sizeof(val));
-
-				  res->set(i, j, val);
+			    const uint64_t nzr = buf.read<uint64_t>();
+			    if (nzr > nzb - rowOffsets[i])
+				    throw std::runtime_error("ReadDaphne: more non-zeros than declared");
+			    for (size_t n = rowOffsets[i]; n < rowOffsets[i] + nzr; n++) {
+				    colIdxs[n] = buf.read<size_t>();
+				    values[n] = buf.read<VT>();
 			    }
+			    rowOffsets[i + 1] = rowOffsets[i] + nzr;
 		    }
 
 		goto exit;
@@ -171,35 +482,27 @@ template <typename VT> struct ReadDaphne<CSRMatrix<VT>> {
 		    res = DataObjectFactory::create<CSRMatrix<VT>>(
 				bb.nbrows, bb.nbcols, nzb, false);
 
-		   // Single column case
-		   if (bb.nbcols == 1) {
+		    // read all coordinates first, then build the CSR matrix
+		    DaphneFileBuffer buf(f);
+		    std::vector<uint32_t> rowIdxs(nzb);
+		    std::vector<VT> values(nzb);
+		    // Single column case
+		    if (bb.nbcols == 1) {
 			for (uint64_t n = 0; n < nzb; n++) {
-				uint32_t i;
-				f.read((char *)&i, sizeof(i));
-
-				VT val;
-				f.read((char *)&val, sizeof(val));
-
-				res->set(i, 1, val);
+				rowIdxs[n] = buf.read<uint32_t>();
+				values[n] = buf.read<VT>();
 			}
-			goto exit;
-		   } else {
-			   // TODO: check numcols is greater than 1
+			cooToCsr(res, rowIdxs.data(), nullptr, values.data(), nzb);
+		    } else {
+			std::vector<uint32_t> colIdxs(nzb);
 			for (uint64_t n = 0; n < nzb; n++) {
-				uint32_t i;
-				f.read((char *)&i, sizeof(i));
-
-				uint32_t j;
-				f.read((char *)&j, sizeof(j));
-
-				VT val;
-				f.read((char *)&val, sizeof(val));
-
-				res->set(i, j, val);
+				rowIdxs[n] = buf.read<uint32_t>();
+				colIdxs[n] = buf.read<uint32_t>();
+				values[n] = buf.read<VT>();
 			}
-			goto exit;
-		   }
-
+			cooToCsr(res, rowIdxs.data(), colIdxs.data(), values.data(), nzb);
+		    }
+		    goto exit;
 	    }
 	    //TODO: frames
 exit:
@@ -211,6 +514,10 @@ exit:
 
 template <> struct ReadDaphne<Frame> {
   static void apply(Frame *&res, const char *filename){
+    if (MappedDaphneFile::getVersion(filename) == DF_VERSION_2) {
+      readDaphneV2(res, filename, 0, std::numeric_limits<size_t>::max());
+      return;
+    }
 
     std::ifstream f;
     f.open(filename, std::ios::in|std::ios::binary);
@@ -21,29 +21,25 @@
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/Frame.h>
-#include <runtime/local/datastructures/Handle.h>
-#include <runtime/local/kernels/DistributedCaller.h>
-
-#include <runtime/local/io/File.h>
-#include <runtime/local/io/ReadCsvFile.h>
-#include <runtime/local/io/utils.h>
+#include <runtime/local/datastructures/ValueTypeUtils.h>
 
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
-#include <cassert>
 #include <cstddef>
 #include <cstdint>
-#include <queue>
-#include <fstream>
-#include <limits>
-#include <sstream>
+#include <cstring>
 
 #include <arrow/api.h>
-#include <arrow/io/memory.h>
-#include <arrow/ipc/api.h>
+#include <arrow/io/file.h>
 #include <parquet/arrow/reader.h>
-#include <arrow/filesystem/localfs.h>
-#include <arrow/csv/api.h>
 
 // ****************************************************************************
 // Struct for partial template specialization
@@ -79,39 +75,222 @@ void readParquet(DTRes *&res, const char *filename, size_t numRows, size_t numCo
 }
 
 // ****************************************************************************
-// (Partial) template specializations for different data/value types
+// Utilities for reading Parquet files directly into DAPHNE data objects
 // ****************************************************************************
 
-inline struct File *arrowToCsv(const char *filename){
-    arrow::Status st;
-    arrow::MemoryPool* pool = arrow::default_memory_pool();
-    arrow::fs::LocalFileSystem file_system;
-    std::shared_ptr<arrow::io::RandomAccessFile> input = file_system.OpenInputFile(filename).ValueOrDie();
-
-    std::unique_ptr<parquet::arrow::FileReader> arrow_reader;
-    st = parquet::arrow::OpenFile(input, pool, &arrow_reader);
-    if (!st.ok()) {
-       // TODO: Handle error instantiating file reader...
-       return NULL;
+/**
+ * @brief Opens the given Parquet file, throws if that fails.
+ */
+inline std::unique_ptr<parquet::arrow::FileReader> openParquetFile(const char *filename) {
+    auto input = arrow::io::ReadableFile::Open(filename);
+    if(!input.ok())
+        throw std::runtime_error("ReadParquet: could not open file " + std::string(filename) + ": " +
+                                 input.status().ToString());
+    std::unique_ptr<parquet::arrow::FileReader> reader;
+    arrow::Status st = parquet::arrow::OpenFile(input.ValueOrDie(), arrow::default_memory_pool(), &reader);
+    if(!st.ok())
+        throw std::runtime_error("ReadParquet: could not read file " + std::string(filename) + ": " + st.ToString());
+    return reader;
+}
+
+/**
+ * @brief Copies the values of a chunk of a numeric Arrow column to `dst`,
+ * writing every `stride`-th element. Nulls become zero.
+ */
+template <typename VT, class ArrowType>
+void copyParquetChunk(const arrow::Array &chunk, VT *dst, size_t stride) {
+    using CT = typename ArrowType::c_type;
+    const CT *src = static_cast<const arrow::NumericArray<ArrowType> &>(chunk).raw_values();
+    const size_t n = static_cast<size_t>(chunk.length());
+    if(chunk.null_count()) {
+        for(size_t i = 0; i < n; i++)
+            dst[i * stride] = chunk.IsNull(i) ? VT(0) : static_cast<VT>(src[i]);
+    }
+    else if constexpr(std::is_same_v<CT, VT>) {
+        if(stride == 1)
+            memcpy(dst, src, n * sizeof(VT));
+        else
+            for(size_t i = 0; i < n; i++)
+                dst[i * stride] = src[i];
+    }
+    else {
+        for(size_t i = 0; i < n; i++)
+            dst[i * stride] = static_cast<VT>(src[i]);
     }
+}
 
-    std::shared_ptr<arrow::Table> table;
-    st = arrow_reader->ReadTable(&table);
+template <typename VT>
+void copyParquetChunk(const arrow::Array &chunk, VT *dst, size_t stride) {
+    switch(chunk.type_id()) {
+        case arrow::Type::INT8:   copyParquetChunk<VT, arrow::Int8Type>(chunk, dst, stride); break;
+        case arrow::Type::INT16:  copyParquetChunk<VT, arrow::Int16Type>(chunk, dst, stride); break;
+        case arrow::Type::INT32:  copyParquetChunk<VT, arrow::Int32Type>(chunk, dst, stride); break;
+        case arrow::Type::INT64:  copyParquetChunk<VT, arrow::Int64Type>(chunk, dst, stride); break;
+        case arrow::Type::UINT8:  copyParquetChunk<VT, arrow::UInt8Type>(chunk, dst, stride); break;
+        case arrow::Type::UINT16: copyParquetChunk<VT, arrow::UInt16Type>(chunk, dst, stride); break;
+        case arrow::Type::UINT32: copyParquetChunk<VT, arrow::UInt32Type>(chunk, dst, stride); break;
+        case arrow::Type::UINT64: copyParquetChunk<VT, arrow::UInt64Type>(chunk, dst, stride); break;
+        case arrow::Type::FLOAT:  copyParquetChunk<VT, arrow::FloatType>(chunk, dst, stride); break;
+        case arrow::Type::DOUBLE: copyParquetChunk<VT, arrow::DoubleType>(chunk, dst, stride); break;
+        case arrow::Type::BOOL: {
+            const auto &arr = static_cast<const arrow::BooleanArray &>(chunk);
+            for(int64_t i = 0; i < arr.length(); i++)
+                dst[i * stride] = (!arr.IsNull(i) && arr.Value(i)) ? VT(1) : VT(0);
+            break;
+        }
+        default:
+            throw std::runtime_error("ReadParquet: unsupported column type " + chunk.type()->ToString());
+    }
+}
 
-    auto output = arrow::io::BufferOutputStream::Create().ValueOrDie();
-    arrow::csv::WriteCSV(*table, arrow::csv::WriteOptions::Defaults(), output.get());
-    auto finishResult = output->Finish();
+inline void copyParquetChunk(const arrow::Array &chunk, ValueTypeCode vtc, uint8_t *dst) {
+    switch(vtc) {
+        case ValueTypeCode::SI8:  copyParquetChunk(chunk, reinterpret_cast<int8_t *>(dst), 1); break;
+        case ValueTypeCode::SI32: copyParquetChunk(chunk, reinterpret_cast<int32_t *>(dst), 1); break;
+        case ValueTypeCode::SI64: copyParquetChunk(chunk, reinterpret_cast<int64_t *>(dst), 1); break;
+        case ValueTypeCode::UI8:  copyParquetChunk(chunk, reinterpret_cast<uint8_t *>(dst), 1); break;
+        case ValueTypeCode::UI32: copyParquetChunk(chunk, reinterpret_cast<uint32_t *>(dst), 1); break;
+        case ValueTypeCode::UI64: copyParquetChunk(chunk, reinterpret_cast<uint64_t *>(dst), 1); break;
+        case ValueTypeCode::F32:  copyParquetChunk(chunk, reinterpret_cast<float *>(dst), 1); break;
+        case ValueTypeCode::F64:  copyParquetChunk(chunk, reinterpret_cast<double *>(dst), 1); break;
+        default: throw std::runtime_error("ReadParquet: unsupported value type");
+    }
+}
 
-    auto csv = finishResult.ValueOrDie()->ToString();
-    void *ccsv = csv.data();
+/**
+ * @brief Creates a single-column `DenseMatrix` from the chunks of an Arrow
+ * column. If the column consists of a single chunk whose layout matches (same
+ * value type, no nulls), the matrix shares the Arrow buffer instead of copying
+ * it.
+ */
+template <typename VT>
+DenseMatrix<VT> *parquetColumnToMatrix(const arrow::ArrayVector &chunks, size_t numRows) {
+    using ArrowType = typename arrow::CTypeTraits<VT>::ArrowType;
+    if(chunks.size() == 1 && chunks[0]->type_id() == ArrowType::type_id && !chunks[0]->null_count()) {
+        const auto &chunk = chunks[0];
+        auto *raw = const_cast<VT *>(std::static_pointer_cast<arrow::NumericArray<ArrowType>>(chunk)->raw_values());
+        std::shared_ptr<VT[]> values(chunk->data()->buffers[1], raw);
+        return DataObjectFactory::create<DenseMatrix<VT>>(numRows, 1, values);
+    }
+    auto *res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, 1, false);
+    size_t rowOffset = 0;
+    for(const auto &chunk : chunks) {
+        copyParquetChunk(*chunk, res->getValues() + rowOffset, 1);
+        rowOffset += chunk->length();
+    }
+    return res;
+}
 
-    FILE *buf = fmemopen(ccsv, csv.size(), "r");
-    struct File *file = openMemFile(buf);
-    getLine(file); // Parquet has headers, readCsv does not expect that.
+inline Structure *parquetColumnToMatrix(const arrow::ArrayVector &chunks, size_t numRows, ValueTypeCode vtc) {
+    switch(vtc) {
+        case ValueTypeCode::SI8:  return parquetColumnToMatrix<int8_t>(chunks, numRows);
+        case ValueTypeCode::SI32: return parquetColumnToMatrix<int32_t>(chunks, numRows);
+        case ValueTypeCode::SI64: return parquetColumnToMatrix<int64_t>(chunks, numRows);
+        case ValueTypeCode::UI8:  return parquetColumnToMatrix<uint8_t>(chunks, numRows);
+        case ValueTypeCode::UI32: return parquetColumnToMatrix<uint32_t>(chunks, numRows);
+        case ValueTypeCode::UI64: return parquetColumnToMatrix<uint64_t>(chunks, numRows);
+        case ValueTypeCode::F32:  return parquetColumnToMatrix<float>(chunks, numRows);
+        case ValueTypeCode::F64:  return parquetColumnToMatrix<double>(chunks, numRows);
+        default: throw std::runtime_error("ReadParquet: unsupported value type");
+    }
+}
 
-    return file;
+inline std::vector<int> parquetColumnIndices(parquet::arrow::FileReader &reader, size_t numCols,
+                                             const char *filename) {
+    const auto fileNumCols = static_cast<size_t>(reader.parquet_reader()->metadata()->num_columns());
+    if(fileNumCols < numCols)
+        throw std::runtime_error("ReadParquet: file " + std::string(filename) + " has " +
+                                 std::to_string(fileNumCols) + " columns, but " + std::to_string(numCols) +
+                                 " were requested");
+    std::vector<int> colIdxs(numCols);
+    for(size_t c = 0; c < numCols; c++)
+        colIdxs[c] = static_cast<int>(c);
+    return colIdxs;
 }
 
+/**
+ * @brief Reads the first `numCols` columns of the first `numRows` rows of a
+ * Parquet file and calls `consume(rowOffset, colIdx, chunk)` for each chunk
+ * of each column.
+ *
+ * Only the requested columns are decoded. The row groups are distributed over
+ * multiple threads, each of which uses its own reader; `consume` is called
+ * concurrently for disjoint row ranges. Chunks reaching beyond `numRows` are
+ * sliced.
+ */
+template <class Consume>
+void readParquetRowGroups(const char *filename, size_t numRows, size_t numCols, Consume consume) {
+    auto reader = openParquetFile(filename);
+    const std::vector<int> colIdxs = parquetColumnIndices(*reader, numCols, filename);
+    auto metadata = reader->parquet_reader()->metadata();
+
+    // the first row of each row group
+    const int numRowGroups = reader->num_row_groups();
+    std::vector<size_t> rowGroupOffsets(numRowGroups + 1, 0);
+    for(int i = 0; i < numRowGroups; i++)
+        rowGroupOffsets[i + 1] = rowGroupOffsets[i] + static_cast<size_t>(metadata->RowGroup(i)->num_rows());
+    if(rowGroupOffsets[numRowGroups] < numRows)
+        throw std::runtime_error("ReadParquet: file " + std::string(filename) + " has only " +
+                                 std::to_string(rowGroupOffsets[numRowGroups]) + " rows, but " +
+                                 std::to_string(numRows) + " were requested");
+    int numUsedRowGroups = 0;
+    while(numUsedRowGroups < numRowGroups && rowGroupOffsets[numUsedRowGroups] < numRows)
+        numUsedRowGroups++;
+
+    const auto numThreads = static_cast<int>(
+            std::min<size_t>(numUsedRowGroups, std::max(1u, std::thread::hardware_concurrency())));
+
+    auto readRowGroups = [&](parquet::arrow::FileReader &r, int first) {
+        for(int i = first; i < numUsedRowGroups; i += numThreads) {
+            std::shared_ptr<arrow::Table> table;
+            arrow::Status st = r.ReadRowGroup(i, colIdxs, &table);
+            if(!st.ok())
+                throw std::runtime_error("ReadParquet: could not read row group " + std::to_string(i) + " of " +
+                                         std::string(filename) + ": " + st.ToString());
+            for(size_t c = 0; c < numCols; c++) {
+                size_t rowOffset = rowGroupOffsets[i];
+                for(const auto &chunk : table->column(static_cast<int>(c))->chunks()) {
+                    if(rowOffset >= numRows)
+                        break;
+                    const auto len = std::min<size_t>(chunk->length(), numRows - rowOffset);
+                    consume(rowOffset, c, len == static_cast<size_t>(chunk->length()) ? chunk : chunk->Slice(0, len));
+                    rowOffset += len;
+                }
+            }
+        }
+    };
+
+    if(numThreads <= 1) {
+        // let Arrow decode the columns in parallel instead
+        reader->set_use_threads(true);
+        readRowGroups(*reader, 0);
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    std::vector<std::exception_ptr> errors(numThreads);
+    for(int t = 0; t < numThreads; t++)
+        threads.emplace_back([&, t] {
+            try {
+                // a FileReader must not be used by multiple threads at once
+                auto threadReader = openParquetFile(filename);
+                readRowGroups(*threadReader, t);
+            }
+            catch(...) {
+                errors[t] = std::current_exception();
+            }
+        });
+    for(auto &t : threads)
+        t.join();
+    for(auto &e : errors)
+        if(e)
+            std::rethrow_exception(e);
+}
+
+// ****************************************************************************
+// (Partial) template specializations for different data/value types
+// ****************************************************************************
+
 // ----------------------------------------------------------------------------
 // Frame
 // ----------------------------------------------------------------------------
@@ -119,23 +298,50 @@ inline struct File *arrowToCsv(const char *filename){
 template <> struct ReadParquet<Frame> {
   static void apply(Frame *&res, const char *filename, size_t numRows,
                     size_t numCols, ValueTypeCode *schema) {
-    struct File *file = arrowToCsv(filename);
-    readCsvFile<Frame>(res, file, numRows, numCols, ',', schema);
-    closeFile(file);
-  }
-};
+    if(res == nullptr && tryWrap(res, filename, numRows, numCols, schema))
+        return;
 
-// ----------------------------------------------------------------------------
-// CSRMatrix
-// ----------------------------------------------------------------------------
+    if(res == nullptr)
+        res = DataObjectFactory::create<Frame>(numRows, numCols, schema, nullptr, false);
 
-template <typename VT> struct ReadParquet<CSRMatrix<VT>> {
-    static void apply(CSRMatrix<VT> *&res, const char *filename, size_t numRows,
-                      size_t numCols, ssize_t numNonZeros, bool sorted = true) {
-        struct File *file = arrowToCsv(filename);
-        readCsvFile<CSRMatrix<VT>>(res, file, numRows, numCols, ',', numNonZeros, sorted);
-        closeFile(file);
+    std::vector<uint8_t *> cols(numCols);
+    std::vector<size_t> elemSizes(numCols);
+    for(size_t c = 0; c < numCols; c++) {
+        cols[c] = reinterpret_cast<uint8_t *>(res->getColumnRaw(c));
+        elemSizes[c] = ValueTypeUtils::sizeOf(schema[c]);
     }
+    readParquetRowGroups(filename, numRows, numCols,
+        [&](size_t rowOffset, size_t c, const std::shared_ptr<arrow::Array> &chunk) {
+            copyParquetChunk(*chunk, schema[c], cols[c] + rowOffset * elemSizes[c]);
+        });
+  }
+
+private:
+  /**
+   * @brief If the file consists of a single row group, creates `res` around
+   * the Arrow buffers of all columns whose value types match the schema.
+   */
+  static bool tryWrap(Frame *&res, const char *filename, size_t numRows, size_t numCols,
+                      ValueTypeCode *schema) {
+    auto reader = openParquetFile(filename);
+    if(reader->num_row_groups() != 1 ||
+            static_cast<size_t>(reader->parquet_reader()->metadata()->num_rows()) != numRows)
+        return false;
+    const std::vector<int> colIdxs = parquetColumnIndices(*reader, numCols, filename);
+    reader->set_use_threads(true);
+    std::shared_ptr<arrow::Table> table;
+    arrow::Status st = reader->ReadRowGroup(0, colIdxs, &table);
+    if(!st.ok())
+        throw std::runtime_error("ReadParquet: could not read file " + std::string(filename) + ": " + st.ToString());
+
+    std::vector<Structure *> colMats;
+    for(size_t c = 0; c < numCols; c++)
+        colMats.push_back(parquetColumnToMatrix(table->column(static_cast<int>(c))->chunks(), numRows, schema[c]));
+    res = DataObjectFactory::create<Frame>(colMats, nullptr);
+    for(auto colMat : colMats)
+        DataObjectFactory::destroy(colMat);
+    return true;
+  }
 };
 
 // ----------------------------------------------------------------------------
@@ -145,9 +351,61 @@ template <typename VT> struct ReadParquet<CSRMatrix<VT>> {
 template <typename VT> struct ReadParquet<DenseMatrix<VT>> {
   static void apply(DenseMatrix<VT> *&res, const char *filename, size_t numRows,
                     size_t numCols) {
-        struct File *file = arrowToCsv(filename);
-        readCsvFile<DenseMatrix<VT>>(res, file, numRows, numCols, ',');
-        closeFile(file);
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
+
+        // Parquet is columnar, so each column is scattered into the rows.
+        VT *values = res->getValues();
+        const size_t rowSkip = res->getRowSkip();
+        readParquetRowGroups(filename, numRows, numCols,
+            [&](size_t rowOffset, size_t c, const std::shared_ptr<arrow::Array> &chunk) {
+                copyParquetChunk(*chunk, values + rowOffset * rowSkip + c, rowSkip);
+            });
+    }
+};
+
+// ----------------------------------------------------------------------------
+// CSRMatrix
+// ----------------------------------------------------------------------------
+
+template <typename VT> struct ReadParquet<CSRMatrix<VT>> {
+    /**
+     * @brief Reads a sparse matrix stored as (row, column) pairs of its
+     * non-zeros, i.e., in the same layout as a COO CSV file.
+     */
+    static void apply(CSRMatrix<VT> *&res, const char *filename, size_t numRows,
+                      size_t numCols, ssize_t numNonZeros, bool sorted = true) {
+        if(numNonZeros == -1)
+            throw std::runtime_error("Currently reading of sparse matrices requires a number of non zeros to be defined");
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<CSRMatrix<VT>>(numRows, numCols, numNonZeros, false);
+
+        DenseMatrix<uint64_t> *rowColPairs = nullptr;
+        ReadParquet<DenseMatrix<uint64_t>>::apply(rowColPairs, filename, static_cast<size_t>(numNonZeros), 2);
+        std::vector<std::pair<uint64_t, uint64_t>> pairs(numNonZeros);
+        for(size_t i = 0; i < pairs.size(); i++)
+            pairs[i] = {rowColPairs->get(i, 0), rowColPairs->get(i, 1)};
+        DataObjectFactory::destroy(rowColPairs);
+        if(!sorted)
+            std::sort(pairs.begin(), pairs.end());
+
+        auto *rowOffsets = res->getRowOffsets();
+        auto *colIdxs = res->getColIdxs();
+        auto *values = res->getValues();
+        std::memset(rowOffsets, 0, (numRows + 1) * sizeof(size_t));
+        for(size_t i = 0; i < pairs.size(); i++) {
+            const auto [row, col] = pairs[i];
+            if(row >= numRows || col >= numCols)
+                throw std::runtime_error("Position [" + std::to_string(row) + ", " + std::to_string(col)
+                    + "] is not part of matrix<" + std::to_string(numRows) + ", "
+                    + std::to_string(numCols) + ">");
+            rowOffsets[row + 1]++;
+            colIdxs[i] = col;
+            values[i] = 1;
+        }
+        for(size_t r = 1; r <= numRows; r++)
+            rowOffsets[r] += rowOffsets[r - 1];
     }
 };
 
@@ -27,7 +27,11 @@
 #include <runtime/local/io/utils.h>
 #include <runtime/local/io/DaphneFile.h>
 
+#include <stdexcept>
+#include <string>
+#include <algorithm>
 #include <type_traits>
+#include <vector>
 
 #include <cassert>
 #include <cstddef>
@@ -37,22 +41,156 @@
 #include <limits>
 #include <stdlib.h>
 
+// ****************************************************************************
+// Writer for the version 2 format
+// ****************************************************************************
+
+/**
+ * @brief Writes a version 2 Daphne binary file (see DaphneFile.h): the header
+ * on construction, then the blocks, and the block index and footer on
+ * `finish()`.
+ */
+class DaphneFileWriter {
+	std::ofstream f;
+	uint64_t pos = 0;
+	bool compress;
+	std::vector<DF_block_index> index;
+	std::vector<uint8_t> buf;
+	std::vector<uint8_t> encoded;
+
+	void pad() {
+		static const char zeros[DF_V2_ALIGNMENT] = {};
+		write(zeros, (DF_V2_ALIGNMENT - pos % DF_V2_ALIGNMENT) % DF_V2_ALIGNMENT);
+	}
+
+public:
+	/**
+	 * @param compress Whether to compress blocks (if that makes them smaller).
+	 */
+	DaphneFileWriter(const char *filename, DF_data_t dt, uint64_t nbrows, uint64_t nbcols, bool compress) :
+			compress(compress) {
+		f.open(filename, std::ios::out|std::ios::binary);
+		if (!f.good())
+			throw std::runtime_error(std::string("WriteDaphne: could not open file ") + filename);
+		DF_header h;
+		memset(&h, 0, sizeof(h));
+		h.version = DF_VERSION_2;
+		h.dt = dt;
+		h.nbrows = nbrows;
+		h.nbcols = nbcols;
+		write(&h, sizeof(h));
+	}
+
+	void write(const void *data, size_t n) {
+		f.write(static_cast<const char *>(data), n);
+		pos += n;
+	}
+
+	/**
+	 * @brief Writes a dense block of `nbrows` rows of `rowBytes` bytes each,
+	 * which are `rowStride` bytes apart in `data`.
+	 */
+	void writeDenseBlock(uint64_t rx, uint64_t cx, uint64_t nbrows, uint64_t nbcols, const uint8_t *data,
+			size_t rowBytes, size_t rowStride, size_t elemSize) {
+		pad();
+		DF_block_index bi;
+		memset(&bi, 0, sizeof(bi));
+		bi.rx = rx; bi.cx = cx; bi.nbrows = nbrows; bi.nbcols = nbcols;
+		bi.offset = pos;
+		bi.bt = DF_body_t::dense;
+		bi.compression = DF_compression_t::no_compression;
+		const size_t rawSize = nbrows * rowBytes;
+		if (compress) {
+			const uint8_t *src = data;
+			if (rowStride != rowBytes) {
+				buf.resize(rawSize);
+				for (size_t r = 0; r < nbrows; r++)
+					memcpy(buf.data() + r * rowBytes, data + r * rowStride, rowBytes);
+				src = buf.data();
+			}
+			dfRleEncode(src, rawSize / elemSize, elemSize, encoded);
+			if (encoded.size() < rawSize) {
+				bi.compression = DF_compression_t::rle_compression;
+				write(encoded.data(), encoded.size());
+			}
+		}
+		if (bi.compression == DF_compression_t::no_compression) {
+			if (rowStride == rowBytes)
+				write(data, rawSize);
+			else
+				for (size_t r = 0; r < nbrows; r++)
+					write(data + r * rowStride, rowBytes);
+		}
+		bi.size = pos - bi.offset;
+		index.push_back(bi);
+	}
+
+	/**
+	 * @brief Writes a sparse (CSR) block of the rows `[rx, rx + nbrows)`,
+	 * given the (absolute) row offsets of these rows.
+	 */
+	void writeSparseBlock(uint64_t rx, uint64_t nbrows, uint64_t nbcols, const size_t *rowOffsets,
+			const size_t *colIdxs, const uint8_t *values, size_t elemSize) {
+		pad();
+		DF_block_index bi;
+		memset(&bi, 0, sizeof(bi));
+		bi.rx = rx; bi.cx = 0; bi.nbrows = nbrows; bi.nbcols = nbcols;
+		bi.offset = pos;
+		bi.bt = DF_body_t::sparse;
+		bi.compression = DF_compression_t::no_compression;
+		const size_t base = rowOffsets[0];
+		bi.nnz = rowOffsets[nbrows] - base;
+		for (size_t r = 0; r <= nbrows; r++) {
+			const uint64_t off = rowOffsets[r] - base;
+			write(&off, sizeof(off));
+		}
+		for (size_t i = base; i < base + bi.nnz; i++) {
+			const uint64_t c = colIdxs[i];
+			write(&c, sizeof(c));
+		}
+		write(values + base * elemSize, bi.nnz * elemSize);
+		bi.size = pos - bi.offset;
+		index.push_back(bi);
+	}
+
+	void finish() {
+		pad();
+		DF_footer footer;
+		footer.indexOffset = pos;
+		footer.numBlocks = index.size();
+		footer.magic = DF_V2_MAGIC;
+		write(index.data(), index.size() * sizeof(DF_block_index));
+		write(&footer, sizeof(footer));
+		f.close();
+		if (f.fail())
+			throw std::runtime_error("WriteDaphne: could not write file");
+	}
+};
+
 // ****************************************************************************
 // Struct for partial template specialization
 // ****************************************************************************
 
 template <class DTArg>
 struct WriteDaphne {
-    static void apply(const DTArg *arg, const char * filename) = delete;
+    static void apply(const DTArg *arg, const char * filename, bool compress = false, size_t blockBytes = DF_V2_BLOCK_BYTES) = delete;
 };
 
 // ****************************************************************************
 // Convenience function
 // ****************************************************************************
 
+/**
+ * @brief Writes a data object to a Daphne binary file (version 2).
+ *
+ * @param compress Whether to run-length encode the dense blocks that become
+ * smaller that way (the others are stored as they are).
+ * @param blockBytes The approximate size of the blocks, which is the
+ * granularity of reading parts of the file.
+ */
 template <class DTArg>
-void writeDaphne(const DTArg *arg, const char * filename) {
-    WriteDaphne<DTArg>::apply(arg, filename);
+void writeDaphne(const DTArg *arg, const char * filename, bool compress = false, size_t blockBytes = DF_V2_BLOCK_BYTES) {
+    WriteDaphne<DTArg>::apply(arg, filename, compress, blockBytes);
 }
 
 // ****************************************************************************
@@ -65,189 +203,89 @@ void writeDaphne(const DTArg *arg, const char * filename) {
 
 template <typename VT>
 struct WriteDaphne<DenseMatrix<VT>> {
-    static void apply(const DenseMatrix<VT> *arg, const char * filename) {
-
-	std::ofstream f;
-	f.open(filename, std::ios::out|std::ios::binary);
-	// TODO: check f.good()
-
-	// write header
-	DF_header h;
-	h.version = 1;
-	h.dt = DF_data_t::DenseMatrix_t;
-	h.nbrows = (uint64_t) arg->getNumRows();
-	h.nbcols = (uint64_t) arg->getNumCols();
-	f.write((const char *)&h, sizeof(h));
+    static void apply(const DenseMatrix<VT> *arg, const char * filename, bool compress = false, size_t blockBytes = DF_V2_BLOCK_BYTES) {
+	const size_t numRows = arg->getNumRows();
+	const size_t numCols = arg->getNumCols();
+	DaphneFileWriter w(filename, DF_data_t::DenseMatrix_t, numRows, numCols, compress);
 
 	// value type
-	const ValueTypeCode vt = ValueTypeUtils::codeFor<VT>;	
-	f.write((const char *) &vt, sizeof(vt)); 
-
-	// write body
-        // single block
-	DF_body b;
-	b.rx = 0;
-	b.cx = 0;
-	f.write((const char *)&b, sizeof(b));
-
-	// block header
-	DF_body_block bb;
-	bb.nbrows = (uint32_t) arg->getNumRows();
-	bb.nbcols = (uint32_t) arg->getNumCols();
-	bb.bt = DF_body_t::dense;
-	f.write((const char *)&bb, sizeof(bb));
-
-	// value type
-	f.write((const char *) &vt, sizeof(vt)); 
-
-	// block values
-	const VT * valuesArg = arg->getValues();
-	f.write((const char *)valuesArg, arg->getNumRows() * arg->getNumCols() * sizeof(VT));
-
-	f.close();
-	return;
+	const ValueTypeCode vt = ValueTypeUtils::codeFor<VT>;
+	w.write(&vt, sizeof(vt));
+
+	// blocks of rows
+	const size_t blockRows = dfBlockRows(numCols * sizeof(VT), blockBytes);
+	const uint8_t *values = reinterpret_cast<const uint8_t *>(arg->getValues());
+	for (size_t r = 0; r < numRows; r += blockRows) {
+		const size_t n = std::min(blockRows, numRows - r);
+		w.writeDenseBlock(r, 0, n, numCols, values + r * arg->getRowSkip() * sizeof(VT),
+				numCols * sizeof(VT), arg->getRowSkip() * sizeof(VT), sizeof(VT));
+	}
+	w.finish();
    }
 };
-  
-template <typename VT>
-struct WriteDaphne<CSRMatrix<VT>> {
-    static void apply(const CSRMatrix<VT> *arg, const char * filename) {
-
-	std::ofstream f;
-	f.open(filename, std::ios::out|std::ios::binary);
-	// TODO: check f.good()
 
-	// write header
-	DF_header h;
-	h.version = 1;
-	h.dt = DF_data_t::CSRMatrix_t;
-	h.nbrows = (uint64_t) arg->getNumRows();
-	h.nbcols = (uint64_t) arg->getNumCols();
-	f.write((const char *)&h, sizeof(h));
+// ----------------------------------------------------------------------------
+// CSRMatrix
+// ----------------------------------------------------------------------------
 
-	// value type
-	const ValueTypeCode vt = ValueTypeUtils::codeFor<VT>;	
-	f.write((const char *) &vt, sizeof(vt)); 
-
-	// write body
-        // single block
-	DF_body b;
-	b.rx = 0;
-	b.cx = 0;
-	f.write((const char *)&b, sizeof(b));
-
-	// block header
-	DF_body_block bb;
-	bb.nbrows = (uint32_t) arg->getNumRows();
-	bb.nbcols = (uint32_t) arg->getNumCols();
-	bb.bt = DF_body_t::sparse;
-	f.write((const char *)&bb, sizeof(bb));
+template <typename VT>
+struct WriteDaphne<CSRMatrix<VT>> {
+    static void apply(const CSRMatrix<VT> *arg, const char * filename, bool compress = false, size_t blockBytes = DF_V2_BLOCK_BYTES) {
+	const size_t numRows = arg->getNumRows();
+	const size_t numCols = arg->getNumCols();
+	DaphneFileWriter w(filename, DF_data_t::CSRMatrix_t, numRows, numCols, compress);
 
 	// value type
-	f.write((const char *) &vt, sizeof(vt));
-
-	// nzb value
-        const size_t nzb = arg->getNumNonZeros();
-	f.write((const char *) &nzb, sizeof(nzb) );
-
-	// CSR values
-	for (size_t i = 0; i < arg->getNumRows(); i++) {
-		// nzv for row i
-		const size_t nzb_i = arg->getNumNonZeros(i);
-	        f.write((const char *) &nzb_i, sizeof(nzb_i));
-
-		// values for row i
-		const VT * vals= arg->getValues(i);
-		const size_t * colIdxs= arg->getColIdxs(i);
-
-		for (size_t j=0; j < nzb_i; j++) {
-			f.write((const char *) &colIdxs[j], sizeof(colIdxs[j]));
-			f.write((const char *) &(vals[j]), sizeof(VT));
-		}
+	const ValueTypeCode vt = ValueTypeUtils::codeFor<VT>;
+	w.write(&vt, sizeof(vt));
+
+	// blocks of rows with a bounded number of non-zeros
+	const size_t * rowOffsets = arg->getRowOffsets();
+	const size_t maxBlockNnz = std::max<size_t>(1, blockBytes / (sizeof(uint64_t) + sizeof(VT)));
+	for (size_t r = 0; r < numRows; ) {
+		size_t end = r + 1;
+		while (end < numRows && rowOffsets[end + 1] - rowOffsets[r] <= maxBlockNnz)
+			end++;
+		w.writeSparseBlock(r, end - r, numCols, rowOffsets + r, arg->getColIdxs(),
+				reinterpret_cast<const uint8_t *>(arg->getValues()), sizeof(VT));
+		r = end;
 	}
-
-	f.close();
-	return;
+	w.finish();
    }
 };
-  
-template <>
-struct WriteDaphne<Frame> {
-    static void apply(const Frame *arg, const char * filename) {
 
-	std::ofstream f;
-	f.open(filename, std::ios::out|std::ios::binary);
-	// TODO: check f.good()
+// ----------------------------------------------------------------------------
+// Frame
+// ----------------------------------------------------------------------------
 
-	// write header
-	DF_header h;
-	h.version = 1;
-	h.dt = DF_data_t::Frame_t;
-	h.nbrows = (uint64_t) arg->getNumRows();
-	h.nbcols = (uint64_t) arg->getNumCols();
-	f.write((const char *)&h, sizeof(h));
+template <>
+struct WriteDaphne<Frame> {
+    static void apply(const Frame *arg, const char * filename, bool compress = false, size_t blockBytes = DF_V2_BLOCK_BYTES) {
+	const size_t numRows = arg->getNumRows();
+	const size_t numCols = arg->getNumCols();
+	DaphneFileWriter w(filename, DF_data_t::Frame_t, numRows, numCols, compress);
 
 	const ValueTypeCode * schema = arg->getSchema();
 	const std::string *labels = arg->getLabels();
-
-	for (uint64_t c = 0; c < h.nbcols; c++) {
-		f.write((const char *)&(schema[c]), sizeof(ValueTypeCode));
+	for (size_t c = 0; c < numCols; c++)
+		w.write(&(schema[c]), sizeof(ValueTypeCode));
+	for (size_t c = 0; c < numCols; c++) {
+		const uint16_t len = labels[c].length();
+		w.write(&len, sizeof(len));
+		w.write(labels[c].data(), len);
 	}
 
-	for (uint64_t c = 0; c < h.nbcols; c++) {
-		uint16_t len = (labels[c]).length();
-		f.write((const char *) &len, sizeof(len));
-		f.write((const char *) &(labels[c]), len);
-	}
-
-	DF_body b;
-	b.rx = 0; b.cx = 0;
-	f.write((char *)&b, sizeof(b));
-	//TODO: consider multiple blocks
-	// Assuming a dense block representation
-	// TODO: Consider alternative representations for frames
-
-	void* vals[h.nbcols];
-	for (size_t c = 0; c < h.nbcols; c++) {
-		vals[c] = const_cast<void*>(arg->getColumnRaw(c));
-	}
-
-	for (size_t r=0; r < h.nbrows; r++) {
-		for (size_t c=0; c < h.nbcols; c++) { 
-			switch (schema[c]) {
-				case ValueTypeCode::SI8:
-					f.write((char *)&(reinterpret_cast<int8_t *>(vals[c])[r]), sizeof(int8_t));
-					break;
-				case ValueTypeCode::SI32:
-					f.write((char *)&(reinterpret_cast<int32_t *>(vals[c])[r]), sizeof(int32_t));
-						break;
-				case ValueTypeCode::SI64:
-					f.write((char *)&(reinterpret_cast<int64_t *>(vals[c])[r]), sizeof(int64_t));
-					break;
-				case ValueTypeCode::UI8:
-					f.write((char *)&(reinterpret_cast<uint8_t *>(vals[c])[r]), sizeof(uint8_t));
-					break;
-				case ValueTypeCode::UI32:
-					f.write((char *)&(reinterpret_cast<uint32_t *>(vals[c])[r]), sizeof(uint32_t));
-					break;
-				case ValueTypeCode::UI64:
-					f.write((char *)&(reinterpret_cast<uint64_t *>(vals[c])[r]), sizeof(uint64_t));
-					break;
-				case ValueTypeCode::F32:
-					f.write((char *)&(reinterpret_cast<float *>(vals[c])[r]), sizeof(float));
-					break;
-				case ValueTypeCode::F64:
-					f.write((char *)&(reinterpret_cast<double *>(vals[c])[r]), sizeof(double));
-					break;
-				default:
-					throw std::runtime_error("WriteDaphne::apply: unknown value type code");
-			}
+	// each column in blocks of rows
+	for (size_t c = 0; c < numCols; c++) {
+		const size_t elemSize = ValueTypeUtils::sizeOf(schema[c]);
+		const size_t blockRows = dfBlockRows(elemSize, blockBytes);
+		const uint8_t *values = reinterpret_cast<const uint8_t *>(arg->getColumnRaw(c));
+		for (size_t r = 0; r < numRows; r += blockRows) {
+			const size_t n = std::min(blockRows, numRows - r);
+			w.writeDenseBlock(r, c, n, 1, values + r * elemSize, elemSize, elemSize, elemSize);
 		}
-
 	}
-
-	f.close();
-	return;
+	w.finish();
     }
 };
 
@@ -21,8 +21,10 @@
 #include <limits>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 
 #include <cstdint>
+#include <cstdlib>
 
 // Conversion of std::string.
 
@@ -76,5 +78,49 @@ inline void convertCstr(const char * x, uint8_t *v) { *v = atoi(x); }
 inline void convertCstr(const char * x, uint32_t *v) { *v = atoi(x); }
 inline void convertCstr(const char * x, uint64_t *v) { *v = atoi(x); }
 
+// Conversion of a non-empty field of a CSV line, which is not necessarily
+// terminated by a null character. Returns a pointer to the first character
+// after the parsed number.
+
+inline const char * convertCsvField(const char * x, double *v) {
+  char * end;
+  *v = strtod(x, &end);
+  if(x == end)
+    *v = std::numeric_limits<double>::quiet_NaN();
+  return end;
+}
+inline const char * convertCsvField(const char * x, float *v) {
+  char * end;
+  *v = strtof(x, &end);
+  if(x == end)
+    *v = std::numeric_limits<float>::quiet_NaN();
+  return end;
+}
+template<typename VT>
+inline const char * convertCsvFieldInt(const char * x, VT *v) {
+  char * end;
+  if constexpr(std::is_same_v<VT, uint64_t>)
+    *v = strtoull(x, &end, 10);
+  else
+    *v = static_cast<VT>(strtoll(x, &end, 10));
+  return end;
+}
+inline const char * convertCsvField(const char * x, int8_t *v) { return convertCsvFieldInt(x, v); }
+inline const char * convertCsvField(const char * x, int32_t *v) { return convertCsvFieldInt(x, v); }
+inline const char * convertCsvField(const char * x, int64_t *v) { return convertCsvFieldInt(x, v); }
+inline const char * convertCsvField(const char * x, uint8_t *v) { return convertCsvFieldInt(x, v); }
+inline const char * convertCsvField(const char * x, uint32_t *v) { return convertCsvFieldInt(x, v); }
+inline const char * convertCsvField(const char * x, uint64_t *v) { return convertCsvFieldInt(x, v); }
+
+// The value of an empty field of a CSV line.
+
+template<typename VT>
+inline VT emptyCsvField() {
+  if constexpr(std::is_floating_point_v<VT>)
+    return std::numeric_limits<VT>::quiet_NaN();
+  else
+    return 0;
+}
+
 #endif // SRC_RUNTIME_LOCAL_IO_UTILS_H
 
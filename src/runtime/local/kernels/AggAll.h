@@ -52,35 +52,73 @@ typename DT::VT aggAll(AggOpCode opCode, const DT * arg, DCTX(ctx)) {
 // scalar <- DenseMatrix
 // ----------------------------------------------------------------------------
 
+/**
+ * @brief Aggregates `n` contiguous values into `agg` using the given binary
+ * operation.
+ * 
+ * Uses several independent partial aggregates, such that the compiler can
+ * vectorize the loop. Note that this changes the order in which the values
+ * are combined, which may affect the rounding of floating-point sums.
+ */
+template<BinaryOpCode opCode, typename VT>
+DAPHNE_ALWAYS_INLINE VT aggDenseArray(const VT * values, size_t n, VT agg, DCTX(ctx)) {
+    constexpr size_t numPartials = 16;
+    size_t i = 0;
+    if(n >= numPartials) {
+        VT partials[numPartials];
+        for(size_t k = 0; k < numPartials; k++)
+            partials[k] = values[k];
+        for(i = numPartials; i + numPartials <= n; i += numPartials)
+            for(size_t k = 0; k < numPartials; k++)
+                partials[k] = EwBinarySca<opCode, VT, VT, VT>::apply(partials[k], values[i + k], ctx);
+        for(size_t k = 0; k < numPartials; k++)
+            agg = EwBinarySca<opCode, VT, VT, VT>::apply(agg, partials[k], ctx);
+    }
+    for(; i < n; i++)
+        agg = EwBinarySca<opCode, VT, VT, VT>::apply(agg, values[i], ctx);
+    return agg;
+}
+
 template<typename VT>
 struct AggAll<DenseMatrix<VT>> {
+    // The aggregation of all cells for a particular binary operation.
+    template<BinaryOpCode opCode>
+    struct Loop {
+        DAPHNE_ALWAYS_INLINE static VT run(const VT * valuesArg, size_t numRows, size_t numCols, size_t rowSkip,
+                VT agg, DCTX(ctx)) {
+            if(rowSkip == numCols)
+                return aggDenseArray<opCode>(valuesArg, numRows * numCols, agg, ctx);
+            for(size_t r = 0; r < numRows; r++) {
+                agg = aggDenseArray<opCode>(valuesArg, numCols, agg, ctx);
+                valuesArg += rowSkip;
+            }
+            return agg;
+        }
+    };
+
     static VT apply(AggOpCode opCode, const DenseMatrix<VT> * arg, DCTX(ctx)) {
         const size_t numRows = arg->getNumRows();
         const size_t numCols = arg->getNumCols();
         
         const VT * valuesArg = arg->getValues();
 
-        EwBinaryScaFuncPtr<VT, VT, VT> func;
+        BinaryOpCode binaryOpCode;
         VT agg;
         if (AggOpCodeUtils::isPureBinaryReduction(opCode)) {
-            func = getEwBinaryScaFuncPtr<VT, VT, VT>(AggOpCodeUtils::getBinaryOpCode(opCode));
+            binaryOpCode = AggOpCodeUtils::getBinaryOpCode(opCode);
             agg = AggOpCodeUtils::template getNeutral<VT>(opCode);
         }
         else {
-            // TODO Setting the function pointer yields the correct result.
+            // TODO Setting the op code yields the correct result.
             // However, since MEAN and STDDEV are not sparse-safe, the program
             // does not take the same path for doing the summation, and is less
             // efficient.
             // for MEAN and STDDDEV, we need to sum
-            func = getEwBinaryScaFuncPtr<VT, VT, VT>(AggOpCodeUtils::getBinaryOpCode(AggOpCode::SUM));
+            binaryOpCode = AggOpCodeUtils::getBinaryOpCode(AggOpCode::SUM);
             agg = VT(0);
         }
 
-        for(size_t r = 0; r < numRows; r++) {
-            for(size_t c = 0; c < numCols; c++)
-                agg = func(agg, valuesArg[c], ctx);
-            valuesArg += arg->getRowSkip();
-        }
+        agg = dispatchBinaryOpCode<Loop>(binaryOpCode, valuesArg, numRows, numCols, arg->getRowSkip(), agg, ctx);
         if (AggOpCodeUtils::isPureBinaryReduction(opCode))
             return agg;
 
@@ -57,6 +57,20 @@ void aggCol(AggOpCode opCode, DTRes *& res, const DTArg * arg, DCTX(ctx)) {
 
 template<typename VT>
 struct AggCol<DenseMatrix<VT>, DenseMatrix<VT>> {
+    // The aggregation of each column for a particular binary operation, the
+    // first row is already in valuesRes.
+    template<BinaryOpCode opCode>
+    struct Loop {
+        DAPHNE_ALWAYS_INLINE static void run(VT * valuesRes, const VT * valuesArg, size_t numRows, size_t numCols,
+                size_t rowSkipArg, DCTX(ctx)) {
+            for(size_t r = 1; r < numRows; r++) {
+                valuesArg += rowSkipArg;
+                for(size_t c = 0; c < numCols; c++)
+                    valuesRes[c] = EwBinarySca<opCode, VT, VT, VT>::apply(valuesRes[c], valuesArg[c], ctx);
+            }
+        }
+    };
+
     static void apply(AggOpCode opCode, DenseMatrix<VT> *& res, const DenseMatrix<VT> * arg, DCTX(ctx)) {
         const size_t numRows = arg->getNumRows();
         const size_t numCols = arg->getNumCols();
@@ -67,24 +81,20 @@ struct AggCol<DenseMatrix<VT>, DenseMatrix<VT>> {
         const VT * valuesArg = arg->getValues();
         VT * valuesRes = res->getValues();
         
-        EwBinaryScaFuncPtr<VT, VT, VT> func;
+        BinaryOpCode binaryOpCode;
         if(AggOpCodeUtils::isPureBinaryReduction(opCode))
-            func = getEwBinaryScaFuncPtr<VT, VT, VT>(AggOpCodeUtils::getBinaryOpCode(opCode));
+            binaryOpCode = AggOpCodeUtils::getBinaryOpCode(opCode);
         else
-            // TODO Setting the function pointer yields the correct result.
+            // TODO Setting the op code yields the correct result.
             // However, since MEAN and STDDEV are not sparse-safe, the program
             // does not take the same path for doing the summation, and is less
             // efficient.
             // for MEAN and STDDDEV, we need to sum
-            func = getEwBinaryScaFuncPtr<VT, VT, VT>(AggOpCodeUtils::getBinaryOpCode(AggOpCode::SUM));
+            binaryOpCode = AggOpCodeUtils::getBinaryOpCode(AggOpCode::SUM);
 
         memcpy(valuesRes, valuesArg, numCols * sizeof(VT));
         
-        for(size_t r = 1; r < numRows; r++) {
-            valuesArg += arg->getRowSkip();
-            for(size_t c = 0; c < numCols; c++)
-                valuesRes[c] = func(valuesRes[c], valuesArg[c], ctx);
-        }
+        dispatchBinaryOpCode<Loop>(binaryOpCode, valuesRes, valuesArg, numRows, numCols, arg->getRowSkip(), ctx);
         
         if(AggOpCodeUtils::isPureBinaryReduction(opCode))
             return;
@@ -56,6 +56,19 @@ void aggRow(AggOpCode opCode, DTRes *& res, const DTArg * arg, DCTX(ctx)) {
 
 template<typename VT>
 struct AggRow<DenseMatrix<VT>, DenseMatrix<VT>> {
+    // The aggregation of each row for a particular binary operation.
+    template<BinaryOpCode opCode>
+    struct Loop {
+        DAPHNE_ALWAYS_INLINE static void run(VT * valuesRes, const VT * valuesArg, size_t numRows, size_t numCols,
+                size_t rowSkipRes, size_t rowSkipArg, DCTX(ctx)) {
+            for(size_t r = 0; r < numRows; r++) {
+                *valuesRes = aggDenseArray<opCode>(valuesArg + 1, numCols > 1 ? numCols - 1 : 0, *valuesArg, ctx);
+                valuesArg += rowSkipArg;
+                valuesRes += rowSkipRes;
+            }
+        }
+    };
+
     static void apply(AggOpCode opCode, DenseMatrix<VT> *& res, const DenseMatrix<VT> * arg, DCTX(ctx)) {
         const size_t numRows = arg->getNumRows();
         const size_t numCols = arg->getNumCols();
@@ -95,25 +108,19 @@ struct AggRow<DenseMatrix<VT>, DenseMatrix<VT>> {
             }
         }
         else {
-            EwBinaryScaFuncPtr<VT, VT, VT> func;    
+            BinaryOpCode binaryOpCode;
             if(AggOpCodeUtils::isPureBinaryReduction(opCode))
-                func = getEwBinaryScaFuncPtr<VT, VT, VT>(AggOpCodeUtils::getBinaryOpCode(opCode));
+                binaryOpCode = AggOpCodeUtils::getBinaryOpCode(opCode);
             else
-                // TODO Setting the function pointer yields the correct result.
+                // TODO Setting the op code yields the correct result.
                 // However, since MEAN and STDDEV are not sparse-safe, the program
                 // does not take the same path for doing the summation, and is less
                 // efficient.
                 // for MEAN and STDDDEV, we need to sum
-                func = getEwBinaryScaFuncPtr<VT, VT, VT>(AggOpCodeUtils::getBinaryOpCode(AggOpCode::SUM));
+                binaryOpCode = AggOpCodeUtils::getBinaryOpCode(AggOpCode::SUM);
 
-            for(size_t r = 0; r < numRows; r++) {
-                VT agg = *valuesArg;
-                for(size_t c = 1; c < numCols; c++)
-                    agg = func(agg, valuesArg[c], ctx);
-                *valuesRes = agg;
-                valuesArg += arg->getRowSkip();
-                valuesRes += res->getRowSkip();
-            }
+            dispatchBinaryOpCode<Loop>(binaryOpCode, valuesRes, valuesArg, numRows, numCols,
+                    res->getRowSkip(), arg->getRowSkip(), ctx);
 
             if(AggOpCodeUtils::isPureBinaryReduction(opCode))
                 return;
@@ -20,6 +20,7 @@
 #include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/DistributedDataManager.h>
 #include <runtime/local/datastructures/Handle.h>
 
 #include <runtime/distributed/proto/worker.pb.h>
@@ -58,18 +59,13 @@ struct Broadcast<DenseMatrix<double>>
 {
     static void apply(Handle<DenseMatrix<double>> *&res, const DenseMatrix<double> *mat, DCTX(ctx))
     {
-        auto envVar = std::getenv("DISTRIBUTED_WORKERS");
-        assert(envVar && "Environment variable has to be set");
-        std::string workersStr(envVar);
-        std::string delimiter(",");
-
-        size_t pos;
-        std::vector<std::string> workers;
-        while ((pos = workersStr.find(delimiter)) != std::string::npos) {
-            workers.push_back(workersStr.substr(0, pos));
-            workersStr.erase(0, pos + delimiter.size());
+        // The matrix may still be on the workers from a previous operation.
+        auto &manager = DistributedDataManager::instance();
+        if (auto placement = manager.lookup(mat, DistributedDataManager::Kind::BROADCAST)) {
+            res = new Handle<DenseMatrix<double>>(placement, mat->getNumRows(), mat->getNumCols());
+            return;
         }
-        workers.push_back(workersStr);
+        auto workers = manager.getWorkers();
 
         // auto blockSize = DistributedData::BLOCK_SIZE;
 
@@ -105,7 +101,9 @@ struct Broadcast<DenseMatrix<double>>
             DistributedData data(storedData, workerAddr, channel);
             map.insert({*ix, data});
         }
-        res = new Handle<DenseMatrix<double>>(map, mat->getNumRows(), mat->getNumCols());
+        auto placement = std::make_shared<DistributedPlacement>(map);
+        manager.remember(mat, DistributedDataManager::Kind::BROADCAST, placement);
+        res = new Handle<DenseMatrix<double>>(placement, mat->getNumRows(), mat->getNumCols());
     }
 };
 
@@ -21,6 +21,7 @@
 
 #include <api/cli/DaphneUserConfig.h>
 #include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/BufferPool.h>
 
 #include <cstdint>
 
@@ -31,6 +32,9 @@
 void createDaphneContext(DaphneContext *& res, uint64_t configPtr) {
     auto config = reinterpret_cast<DaphneUserConfig *>(configPtr);
     res = new DaphneContext(*config);
+    // The buffers of the data objects created by the kernels come from the
+    // pool of the kernels library.
+    BufferPool::instance().configure(config->buffer_pool_size << 20, config->use_huge_pages);
 }
 
 #endif //SRC_RUNTIME_LOCAL_KERNELS_CREATEDAPHNECONTEXT_H
\ No newline at end of file
@@ -20,12 +20,18 @@
 #include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/DistributedDataManager.h>
 #include <runtime/local/datastructures/Handle.h>
 
 #include <runtime/distributed/proto/worker.pb.h>
 #include <runtime/distributed/proto/worker.grpc.pb.h>
 #include <runtime/distributed/worker/ProtoDataConverter.h>
 #include <runtime/local/kernels/DistributedCaller.h>
+#include <util/ParallelFor.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 #include <cassert>
 #include <cstddef>
@@ -59,65 +65,80 @@ struct Distribute<DenseMatrix<double>>
 {
     static void apply(Handle<DenseMatrix<double>> *&res, const DenseMatrix<double> *mat, DCTX(ctx))
     {
-        auto envVar = std::getenv("DISTRIBUTED_WORKERS");
-        assert(envVar && "Environment variable has to be set");
-        std::string workersStr(envVar);
-        std::string delimiter(",");
-
-        size_t pos;
-        std::vector<std::string> workers;
-        while ((pos = workersStr.find(delimiter)) != std::string::npos) {
-            workers.push_back(workersStr.substr(0, pos));
-            workersStr.erase(0, pos + delimiter.size());
+        // The matrix may still be on the workers from a previous operation.
+        auto &manager = DistributedDataManager::instance();
+        if (auto placement = manager.lookup(mat, DistributedDataManager::Kind::DISTRIBUTED)) {
+            res = new Handle<DenseMatrix<double>>(placement, mat->getNumRows(), mat->getNumCols());
+            return;
         }
-        workers.push_back(workersStr);
+        auto workers = manager.getWorkers();
 
         // auto blockSize = DistributedData::BLOCK_SIZE;
 
-        struct StoredInfo {
-            DistributedIndex *ix ;
+        struct Partition {
+            DistributedIndex ix;
             std::string workerAddr;
             std::shared_ptr<grpc::Channel> channel;
-        };        
-        DistributedCaller<StoredInfo, distributed::Matrix, distributed::StoredData> caller;
+            size_t rowBegin;
+            size_t rowEnd;
+            distributed::StoredData storedData;
+        };
+        // Only used for creating the channels.
+        DistributedCaller<void *, distributed::Matrix, distributed::StoredData> caller;
 
         Handle<DenseMatrix<double>>::HandleMap map;
 
+        std::vector<Partition> partitions;
         auto r = 0ul;
         for (auto workerIx = 0ul; workerIx < workers.size() && r < mat->getNumRows(); workerIx++) {            
             auto workerAddr = workers.at(workerIx);          
 
-            distributed::Matrix protoMat;
-
             auto k = mat->getNumRows() / workers.size();
             auto m = mat->getNumRows() % workers.size();
-            ProtoDataConverter::convertToProto(mat,
-                &protoMat,
+            partitions.push_back({DistributedIndex(workerIx, 0),
+                workerAddr,
+                caller.GetOrCreateChannel(workerAddr),
                 (workerIx * k) + std::min(workerIx, m),
                 (workerIx + 1) * k + std::min(workerIx + 1, m),
-                0,
-                mat->getNumCols());
-                        
-            auto channel = caller.GetOrCreateChannel(workerAddr);
-            StoredInfo storedInfo ({new DistributedIndex(workerIx, 0), workerAddr, channel});
-            caller.asyncStoreCall(workerAddr, storedInfo, protoMat);
+                {}});
             
             // keep track of proccessed rows
             r = (workerIx + 1) * k + std::min(workerIx + 1, m);
         }
-        // get results
-        while (!caller.isQueueEmpty()){
-            auto response = caller.getNextResult();
-            auto ix = response.storedInfo.ix;
-            auto workerAddr = response.storedInfo.workerAddr;
-            auto channel = response.storedInfo.channel;
-
-            auto storedData = response.result;
-
-            DistributedData data(storedData, workerAddr, channel);
-            map.insert({*ix, data});
+        // Stream the partitions to all workers at once, in chunks copied
+        // directly from the matrix, such that partitions may be larger than
+        // the maximum message size.
+        parallelFor(partitions.size(), partitions.size(), [&](size_t i) {
+            auto &part = partitions[i];
+            auto stub = distributed::Worker::NewStub(part.channel);
+            grpc::ClientContext context;
+            auto writer = stub->StoreStream(&context, &part.storedData);
+            distributed::MatrixChunk chunk;
+            size_t cell = 0;
+            do {
+                cell = ProtoDataConverter::convertToChunk(mat,
+                    &chunk,
+                    part.rowBegin,
+                    part.rowEnd,
+                    0,
+                    mat->getNumCols(),
+                    cell);
+                // if a write fails, Finish() tells why
+                if (!writer->Write(chunk))
+                    break;
+            } while (cell < chunk.num_rows() * chunk.num_cols());
+            writer->WritesDone();
+            auto status = writer->Finish();
+            if (!status.ok())
+                throw std::runtime_error("Distribute: " + status.error_message());
+        });
+        for (auto &part : partitions) {
+            DistributedData data(part.storedData, part.workerAddr, part.channel);
+            map.insert({part.ix, data});
         }
-        res = new Handle<DenseMatrix<double>>(map, mat->getNumRows(), mat->getNumCols());
+        auto placement = std::make_shared<DistributedPlacement>(map);
+        manager.remember(mat, DistributedDataManager::Kind::DISTRIBUTED, placement);
+        res = new Handle<DenseMatrix<double>>(placement, mat->getNumRows(), mat->getNumCols());
     }
 };
 
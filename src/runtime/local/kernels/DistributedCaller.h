@@ -47,6 +47,8 @@ private:
         StoredInfo storedInfo;
         // Contains the actual result of the call
         ReturnType result;
+        // The status the worker responded with
+        grpc::Status status;
     };
     struct AsyncClientCall
     {
@@ -198,13 +200,13 @@ public:
         bool ok = false;
         cq_.Next(&got_tag, &ok);
         callCounter--;
-        AsyncClientCall *call = static_cast<AsyncClientCall*>(got_tag);
+        std::unique_ptr<AsyncClientCall> call(static_cast<AsyncClientCall*>(got_tag));
         if (!ok){
             throw std::runtime_error(
                 call->status.error_message()
             );
         }                
-        return ResultData({call->storedInfo, call->result});
+        return ResultData({call->storedInfo, call->result, call->status});
     };
 
     /**
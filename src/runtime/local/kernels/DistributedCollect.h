@@ -20,12 +20,19 @@
 #include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/DistributedDataManager.h>
 #include <runtime/local/datastructures/Handle.h>
 
 #include <runtime/distributed/proto/worker.pb.h>
 #include <runtime/distributed/proto/worker.grpc.pb.h>
 
 #include <runtime/distributed/worker/ProtoDataConverter.h>
+#include <util/ParallelFor.h>
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <cassert>
 #include <cstddef>
@@ -59,48 +66,63 @@ struct DistributedCollect<DenseMatrix<double>>
 {
     static void apply(DenseMatrix<double> *&res, const Handle<DenseMatrix<double>> *handle, DCTX(ctx))
     {
-        struct StoredInfo{
-            DistributedIndex *ix;
-        };
-        DistributedCaller<StoredInfo, distributed::StoredData, distributed::Matrix> caller;
-
         // auto blockSize = DistributedData::BLOCK_SIZE;
         res = DataObjectFactory::create<DenseMatrix<double>>(handle->getRows(), handle->getCols(), false);
-        for (auto &pair : handle->getMap()) {
-            auto ix = pair.first;
-            auto data = pair.second;
 
-            StoredInfo storedInfo({new DistributedIndex(ix)});
-
-            caller.asyncTransferCall(data.getChannel(), storedInfo, data.getData());
-        }
         // Get num workers
-        auto envVar = std::getenv("DISTRIBUTED_WORKERS");
-        assert(envVar && "Environment variable has to be set");
-        std::string workersStr(envVar);
-        std::string delimiter(",");
-
-        size_t pos;
-        auto workersSize = 0;
-        while ((pos = workersStr.find(delimiter)) != std::string::npos) {
-            workersSize++;
-            workersStr.erase(0, pos + delimiter.size());
-        }
-        workersSize++;
-        // Get Results
+        auto &manager = DistributedDataManager::instance();
+        const size_t workersSize = manager.getWorkers().size();
         auto k = res->getNumRows() / workersSize;
-        auto m = res->getNumRows() % workersSize;        
-        while (!caller.isQueueEmpty()){
-            auto response = caller.getNextResult();
-            auto ix = response.storedInfo.ix;
-            auto matProto = response.result;
-            ProtoDataConverter::convertFromProto(matProto,
-                res,
-                ix->getRow() * k + std::min(ix->getRow(), m),
-                (ix->getRow() + 1) * k + std::min((ix->getRow() + 1), m),
-                0,
-                res->getNumCols());
-        }      
+        auto m = res->getNumRows() % workersSize;
+
+        // Stream the partitions from all workers at once, copying each chunk
+        // directly into the result as soon as it arrives.
+        auto map = handle->getMap();
+        std::vector<std::pair<DistributedIndex, DistributedData>> partitions(map.begin(), map.end());
+        // The partitions have distinct indices, so they cover all rows if
+        // their rows add up to the rows of the result.
+        size_t numRowsCovered = 0;
+        for (auto &part : partitions) {
+            const size_t row = part.first.getRow();
+            if (row >= workersSize || part.first.getCol() != 0)
+                throw std::runtime_error("DistributedCollect: unexpected partition");
+            numRowsCovered += k + (row < m);
+        }
+        if (numRowsCovered != res->getNumRows())
+            throw std::runtime_error("DistributedCollect: the partitions do not cover the matrix");
+        parallelFor(partitions.size(), partitions.size(), [&](size_t i) {
+            auto ix = partitions[i].first;
+            auto &data = partitions[i].second;
+            auto stub = distributed::Worker::NewStub(data.getChannel());
+            grpc::ClientContext context;
+            auto reader = stub->TransferStream(&context, data.getData());
+            const size_t rowBegin = ix.getRow() * k + std::min(ix.getRow(), m);
+            const size_t numCells = (k + (ix.getRow() < m)) * res->getNumCols();
+            size_t numCellsReceived = 0;
+            distributed::MatrixChunk chunk;
+            try {
+                while (reader->Read(&chunk)) {
+                    if (chunk.first_cell() != numCellsReceived || chunk.num_rows() * chunk.num_cols() != numCells)
+                        throw std::runtime_error("DistributedCollect: unexpected chunk");
+                    ProtoDataConverter::convertFromChunk(chunk, res, rowBegin, 0);
+                    numCellsReceived += chunk.cells().size() / sizeof(double);
+                }
+            }
+            catch (...) {
+                context.TryCancel();
+                reader->Finish();
+                throw;
+            }
+            auto status = reader->Finish();
+            if (!status.ok())
+                throw std::runtime_error("DistributedCollect: " + status.error_message());
+            if (numCellsReceived != numCells)
+                throw std::runtime_error("DistributedCollect: received " + std::to_string(numCellsReceived)
+                    + " of " + std::to_string(numCells) + " cells of a partition");
+        });
+        // The rows of the result are partitioned like Distribute would do,
+        // so distributing it again can reuse the partitions.
+        manager.remember(res, DistributedDataManager::Kind::DISTRIBUTED, handle->getPlacement());
     }
 };
 
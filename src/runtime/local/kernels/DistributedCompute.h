@@ -25,10 +25,64 @@
 #include <runtime/distributed/proto/worker.pb.h>
 #include <runtime/distributed/proto/worker.grpc.pb.h>
 
+#include <runtime/distributed/worker/FunctionCache.h>
 #include <runtime/distributed/worker/ProtoDataConverter.h>
 
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
+
+// ****************************************************************************
+// Functions known to the workers
+// ****************************************************************************
+
+/**
+ * @brief Remembers which functions have been sent to which worker, such that
+ * only their hash needs to be sent from then on.
+ *
+ * The workers cache only a bounded number of compiled functions, so a worker
+ * may have evicted a function it was sent before. It responds with
+ * `NOT_FOUND` then, upon which the task is sent again with the code.
+ */
+class DistributedFunctionRegistry
+{
+    std::mutex mtx;
+    std::map<std::string, std::unordered_set<uint64_t>> sentFunctions;
+
+public:
+    static DistributedFunctionRegistry &instance()
+    {
+        static DistributedFunctionRegistry registry;
+        return registry;
+    }
+
+    /**
+     * @brief Sets the function of a task to be sent to the given worker.
+     */
+    void setFunction(distributed::Task &task, const std::string &workerAddr, const char *mlirCode, uint64_t hash)
+    {
+        task.set_mlir_hash(hash);
+        std::lock_guard<std::mutex> lock(mtx);
+        if (sentFunctions[workerAddr].insert(hash).second)
+            task.set_mlir_code(mlirCode);
+        else
+            task.clear_mlir_code();
+    }
+
+    /**
+     * @brief Records that the given worker does not hold the function anymore.
+     */
+    void forget(const std::string &workerAddr, uint64_t hash)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        sentFunctions[workerAddr].erase(hash);
+    }
+};
 
 // ****************************************************************************
 // Struct for partial template specialization
@@ -67,7 +121,11 @@ struct DistributedCompute<DTRes, Structure>
         struct StoredInfo {
             DistributedIndex *ix;
             DistributedData *data;
+            // kept for sending the task again if the worker lacks the function
+            distributed::Task task;
         };
+        auto &functions = DistributedFunctionRegistry::instance();
+        const uint64_t hash = hashMlirCode(mlirCode);
         DistributedCaller<StoredInfo, distributed::Task, distributed::ComputeResult> caller;
         typename Handle<DTRes>::HandleMap resMap;        
         size_t resultRows{};
@@ -85,9 +143,9 @@ struct DistributedCompute<DTRes, Structure>
                 auto argData = pair.second;
                 distributed::Task task;
                 *task.add_inputs()->mutable_stored() = argData.getData();
-                task.set_mlir_code(mlirCode);
+                functions.setFunction(task, argData.getAddress(), mlirCode, hash);
                 
-                StoredInfo storedInfo ({new DistributedIndex(ix), new DistributedData(argData)});
+                StoredInfo storedInfo ({new DistributedIndex(ix), new DistributedData(argData), task});
 
                 caller.asyncComputeCall(argData.getChannel(), storedInfo, task);
             }
@@ -121,9 +179,9 @@ struct DistributedCompute<DTRes, Structure>
                         distributed::Task task;
                         *task.add_inputs()->mutable_stored() = lhsData.getData();
                         *task.add_inputs()->mutable_stored() = rhsData.getData();
-                        task.set_mlir_code(mlirCode);
+                        functions.setFunction(task, lhsData.getAddress(), mlirCode, hash);
                         
-                        StoredInfo storedInfo ({new DistributedIndex(ix), new DistributedData(lhsData)});
+                        StoredInfo storedInfo ({new DistributedIndex(ix), new DistributedData(lhsData), task});
 
                         caller.asyncComputeCall(lhsData.getChannel(), storedInfo, task);
                     }
@@ -157,9 +215,9 @@ struct DistributedCompute<DTRes, Structure>
                         distributed::Task task;
                         *task.add_inputs()->mutable_stored() = lhsData.getData();
                         *task.add_inputs()->mutable_stored() = rhsData.getData();
-                        task.set_mlir_code(mlirCode);
+                        functions.setFunction(task, lhsData.getAddress(), mlirCode, hash);
                     
-                        StoredInfo storedInfo ({new DistributedIndex(ix), new DistributedData(lhsData)});
+                        StoredInfo storedInfo ({new DistributedIndex(ix), new DistributedData(lhsData), task});
 
                         caller.asyncComputeCall(lhsData.getChannel(), storedInfo, task);
                     }
@@ -184,6 +242,16 @@ struct DistributedCompute<DTRes, Structure>
             auto response = caller.getNextResult();
             auto ix = response.storedInfo.ix;
             auto lhsdata = response.storedInfo.data;
+            if (response.status.error_code() == grpc::StatusCode::NOT_FOUND) {
+                // The worker has evicted (or never received) the function.
+                functions.forget(lhsdata->getAddress(), hash);
+                auto storedInfo = response.storedInfo;
+                storedInfo.task.set_mlir_code(mlirCode);
+                caller.asyncComputeCall(lhsdata->getChannel(), storedInfo, storedInfo.task);
+                continue;
+            }
+            if (!response.status.ok())
+                throw std::runtime_error("DistributedCompute: " + response.status.error_message());
             
             auto computeResult = response.result;
             DistributedData data(computeResult.outputs(0).stored(), lhsdata->getAddress(), lhsdata->getChannel());
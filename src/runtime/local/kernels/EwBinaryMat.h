@@ -55,6 +55,30 @@ void ewBinaryMat(BinaryOpCode opCode, DTRes *& res, const DTLhs * lhs, const DTR
 
 template<typename VTres, typename VTlhs, typename VTrhs>
 struct EwBinaryMat<DenseMatrix<VTres>, DenseMatrix<VTlhs>, DenseMatrix<VTrhs>> {
+    // The loop over all cells for a particular binary operation. If rhsPerRow
+    // is set, the first value of each row of rhs is combined with all values
+    // in the respective row of lhs (column-vector broadcasting).
+    template<BinaryOpCode opCode>
+    struct Loop {
+        DAPHNE_ALWAYS_INLINE static void run(VTres * valuesRes, const VTlhs * valuesLhs, const VTrhs * valuesRhs,
+                size_t numRows, size_t numCols, size_t rowSkipRes, size_t rowSkipLhs, size_t rowSkipRhs,
+                bool rhsPerRow, DCTX(ctx)) {
+            for(size_t r = 0; r < numRows; r++) {
+                if(rhsPerRow) {
+                    const VTrhs valueRhs = valuesRhs[0];
+                    for(size_t c = 0; c < numCols; c++)
+                        valuesRes[c] = EwBinarySca<opCode, VTres, VTlhs, VTrhs>::apply(valuesLhs[c], valueRhs, ctx);
+                }
+                else
+                    for(size_t c = 0; c < numCols; c++)
+                        valuesRes[c] = EwBinarySca<opCode, VTres, VTlhs, VTrhs>::apply(valuesLhs[c], valuesRhs[c], ctx);
+                valuesLhs += rowSkipLhs;
+                valuesRhs += rowSkipRhs;
+                valuesRes += rowSkipRes;
+            }
+        }
+    };
+
     static void apply(BinaryOpCode opCode, DenseMatrix<VTres> *& res, const DenseMatrix<VTlhs> * lhs, const DenseMatrix<VTrhs> * rhs, DCTX(ctx)) {
         const size_t numRowsLhs = lhs->getNumRows();
         const size_t numColsLhs = lhs->getNumCols();
@@ -68,44 +92,23 @@ struct EwBinaryMat<DenseMatrix<VTres>, DenseMatrix<VTlhs>, DenseMatrix<VTrhs>> {
         const VTrhs * valuesRhs = rhs->getValues();
         VTres * valuesRes = res->getValues();
         
-        EwBinaryScaFuncPtr<VTres, VTlhs, VTrhs> func = getEwBinaryScaFuncPtr<VTres, VTlhs, VTrhs>(opCode);
-        
-        if(numRowsLhs == numRowsRhs && numColsLhs == numColsRhs) {
+        if(numRowsLhs == numRowsRhs && numColsLhs == numColsRhs)
             // matrix op matrix (same size)
-            for(size_t r = 0; r < numRowsLhs; r++) {
-                for(size_t c = 0; c < numColsLhs; c++)
-                    valuesRes[c] = func(valuesLhs[c], valuesRhs[c], ctx);
-                valuesLhs += lhs->getRowSkip();
-                valuesRhs += rhs->getRowSkip();
-                valuesRes += res->getRowSkip();
-            }
-        }
-        else if(numColsLhs == numColsRhs && (numRowsRhs == 1 || numRowsLhs == 1)) {
+            dispatchBinaryOpCode<Loop>(opCode, valuesRes, valuesLhs, valuesRhs, numRowsLhs, numColsLhs,
+                    res->getRowSkip(), lhs->getRowSkip(), rhs->getRowSkip(), false, ctx);
+        else if(numColsLhs == numColsRhs && (numRowsRhs == 1 || numRowsLhs == 1))
             // matrix op row-vector
-            for(size_t r = 0; r < numRowsLhs; r++) {
-                for(size_t c = 0; c < numColsLhs; c++)
-                    valuesRes[c] = func(valuesLhs[c], valuesRhs[c], ctx);
-                valuesLhs += lhs->getRowSkip();
-                valuesRes += res->getRowSkip();
-            }
-        }
-        else if(numRowsLhs == numRowsRhs && (numColsRhs == 1 || numColsLhs == 1)) {
+            dispatchBinaryOpCode<Loop>(opCode, valuesRes, valuesLhs, valuesRhs, numRowsLhs, numColsLhs,
+                    res->getRowSkip(), lhs->getRowSkip(), size_t(0), false, ctx);
+        else if(numRowsLhs == numRowsRhs && (numColsRhs == 1 || numColsLhs == 1))
             // matrix op col-vector
-            for(size_t r = 0; r < numRowsLhs; r++) {
-                for(size_t c = 0; c < numColsLhs; c++)
-                    valuesRes[c] = func(valuesLhs[c], valuesRhs[0], ctx);
-                valuesLhs += lhs->getRowSkip();
-                valuesRhs += rhs->getRowSkip();
-                valuesRes += res->getRowSkip();
-            }
-        }
+            dispatchBinaryOpCode<Loop>(opCode, valuesRes, valuesLhs, valuesRhs, numRowsLhs, numColsLhs,
+                    res->getRowSkip(), lhs->getRowSkip(), rhs->getRowSkip(), true, ctx);
         else {
             throw std::runtime_error("EwBinaryMat(Dense) - lhs and rhs must either "
                 "have the same dimensions, or one of them must be a row/column vector "
                 "with the width/height of the other");
         }
-//        auto end = std::chrono::high_resolution_clock::now();
-//        std::cout << "EwBinaryMat time=" << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() << "µs)" << std::endl;
     }
 };
 
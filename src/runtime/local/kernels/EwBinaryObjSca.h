@@ -58,6 +58,20 @@ void ewBinaryObjSca(BinaryOpCode opCode, DTRes *& res, const DTLhs * lhs, VTRhs
 
 template<typename VT>
 struct EwBinaryObjSca<DenseMatrix<VT>, DenseMatrix<VT>, VT> {
+    // The loop over all cells for a particular binary operation.
+    template<BinaryOpCode opCode>
+    struct Loop {
+        DAPHNE_ALWAYS_INLINE static void run(VT * valuesRes, const VT * valuesLhs, VT rhs, size_t numRows,
+                size_t numCols, size_t rowSkipRes, size_t rowSkipLhs, DCTX(ctx)) {
+            for(size_t r = 0; r < numRows; r++) {
+                for(size_t c = 0; c < numCols; c++)
+                    valuesRes[c] = EwBinarySca<opCode, VT, VT, VT>::apply(valuesLhs[c], rhs, ctx);
+                valuesLhs += rowSkipLhs;
+                valuesRes += rowSkipRes;
+            }
+        }
+    };
+
     static void apply(BinaryOpCode opCode, DenseMatrix<VT> *& res, const DenseMatrix<VT> * lhs, VT rhs, DCTX(ctx)) {
         const size_t numRows = lhs->getNumRows();
         const size_t numCols = lhs->getNumCols();
@@ -65,17 +79,8 @@ struct EwBinaryObjSca<DenseMatrix<VT>, DenseMatrix<VT>, VT> {
         if(res == nullptr)
             res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
         
-        const VT * valuesLhs = lhs->getValues();
-        VT * valuesRes = res->getValues();
-        
-        EwBinaryScaFuncPtr<VT, VT, VT> func = getEwBinaryScaFuncPtr<VT, VT, VT>(opCode);
-        
-        for(size_t r = 0; r < numRows; r++) {
-            for(size_t c = 0; c < numCols; c++)
-                valuesRes[c] = func(valuesLhs[c], rhs, ctx);
-            valuesLhs += lhs->getRowSkip();
-            valuesRes += res->getRowSkip();
-        }
+        dispatchBinaryOpCode<Loop>(opCode, res->getValues(), lhs->getValues(), rhs, numRows, numCols,
+                res->getRowSkip(), lhs->getRowSkip(), ctx);
     }
 };
 
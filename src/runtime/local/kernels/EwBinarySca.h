@@ -19,6 +19,7 @@
 
 #include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/kernels/BinaryOpCode.h>
+#include <util/SimdDispatch.h>
 
 #include <algorithm>
 #include <stdexcept>
@@ -86,6 +87,49 @@ EwBinaryScaFuncPtr<VTRes, VTLhs, VTRhs> getEwBinaryScaFuncPtr(BinaryOpCode opCod
     }
 }
 
+/**
+ * @brief Runs `Loop<opCode>::run(args...)` for the specified binary operation
+ * (via `SimdDispatch`).
+ * 
+ * In contrast to the function pointers above, this interprets the opCode only
+ * once per call, such that loops over many values can use the (inlined)
+ * binary function directly and thus be vectorized by the compiler.
+ * 
+ * @param opCode
+ * @param args The arguments passed to `Loop<opCode>::run`.
+ * @return The result of `Loop<opCode>::run`.
+ */
+template<template<BinaryOpCode> class Loop, typename... Args>
+decltype(auto) dispatchBinaryOpCode(BinaryOpCode opCode, Args... args) {
+    switch (opCode) {
+#define MAKE_CASE(opCode) case opCode: return SimdDispatch<Loop<opCode>>::run(args...);
+        // Arithmetic.
+        MAKE_CASE(BinaryOpCode::ADD)
+        MAKE_CASE(BinaryOpCode::SUB)
+        MAKE_CASE(BinaryOpCode::MUL)
+        MAKE_CASE(BinaryOpCode::DIV)
+        MAKE_CASE(BinaryOpCode::POW)
+        MAKE_CASE(BinaryOpCode::MOD)
+        MAKE_CASE(BinaryOpCode::LOG)
+        // Comparisons.
+        MAKE_CASE(BinaryOpCode::EQ)
+        MAKE_CASE(BinaryOpCode::NEQ)
+        MAKE_CASE(BinaryOpCode::LT)
+        MAKE_CASE(BinaryOpCode::LE)
+        MAKE_CASE(BinaryOpCode::GT)
+        MAKE_CASE(BinaryOpCode::GE)
+        // Min/max.
+        MAKE_CASE(BinaryOpCode::MIN)
+        MAKE_CASE(BinaryOpCode::MAX)
+        // Logical.
+        MAKE_CASE(BinaryOpCode::AND)
+        MAKE_CASE(BinaryOpCode::OR)
+#undef MAKE_CASE
+        default:
+            throw std::runtime_error("unknown BinaryOpCode");
+    }
+}
+
 // ****************************************************************************
 // Convenience function
 // ****************************************************************************
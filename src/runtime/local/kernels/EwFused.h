@@ -0,0 +1,314 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_LOCAL_KERNELS_EWFUSED_H
+#define SRC_RUNTIME_LOCAL_KERNELS_EWFUSED_H
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/AggOpCode.h>
+#include <runtime/local/kernels/BinaryOpCode.h>
+#include <runtime/local/kernels/EwBinarySca.h>
+#include <runtime/local/kernels/EwUnarySca.h>
+#include <runtime/local/kernels/UnaryOpCode.h>
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstring>
+
+// ****************************************************************************
+// Fused expression programs
+// ****************************************************************************
+
+/**
+ * @brief An expression of elementwise operations, optionally followed by a
+ * row-wise aggregation, which `ewFused` evaluates in a single pass over its
+ * inputs.
+ *
+ * The textual form is a whitespace-separated postfix program, e.g.,
+ * `m0 m1 sub m2 div` for `(X - mu) / sd`. The tokens are:
+ * - `m<i>`: the i-th matrix argument, which has the shape of the result or is
+ *   broadcast as a row vector, column vector, or single value
+ * - `s<i>`: the i-th scalar argument
+ * - the name of a `BinaryOpCode` or `UnaryOpCode` in lower case
+ * - `sumRow`, `minRow`, `maxRow`: the row-wise aggregation of the expression,
+ *   which must be the last token
+ */
+struct EwFusedProgram {
+    enum class Kind {
+        MATRIX,
+        SCALAR,
+        BINARY,
+        UNARY,
+        ROW_AGG,
+    };
+
+    struct Instr {
+        Kind kind;
+        // The argument index or the op code.
+        size_t arg;
+    };
+
+    std::vector<Instr> instrs;
+    // The number of intermediate values the program needs at most.
+    size_t maxDepth = 0;
+
+    bool hasRowAgg() const {
+        return !instrs.empty() && instrs.back().kind == Kind::ROW_AGG;
+    }
+
+    static EwFusedProgram parse(const char * program, size_t numArgs, size_t numScalars) {
+        static const std::pair<const char *, BinaryOpCode> binaryOps[] = {
+            {"add", BinaryOpCode::ADD}, {"sub", BinaryOpCode::SUB}, {"mul", BinaryOpCode::MUL},
+            {"div", BinaryOpCode::DIV}, {"pow", BinaryOpCode::POW}, {"log", BinaryOpCode::LOG},
+            {"eq", BinaryOpCode::EQ}, {"neq", BinaryOpCode::NEQ}, {"lt", BinaryOpCode::LT},
+            {"le", BinaryOpCode::LE}, {"gt", BinaryOpCode::GT}, {"ge", BinaryOpCode::GE},
+            {"min", BinaryOpCode::MIN}, {"max", BinaryOpCode::MAX},
+        };
+        static const std::pair<const char *, UnaryOpCode> unaryOps[] = {
+            {"sign", UnaryOpCode::SIGN}, {"sqrt", UnaryOpCode::SQRT}, {"exp", UnaryOpCode::EXP},
+            {"abs", UnaryOpCode::ABS}, {"floor", UnaryOpCode::FLOOR}, {"ceil", UnaryOpCode::CEIL},
+            {"round", UnaryOpCode::ROUND},
+        };
+        static const std::pair<const char *, AggOpCode> aggOps[] = {
+            {"sumRow", AggOpCode::SUM}, {"minRow", AggOpCode::MIN}, {"maxRow", AggOpCode::MAX},
+        };
+
+        EwFusedProgram res;
+        size_t depth = 0;
+        std::istringstream tokens(program);
+        std::string token;
+        while(tokens >> token) {
+            if(res.hasRowAgg())
+                throw std::runtime_error("ewFused: the row aggregation must be the last operation");
+
+            Instr instr;
+            size_t pops = 0;
+            if((token[0] == 'm' || token[0] == 's') && token.size() > 1 &&
+                    token.find_first_not_of("0123456789", 1) == std::string::npos) {
+                instr.kind = token[0] == 'm' ? Kind::MATRIX : Kind::SCALAR;
+                instr.arg = std::stoul(token.substr(1));
+                if(instr.arg >= (instr.kind == Kind::MATRIX ? numArgs : numScalars))
+                    throw std::runtime_error("ewFused: argument index out of bounds: " + token);
+            }
+            else {
+                auto isToken = [&token](const auto & op) { return token == op.first; };
+                auto binIt = std::find_if(std::begin(binaryOps), std::end(binaryOps), isToken);
+                auto unIt = std::find_if(std::begin(unaryOps), std::end(unaryOps), isToken);
+                auto aggIt = std::find_if(std::begin(aggOps), std::end(aggOps), isToken);
+                if(binIt != std::end(binaryOps)) {
+                    instr = {Kind::BINARY, static_cast<size_t>(binIt->second)};
+                    pops = 2;
+                }
+                else if(unIt != std::end(unaryOps)) {
+                    instr = {Kind::UNARY, static_cast<size_t>(unIt->second)};
+                    pops = 1;
+                }
+                else if(aggIt != std::end(aggOps)) {
+                    instr = {Kind::ROW_AGG, static_cast<size_t>(aggIt->second)};
+                    pops = 1;
+                }
+                else
+                    throw std::runtime_error("ewFused: unknown operation: " + token);
+            }
+            if(depth < pops)
+                throw std::runtime_error("ewFused: too few operands for: " + token);
+            depth = depth - pops + 1;
+            res.maxDepth = std::max(res.maxDepth, depth);
+            res.instrs.push_back(instr);
+        }
+        if(depth != 1)
+            throw std::runtime_error("ewFused: the program must compute exactly one value");
+        return res;
+    }
+};
+
+// ****************************************************************************
+// Struct for partial template specialization
+// ****************************************************************************
+
+template<class DTRes, class DTArg>
+struct EwFused {
+    static void apply(DTRes *& res, const DTArg ** args, size_t numArgs,
+            const typename DTRes::VT * scalars, size_t numScalars, const char * program, DCTX(ctx)) = delete;
+};
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+/**
+ * @brief Evaluates a fused expression of elementwise operations (see
+ * `EwFusedProgram`) on the given matrices and scalars.
+ *
+ * The expression is evaluated tile by tile, such that all intermediate values
+ * stay in the cache and the inputs are read and the result is written only
+ * once. If `res` is given, it must have the shape of the result; it may be a
+ * view.
+ */
+template<class DTRes, class DTArg>
+void ewFused(DTRes *& res, const DTArg ** args, size_t numArgs,
+        const typename DTRes::VT * scalars, size_t numScalars, const char * program, DCTX(ctx)) {
+    EwFused<DTRes, DTArg>::apply(res, args, numArgs, scalars, numScalars, program, ctx);
+}
+
+// ****************************************************************************
+// (Partial) template specializations for different data/value types
+// ****************************************************************************
+
+// ----------------------------------------------------------------------------
+// DenseMatrix <- DenseMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct EwFused<DenseMatrix<VT>, DenseMatrix<VT>> {
+    // The number of values of each intermediate tile.
+    static constexpr size_t TILE_SIZE = 1024;
+
+    template<BinaryOpCode opCode>
+    struct BinaryLoop {
+        DAPHNE_ALWAYS_INLINE static void run(VT * lhs, const VT * rhs, size_t n, DCTX(ctx)) {
+            for(size_t i = 0; i < n; i++)
+                lhs[i] = EwBinarySca<opCode, VT, VT, VT>::apply(lhs[i], rhs[i], ctx);
+        }
+    };
+
+    template<UnaryOpCode opCode>
+    struct UnaryLoop {
+        DAPHNE_ALWAYS_INLINE static void run(VT * arg, size_t n, DCTX(ctx)) {
+            for(size_t i = 0; i < n; i++)
+                arg[i] = EwUnarySca<opCode, VT, VT>::apply(arg[i], ctx);
+        }
+    };
+
+    // Aggregates each row of a tile into the respective value of res, which
+    // is initialized with the first tile of the row.
+    template<BinaryOpCode opCode>
+    struct RowAggLoop {
+        DAPHNE_ALWAYS_INLINE static void run(VT * valuesRes, size_t rowSkipRes, const VT * tile,
+                size_t numRows, size_t numCols, bool first, DCTX(ctx)) {
+            for(size_t r = 0; r < numRows; r++) {
+                VT agg = first ? tile[0] : EwBinarySca<opCode, VT, VT, VT>::apply(valuesRes[0], tile[0], ctx);
+                for(size_t c = 1; c < numCols; c++)
+                    agg = EwBinarySca<opCode, VT, VT, VT>::apply(agg, tile[c], ctx);
+                valuesRes[0] = agg;
+                valuesRes += rowSkipRes;
+                tile += numCols;
+            }
+        }
+    };
+
+    // Copies the part of arg broadcast to the given rows and columns of the
+    // result into the tile.
+    static void load(VT * tile, const DenseMatrix<VT> * arg, size_t rowStart, size_t numRows,
+            size_t colStart, size_t numCols) {
+        const size_t rowSkip = arg->getNumRows() == 1 ? 0 : arg->getRowSkip();
+        const VT * values = arg->getValues() + rowStart * rowSkip;
+        if(arg->getNumCols() == 1)
+            for(size_t r = 0; r < numRows; r++, values += rowSkip, tile += numCols)
+                std::fill(tile, tile + numCols, values[0]);
+        else
+            for(size_t r = 0; r < numRows; r++, values += rowSkip, tile += numCols)
+                std::memcpy(tile, values + colStart, numCols * sizeof(VT));
+    }
+
+    static void apply(DenseMatrix<VT> *& res, const DenseMatrix<VT> ** args, size_t numArgs,
+            const VT * scalars, size_t numScalars, const char * program, DCTX(ctx)) {
+        using Kind = EwFusedProgram::Kind;
+
+        const EwFusedProgram prog = EwFusedProgram::parse(program, numArgs, numScalars);
+        if(numArgs == 0)
+            throw std::runtime_error("ewFused: at least one matrix argument is required");
+
+        // The shape of the result (before the row aggregation), all arguments
+        // must either have it or be broadcast along rows and/or columns.
+        size_t numRows = 0;
+        size_t numCols = 0;
+        for(size_t i = 0; i < numArgs; i++) {
+            numRows = std::max(numRows, args[i]->getNumRows());
+            numCols = std::max(numCols, args[i]->getNumCols());
+        }
+        for(size_t i = 0; i < numArgs; i++) {
+            const size_t r = args[i]->getNumRows();
+            const size_t c = args[i]->getNumCols();
+            if((r != numRows && r != 1) || (c != numCols && c != 1))
+                throw std::runtime_error("ewFused: the arguments must either have the same dimensions, or be "
+                        "row/column vectors with the width/height of the others");
+        }
+
+        const size_t numColsRes = prog.hasRowAgg() ? 1 : numCols;
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numColsRes, false);
+        else if(res->getNumRows() != numRows || res->getNumCols() != numColsRes)
+            throw std::runtime_error("ewFused: the given result has the wrong dimensions");
+        if(numRows == 0 || numCols == 0)
+            return;
+
+        // Tiles consist of whole rows if they fit, otherwise of a part of one
+        // row.
+        const size_t tileCols = std::min(numCols, TILE_SIZE);
+        const size_t tileRows = tileCols == numCols ? TILE_SIZE / numCols : 1;
+        std::vector<VT> tiles(prog.maxDepth * TILE_SIZE);
+
+        VT * valuesRes = res->getValues();
+        const size_t rowSkipRes = res->getRowSkip();
+        for(size_t r0 = 0; r0 < numRows; r0 += tileRows) {
+            const size_t nr = std::min(tileRows, numRows - r0);
+            for(size_t c0 = 0; c0 < numCols; c0 += tileCols) {
+                const size_t nc = std::min(tileCols, numCols - c0);
+                const size_t n = nr * nc;
+                VT * top = tiles.data() - TILE_SIZE;
+                for(const auto & instr : prog.instrs) {
+                    switch(instr.kind) {
+                        case Kind::MATRIX:
+                            top += TILE_SIZE;
+                            load(top, args[instr.arg], r0, nr, c0, nc);
+                            break;
+                        case Kind::SCALAR:
+                            top += TILE_SIZE;
+                            std::fill(top, top + n, scalars[instr.arg]);
+                            break;
+                        case Kind::BINARY:
+                            top -= TILE_SIZE;
+                            dispatchBinaryOpCode<BinaryLoop>(static_cast<BinaryOpCode>(instr.arg),
+                                    top, static_cast<const VT *>(top + TILE_SIZE), n, ctx);
+                            break;
+                        case Kind::UNARY:
+                            dispatchUnaryOpCode<UnaryLoop>(static_cast<UnaryOpCode>(instr.arg), top, n, ctx);
+                            break;
+                        case Kind::ROW_AGG:
+                            dispatchBinaryOpCode<RowAggLoop>(
+                                    AggOpCodeUtils::getBinaryOpCode(static_cast<AggOpCode>(instr.arg)),
+                                    valuesRes + r0 * rowSkipRes, rowSkipRes, static_cast<const VT *>(top),
+                                    nr, nc, c0 == 0, ctx);
+                            break;
+                    }
+                }
+                if(!prog.hasRowAgg())
+                    for(size_t r = 0; r < nr; r++)
+                        std::memcpy(valuesRes + (r0 + r) * rowSkipRes + c0, top + r * nc, nc * sizeof(VT));
+            }
+        }
+    }
+};
+
+#endif //SRC_RUNTIME_LOCAL_KERNELS_EWFUSED_H
@@ -54,6 +54,20 @@ void ewUnaryMat(UnaryOpCode opCode, DTRes *& res, const DTArg * arg, DCTX(ctx))
 
 template<typename VT>
 struct EwUnaryMat<DenseMatrix<VT>, DenseMatrix<VT>> {
+    // The loop over all cells for a particular unary operation.
+    template<UnaryOpCode opCode>
+    struct Loop {
+        DAPHNE_ALWAYS_INLINE static void run(VT * valuesRes, const VT * valuesArg, size_t numRows, size_t numCols,
+                size_t rowSkipRes, size_t rowSkipArg, DCTX(ctx)) {
+            for(size_t r = 0; r < numRows; r++) {
+                for(size_t c = 0; c < numCols; c++)
+                    valuesRes[c] = EwUnarySca<opCode, VT, VT>::apply(valuesArg[c], ctx);
+                valuesArg += rowSkipArg;
+                valuesRes += rowSkipRes;
+            }
+        }
+    };
+
     static void apply(UnaryOpCode opCode, DenseMatrix<VT> *& res, const DenseMatrix<VT> * arg, DCTX(ctx)) {
         const size_t numRows = arg->getNumRows();
         const size_t numCols = arg->getNumCols();
@@ -61,17 +75,8 @@ struct EwUnaryMat<DenseMatrix<VT>, DenseMatrix<VT>> {
         if(res == nullptr)
             res = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
         
-        const VT * valuesArg = arg->getValues();
-        VT * valuesRes = res->getValues();
-        
-        EwUnaryScaFuncPtr<VT, VT> func = getEwUnaryScaFuncPtr<VT, VT>(opCode);
-        
-        for(size_t r = 0; r < numRows; r++) {
-            for(size_t c = 0; c < numCols; c++)
-                valuesRes[c] = func(valuesArg[c], ctx);
-            valuesArg += arg->getRowSkip();
-            valuesRes += res->getRowSkip();
-        }
+        dispatchUnaryOpCode<Loop>(opCode, res->getValues(), arg->getValues(), numRows, numCols,
+                res->getRowSkip(), arg->getRowSkip(), ctx);
     }
 };
 
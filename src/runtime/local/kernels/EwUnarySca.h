@@ -19,6 +19,7 @@
 
 #include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/kernels/UnaryOpCode.h>
+#include <util/SimdDispatch.h>
 
 #include <limits>
 #include <stdexcept>
@@ -74,6 +75,33 @@ EwUnaryScaFuncPtr<VTRes, VTArg> getEwUnaryScaFuncPtr(UnaryOpCode opCode) {
     }
 }
 
+/**
+ * @brief Runs `Loop<opCode>::run(args...)` for the specified unary operation
+ * (via `SimdDispatch`), see `dispatchBinaryOpCode`.
+ * 
+ * @param opCode
+ * @param args The arguments passed to `Loop<opCode>::run`.
+ * @return The result of `Loop<opCode>::run`.
+ */
+template<template<UnaryOpCode> class Loop, typename... Args>
+decltype(auto) dispatchUnaryOpCode(UnaryOpCode opCode, Args... args) {
+    switch(opCode) {
+        #define MAKE_CASE(opCode) case opCode: return SimdDispatch<Loop<opCode>>::run(args...);
+        // Arithmetic/general math.
+        MAKE_CASE(UnaryOpCode::SIGN)
+        MAKE_CASE(UnaryOpCode::SQRT)
+        MAKE_CASE(UnaryOpCode::EXP)
+        // Rounding.
+        MAKE_CASE(UnaryOpCode::ABS)
+        MAKE_CASE(UnaryOpCode::FLOOR)
+        MAKE_CASE(UnaryOpCode::CEIL)
+        MAKE_CASE(UnaryOpCode::ROUND)
+        #undef MAKE_CASE
+        default:
+            throw std::runtime_error("unknown UnaryOpCode");
+    }
+}
+
 // ****************************************************************************
 // Convenience function
 // ****************************************************************************
@@ -18,11 +18,17 @@
 #define SRC_RUNTIME_LOCAL_KERNELS_GEMV_H
 
 #include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <util/ParallelFor.h>
 
 #include <cblas.h>
 
+#include <algorithm>
+#include <thread>
+#include <vector>
+
 // ****************************************************************************
 // Struct for partial template specialization
 // ****************************************************************************
@@ -99,4 +105,49 @@ struct Gemv<DenseMatrix<float>, DenseMatrix<float>, DenseMatrix<float>> {
     }
 };
 
+// ----------------------------------------------------------------------------
+// DenseMatrix <- CSRMatrix, DenseMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct Gemv<DenseMatrix<VT>, CSRMatrix<VT>, DenseMatrix<VT>> {
+    static void apply(DenseMatrix<VT> *& res, const CSRMatrix<VT> * mat, const DenseMatrix<VT> * vec, DCTX(ctx)) {
+        const size_t numRows = mat->getNumRows();
+        const size_t numCols = mat->getNumCols();
+        const size_t nnz = mat->getNumNonZeros();
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VT>>(numCols, 1, false);
+
+        const VT * valuesVec = vec->getValues();
+        const size_t rowSkipVec = vec->getRowSkip();
+
+        // Each thread scatters the rows of a range into its own partial
+        // result, as long as these do not outweigh the non-zeros.
+        const size_t numThreads = limitThreadsByHistogram(
+                parallelForNumThreads(nnz, ctx ? ctx->config.numberOfThreads : 0), nnz, numCols);
+        std::vector<std::vector<VT>> partials(numThreads);
+        parallelFor(numThreads, numThreads, [&](size_t t) {
+            partials[t].assign(numCols, VT(0));
+            VT * partial = partials[t].data();
+            for(size_t r = numRows * t / numThreads; r < numRows * (t + 1) / numThreads; r++) {
+                const VT v = valuesVec[r * rowSkipVec];
+                const size_t * colIdxs = mat->getColIdxs(r);
+                const VT * values = mat->getValues(r);
+                for(size_t i = 0; i < mat->getNumNonZeros(r); i++)
+                    partial[colIdxs[i]] += values[i] * v;
+            }
+        });
+
+        VT * valuesRes = res->getValues();
+        const size_t rowSkipRes = res->getRowSkip();
+        for(size_t c = 0; c < numCols; c++) {
+            VT sum = partials[0][c];
+            for(size_t t = 1; t < numThreads; t++)
+                sum += partials[t][c];
+            valuesRes[c * rowSkipRes] = sum;
+        }
+    }
+};
+
 #endif //SRC_RUNTIME_LOCAL_KERNELS_GEMV_H
\ No newline at end of file
@@ -26,11 +26,19 @@
 #include <runtime/local/kernels/Order.h>
 #include <runtime/local/kernels/ExtractCol.h>
 #include <util/DeduceType.h>
+#include <util/ParallelFor.h>
 #include <ir/daphneir/Daphne.h>
 
+#include <algorithm>
 #include <iterator>
+#include <limits>
+#include <numeric>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
+#include <cstring>
+
 // ****************************************************************************
 // Struct for partial template specialization
 // ****************************************************************************
@@ -116,16 +124,330 @@ std::string myStringifyGroupEnum(mlir::daphne::GroupEnum val) {
     return "";
 }
 
+// ----------------------------------------------------------------------------
+// Hash-based grouping
+// ----------------------------------------------------------------------------
+
+// type-erased access to the values of a key column
+struct GroupKeyColumn {
+    const void * values;
+    uint64_t (*hash)(const void * values, size_t row);
+    bool (*equal)(const void * values, size_t rowLhs, size_t rowRhs);
+    bool (*less)(const void * values, size_t rowLhs, size_t rowRhs);
+};
+
+template<typename VT>
+struct MakeGroupKeyColumn {
+    static void apply(GroupKeyColumn & keyCol, const void * values) {
+        keyCol.values = values;
+        keyCol.hash = [](const void * vs, size_t r) {
+            VT v = static_cast<const VT *>(vs)[r];
+            if constexpr(std::is_floating_point<VT>::value)
+                if(v == 0)
+                    v = 0; // -0.0 == 0.0
+            uint64_t h = 0;
+            memcpy(&h, &v, sizeof(VT));
+            return h;
+        };
+        keyCol.equal = [](const void * vs, size_t a, size_t b) {
+            return static_cast<const VT *>(vs)[a] == static_cast<const VT *>(vs)[b];
+        };
+        keyCol.less = [](const void * vs, size_t a, size_t b) {
+            return static_cast<const VT *>(vs)[a] < static_cast<const VT *>(vs)[b];
+        };
+    }
+};
+
+// open-addressing hash table mapping the keys of rows to dense group ids
+class GroupHashTable {
+    const std::vector<GroupKeyColumn> & keyCols;
+    std::vector<size_t> slots; // group id + 1, 0 if empty
+    size_t mask;
+    std::vector<uint64_t> groupHashes;
+
+    void grow() {
+        std::vector<size_t>(slots.size() * 2, 0).swap(slots);
+        mask = slots.size() - 1;
+        for(size_t g = 0; g < groupHashes.size(); g++) {
+            size_t s = groupHashes[g] & mask;
+            while(slots[s])
+                s = (s + 1) & mask;
+            slots[s] = g + 1;
+        }
+    }
+
+    bool equalKeys(size_t rowLhs, size_t rowRhs) const {
+        for(auto & kc : keyCols)
+            if(!kc.equal(kc.values, rowLhs, rowRhs))
+                return false;
+        return true;
+    }
+
+public:
+    // the first row of each group
+    std::vector<size_t> groupRows;
+
+    explicit GroupHashTable(const std::vector<GroupKeyColumn> & keyCols) : keyCols(keyCols), slots(1024, 0), mask(1023) {}
+
+    uint64_t hashRow(size_t row) const {
+        uint64_t h = 0;
+        for(auto & kc : keyCols)
+            h = (h ^ kc.hash(kc.values, row)) * 0x9e3779b97f4a7c15ULL;
+        // finalizer of MurmurHash3
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    size_t findOrInsert(size_t row, uint64_t h) {
+        size_t s = h & mask;
+        while(slots[s]) {
+            const size_t g = slots[s] - 1;
+            if(groupHashes[g] == h && equalKeys(groupRows[g], row))
+                return g;
+            s = (s + 1) & mask;
+        }
+        const size_t g = groupRows.size();
+        slots[s] = g + 1;
+        groupRows.push_back(row);
+        groupHashes.push_back(h);
+        if(groupRows.size() * 2 > slots.size())
+            grow();
+        return g;
+    }
+
+    uint64_t getGroupHash(size_t g) const { return groupHashes[g]; }
+    size_t getNumGroups() const { return groupRows.size(); }
+};
+
+// Aggregates a column of the argument frame into the column of the result
+// frame in a single pass, given the group of each row. With more than one
+// thread, each thread pre-aggregates its rows into its own partial results.
+template<typename VTRes, typename VTArg>
+struct ColumnHashGroupAgg {
+    static void apply(Frame * res, size_t colIdxRes, const Frame * arg, size_t colIdxArg,
+            const std::vector<size_t> * groupIds, const std::vector<size_t> * groupRank, size_t numThreads,
+            mlir::daphne::GroupEnum aggFunc, DCTX(ctx)) {
+        using mlir::daphne::GroupEnum;
+        VTRes * valuesRes = static_cast<VTRes *>(res->getColumnRaw(colIdxRes));
+        const VTArg * valuesArg = static_cast<const VTArg *>(arg->getColumnRaw(colIdxArg));
+        const size_t numRows = arg->getNumRows();
+        const size_t numGroups = res->getNumRows();
+
+        // the partial result and number of rows of each group in each chunk
+        const size_t numChunks = numThreads;
+        std::vector<std::vector<VTRes>> acc(numChunks);
+        std::vector<std::vector<size_t>> cnt(numChunks);
+        parallelFor(numChunks, numThreads, [&](size_t c) {
+            VTRes init = 0;
+            if(aggFunc == GroupEnum::MIN)
+                init = std::numeric_limits<VTRes>::has_infinity ? std::numeric_limits<VTRes>::infinity() : std::numeric_limits<VTRes>::max();
+            else if(aggFunc == GroupEnum::MAX)
+                init = std::numeric_limits<VTRes>::has_infinity ? -std::numeric_limits<VTRes>::infinity() : std::numeric_limits<VTRes>::lowest();
+            auto & a = acc[c];
+            auto & n = cnt[c];
+            a.assign(numGroups, init);
+            n.assign(numGroups, 0);
+            const size_t * gids = groupIds->data();
+            const size_t begin = numRows * c / numChunks;
+            const size_t end = numRows * (c + 1) / numChunks;
+            switch(aggFunc) {
+                case GroupEnum::COUNT:
+                    for(size_t r = begin; r < end; r++)
+                        n[gids[r]]++;
+                    break;
+                case GroupEnum::SUM:
+                case GroupEnum::AVG:
+                    for(size_t r = begin; r < end; r++) {
+                        a[gids[r]] += static_cast<VTRes>(valuesArg[r]);
+                        n[gids[r]]++;
+                    }
+                    break;
+                case GroupEnum::MIN:
+                    for(size_t r = begin; r < end; r++)
+                        a[gids[r]] = std::min<VTRes>(a[gids[r]], valuesArg[r]);
+                    break;
+                case GroupEnum::MAX:
+                    for(size_t r = begin; r < end; r++)
+                        a[gids[r]] = std::max<VTRes>(a[gids[r]], valuesArg[r]);
+                    break;
+            }
+        });
+
+        // combine the partial results in the order of the chunks
+        for(size_t g = 0; g < numGroups; g++) {
+            VTRes a = acc[0][g];
+            size_t n = cnt[0][g];
+            for(size_t c = 1; c < numChunks; c++) {
+                switch(aggFunc) {
+                    case GroupEnum::MIN: a = std::min(a, acc[c][g]); break;
+                    case GroupEnum::MAX: a = std::max(a, acc[c][g]); break;
+                    default: a += acc[c][g]; break;
+                }
+                n += cnt[c][g];
+            }
+            VTRes v;
+            switch(aggFunc) {
+                case GroupEnum::COUNT: v = static_cast<VTRes>(n); break;
+                case GroupEnum::AVG: v = static_cast<VTRes>(static_cast<double>(a) / static_cast<double>(n)); break;
+                default: v = static_cast<VTRes>(a); break;
+            }
+            valuesRes[(*groupRank)[g]] = v;
+        }
+    }
+};
+
+// copies the key of each group (taken from its first row) into a key column of the result
+template<typename VT>
+struct ColumnHashGroupKey {
+    static void apply(Frame * res, size_t colIdxRes, const Frame * arg, size_t colIdxArg,
+            const std::vector<size_t> * groupRows, const std::vector<size_t> * groupRank) {
+        VT * valuesRes = static_cast<VT *>(res->getColumnRaw(colIdxRes));
+        const VT * valuesArg = static_cast<const VT *>(arg->getColumnRaw(colIdxArg));
+        for(size_t g = 0; g < groupRows->size(); g++)
+            valuesRes[(*groupRank)[g]] = valuesArg[(*groupRows)[g]];
+    }
+};
+
 template <> struct Group<Frame> {
     static void apply(Frame *& res, const Frame * arg, const char ** keyCols, size_t numKeyCols,
         const char ** aggCols, size_t numAggCols, mlir::daphne::GroupEnum * aggFuncs, size_t numAggFuncs, DCTX(ctx)) {
-        size_t numRowsArg = arg->getNumRows();
-        size_t numColsRes = numKeyCols + numAggCols;
-        size_t numRowsRes = numRowsArg;
         if (arg == nullptr || (keyCols == nullptr && numKeyCols != 0) || (aggCols == nullptr && numAggCols != 0) || (aggFuncs == nullptr && numAggFuncs != 0))   {
             throw std::runtime_error("group-kernel called with invalid arguments");
         }
+        if (!hashGroup(res, arg, keyCols, numKeyCols, aggCols, numAggCols, aggFuncs, ctx))
+            sortGroup(res, arg, keyCols, numKeyCols, aggCols, numAggCols, aggFuncs, ctx);
+    }
+
+private:
+    static void createResult(Frame *& res, const Frame * arg, size_t numRowsRes, const char ** keyCols, size_t numKeyCols,
+        const char ** aggCols, size_t numAggCols, mlir::daphne::GroupEnum * aggFuncs) {
+        size_t numColsRes = numKeyCols + numAggCols;
+        std::string * labels = new std::string[numColsRes];
+        ValueTypeCode * schema = new ValueTypeCode[numColsRes];
+
+        for (size_t i = 0; i < numKeyCols; i++) {
+            labels[i] = keyCols[i];
+            schema[i] = arg->getColumnType(keyCols[i]);
+        }
+        using mlir::daphne::GroupEnum;
+        for (size_t i = numKeyCols; i < numColsRes; i++) {
+            // TODO Maybe we can find a good way to call mlir::daphne::stringifyGroupEnum,
+            // we would need to link with the respective library.
+//            labels[i] = mlir::daphne::stringifyGroupEnum(aggFuncs[i-numKeyCols]).str() + "(" +  aggCols[i-numKeyCols] + ")";
+            labels[i] = myStringifyGroupEnum(aggFuncs[i-numKeyCols]) + "(" +  aggCols[i-numKeyCols] + ")";
+            switch(aggFuncs[i-numKeyCols]) {
+                case GroupEnum::COUNT: schema[i] = ValueTypeCode::UI64; break;
+                case GroupEnum::SUM: schema[i] = arg->getColumnType(aggCols[i-numKeyCols]); break;
+                case GroupEnum::MIN: schema[i] = arg->getColumnType(aggCols[i-numKeyCols]); break;
+                case GroupEnum::MAX: schema[i] = arg->getColumnType(aggCols[i-numKeyCols]); break;
+                case GroupEnum::AVG: schema[i] = ValueTypeCode::F64; break;
+            }
+        } 
         
+        res = DataObjectFactory::create<Frame>(numRowsRes, numColsRes, schema, labels, false);
+        delete [] labels;
+        delete [] schema;
+    }
+
+    // Groups by means of a hash table on the key columns and aggregates in a
+    // single pass over the rows, without reordering the frame. Returns false
+    // (without creating the result) if the keys have a high cardinality, in
+    // which case sorting is preferable.
+    static bool hashGroup(Frame *& res, const Frame * arg, const char ** keyCols, size_t numKeyCols,
+        const char ** aggCols, size_t numAggCols, mlir::daphne::GroupEnum * aggFuncs, DCTX(ctx)) {
+        const size_t numRowsArg = arg->getNumRows();
+        // at most that many groups (i.e., at least two rows per group on average)
+        const size_t maxNumGroups = std::max<size_t>(1, numRowsArg / 2);
+
+        const size_t numThreads = parallelForNumThreads(numRowsArg, ctx ? ctx->config.numberOfThreads : 0);
+
+        std::vector<GroupKeyColumn> keys(numKeyCols);
+        for (size_t i = 0; i < numKeyCols; i++) {
+            const size_t idx = arg->getColumnIdx(keyCols[i]);
+            DeduceValueTypeAndExecute<MakeGroupKeyColumn>::apply(arg->getColumnType(idx), keys[i], arg->getColumnRaw(idx));
+        }
+
+        // Determine the group of each row, first in a hash table per chunk of
+        // rows, then merged into a global one.
+        std::vector<size_t> groupIds(numRowsArg, 0);
+        GroupHashTable global(keys);
+        if (numKeyCols == 0) {
+            // pure aggregation over all rows
+            global.groupRows.push_back(0);
+        }
+        else {
+            const size_t numChunks = numThreads;
+            std::vector<GroupHashTable> locals(numChunks, GroupHashTable(keys));
+            std::vector<char> tooMany(numChunks, false);
+            parallelFor(numChunks, numThreads, [&](size_t c) {
+                for (size_t r = numRowsArg * c / numChunks; r < numRowsArg * (c + 1) / numChunks; r++) {
+                    groupIds[r] = locals[c].findOrInsert(r, locals[c].hashRow(r));
+                    if (locals[c].getNumGroups() > maxNumGroups) {
+                        tooMany[c] = true;
+                        return;
+                    }
+                }
+            });
+            if (std::find(tooMany.begin(), tooMany.end(), true) != tooMany.end())
+                return false;
+            std::vector<std::vector<size_t>> localToGlobal(numChunks);
+            for (size_t c = 0; c < numChunks; c++) {
+                for (size_t g = 0; g < locals[c].getNumGroups(); g++)
+                    localToGlobal[c].push_back(global.findOrInsert(locals[c].groupRows[g], locals[c].getGroupHash(g)));
+                if (global.getNumGroups() > maxNumGroups)
+                    return false;
+            }
+            if (numChunks > 1)
+                parallelFor(numChunks, numThreads, [&](size_t c) {
+                    for (size_t r = numRowsArg * c / numChunks; r < numRowsArg * (c + 1) / numChunks; r++)
+                        groupIds[r] = localToGlobal[c][groupIds[r]];
+                });
+        }
+        const size_t numGroups = global.getNumGroups();
+
+        // The result is ordered by the keys (as with sorting), which only
+        // requires sorting the groups.
+        std::vector<size_t> sortedGroups(numGroups);
+        std::iota(sortedGroups.begin(), sortedGroups.end(), 0);
+        std::sort(sortedGroups.begin(), sortedGroups.end(), [&](size_t a, size_t b) {
+            const size_t ra = global.groupRows[a];
+            const size_t rb = global.groupRows[b];
+            for (auto & kc : keys) {
+                if (kc.less(kc.values, ra, rb))
+                    return true;
+                if (kc.less(kc.values, rb, ra))
+                    return false;
+            }
+            return false;
+        });
+        std::vector<size_t> groupRank(numGroups);
+        for (size_t i = 0; i < numGroups; i++)
+            groupRank[sortedGroups[i]] = i;
+
+        createResult(res, arg, numGroups, keyCols, numKeyCols, aggCols, numAggCols, aggFuncs);
+        for (size_t i = 0; i < numKeyCols; i++) {
+            const size_t idx = arg->getColumnIdx(keyCols[i]);
+            DeduceValueTypeAndExecute<ColumnHashGroupKey>::apply(res->getColumnType(i), res, i, arg, idx, &global.groupRows, &groupRank);
+        }
+        // pre-aggregating per thread only pays off for few groups
+        const size_t numAggThreads = numGroups * numThreads <= numRowsArg ? numThreads : 1;
+        for (size_t i = numKeyCols; i < numKeyCols + numAggCols; i++) {
+            const size_t idx = arg->getColumnIdx(aggCols[i - numKeyCols]);
+            DeduceValueTypeAndExecute<ColumnHashGroupAgg>::apply(res->getColumnType(i), arg->getColumnType(idx), res, i, arg, idx,
+                    &groupIds, &groupRank, numAggThreads, aggFuncs[i - numKeyCols], ctx);
+        }
+        return true;
+    }
+
+    // Groups by sorting the frame on the key columns.
+    static void sortGroup(Frame *& res, const Frame * arg, const char ** keyCols, size_t numKeyCols,
+        const char ** aggCols, size_t numAggCols, mlir::daphne::GroupEnum * aggFuncs, DCTX(ctx)) {
+        size_t numRowsArg = arg->getNumRows();
+        size_t numColsRes = numKeyCols + numAggCols;
+        size_t numRowsRes = numRowsArg;
+
         // convert labels to indices
         auto idxs = std::shared_ptr<size_t[]>(new size_t[numColsRes]);
         bool * ascending = new bool[numKeyCols];
@@ -164,35 +486,11 @@ template <> struct Group<Frame> {
         numRowsRes -= inGroups-groups->size();
 
         // create the result frame
-        std::string * labels = new std::string[numColsRes];
-        ValueTypeCode * schema = new ValueTypeCode[numColsRes];
-
-        for (size_t i = 0; i < numKeyCols; i++) {
-            labels[i] = keyCols[i];
-            schema[i] = ordered->getColumnType(idxs[i]);
-        }
-        using mlir::daphne::GroupEnum;
-        for (size_t i = numKeyCols; i < numColsRes; i++) {
-            // TODO Maybe we can find a good way to call mlir::daphne::stringifyGroupEnum,
-            // we would need to link with the respective library.
-//            labels[i] = mlir::daphne::stringifyGroupEnum(aggFuncs[i-numKeyCols]).str() + "(" +  aggCols[i-numKeyCols] + ")";
-            labels[i] = myStringifyGroupEnum(aggFuncs[i-numKeyCols]) + "(" +  aggCols[i-numKeyCols] + ")";
-            switch(aggFuncs[i-numKeyCols]) {
-                case GroupEnum::COUNT: schema[i] = ValueTypeCode::UI64; break;
-                case GroupEnum::SUM: schema[i] = ordered->getColumnType(idxs[i]); break;
-                case GroupEnum::MIN: schema[i] = ordered->getColumnType(idxs[i]); break;
-                case GroupEnum::MAX: schema[i] = ordered->getColumnType(idxs[i]); break;
-                case GroupEnum::AVG: schema[i] = ValueTypeCode::F64; break;
-            }
-        } 
-        
-        res = DataObjectFactory::create<Frame>(numRowsRes, numColsRes, schema, labels, false);
-        delete [] labels;
-        delete [] schema;
+        createResult(res, arg, numRowsRes, keyCols, numKeyCols, aggCols, numAggCols, aggFuncs);
 
         // copying key columns and column-wise group aggregation
         for (size_t i = 0; i < numColsRes; i++) {
-            DeduceValueTypeAndExecute<ColumnGroupAgg>::apply(res->getSchema()[i], ordered->getSchema()[i], res, ordered, i, groups, (i < numKeyCols) ? (GroupEnum) 0 : aggFuncs[i-numKeyCols], ctx);
+            DeduceValueTypeAndExecute<ColumnGroupAgg>::apply(res->getSchema()[i], ordered->getSchema()[i], res, ordered, i, groups, (i < numKeyCols) ? (mlir::daphne::GroupEnum) 0 : aggFuncs[i-numKeyCols], ctx);
         }        
         delete groups;
         DataObjectFactory::destroy(ordered);
@@ -8,102 +8,262 @@
 #include <runtime/local/datastructures/ValueTypeCode.h>
 #include <runtime/local/datastructures/ValueTypeUtils.h>
 
+#include <util/ParallelFor.h>
+
+#include <algorithm>
 #include <stdexcept>
-#include <tuple>
-#include <unordered_set>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 
 // ****************************************************************************
 // Helper functions
 // ****************************************************************************
 
-template<typename VTCol>
-void innerJoinSetValue(
-    DenseMatrix<VTCol> * res,
-    const DenseMatrix<VTCol> * arg,
-    const int64_t targetRow,
-    const int64_t fromRow,
-    DCTX(ctx)
-){
-    const VTCol argValue = arg->get(fromRow, 0);
-    res->set(targetRow, 0, argValue);
+/**
+ * @brief Hashes a join key, such that keys comparing equal have the same hash.
+ */
+template<typename VT>
+uint64_t innerJoinHash(VT v) {
+    if constexpr(std::is_floating_point<VT>::value)
+        if(v == 0)
+            v = 0; // -0.0 == 0.0
+    uint64_t h = 0;
+    memcpy(&h, &v, sizeof(VT));
+    // finalizer of MurmurHash3
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
 }
 
-template<typename VTCol>
-void innerJoinSet(
-    ValueTypeCode vtcType,
-    Frame *&res,
-    const Frame * arg,
-    const int64_t toRow,
-    const int64_t toCol,
-    const int64_t fromRow,
-    const int64_t fromCol,
-    DCTX(ctx)
-) {
-    if(vtcType == ValueTypeUtils::codeFor<VTCol>){
-        innerJoinSetValue<VTCol>(
-            res->getColumn<VTCol>(toCol),
-            arg->getColumn<VTCol>(fromCol),
-            toRow,
-            fromRow,
-            ctx
-        );
+/**
+ * @brief The row indexes of one join input, radix-partitioned by the lowest
+ * `numPartBits` bits of the hashes of their keys.
+ *
+ * The rows of partition `p` are `rows[offsets[p]]` to `rows[offsets[p + 1] - 1]`
+ * in ascending order.
+ */
+struct InnerJoinPartitions {
+    std::vector<size_t> rows;
+    std::vector<size_t> offsets;
+};
+
+template<typename VT>
+InnerJoinPartitions innerJoinPartition(const VT * keys, size_t numRows, size_t numPartBits, size_t numThreads) {
+    const size_t numParts = size_t(1) << numPartBits;
+    const size_t mask = numParts - 1;
+    const size_t numChunks = std::max<size_t>(1, std::min(numThreads, numRows));
+    auto chunkBegin = [&](size_t c) { return numRows * c / numChunks; };
+
+    // histogram of each chunk
+    std::vector<std::vector<size_t>> hist(numChunks, std::vector<size_t>(numParts, 0));
+    parallelFor(numChunks, numThreads, [&](size_t c) {
+        for(size_t r = chunkBegin(c); r < chunkBegin(c + 1); r++)
+            hist[c][innerJoinHash(keys[r]) & mask]++;
+    });
+
+    // turn the histograms into the start positions of the chunks in each partition
+    InnerJoinPartitions parts;
+    parts.offsets.resize(numParts + 1);
+    size_t pos = 0;
+    for(size_t p = 0; p < numParts; p++) {
+        parts.offsets[p] = pos;
+        for(size_t c = 0; c < numChunks; c++) {
+            const size_t cnt = hist[c][p];
+            hist[c][p] = pos;
+            pos += cnt;
+        }
     }
+    parts.offsets[numParts] = pos;
+
+    // scatter (stable, since the chunks are in order)
+    parts.rows.resize(numRows);
+    parallelFor(numChunks, numThreads, [&](size_t c) {
+        for(size_t r = chunkBegin(c); r < chunkBegin(c + 1); r++)
+            parts.rows[hist[c][innerJoinHash(keys[r]) & mask]++] = r;
+    });
+    return parts;
 }
 
-template<typename VTLhs, typename VTRhs>
-bool innerJoinEqual(
-    // results
-    Frame *& res,
-    // arguments
-    const DenseMatrix<VTLhs> * argLhs,
-    const DenseMatrix<VTRhs> * argRhs,
-    const int64_t targetLhs,
-    const int64_t targetRhs,
-    // context
-    DCTX(ctx)
-){
-    const VTLhs l = argLhs->get(targetLhs, 0);
-    const VTRhs r = argRhs->get(targetRhs, 0);
-    return l == r;
+/**
+ * @brief Joins the key columns of both inputs and returns the matching pairs
+ * of row indexes, ordered by the lhs row index first and the rhs row index
+ * second (i.e., the order of a nested-loop join).
+ *
+ * Both inputs are radix-partitioned on the hashes of their keys. The
+ * partitions are joined in parallel by building a hash table on the smaller
+ * input and probing it with the larger one.
+ */
+template<typename VT>
+void innerJoinKeys(
+    std::vector<size_t> & resLhsRows, std::vector<size_t> & resRhsRows,
+    const VT * lhsKeys, size_t numRowsLhs,
+    const VT * rhsKeys, size_t numRowsRhs,
+    size_t numThreads
+) {
+    // rows per partition such that its hash table fits into the cache
+    constexpr size_t PART_SIZE = 4096;
+    // more partitions than that are not scattered efficiently in one pass
+    constexpr size_t MAX_PART_BITS = 10;
+
+    const bool buildLhs = numRowsLhs < numRowsRhs;
+    const VT * buildKeys = buildLhs ? lhsKeys : rhsKeys;
+    const VT * probeKeys = buildLhs ? rhsKeys : lhsKeys;
+    const size_t numBuild = buildLhs ? numRowsLhs : numRowsRhs;
+    const size_t numProbe = buildLhs ? numRowsRhs : numRowsLhs;
+
+    size_t numPartBits = 0;
+    while((numBuild >> numPartBits) > PART_SIZE && numPartBits < MAX_PART_BITS)
+        numPartBits++;
+    const size_t numParts = size_t(1) << numPartBits;
+
+    const InnerJoinPartitions buildParts = innerJoinPartition(buildKeys, numBuild, numPartBits, numThreads);
+    const InnerJoinPartitions probeParts = innerJoinPartition(probeKeys, numProbe, numPartBits, numThreads);
+
+    // (lhs row, rhs row) pairs of each partition
+    std::vector<std::vector<std::pair<size_t, size_t>>> matches(numParts);
+    parallelFor(numParts, numThreads, [&](size_t p) {
+        const size_t * build = buildParts.rows.data() + buildParts.offsets[p];
+        const size_t * probe = probeParts.rows.data() + probeParts.offsets[p];
+        const size_t nb = buildParts.offsets[p + 1] - buildParts.offsets[p];
+        const size_t np = probeParts.offsets[p + 1] - probeParts.offsets[p];
+        if(!nb || !np)
+            return;
+
+        // bucket-chained hash table on the remaining bits of the hashes
+        size_t numBuckets = 1;
+        while(numBuckets < nb)
+            numBuckets <<= 1;
+        const size_t bucketMask = numBuckets - 1;
+        std::vector<int64_t> heads(numBuckets, -1);
+        std::vector<int64_t> next(nb);
+        // insert in reverse, such that each chain is in ascending row order
+        for(size_t i = nb; i-- > 0; ) {
+            const size_t b = (innerJoinHash(buildKeys[build[i]]) >> numPartBits) & bucketMask;
+            next[i] = heads[b];
+            heads[b] = static_cast<int64_t>(i);
+        }
+
+        auto & m = matches[p];
+        for(size_t j = 0; j < np; j++) {
+            const VT key = probeKeys[probe[j]];
+            const size_t b = (innerJoinHash(key) >> numPartBits) & bucketMask;
+            for(int64_t i = heads[b]; i != -1; i = next[i])
+                if(buildKeys[build[i]] == key) {
+                    if(buildLhs)
+                        m.emplace_back(build[i], probe[j]);
+                    else
+                        m.emplace_back(probe[j], build[i]);
+                }
+        }
+    });
+
+    // Bring the pairs into the order of the lhs rows by a counting sort. All
+    // pairs of an lhs row stem from the same partition and are already in the
+    // order of the rhs rows.
+    std::vector<size_t> lhsPos(numRowsLhs + 1, 0);
+    parallelFor(numParts, numThreads, [&](size_t p) {
+        for(const auto & lr : matches[p])
+            lhsPos[lr.first + 1]++;
+    });
+    for(size_t r = 0; r < numRowsLhs; r++)
+        lhsPos[r + 1] += lhsPos[r];
+    const size_t numRes = lhsPos[numRowsLhs];
+    resLhsRows.resize(numRes);
+    resRhsRows.resize(numRes);
+    parallelFor(numParts, numThreads, [&](size_t p) {
+        for(const auto & lr : matches[p]) {
+            const size_t pos = lhsPos[lr.first]++;
+            resLhsRows[pos] = lr.first;
+            resRhsRows[pos] = lr.second;
+        }
+        std::vector<std::pair<size_t, size_t>>().swap(matches[p]);
+    });
 }
 
-template<typename VTLhs, typename VTRhs>
-bool innerJoinProbeIf(
-    // value type known only at run-time
-    ValueTypeCode vtcLhs,
-    ValueTypeCode vtcRhs,
-    // results
-    Frame *& res,
-    // input frames
-    const Frame * lhs, const Frame * rhs,
-    // input column names
-    const char * lhsOn, const char * rhsOn,
-    // input rows
-    const int64_t targetL, const int64_t targetR,
-    // context
-    DCTX(ctx)
-){
-    if(vtcLhs == ValueTypeUtils::codeFor<VTLhs> && vtcRhs == ValueTypeUtils::codeFor<VTRhs>) {
-        return innerJoinEqual<VTLhs, VTRhs>(
-                res,
-                lhs->getColumn<VTLhs>(lhsOn),
-                rhs->getColumn<VTRhs>(rhsOn),
-                targetL,
-                targetR,
-                ctx
-        );
-    }
-    return false;
+template<typename VT>
+bool innerJoinKeysIf(
+    ValueTypeCode vtc,
+    std::vector<size_t> & resLhsRows, std::vector<size_t> & resRhsRows,
+    const Frame * lhs, size_t lhsOnIdx,
+    const Frame * rhs, size_t rhsOnIdx,
+    size_t numThreads
+) {
+    if(vtc != ValueTypeUtils::codeFor<VT>)
+        return false;
+    innerJoinKeys(
+        resLhsRows, resRhsRows,
+        static_cast<const VT *>(lhs->getColumnRaw(lhsOnIdx)), lhs->getNumRows(),
+        static_cast<const VT *>(rhs->getColumnRaw(rhsOnIdx)), rhs->getNumRows(),
+        numThreads
+    );
+    return true;
+}
+
+template<typename VT>
+bool innerJoinKeysToDoubleIf(ValueTypeCode vtc, std::vector<double> & res, const Frame * arg, size_t colIdx) {
+    if(vtc != ValueTypeUtils::codeFor<VT>)
+        return false;
+    const VT * keys = static_cast<const VT *>(arg->getColumnRaw(colIdx));
+    res.assign(keys, keys + arg->getNumRows());
+    return true;
+}
+
+/**
+ * @brief Converts a key column of any value type to doubles, such that it can
+ * be joined with a key column of another value type.
+ */
+inline std::vector<double> innerJoinKeysToDouble(const Frame * arg, size_t colIdx) {
+    const ValueTypeCode vtc = arg->getColumnType(colIdx);
+    std::vector<double> res;
+    bool found = false;
+    found = found || innerJoinKeysToDoubleIf<int8_t>  (vtc, res, arg, colIdx);
+    found = found || innerJoinKeysToDoubleIf<int32_t> (vtc, res, arg, colIdx);
+    found = found || innerJoinKeysToDoubleIf<int64_t> (vtc, res, arg, colIdx);
+    found = found || innerJoinKeysToDoubleIf<uint8_t> (vtc, res, arg, colIdx);
+    found = found || innerJoinKeysToDoubleIf<uint32_t>(vtc, res, arg, colIdx);
+    found = found || innerJoinKeysToDoubleIf<uint64_t>(vtc, res, arg, colIdx);
+    found = found || innerJoinKeysToDoubleIf<float>   (vtc, res, arg, colIdx);
+    found = found || innerJoinKeysToDoubleIf<double>  (vtc, res, arg, colIdx);
+    if(!found)
+        throw std::runtime_error("innerJoin: unsupported value type of the key columns");
+    return res;
+}
+
+/**
+ * @brief Copies the values of the given rows of a column (of any value type of
+ * the given size in bytes) to the result column.
+ */
+template<typename VTBytes>
+void innerJoinGather(void * res, const void * arg, const size_t * rows, size_t begin, size_t end) {
+    auto resVals = static_cast<VTBytes *>(res);
+    auto argVals = static_cast<const VTBytes *>(arg);
+    for(size_t i = begin; i < end; i++)
+        resVals[i] = argVals[rows[i]];
 }
 
 // ****************************************************************************
 // Convenience function
 // ****************************************************************************
 
-void innerJoin(
+/**
+ * @brief Joins two frames on the equality of one column of each.
+ *
+ * The result consists of all columns of `lhs` followed by all columns of
+ * `rhs`, its rows are in the order of a nested-loop join over `lhs` and `rhs`.
+ * Key columns of different value types are compared as doubles, like in a
+ * comparison of the columns.
+ */
+inline void innerJoin(
     // results
     Frame *& res,
     // input frames
@@ -117,108 +277,75 @@ void innerJoin(
     ValueTypeCode vtcLhsOn = lhs->getColumnType(lhsOn);
     ValueTypeCode vtcRhsOn = rhs->getColumnType(rhsOn);
 
-    // Perhaps check if res already allocated.
-    const size_t numRowRhs = rhs->getNumRows();
-    const size_t numRowLhs = lhs->getNumRows();
-    const size_t totalRows = numRowRhs * numRowLhs;
     const size_t numColRhs = rhs->getNumCols();
     const size_t numColLhs = lhs->getNumCols();
     const size_t totalCols = numColRhs + numColLhs;
     const std::string * oldlabels_l = lhs->getLabels();
     const std::string * oldlabels_r = rhs->getLabels();
 
-    int64_t col_idx_res = 0;
-    int64_t row_idx_res = 0;
+    const size_t numThreads = parallelForNumThreads(
+            lhs->getNumRows() + rhs->getNumRows(), ctx ? ctx->config.numberOfThreads : 0);
 
-    ValueTypeCode schema[totalCols];
-    std::string newlabels[totalCols];
+    // Join the key columns.
+    std::vector<size_t> resLhsRows, resRhsRows;
+    const size_t lhsOnIdx = lhs->getColumnIdx(lhsOn);
+    const size_t rhsOnIdx = rhs->getColumnIdx(rhsOn);
+    bool found = false;
+    if(vtcLhsOn != vtcRhsOn) {
+        const std::vector<double> lhsKeys = innerJoinKeysToDouble(lhs, lhsOnIdx);
+        const std::vector<double> rhsKeys = innerJoinKeysToDouble(rhs, rhsOnIdx);
+        innerJoinKeys(
+            resLhsRows, resRhsRows,
+            lhsKeys.data(), lhs->getNumRows(),
+            rhsKeys.data(), rhs->getNumRows(),
+            numThreads
+        );
+        found = true;
+    }
+    found = found || innerJoinKeysIf<int8_t>  (vtcLhsOn, resLhsRows, resRhsRows, lhs, lhsOnIdx, rhs, rhsOnIdx, numThreads);
+    found = found || innerJoinKeysIf<int32_t> (vtcLhsOn, resLhsRows, resRhsRows, lhs, lhsOnIdx, rhs, rhsOnIdx, numThreads);
+    found = found || innerJoinKeysIf<int64_t> (vtcLhsOn, resLhsRows, resRhsRows, lhs, lhsOnIdx, rhs, rhsOnIdx, numThreads);
+    found = found || innerJoinKeysIf<uint8_t> (vtcLhsOn, resLhsRows, resRhsRows, lhs, lhsOnIdx, rhs, rhsOnIdx, numThreads);
+    found = found || innerJoinKeysIf<uint32_t>(vtcLhsOn, resLhsRows, resRhsRows, lhs, lhsOnIdx, rhs, rhsOnIdx, numThreads);
+    found = found || innerJoinKeysIf<uint64_t>(vtcLhsOn, resLhsRows, resRhsRows, lhs, lhsOnIdx, rhs, rhsOnIdx, numThreads);
+    found = found || innerJoinKeysIf<float>   (vtcLhsOn, resLhsRows, resRhsRows, lhs, lhsOnIdx, rhs, rhsOnIdx, numThreads);
+    found = found || innerJoinKeysIf<double>  (vtcLhsOn, resLhsRows, resRhsRows, lhs, lhsOnIdx, rhs, rhsOnIdx, numThreads);
+    if(!found)
+        throw std::runtime_error("innerJoin: unsupported value type of the key columns");
+    const size_t numRes = resLhsRows.size();
 
     // Setting Schema and Labels
+    std::vector<ValueTypeCode> schema;
+    std::vector<std::string> newlabels;
     for(size_t col_idx_l = 0; col_idx_l < numColLhs; col_idx_l++){
-        schema[col_idx_res] = lhs->getColumnType(col_idx_l);
-        newlabels[col_idx_res] = oldlabels_l[col_idx_l];
-        col_idx_res++;
+        schema.push_back(lhs->getColumnType(col_idx_l));
+        newlabels.push_back(oldlabels_l[col_idx_l]);
     }
     for(size_t col_idx_r = 0; col_idx_r < numColRhs; col_idx_r++){
-        schema[col_idx_res] = rhs->getColumnType(col_idx_r);
-        newlabels[col_idx_res] = oldlabels_r[col_idx_r];
-        col_idx_res++;
+        schema.push_back(rhs->getColumnType(col_idx_r));
+        newlabels.push_back(oldlabels_r[col_idx_r]);
     }
 
     // Creating Result Frame
-    res = DataObjectFactory::create<Frame>(totalRows, totalCols, schema, newlabels, false);
-
-    for(size_t row_idx_l = 0; row_idx_l < numRowLhs; row_idx_l++){
-        for(size_t row_idx_r = 0; row_idx_r < numRowRhs; row_idx_r++){
-            col_idx_res = 0;
-            //PROBE ROWS
-            bool hit = false;
-            hit = hit || innerJoinProbeIf<int64_t, int64_t>(
-                vtcLhsOn, vtcRhsOn,
-                res,
-                lhs, rhs,
-                lhsOn, rhsOn,
-                row_idx_l, row_idx_r,
-                ctx);
-            hit = hit || innerJoinProbeIf<double, double>(
-                vtcLhsOn, vtcRhsOn,
-                res,
-                lhs, rhs,
-                lhsOn, rhsOn,
-                row_idx_l, row_idx_r,
-                ctx);
-            if(hit){
-                for(size_t idx_c = 0; idx_c < numColLhs; idx_c++){
-                    innerJoinSet<int64_t>(
-                        schema[col_idx_res],
-                        res,
-                        lhs,
-                        row_idx_res,
-                        col_idx_res,
-                        row_idx_l,
-                        idx_c,
-                        ctx
-                    );
-                    innerJoinSet<double>(
-                        schema[col_idx_res],
-                        res,
-                        lhs,
-                        row_idx_res,
-                        col_idx_res,
-                        row_idx_l,
-                        idx_c,
-                        ctx
-                    );
-                    col_idx_res++;
-                }
-                for(size_t idx_c = 0; idx_c < numColRhs; idx_c++){
-                    innerJoinSet<int64_t>(
-                        schema[col_idx_res],
-                        res,
-                        rhs,
-                        row_idx_res,
-                        col_idx_res,
-                        row_idx_r,
-                        idx_c,
-                        ctx
-                    );
-
-                    innerJoinSet<double>(
-                        schema[col_idx_res],
-                        res,
-                        rhs,
-                        row_idx_res,
-                        col_idx_res,
-                        row_idx_r,
-                        idx_c,
-                        ctx
-                    );
-                    col_idx_res++;
-                }
-                row_idx_res++;
-            }
+    res = DataObjectFactory::create<Frame>(numRes, totalCols, schema.data(), newlabels.data(), false);
+
+    // Copy the matching rows of all columns, in blocks of rows per column.
+    constexpr size_t BLOCK_SIZE = 1 << 16;
+    const size_t numBlocks = (numRes + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    parallelFor(totalCols * numBlocks, numThreads, [&](size_t task) {
+        const size_t c = task / numBlocks;
+        const size_t begin = (task % numBlocks) * BLOCK_SIZE;
+        const size_t end = std::min(numRes, begin + BLOCK_SIZE);
+        const bool fromLhs = c < numColLhs;
+        const void * arg = fromLhs ? lhs->getColumnRaw(c) : rhs->getColumnRaw(c - numColLhs);
+        const size_t * rows = fromLhs ? resLhsRows.data() : resRhsRows.data();
+        void * resCol = res->getColumnRaw(c);
+        switch(ValueTypeUtils::sizeOf(schema[c])) {
+            case 1: innerJoinGather<uint8_t> (resCol, arg, rows, begin, end); break;
+            case 4: innerJoinGather<uint32_t>(resCol, arg, rows, begin, end); break;
+            case 8: innerJoinGather<uint64_t>(resCol, arg, rows, begin, end); break;
+            default: throw std::runtime_error("innerJoin: unsupported value type");
         }
-    }
-    res->shrinkNumRows(row_idx_res);
+    });
 }
 #endif //SRC_RUNTIME_LOCAL_KERNELS_INNERJOIN_H
@@ -95,6 +95,16 @@ struct InsertCol<DenseMatrix<VT>, DenseMatrix<VT>> {
         const size_t rowSkipArg = arg->getRowSkip();
         const size_t rowSkipIns = ins->getRowSkip();
         
+        if(res == arg) {
+            // Updated in place, so only the addressed columns change.
+            for(size_t r = 0; r < numRowsArg; r++) {
+                memcpy(valuesRes + colLowerIncl, valuesIns, numColsIns * sizeof(VT));
+                valuesRes += rowSkipRes;
+                valuesIns += rowSkipIns;
+            }
+            return;
+        }
+        
         // TODO Can be simplified/more efficient in certain cases.
         for(size_t r = 0; r < numRowsArg; r++) {
             memcpy(valuesRes, valuesArg, colLowerIncl * sizeof(VT));
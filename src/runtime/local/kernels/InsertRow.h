@@ -95,6 +95,17 @@ struct InsertRow<DenseMatrix<VT>, DenseMatrix<VT>> {
         const size_t rowSkipArg = arg->getRowSkip();
         const size_t rowSkipIns = ins->getRowSkip();
         
+        if(res == arg) {
+            // Updated in place, so only the addressed rows change.
+            valuesRes += rowSkipRes * rowLowerIncl;
+            for(size_t r = rowLowerIncl; r < rowUpperExcl; r++) {
+                memcpy(valuesRes, valuesIns, numColsArg * sizeof(VT));
+                valuesRes += rowSkipRes;
+                valuesIns += rowSkipIns;
+            }
+            return;
+        }
+        
         // TODO Can be simplified/more efficient in certain cases.
         for(size_t r = 0; r < rowLowerIncl; r++) {
             memcpy(valuesRes, valuesArg, numColsArg * sizeof(VT));
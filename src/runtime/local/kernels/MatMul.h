@@ -17,13 +17,21 @@
 #pragma once
 
 #include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <util/ParallelFor.h>
 
 #include <cblas.h>
 
+#include <algorithm>
+#include <thread>
+#include <utility>
+#include <vector>
+
 #include <cassert>
 #include <cstddef>
+#include <cstring>
 
 // ****************************************************************************
 // Struct for partial template specialization
@@ -101,3 +109,301 @@ struct MatMul<DenseMatrix<double>, DenseMatrix<double>, DenseMatrix<double>> {
                     static_cast<int>(rhs->getRowSkip()), 0, res->getValues(), static_cast<int>(res->getRowSkip()));
     }
 };
+
+// ----------------------------------------------------------------------------
+// Helpers for sparse matrix multiplication
+// ----------------------------------------------------------------------------
+
+/**
+ * @brief Splits the rows `[0, numRows)` into at most `numChunks` ranges with
+ * roughly the same amount of work, given the inclusive prefix sum of the
+ * work per row in `workOffsets[0..numRows]` (with `workOffsets[0]` as the
+ * base).
+ */
+inline std::vector<size_t> sparseMatMulSplitRows(const size_t * workOffsets, size_t numRows, size_t numChunks) {
+    const size_t totalWork = workOffsets[numRows] - workOffsets[0];
+    std::vector<size_t> bounds{0};
+    for(size_t i = 1; i < numChunks; i++) {
+        const size_t target = workOffsets[0] + totalWork * i / numChunks;
+        const size_t r = std::lower_bound(workOffsets + bounds.back(), workOffsets + numRows, target) - workOffsets;
+        if(r > bounds.back() && r < numRows)
+            bounds.push_back(r);
+    }
+    bounds.push_back(numRows);
+    return bounds;
+}
+
+/**
+ * @brief Accumulates the rows of the product of two CSR matrices, one row at
+ * a time (Gustavson's algorithm).
+ *
+ * Each row is accumulated in a dense array if it touches a considerable
+ * fraction of the columns and in a hash table otherwise. Each thread needs
+ * its own accumulator.
+ */
+template<typename VT>
+class SpGemmRowAccumulator {
+    static constexpr size_t EMPTY = static_cast<size_t>(-1);
+
+    const CSRMatrix<VT> * lhs;
+    const CSRMatrix<VT> * rhs;
+    const size_t numCols;
+
+    // dense accumulator, allocated on first use
+    std::vector<VT> denseValues;
+    std::vector<char> denseUsed;
+    // hash accumulator
+    std::vector<size_t> hashCols;
+    std::vector<VT> hashValues;
+
+    // the columns touched by the current row
+    std::vector<size_t> cols;
+    std::vector<std::pair<size_t, VT>> entries;
+
+    template<bool numeric, class Add>
+    void forEachProduct(size_t r, Add add) const {
+        const size_t * colIdxsLhs = lhs->getColIdxs(r);
+        const VT * valuesLhs = lhs->getValues(r);
+        const size_t nnzLhs = lhs->getNumNonZeros(r);
+        for(size_t i = 0; i < nnzLhs; i++) {
+            const size_t k = colIdxsLhs[i];
+            const size_t * colIdxsRhs = rhs->getColIdxs(k);
+            const VT * valuesRhs = rhs->getValues(k);
+            const size_t nnzRhs = rhs->getNumNonZeros(k);
+            for(size_t j = 0; j < nnzRhs; j++)
+                add(colIdxsRhs[j], numeric ? valuesLhs[i] * valuesRhs[j] : VT(0));
+        }
+    }
+
+public:
+    SpGemmRowAccumulator(const CSRMatrix<VT> * lhs, const CSRMatrix<VT> * rhs) :
+            lhs(lhs), rhs(rhs), numCols(rhs->getNumCols()) {}
+
+    /**
+     * @brief Accumulates the given row of the product, whose number of
+     * multiplications `flops` is an upper bound of its number of non-zeros.
+     *
+     * Without `numeric`, only the number of non-zeros is determined (symbolic
+     * phase). Otherwise, the column indices (sorted) and values are written
+     * to the given output arrays.
+     *
+     * @return The number of non-zeros of the row.
+     */
+    template<bool numeric>
+    size_t accumulateRow(size_t r, size_t flops, size_t * colIdxsRes = nullptr, VT * valuesRes = nullptr) {
+        if(flops == 0)
+            return 0;
+        if(flops * 16 >= numCols) {
+            if(denseUsed.empty()) {
+                denseUsed.resize(numCols, false);
+                if(numeric)
+                    denseValues.resize(numCols, VT(0));
+            }
+            cols.clear();
+            forEachProduct<numeric>(r, [&](size_t c, VT v) {
+                if(!denseUsed[c]) {
+                    denseUsed[c] = true;
+                    cols.push_back(c);
+                }
+                if(numeric)
+                    denseValues[c] += v;
+            });
+            const size_t nnz = cols.size();
+            if(numeric)
+                std::sort(cols.begin(), cols.end());
+            for(size_t i = 0; i < nnz; i++) {
+                const size_t c = cols[i];
+                denseUsed[c] = false;
+                if(numeric) {
+                    colIdxsRes[i] = c;
+                    valuesRes[i] = denseValues[c];
+                    denseValues[c] = VT(0);
+                }
+            }
+            return nnz;
+        }
+        else {
+            // a power of two with a load factor of at most 50%
+            size_t capacity = 1;
+            while(capacity < 2 * flops)
+                capacity *= 2;
+            const size_t mask = capacity - 1;
+            hashCols.assign(capacity, EMPTY);
+            if(numeric)
+                hashValues.assign(capacity, VT(0));
+            size_t nnz = 0;
+            forEachProduct<numeric>(r, [&](size_t c, VT v) {
+                size_t s = (c * 0x9e3779b97f4a7c15ULL) >> 32 & mask;
+                while(hashCols[s] != c && hashCols[s] != EMPTY)
+                    s = (s + 1) & mask;
+                if(hashCols[s] == EMPTY) {
+                    hashCols[s] = c;
+                    nnz++;
+                }
+                if(numeric)
+                    hashValues[s] += v;
+            });
+            if(numeric) {
+                entries.clear();
+                for(size_t s = 0; s < capacity; s++)
+                    if(hashCols[s] != EMPTY)
+                        entries.emplace_back(hashCols[s], hashValues[s]);
+                std::sort(entries.begin(), entries.end(),
+                        [](const std::pair<size_t, VT> & a, const std::pair<size_t, VT> & b) { return a.first < b.first; });
+                for(size_t i = 0; i < nnz; i++) {
+                    colIdxsRes[i] = entries[i].first;
+                    valuesRes[i] = entries[i].second;
+                }
+            }
+            return nnz;
+        }
+    }
+};
+
+/**
+ * @brief Computes the prefix sum of the number of multiplications per row of
+ * the product of two CSR matrices, which bounds its number of non-zeros.
+ */
+template<typename VT>
+std::vector<size_t> spGemmFlopOffsets(const CSRMatrix<VT> * lhs, const CSRMatrix<VT> * rhs) {
+    const size_t numRows = lhs->getNumRows();
+    std::vector<size_t> flopOffsets(numRows + 1, 0);
+    for(size_t r = 0; r < numRows; r++) {
+        const size_t * colIdxsLhs = lhs->getColIdxs(r);
+        size_t flops = 0;
+        for(size_t i = 0; i < lhs->getNumNonZeros(r); i++)
+            flops += rhs->getNumNonZeros(colIdxsLhs[i]);
+        flopOffsets[r + 1] = flopOffsets[r] + flops;
+    }
+    return flopOffsets;
+}
+
+// ----------------------------------------------------------------------------
+// DenseMatrix <- CSRMatrix, DenseMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct MatMul<DenseMatrix<VT>, CSRMatrix<VT>, DenseMatrix<VT>> {
+    static void apply(DenseMatrix<VT> *& res, const CSRMatrix<VT> * lhs, const DenseMatrix<VT> * rhs, DCTX(ctx)) {
+        const size_t nr1 = lhs->getNumRows();
+        const size_t nc2 = rhs->getNumCols();
+        assert((lhs->getNumCols() == rhs->getNumRows()) && "#cols of lhs and #rows of rhs must be the same");
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VT>>(nr1, nc2, false);
+
+        const VT * valuesRhs = rhs->getValues();
+        const size_t rowSkipRhs = rhs->getRowSkip();
+        VT * valuesRes = res->getValues();
+        const size_t rowSkipRes = res->getRowSkip();
+
+        // rows with roughly the same number of non-zeros for each task
+        const size_t numThreads = parallelForNumThreads(lhs->getNumNonZeros() * nc2, ctx ? ctx->config.numberOfThreads : 0);
+        const std::vector<size_t> bounds = sparseMatMulSplitRows(lhs->getRowOffsets(), nr1, numThreads * 4);
+        parallelFor(bounds.size() - 1, numThreads, [&](size_t t) {
+            for(size_t r = bounds[t]; r < bounds[t + 1]; r++) {
+                const size_t * colIdxsLhs = lhs->getColIdxs(r);
+                const VT * valuesLhs = lhs->getValues(r);
+                const size_t nnz = lhs->getNumNonZeros(r);
+                VT * rowRes = valuesRes + r * rowSkipRes;
+                if(nc2 == 1) { // Matrix-Vector
+                    VT sum = 0;
+                    for(size_t i = 0; i < nnz; i++)
+                        sum += valuesLhs[i] * valuesRhs[colIdxsLhs[i] * rowSkipRhs];
+                    rowRes[0] = sum;
+                }
+                else { // Matrix-Matrix
+                    std::fill(rowRes, rowRes + nc2, VT(0));
+                    for(size_t i = 0; i < nnz; i++) {
+                        const VT v = valuesLhs[i];
+                        const VT * rowRhs = valuesRhs + colIdxsLhs[i] * rowSkipRhs;
+                        for(size_t c = 0; c < nc2; c++)
+                            rowRes[c] += v * rowRhs[c];
+                    }
+                }
+            }
+        });
+    }
+};
+
+// ----------------------------------------------------------------------------
+// DenseMatrix <- CSRMatrix, CSRMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct MatMul<DenseMatrix<VT>, CSRMatrix<VT>, CSRMatrix<VT>> {
+    static void apply(DenseMatrix<VT> *& res, const CSRMatrix<VT> * lhs, const CSRMatrix<VT> * rhs, DCTX(ctx)) {
+        const size_t nr1 = lhs->getNumRows();
+        const size_t nc2 = rhs->getNumCols();
+        assert((lhs->getNumCols() == rhs->getNumRows()) && "#cols of lhs and #rows of rhs must be the same");
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<DenseMatrix<VT>>(nr1, nc2, false);
+
+        VT * valuesRes = res->getValues();
+        const size_t rowSkipRes = res->getRowSkip();
+
+        // the rows of the result are dense accumulators by themselves
+        const std::vector<size_t> flopOffsets = spGemmFlopOffsets(lhs, rhs);
+        const size_t numThreads = parallelForNumThreads(flopOffsets[nr1] + nr1 * nc2, ctx ? ctx->config.numberOfThreads : 0);
+        const std::vector<size_t> bounds = sparseMatMulSplitRows(flopOffsets.data(), nr1, numThreads * 4);
+        parallelFor(bounds.size() - 1, numThreads, [&](size_t t) {
+            for(size_t r = bounds[t]; r < bounds[t + 1]; r++) {
+                VT * rowRes = valuesRes + r * rowSkipRes;
+                std::fill(rowRes, rowRes + nc2, VT(0));
+                const size_t * colIdxsLhs = lhs->getColIdxs(r);
+                const VT * valuesLhs = lhs->getValues(r);
+                for(size_t i = 0; i < lhs->getNumNonZeros(r); i++) {
+                    const size_t k = colIdxsLhs[i];
+                    const size_t * colIdxsRhs = rhs->getColIdxs(k);
+                    const VT * valuesRhs = rhs->getValues(k);
+                    for(size_t j = 0; j < rhs->getNumNonZeros(k); j++)
+                        rowRes[colIdxsRhs[j]] += valuesLhs[i] * valuesRhs[j];
+                }
+            }
+        });
+    }
+};
+
+// ----------------------------------------------------------------------------
+// CSRMatrix <- CSRMatrix, CSRMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct MatMul<CSRMatrix<VT>, CSRMatrix<VT>, CSRMatrix<VT>> {
+    static void apply(CSRMatrix<VT> *& res, const CSRMatrix<VT> * lhs, const CSRMatrix<VT> * rhs, DCTX(ctx)) {
+        const size_t nr1 = lhs->getNumRows();
+        const size_t nc2 = rhs->getNumCols();
+        assert((lhs->getNumCols() == rhs->getNumRows()) && "#cols of lhs and #rows of rhs must be the same");
+
+        const std::vector<size_t> flopOffsets = spGemmFlopOffsets(lhs, rhs);
+        const size_t numThreads = parallelForNumThreads(flopOffsets[nr1], ctx ? ctx->config.numberOfThreads : 0);
+        const std::vector<size_t> bounds = sparseMatMulSplitRows(flopOffsets.data(), nr1, numThreads * 4);
+        const size_t numChunks = bounds.size() - 1;
+
+        // Symbolic phase: the number of non-zeros of each row of the result.
+        std::vector<size_t> rowNnz(nr1 + 1, 0);
+        parallelFor(numChunks, numThreads, [&](size_t t) {
+            SpGemmRowAccumulator<VT> acc(lhs, rhs);
+            for(size_t r = bounds[t]; r < bounds[t + 1]; r++)
+                rowNnz[r + 1] = acc.template accumulateRow<false>(r, flopOffsets[r + 1] - flopOffsets[r]);
+        });
+        for(size_t r = 0; r < nr1; r++)
+            rowNnz[r + 1] += rowNnz[r];
+
+        if(res == nullptr)
+            res = DataObjectFactory::create<CSRMatrix<VT>>(nr1, nc2, rowNnz[nr1], false);
+        size_t * rowOffsetsRes = res->getRowOffsets();
+        std::copy(rowNnz.begin(), rowNnz.end(), rowOffsetsRes);
+
+        // Numeric phase: the column indices and values of each row.
+        size_t * colIdxsRes = res->getColIdxs();
+        VT * valuesRes = res->getValues();
+        parallelFor(numChunks, numThreads, [&](size_t t) {
+            SpGemmRowAccumulator<VT> acc(lhs, rhs);
+            for(size_t r = bounds[t]; r < bounds[t + 1]; r++)
+                acc.template accumulateRow<true>(r, flopOffsets[r + 1] - flopOffsets[r],
+                        colIdxsRes + rowOffsetsRes[r], valuesRes + rowOffsetsRes[r]);
+        });
+    }
+};
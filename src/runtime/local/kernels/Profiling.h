@@ -0,0 +1,43 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_LOCAL_KERNELS_PROFILING_H
+#define SRC_RUNTIME_LOCAL_KERNELS_PROFILING_H
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/instrumentation/Profiler.h>
+
+#include <cstddef>
+
+// ****************************************************************************
+// Convenience functions
+// ****************************************************************************
+
+// The compiler wraps each kernel call into these kernels if profiling is
+// enabled, passing the identifier of the call site (see
+// RewriteToCallKernelOpPass).
+
+void startProfiling(size_t siteId, DCTX(ctx)) {
+    if(auto profiler = ctx->config.profiler.get())
+        profiler->beginKernel(siteId);
+}
+
+void stopProfiling(size_t siteId, DCTX(ctx)) {
+    if(auto profiler = ctx->config.profiler.get())
+        profiler->endKernel(siteId);
+}
+
+#endif //SRC_RUNTIME_LOCAL_KERNELS_PROFILING_H
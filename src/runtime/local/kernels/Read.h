@@ -160,6 +160,12 @@ struct Read<CSRMatrix<VT>> {
 template<>
 struct Read<Frame> {
     static void apply(Frame *& res, const char * filename, DCTX(ctx)) {
+        // Daphne binary files contain the schema and labels themselves
+        if(extValue(filename) == 3) {
+            readDaphne(res, filename);
+            return;
+        }
+
         FileMetaData fmd = FileMetaData::ofFile(filename);
         
         ValueTypeCode * schema;
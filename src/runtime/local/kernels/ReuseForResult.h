@@ -0,0 +1,79 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_RUNTIME_LOCAL_KERNELS_REUSEFORRESULT_H
+#define SRC_RUNTIME_LOCAL_KERNELS_REUSEFORRESULT_H
+
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/DistributedDataManager.h>
+
+// ****************************************************************************
+// Struct for partial template specialization
+// ****************************************************************************
+
+template<class DT>
+struct ReuseForResult {
+    static void apply(DT *& res, const DT * arg, DCTX(ctx)) = delete;
+};
+
+// ****************************************************************************
+// Convenience function
+// ****************************************************************************
+
+/**
+ * @brief Provides the given argument of a kernel as the result of the kernel,
+ * if the kernel may overwrite it, such that the kernel updates it in place
+ * instead of allocating a new result.
+ *
+ * The compiler inserts this kernel only if the kernel using `arg` is its last
+ * use (see `UpdateInPlacePass`). At run-time, the argument may still be
+ * referenced elsewhere, e.g., by another variable or a view. Thus, `res` is
+ * `arg` only if nothing but `arg` refers to the data object and its values.
+ * In that case, the reference counter of `arg` is increased, since it is
+ * decreased after the kernel as usual.
+ *
+ * @param res `arg`, or `nullptr` if `arg` must not be overwritten.
+ * @param arg The argument of the kernel.
+ */
+template<class DT>
+void reuseForResult(DT *& res, const DT * arg, DCTX(ctx)) {
+    ReuseForResult<DT>::apply(res, arg, ctx);
+}
+
+// ****************************************************************************
+// (Partial) template specializations for different data/value types
+// ****************************************************************************
+
+// ----------------------------------------------------------------------------
+// DenseMatrix <- DenseMatrix
+// ----------------------------------------------------------------------------
+
+template<typename VT>
+struct ReuseForResult<DenseMatrix<VT>> {
+    static void apply(DenseMatrix<VT> *& res, const DenseMatrix<VT> * arg, DCTX(ctx)) {
+        if(arg->getRefCounter() != 1 || !arg->hasExclusiveValues()) {
+            res = nullptr;
+            return;
+        }
+        // The copies of the matrix on distributed workers become stale.
+        DistributedDataManager::instance().invalidate(arg);
+        arg->increaseRefCounter();
+        res = const_cast<DenseMatrix<VT> *>(arg);
+    }
+};
+
+#endif //SRC_RUNTIME_LOCAL_KERNELS_REUSEFORRESULT_H
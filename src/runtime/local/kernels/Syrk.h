@@ -21,6 +21,8 @@
 #include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/MatMul.h>
+#include <runtime/local/kernels/Transpose.h>
 
 #include <cblas.h>
 
@@ -113,12 +115,11 @@ struct Syrk<DenseMatrix<float>, DenseMatrix<float>> {
 template<typename VT>
 struct Syrk<CSRMatrix<VT>, CSRMatrix<VT>> {
     static void apply(CSRMatrix<VT> *& res, const CSRMatrix<VT> * arg, DCTX(ctx)) {
-        const size_t numRows = arg->getNumRows();
-        const size_t numCols = arg->getNumCols();
-        
-        if(res == nullptr)
-            res = DataObjectFactory::create<CSRMatrix<VT>>(numCols, numRows, arg->getNumNonZeros(), false);
-        assert(false && "TODO: Syrk for Sparse");
+        // t(arg) @ arg, with the transpose materialized as a new CSR matrix
+        CSRMatrix<VT> * argT = nullptr;
+        transpose(argT, arg, ctx);
+        matMul(res, argT, arg, ctx);
+        DataObjectFactory::destroy(argT);
     }
 };
 
@@ -21,6 +21,11 @@
 #include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <util/ParallelFor.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
 
 #include <cstddef>
 
@@ -83,6 +88,79 @@ struct Transpose<DenseMatrix<VT>, DenseMatrix<VT>> {
 // CSRMatrix <- CSRMatrix
 // ----------------------------------------------------------------------------
 
+/**
+ * @brief Computes the compressed sparse column (CSC) representation of the
+ * given CSR matrix, which is the CSR representation of its transpose.
+ *
+ * This is a counting sort of the non-zeros by their column in
+ * O(nnz + rows + cols): each thread counts the non-zeros per column in a range
+ * of rows, a prefix sum over these histograms yields the position of each
+ * thread's first non-zero in each column, and finally each thread scatters its
+ * non-zeros to these positions. The row indices within each column are sorted.
+ *
+ * Column-oriented kernels can use this to obtain a CSC view of a CSR matrix.
+ *
+ * @param arg The CSR matrix (may be a view on a range of rows).
+ * @param colOffsets Receives the `numCols + 1` column offsets.
+ * @param rowIdxs Receives the row index of each of the `nnz` non-zeros.
+ * @param values Receives the value of each of the `nnz` non-zeros.
+ */
+template<typename VT>
+void csrToCsc(const CSRMatrix<VT> * arg, size_t * colOffsets, size_t * rowIdxs, VT * values, DCTX(ctx)) {
+    const size_t numRows = arg->getNumRows();
+    const size_t numCols = arg->getNumCols();
+    const size_t nnz = arg->getNumNonZeros();
+    const VT * valuesArg = arg->getValues();
+    const size_t * colIdxsArg = arg->getColIdxs();
+    const size_t * rowOffsetsArg = arg->getRowOffsets();
+
+    const size_t numThreads = limitThreadsByHistogram(
+            parallelForNumThreads(nnz, ctx ? ctx->config.numberOfThreads : 0), nnz, numCols);
+
+    // Split the rows into ranges with roughly the same number of non-zeros.
+    std::vector<size_t> rowBounds{0};
+    for(size_t t = 1; t < numThreads; t++) {
+        const size_t target = rowOffsetsArg[0] + nnz * t / numThreads;
+        const size_t r = std::lower_bound(rowOffsetsArg + rowBounds.back(), rowOffsetsArg + numRows, target) - rowOffsetsArg;
+        if(r > rowBounds.back() && r < numRows)
+            rowBounds.push_back(r);
+    }
+    rowBounds.push_back(numRows);
+    const size_t numChunks = rowBounds.size() - 1;
+
+    // Count the non-zeros per column in each range of rows.
+    std::vector<std::vector<size_t>> hist(numChunks);
+    parallelFor(numChunks, numThreads, [&](size_t t) {
+        hist[t].assign(numCols, 0);
+        size_t * h = hist[t].data();
+        for(size_t i = rowOffsetsArg[rowBounds[t]]; i < rowOffsetsArg[rowBounds[t + 1]]; i++)
+            h[colIdxsArg[i]]++;
+    });
+
+    // Turn the histograms into the positions to write to.
+    colOffsets[0] = 0;
+    for(size_t c = 0; c < numCols; c++) {
+        size_t pos = colOffsets[c];
+        for(size_t t = 0; t < numChunks; t++) {
+            const size_t cnt = hist[t][c];
+            hist[t][c] = pos;
+            pos += cnt;
+        }
+        colOffsets[c + 1] = pos;
+    }
+
+    // Scatter the non-zeros.
+    parallelFor(numChunks, numThreads, [&](size_t t) {
+        size_t * pos = hist[t].data();
+        for(size_t r = rowBounds[t]; r < rowBounds[t + 1]; r++)
+            for(size_t i = rowOffsetsArg[r]; i < rowOffsetsArg[r + 1]; i++) {
+                const size_t p = pos[colIdxsArg[i]]++;
+                rowIdxs[p] = r;
+                values[p] = valuesArg[i];
+            }
+    });
+}
+
 template<typename VT>
 struct Transpose<CSRMatrix<VT>, CSRMatrix<VT>> {
     static void apply(CSRMatrix<VT> *& res, const CSRMatrix<VT> * arg, DCTX(ctx)) {
@@ -92,30 +170,7 @@ struct Transpose<CSRMatrix<VT>, CSRMatrix<VT>> {
         if(res == nullptr)
             res = DataObjectFactory::create<CSRMatrix<VT>>(numCols, numRows, arg->getNumNonZeros(), false);
         
-        const VT * valuesArg = arg->getValues();
-        const size_t * colIdxsArg = arg->getColIdxs();
-        const size_t * rowOffsetsArg = arg->getRowOffsets();
-        
-        VT * valuesRes = res->getValues();
-        VT * const valuesResInit = valuesRes;
-        size_t * colIdxsRes = res->getColIdxs();
-        size_t * rowOffsetsRes = res->getRowOffsets();
-        
-        size_t * curRowOffsets = new size_t[numRows + 1];
-        memcpy(curRowOffsets, rowOffsetsArg, (numRows + 1) * sizeof(size_t));
-        
-        rowOffsetsRes[0] = 0;
-        for(size_t c = 0; c < numCols; c++) {
-            for(size_t r = 0; r < numRows; r++)
-                if(curRowOffsets[r] < rowOffsetsArg[r + 1] && colIdxsArg[curRowOffsets[r]] == c) {
-                    *valuesRes++ = valuesArg[curRowOffsets[r]];
-                    *colIdxsRes++ = r;
-                    curRowOffsets[r]++;
-                }
-            rowOffsetsRes[c + 1] = valuesRes - valuesResInit;
-        }
-        
-        delete[] curRowOffsets;
+        csrToCsc(arg, res->getRowOffsets(), res->getColIdxs(), res->getValues(), ctx);
     }
 };
 
@@ -17,12 +17,15 @@
 #ifndef SRC_RUNTIME_LOCAL_VECTORIZED_LOADPARTITIONING_H
 #define SRC_RUNTIME_LOCAL_VECTORIZED_LOADPARTITIONING_H
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <cstdlib>
 #include <string>
+#include <vector>
 
 enum SelfSchedulingScheme { STATIC=0, SS, GSS, TSS, FAC2, TFSS, FISS, VISS, 
-                            PLS, MSTATIC, MFSC, PSS,
+                            PLS, MSTATIC, MFSC, PSS, AWF, AF,
                             INVALID=-1 /* only for JSON enum conversion */};
 class LoadPartitioning {
 
@@ -38,6 +41,10 @@ private:
     uint64_t tssDelta;
     uint64_t mfscChunk;
     uint32_t fissStages;
+    // execution time feedback of the adaptive schemes (per worker)
+    std::vector<uint64_t> workerTasks;
+    std::vector<double> workerTime;
+    std::vector<double> workerSqTime;
     int getMethod (const char * method){
         return std::stoi(method);
     }
@@ -77,10 +84,73 @@ public:
         tssChunk = (uint64_t) ceil((double) totalTasks / ((double) 2.0*totalWorkers));
         uint64_t nTemp = (uint64_t) ceil(2.0*totalTasks/(tssChunk+1.0));
         tssDelta  = (uint64_t) (tssChunk - 1.0)/(double)(nTemp-1.0);
+        workerTasks.resize(workers);
+        workerTime.resize(workers);
+        workerSqTime.resize(workers);
     }
     bool hasNextChunk(){
         return scheduledTasks < totalTasks; 
-    }  
+    }
+    /**
+     * @brief Whether the chunk sizes depend on the execution times reported
+     * via `recordChunk()`, such that the chunks should be requested on demand
+     * by each worker with `getNextChunk(worker)`.
+     */
+    bool isAdaptive() const {
+        return schedulingMethod == AWF || schedulingMethod == AF;
+    }
+    /**
+     * @brief Reports that the given worker executed a chunk of the given
+     * number of tasks in the given time.
+     */
+    void recordChunk(uint32_t worker, uint64_t chunkSize, double seconds){
+        double timePerTask = seconds / chunkSize;
+        workerTasks[worker] += chunkSize;
+        workerTime[worker] += seconds;
+        workerSqTime[worker] += chunkSize * timePerTask * timePerTask;
+    }
+    /**
+     * @brief The size of the next chunk, to be executed by the given worker.
+     *
+     * For the adaptive schemes, the chunk is sized by the execution times the
+     * workers reported so far: adaptive weighted factoring (AWF) scales the
+     * factoring chunk by the relative speed of the worker, adaptive factoring
+     * (AF) additionally shrinks it when the time per task varies a lot.
+     */
+    uint64_t getNextChunk(uint32_t worker){
+        if(!isAdaptive())
+            return getNextChunk();
+        // without any measurements, start like factoring
+        double facChunk = (double)remainingTasks/(2.0*totalWorkers);
+        uint64_t chunkSize = (uint64_t) ceil(facChunk);
+        if(workerTasks[worker] > 0 && workerTime[worker] > 0){
+            // mean and variance of the time per task of all measured workers
+            double sumInvMu = 0, D = 0;
+            uint32_t measured = 0;
+            for(uint32_t w = 0; w < totalWorkers; w++){
+                if(workerTasks[w] == 0 || workerTime[w] <= 0)
+                    continue;
+                double mu = workerTime[w]/workerTasks[w];
+                double var = std::max(0.0, workerSqTime[w]/workerTasks[w] - mu*mu);
+                sumInvMu += 1.0/mu;
+                D += var/mu;
+                measured++;
+            }
+            // workers without measurements are assumed to be of average speed
+            sumInvMu *= (double)totalWorkers/measured;
+            D *= (double)totalWorkers/measured;
+            double mu = workerTime[worker]/workerTasks[worker];
+            double weight = totalWorkers/(mu*sumInvMu);
+            chunkSize = (uint64_t) ceil(weight*facChunk);
+            if(schedulingMethod == AF){
+                double T = 1.0/sumInvMu;
+                double R = (double)remainingTasks;
+                double afChunk = (D + 2.0*T*R - sqrt(D*D + 4.0*D*T*R))/(2.0*mu);
+                chunkSize = std::min(chunkSize, (uint64_t) ceil(afChunk));
+            }
+        }
+        return commitChunk(chunkSize);
+    }
     uint64_t getNextChunk(){
         uint64_t chunkSize = 0;
         switch (schedulingMethod){
@@ -144,18 +214,27 @@ public:
                 chunkSize=mfscChunk;
                 break;
             }
+            case AWF:
+            case AF:{//adaptive schemes without a requesting worker, like TFSS
+                chunkSize = (uint64_t) ceil((double) remainingTasks/ ((double) 2.0*totalWorkers));
+                break;
+            }
             default:{
                 chunkSize = (uint64_t)ceil(totalTasks/totalWorkers/4.0);
                 break;
             }
         }
+        return commitChunk(chunkSize);
+    } 
+private:
+    uint64_t commitChunk(uint64_t chunkSize){
         chunkSize = std::max(chunkSize,chunkParam);
         chunkSize = std::min(chunkSize, remainingTasks);
         schedulingStep++;
         scheduledTasks+=chunkSize;
         remainingTasks-=chunkSize;
         return chunkSize;
-    } 
+    }
 };
 
 #endif //SRC_RUNTIME_LOCAL_VECTORIZED_LOADPARTITIONING_H
@@ -19,13 +19,13 @@
 #include <runtime/local/vectorized/TaskQueues.h>
 #include <runtime/local/vectorized/VectorizedDataSink.h>
 #include <runtime/local/vectorized/Workers.h>
+#include <runtime/local/vectorized/WorkerPool.h>
 #include <runtime/local/vectorized/LoadPartitioning.h>
 #include <ir/daphneir/Daphne.h>
 
 #include <functional>
 #include <queue>
 
-//TODO use the wrapper to cache threads
 //TODO generalize for arbitrary inputs (not just binary)
 
 using mlir::daphne::VectorSplit;
@@ -55,6 +55,38 @@ protected:
         return std::make_pair(len, mem_required);
     }
 
+    // (Re-)creates the context's worker pool if it does not exist yet or the
+    // configuration of the pool has changed since its creation.
+    WorkerPool* getWorkerPool(bool verbose = false) {
+        auto queueType = _ctx->config.taskQueueType;
+        auto numaAware = _ctx->config.numaAware;
+        auto profiler = _ctx->config.profiler;
+        if(!_ctx->workerPool || _ctx->workerPool->getNumWorkers() != _numCPPThreads ||
+                _ctx->workerPool->getQueueType() != queueType || _ctx->workerPool->isNumaAware() != numaAware ||
+                _ctx->workerPool->getProfiler() != profiler.get())
+            _ctx->workerPool = std::make_shared<WorkerPool>(_numCPPThreads, queueType, numaAware, verbose, profiler);
+        return _ctx->workerPool.get();
+    }
+
+    // Executes the tasks created by createTask for chunks of rows handed out on
+    // demand by an adaptive self-scheduling scheme. Each worker of the pool
+    // runs one SelfSchedulingTask, which feeds the execution times of its
+    // chunks back to the scheme.
+    void executeSelfScheduled(WorkerPool* pool, const LoadPartitioning& lp, uint64_t startRow,
+            const std::function<Task*(uint64_t, uint64_t)>& createTask, uint32_t batchSize) {
+        SelfScheduler sched(lp, startRow);
+        std::vector<Task*> tasks;
+        for(uint32_t w = 0; w < pool->getNumWorkers(); ++w)
+            tasks.push_back(new SelfSchedulingTask(sched, w, createTask));
+        pool->execute(tasks, batchSize);
+    }
+
+    // The NUMA node responsible for row rl of a pipeline over len rows. Rows
+    // are assigned block-wise, such that consecutive chunks stay on one node.
+    static uint32_t nodeOfRow(uint64_t rl, uint64_t len, uint32_t numNodes) {
+        return static_cast<uint32_t>(rl * numNodes / len);
+    }
+
     void initCPPWorkers(TaskQueue* q, uint32_t batchSize, bool verbose = false) {
         cpp_workers.resize(_numCPPThreads);
         for(auto& w : cpp_workers)
@@ -150,6 +182,15 @@ public:
 
     void combineOutputs(DenseMatrix<VT>***& res, DenseMatrix<VT>***& res_cuda, size_t numOutputs,
             mlir::daphne::VectorCombine* combines) override;
+
+private:
+    // Allocates the missing row-wise combined outputs with buffers no thread
+    // has touched yet, returns their size.
+    size_t allocateUntouchedOutputs(DenseMatrix<VT>*** res, size_t numOutputs, const int64_t* outRows,
+            const int64_t* outCols, const VectorCombine* combines);
+
+    void firstTouchOutputs(WorkerPool* pool, DenseMatrix<VT>*** res, const std::vector<bool>& freshOutputs,
+            const VectorCombine* combines, uint64_t len);
 };
 
 template<typename VT>
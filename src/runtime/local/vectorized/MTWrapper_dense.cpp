@@ -15,6 +15,7 @@
  */
 
 #include "MTWrapper.h"
+#include <runtime/local/datastructures/BufferPool.h>
 #include <runtime/local/vectorized/Tasks.h>
 #ifdef USE_CUDA
 #include <runtime/local/vectorized/TasksCUDA.h>
@@ -28,48 +29,127 @@ void MTWrapper<DenseMatrix<VT>>::executeSingleQueue(
     auto inputProps = this->getInputProperties(inputs, numInputs, splits);
     auto len = inputProps.first;
     auto mem_required = inputProps.second;
+    int method=ctx->config.taskPartitioningScheme;
+    int chunkParam = ctx->config.minimumTaskSize;
+    if(chunkParam<=0)
+        chunkParam=1;
+    LoadPartitioning lp(method, len, chunkParam, this->_numThreads, false);
+
+    std::vector<bool> freshOutputs(numOutputs);
+    for(size_t i = 0; i < numOutputs; ++i)
+        freshOutputs[i] = (*res[i]) == nullptr;
+    // outputs placed on the NUMA nodes by first touch (see firstTouchOutputs)
+    // must not reuse buffers of the pool, which have been touched already
+    if(!lp.isAdaptive() && !this->_numCUDAThreads && this->getWorkerPool(verbose)->getNumNodes() > 1)
+        mem_required += allocateUntouchedOutputs(res, numOutputs, outRows, outCols, combines);
     mem_required += this->allocateOutput(res, numOutputs, outRows, outCols, combines);
     auto row_mem = mem_required / len;
 
-    // create task queue (w/o size-based blocking)
-    std::unique_ptr<TaskQueue> q = std::make_unique<BlockingTaskQueue>(len);
-
     auto batchSize8M = std::max(100ul, static_cast<size_t>(std::ceil(8388608 / row_mem)));
-    this->initCPPWorkers(q.get(), batchSize8M, verbose);
+
+    // lock for aggregation combine
+    // TODO: multiple locks per output
+    std::mutex resLock;
+
+    // create tasks
+    std::vector<Task*> tasks;
+    std::vector<uint64_t> taskStarts;
+    uint64_t startChunk = 0;
+    uint64_t endChunk = 0;
+    auto createTask = [&](uint64_t rl, uint64_t ru) -> Task* {
+        return new CompiledPipelineTask<DenseMatrix<VT>>(CompiledPipelineTaskData<DenseMatrix<VT>>{funcs, isScalar,
+                inputs, numInputs, numOutputs, outRows, outCols, splits, combines, rl, ru, outRows,
+                outCols, 0, ctx}, resLock, res);
+    };
+    if(lp.isAdaptive() && !this->_numCUDAThreads) {
+        this->executeSelfScheduled(this->getWorkerPool(verbose), lp, 0, createTask, batchSize8M);
+        return;
+    }
+    while (lp.hasNextChunk()) {
+        endChunk += lp.getNextChunk();
+        tasks.push_back(createTask(startChunk, endChunk));
+        taskStarts.push_back(startChunk);
+        startChunk = endChunk;
+    }
 
 #ifdef USE_CUDA
     if(this->_numCUDAThreads) {
+        // CPU and CUDA workers share a single queue to balance the load across device types
+        std::unique_ptr<TaskQueue> q = createTaskQueue(ctx->config.taskQueueType, len);
+        this->initCPPWorkers(q.get(), batchSize8M, verbose);
         this->initCUDAWorkers(q.get(), batchSize8M * 4, verbose);
         this->cudaPrefetchInputs(inputs, numInputs, mem_required, splits);
 #ifndef NDEBUG
         std::cout << "Required memory (ins/outs): " << mem_required << "\nRequired mem/row: " << row_mem << std::endl;
         std::cout << "batchsizeCPU=" << batchSize8M << " batchsizeGPU=" << batchSize8M*4 << std::endl;
 #endif
+        for(auto* t : tasks)
+            q->enqueueTask(t);
+        q->closeInput();
+
+        this->joinAll();
+        return;
     }
 #endif
 
-    // lock for aggregation combine
-    // TODO: multiple locks per output
-    std::mutex resLock;
+    auto pool = this->getWorkerPool(verbose);
+    if(pool->getNumNodes() > 1) {
+        // place the output rows on the nodes that will produce them and
+        // submit each task to the node owning its rows
+        this->firstTouchOutputs(pool, res, freshOutputs, combines, len);
+        std::vector<uint32_t> taskNodes;
+        for(auto rl : taskStarts)
+            taskNodes.push_back(this->nodeOfRow(rl, len, pool->getNumNodes()));
+        pool->execute(tasks, batchSize8M, &taskNodes);
+    }
+    else
+        pool->execute(tasks, batchSize8M);
+}
 
-    // create tasks and close input
-    uint64_t startChunk = 0;
-    uint64_t endChunk = 0;
-    int method=ctx->config.taskPartitioningScheme;
-    int chunkParam = ctx->config.minimumTaskSize;
-    if(chunkParam<=0)
-        chunkParam=1;
-    LoadPartitioning lp(method, len, chunkParam, this->_numThreads, false);
-    while (lp.hasNextChunk()) {
-        endChunk += lp.getNextChunk();
-        q->enqueueTask(new CompiledPipelineTask<DenseMatrix<VT>>(CompiledPipelineTaskData<DenseMatrix<VT>>{funcs, isScalar,
-                inputs, numInputs, numOutputs, outRows, outCols, splits, combines, startChunk, endChunk, outRows,
-                outCols, 0, ctx}, resLock, res));
-        startChunk = endChunk;
+template<typename VT>
+size_t MTWrapper<DenseMatrix<VT>>::allocateUntouchedOutputs(DenseMatrix<VT>*** res, size_t numOutputs,
+        const int64_t* outRows, const int64_t* outCols, const VectorCombine* combines) {
+    auto mem_required = 0ul;
+    for(size_t i = 0; i < numOutputs; ++i) {
+        if((*res[i]) == nullptr && outRows[i] != -1 && outCols[i] != -1 && combines[i] == VectorCombine::ROWS) {
+            auto values = BufferPool::instance().allocateUntouched<VT[]>(outRows[i] * outCols[i]);
+            (*res[i]) = DataObjectFactory::create<DenseMatrix<VT>>(outRows[i], outCols[i], values);
+            mem_required += (*res[i])->bufferSize();
+        }
     }
-    q->closeInput();
+    return mem_required;
+}
 
-    this->joinAll();
+template<typename VT>
+void MTWrapper<DenseMatrix<VT>>::firstTouchOutputs(WorkerPool* pool, DenseMatrix<VT>*** res,
+        const std::vector<bool>& freshOutputs, const VectorCombine* combines, uint64_t len) {
+    // Only row-wise combined outputs are partitioned like the tasks, all
+    // other outputs are written by all nodes.
+    auto numNodes = pool->getNumNodes();
+    auto piecesPerNode = std::max(1u, pool->getNumWorkers() / numNodes);
+    std::vector<Task*> tasks;
+    std::vector<uint32_t> nodes;
+    for(size_t o = 0; o < freshOutputs.size(); ++o) {
+        if(!freshOutputs[o] || combines[o] != VectorCombine::ROWS)
+            continue;
+        auto* out = *res[o];
+        auto* values = out->getValues();
+        auto rowBytes = out->getRowSkip() * sizeof(VT);
+        for(uint32_t node = 0; node < numNodes; ++node) {
+            // exactly the rows r with nodeOfRow(r) == node
+            uint64_t nodeStart = (node * len + numNodes - 1) / numNodes;
+            uint64_t nodeEnd = ((node + 1) * len + numNodes - 1) / numNodes;
+            for(uint32_t p = 0; p < piecesPerNode; ++p) {
+                uint64_t rl = nodeStart + (nodeEnd - nodeStart) * p / piecesPerNode;
+                uint64_t ru = nodeStart + (nodeEnd - nodeStart) * (p + 1) / piecesPerNode;
+                if(rl == ru)
+                    continue;
+                tasks.push_back(new FirstTouchTask(values + rl * out->getRowSkip(), (ru - rl) * rowBytes));
+                nodes.push_back(node);
+            }
+        }
+    }
+    pool->execute(tasks, 0, &nodes);
 }
 
 template<typename VT>
@@ -93,7 +173,7 @@ template<typename VT>
     float taskRatioCUDA = 0.25f;
     auto gpu_task_len = static_cast<size_t>(std::ceil(static_cast<float>(len) * taskRatioCUDA));
     device_task_len += gpu_task_len;
-    std::unique_ptr<TaskQueue> q_cuda = std::make_unique<BlockingTaskQueue>(gpu_task_len);
+    std::unique_ptr<TaskQueue> q_cuda = createTaskQueue(ctx->config.taskQueueType, gpu_task_len);
     this->initCUDAWorkers(q_cuda.get(), batchSize8M * 4, verbose);
 
     auto*** res_cuda = new DenseMatrix<VT>**[numOutputs];
@@ -127,10 +207,8 @@ template<typename VT>
 
     auto cpu_task_len = len - device_task_len;
     DenseMatrix<VT> ***res_cpp{};
-    std::unique_ptr<TaskQueue> q_cpp;
+    TaskGroup cpuTasks;
     if(cpu_task_len > 0) {
-        q_cpp = std::make_unique<BlockingTaskQueue>(cpu_task_len);
-        this->initCPPWorkers(q_cpp.get(), batchSize8M, verbose);
         res_cpp = new DenseMatrix<VT> **[numOutputs];
         auto offset = device_task_len;
 
@@ -154,16 +232,18 @@ template<typename VT>
         if(chunkParam<=0)
             chunkParam=1;
         LoadPartitioning lp(method, len, chunkParam, this->_numThreads, false);
+        std::vector<Task*> tasks;
         while (lp.hasNextChunk()) {
             endChunk += lp.getNextChunk();
-            q_cpp->enqueueTask(new CompiledPipelineTask<DenseMatrix<VT>>(CompiledPipelineTaskData<DenseMatrix<VT>>{
+            tasks.push_back(new CompiledPipelineTask<DenseMatrix<VT>>(CompiledPipelineTaskData<DenseMatrix<VT>>{
                     funcs, isScalar, inputs, numInputs, numOutputs, outRows, outCols, splits, combines, startChunk, endChunk,
                     outRows, outCols, offset, ctx}, resLock, res_cpp));
             startChunk = endChunk;
         }
-        q_cpp->closeInput();
+        this->getWorkerPool(verbose)->submit(tasks, batchSize8M, cpuTasks);
     }
     this->joinAll();
+    cpuTasks.wait();
 
 #ifdef USE_CUDA
     this->combineOutputs(res, res_cuda, numOutputs, combines);
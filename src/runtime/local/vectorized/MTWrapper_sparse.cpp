@@ -29,12 +29,7 @@ void MTWrapper<CSRMatrix<VT>>::executeSingleQueue(std::vector<std::function<void
     // ToDo: sparse output mem requirements
     auto row_mem = mem_required / len;
 
-    // create task queue (w/o size-based blocking)
-    std::unique_ptr<TaskQueue> q = std::make_unique<BlockingTaskQueue>(len);
-
     auto batchSize8M = std::max(100ul, static_cast<size_t>(std::ceil(8388608 / row_mem)));
-    this->initCPPWorkers(q.get(), batchSize8M, verbose);
-
 
     for(size_t i = 0; i < numOutputs; i++)
         if(*(res[i]) != nullptr)
@@ -47,7 +42,8 @@ void MTWrapper<CSRMatrix<VT>>::executeSingleQueue(std::vector<std::function<void
     // lock for aggregation combine
     // TODO: multiple locks per output
 
-    // create tasks and close input
+    // create tasks
+    std::vector<Task*> tasks;
     uint64_t startChunk = 0;
     uint64_t endChunk = 0;
     int method=ctx->config.taskPartitioningScheme;
@@ -55,16 +51,21 @@ void MTWrapper<CSRMatrix<VT>>::executeSingleQueue(std::vector<std::function<void
     if(chunkParam<=0)
         chunkParam=1;
     LoadPartitioning lp(method, len, chunkParam, this->_numThreads, false);
-    while (lp.hasNextChunk()) {
-        endChunk += lp.getNextChunk();
-        q->enqueueTask(new CompiledPipelineTask<CSRMatrix<VT>>(CompiledPipelineTaskData<CSRMatrix<VT>>{funcs, isScalar,
-                inputs, numInputs, numOutputs, outRows, outCols, splits, combines, startChunk, endChunk, outRows,
-                outCols, 0, ctx}, dataSinks));
-        startChunk = endChunk;
+    auto createTask = [&](uint64_t rl, uint64_t ru) -> Task* {
+        return new CompiledPipelineTask<CSRMatrix<VT>>(CompiledPipelineTaskData<CSRMatrix<VT>>{funcs, isScalar,
+                inputs, numInputs, numOutputs, outRows, outCols, splits, combines, rl, ru, outRows,
+                outCols, 0, ctx}, dataSinks);
+    };
+    if(lp.isAdaptive())
+        this->executeSelfScheduled(this->getWorkerPool(verbose), lp, 0, createTask, batchSize8M);
+    else {
+        while (lp.hasNextChunk()) {
+            endChunk += lp.getNextChunk();
+            tasks.push_back(createTask(startChunk, endChunk));
+            startChunk = endChunk;
+        }
+        this->getWorkerPool(verbose)->execute(tasks, batchSize8M);
     }
-    q->closeInput();
-
-    this->joinAll();
     for(size_t i = 0; i < numOutputs; i++) {
         *(res[i]) = dataSinks[i]->consume();
         delete dataSinks[i];
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cstdint>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/**
+ * @brief The CPUs of each NUMA node of the machine.
+ *
+ * Read from sysfs, so no dependency on libnuma is required. On systems where
+ * the topology cannot be determined, all CPUs are considered to belong to a
+ * single node.
+ */
+struct NumaTopology {
+    std::vector<std::vector<uint32_t>> nodeCpus;
+
+    [[nodiscard]] uint32_t getNumNodes() const { return static_cast<uint32_t>(nodeCpus.size()); }
+
+    /**
+     * @brief Parses a Linux CPU list like `0-3,8-11`.
+     */
+    static std::vector<uint32_t> parseCpuList(const std::string& list) {
+        std::vector<uint32_t> cpus;
+        std::stringstream ss(list);
+        std::string range;
+        while(std::getline(ss, range, ',')) {
+            if(range.empty() || range == "\n")
+                continue;
+            auto dash = range.find('-');
+            auto first = static_cast<uint32_t>(std::stoul(range.substr(0, dash)));
+            auto last = dash == std::string::npos ? first : static_cast<uint32_t>(std::stoul(range.substr(dash + 1)));
+            for(auto cpu = first; cpu <= last; cpu++)
+                cpus.push_back(cpu);
+        }
+        return cpus;
+    }
+
+    static NumaTopology detect() {
+        NumaTopology topo;
+        for(uint32_t node = 0; ; node++) {
+            std::ifstream ifs("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            if(!ifs.good())
+                break;
+            std::string list;
+            std::getline(ifs, list);
+            auto cpus = parseCpuList(list);
+            // memory-only nodes have no CPUs to run workers on
+            if(!cpus.empty())
+                topo.nodeCpus.push_back(cpus);
+        }
+        if(topo.nodeCpus.empty()) {
+            topo.nodeCpus.emplace_back();
+            for(uint32_t cpu = 0; cpu < std::thread::hardware_concurrency(); cpu++)
+                topo.nodeCpus[0].push_back(cpu);
+        }
+        return topo;
+    }
+
+    /**
+     * @brief Restricts the given thread to the CPUs of the given node.
+     *
+     * @return `true` if the affinity could be set.
+     */
+    bool pinToNode(std::thread& t, uint32_t node) const {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for(auto cpu : nodeCpus[node])
+            CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(t.native_handle(), sizeof(cpu_set_t), &set) == 0;
+#else
+        return false;
+#endif
+    }
+};
@@ -0,0 +1,30 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+/**
+ * @brief The implementation of `TaskQueue` used by the vectorized execution
+ * engine.
+ *
+ * Kept separate from `TaskQueues.h` such that the user config does not need
+ * to include the task definitions.
+ */
+enum class TaskQueueType {
+    BLOCKING = 0, // mutex and condition variable around a std::list
+    LOCKFREE,     // bounded lock-free MPMC ring buffer
+    INVALID = -1  // only for JSON enum conversion
+};
@@ -17,10 +17,17 @@
 #ifndef SRC_RUNTIME_LOCAL_VECTORIZED_TASKQUEUES_H
 #define SRC_RUNTIME_LOCAL_VECTORIZED_TASKQUEUES_H
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <list>
+#include <memory>
 #include <mutex>
+#include <stdexcept>
 #include <condition_variable>
+#include <thread>
 #include <runtime/local/vectorized/Tasks.h>
+#include <runtime/local/vectorized/TaskQueueType.h>
 
 const uint64_t DEFAULT_MAX_SIZE = 100000;
 
@@ -30,6 +37,13 @@ public:
 
     virtual void enqueueTask(Task* t) = 0;
     virtual Task* dequeueTask() = 0;
+    /**
+     * @brief Non-blocking dequeue of up to `maxTasks` tasks at once.
+     *
+     * @return The number of tasks written to `tasks`; zero if the queue is
+     * currently empty (never returns the EOF marker).
+     */
+    virtual size_t tryDequeueTasks(Task** tasks, size_t maxTasks) = 0;
     virtual uint64_t size() = 0;
     virtual void closeInput() = 0;
 };
@@ -80,6 +94,18 @@ public:
         return t;
     }
 
+    size_t tryDequeueTasks(Task** tasks, size_t maxTasks) override {
+        std::unique_lock<std::mutex> ul(_qmutex);
+        size_t n = 0;
+        while( n < maxTasks && !_data.empty() ) {
+            tasks[n++] = _data.front();
+            _data.pop_front();
+        }
+        if( n )
+            _cv.notify_one();
+        return n;
+    }
+
     uint64_t size() override {
         std::unique_lock<std::mutex> lu(_qmutex);
         return _data.size();
@@ -92,4 +118,176 @@ public:
     }
 };
 
+/**
+ * @brief A bounded lock-free multi-producer/multi-consumer task queue.
+ *
+ * Ring buffer of cells with per-cell sequence numbers (after D. Vyukov), so
+ * enqueue and dequeue only contend on a single atomic position each and never
+ * allocate. Blocking operations spin for a while and then park on a condition
+ * variable, which is only touched if some thread is actually parked.
+ */
+class LockFreeTaskQueue : public TaskQueue {
+private:
+    struct Cell {
+        std::atomic<uint64_t> seq;
+        Task* task;
+    };
+
+    static constexpr uint32_t SPIN_LIMIT = 1024;
+
+    std::unique_ptr<Cell[]> _cells;
+    uint64_t _mask;
+    alignas(64) std::atomic<uint64_t> _enqueuePos{0};
+    alignas(64) std::atomic<uint64_t> _dequeuePos{0};
+    alignas(64) std::atomic<bool> _closedInput{false};
+    std::atomic<uint32_t> _numParked{0};
+    std::mutex _parkMutex;
+    std::condition_variable _parkCv;
+    EOFTask _eof; //end marker
+
+    static uint64_t roundUpToPowerOf2(uint64_t v) {
+        uint64_t p = 2;
+        while( p < v )
+            p <<= 1;
+        return p;
+    }
+
+    bool tryEnqueue(Task* t) {
+        uint64_t pos = _enqueuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        while( true ) {
+            cell = &_cells[pos & _mask];
+            auto dif = static_cast<int64_t>(cell->seq.load(std::memory_order_acquire)) - static_cast<int64_t>(pos);
+            if( dif == 0 ) {
+                if( _enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed) )
+                    break;
+            }
+            else if( dif < 0 )
+                return false; // full
+            else
+                pos = _enqueuePos.load(std::memory_order_relaxed);
+        }
+        cell->task = t;
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Wakes up parked producers or consumers after the state of the queue changed.
+    void unpark() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if( _numParked.load(std::memory_order_relaxed) ) {
+            std::lock_guard<std::mutex> lg(_parkMutex);
+            _parkCv.notify_all();
+        }
+    }
+
+    // Parks the calling thread until the given condition holds. The timeout
+    // only guards against missed notifications.
+    template<class Pred>
+    void park(Pred ready) {
+        std::unique_lock<std::mutex> ul(_parkMutex);
+        _numParked.fetch_add(1, std::memory_order_seq_cst);
+        _parkCv.wait_for(ul, std::chrono::milliseconds(1), ready);
+        _numParked.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+public:
+    LockFreeTaskQueue() : LockFreeTaskQueue(DEFAULT_MAX_SIZE) {}
+    explicit LockFreeTaskQueue(uint64_t capacity) {
+        auto numCells = roundUpToPowerOf2(capacity);
+        _cells = std::make_unique<Cell[]>(numCells);
+        for( uint64_t i = 0; i < numCells; i++ )
+            _cells[i].seq.store(i, std::memory_order_relaxed);
+        _mask = numCells - 1;
+    }
+    ~LockFreeTaskQueue() override = default;
+
+    void enqueueTask(Task* t) override {
+        uint32_t spins = 0;
+        while( !tryEnqueue(t) ) {
+            if( ++spins < SPIN_LIMIT )
+                std::this_thread::yield();
+            else
+                park([this] { return size() <= _mask; });
+        }
+        unpark();
+    }
+
+    Task* dequeueTask() override {
+        Task* t = nullptr;
+        uint32_t spins = 0;
+        while( !tryDequeueTasks(&t, 1) ) {
+            if( _closedInput.load(std::memory_order_acquire) ) {
+                // all tasks were enqueued before closing, so check once more
+                if( tryDequeueTasks(&t, 1) )
+                    return t;
+                return &_eof;
+            }
+            if( ++spins < SPIN_LIMIT )
+                std::this_thread::yield();
+            else
+                park([this] { return size() > 0 || _closedInput.load(std::memory_order_acquire); });
+        }
+        return t;
+    }
+
+    size_t tryDequeueTasks(Task** tasks, size_t maxTasks) override {
+        uint64_t pos = _dequeuePos.load(std::memory_order_relaxed);
+        size_t n;
+        while( true ) {
+            // determine how many consecutive cells starting at pos are ready
+            n = 0;
+            while( n < maxTasks ) {
+                auto seq = _cells[(pos + n) & _mask].seq.load(std::memory_order_acquire);
+                auto dif = static_cast<int64_t>(seq) - static_cast<int64_t>(pos + n + 1);
+                if( dif != 0 )
+                    break;
+                n++;
+            }
+            if( n == 0 ) {
+                auto seq = _cells[pos & _mask].seq.load(std::memory_order_acquire);
+                if( static_cast<int64_t>(seq) - static_cast<int64_t>(pos + 1) < 0 )
+                    return 0; // empty
+                pos = _dequeuePos.load(std::memory_order_relaxed);
+                continue;
+            }
+            // claim the ready cells at once
+            if( _dequeuePos.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed) )
+                break;
+        }
+        for( size_t i = 0; i < n; i++ ) {
+            Cell& cell = _cells[(pos + i) & _mask];
+            tasks[i] = cell.task;
+            cell.seq.store(pos + i + _mask + 1, std::memory_order_release);
+        }
+        unpark();
+        return n;
+    }
+
+    uint64_t size() override {
+        auto enq = _enqueuePos.load(std::memory_order_acquire);
+        auto deq = _dequeuePos.load(std::memory_order_acquire);
+        return enq > deq ? enq - deq : 0;
+    }
+
+    void closeInput() override {
+        _closedInput.store(true, std::memory_order_release);
+        std::lock_guard<std::mutex> lg(_parkMutex);
+        _parkCv.notify_all();
+    }
+};
+
+inline std::unique_ptr<TaskQueue> createTaskQueue(TaskQueueType type, uint64_t capacity) {
+    switch( type ) {
+        case TaskQueueType::LOCKFREE:
+            // The ring buffer is preallocated, so do not size it by a (potentially huge) number of rows; producers
+            // simply wait for free cells if it is full.
+            return std::make_unique<LockFreeTaskQueue>(std::min(capacity, DEFAULT_MAX_SIZE));
+        case TaskQueueType::BLOCKING:
+            return std::make_unique<BlockingTaskQueue>(capacity);
+        default:
+            throw std::runtime_error("unsupported task queue type");
+    }
+}
+
 #endif //SRC_RUNTIME_LOCAL_VECTORIZED_TASKQUEUES_H
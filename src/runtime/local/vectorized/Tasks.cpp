@@ -16,87 +16,72 @@
 
 #include "runtime/local/vectorized/Tasks.h"
 #include "runtime/local/kernels/EwBinaryMat.h"
+#include "runtime/local/instrumentation/Profiler.h"
 
 template<typename VT>
 void CompiledPipelineTask<DenseMatrix<VT>>::execute(uint32_t fid, uint32_t batchSize) {
+    if(auto profiler = _data._ctx->config.profiler.get())
+        profiler->countRows(_data._ru - _data._rl);
+    std::vector<VectorizedDataSink<DenseMatrix<VT>>> sinks;
+    sinks.reserve(_data._numOutputs);
+    for(size_t o = 0; o < _data._numOutputs; ++o)
+        sinks.emplace_back(_data._combines[o], *_res[o], _resLock, _data._ctx);
     // local add aggregation to minimize locking
     std::vector<DenseMatrix<VT>*> localAddRes(_data._numOutputs);
     std::vector<DenseMatrix<VT>*> localResults(_data._numOutputs);
     std::vector<DenseMatrix<VT>**> outputs;
     for (auto &lres : localResults)
         outputs.push_back(&lres);
+    // views of the result the pipeline can write a batch of a row-wise
+    // combined output to
+    std::vector<DenseMatrix<VT>*> resultViews(_data._numOutputs);
     for(uint64_t r = _data._rl ; r < _data._ru ; r += batchSize) {
         //create zero-copy views of inputs/outputs
         uint64_t r2 = std::min(r + batchSize, _data._ru);
         
         auto linputs = this->createFuncInputs(r, r2);
+        for(size_t o = 0; o < _data._numOutputs; ++o) {
+            resultViews[o] = sinks[o].getView(r - _data._offset, r2 - _data._offset);
+            localResults[o] = resultViews[o];
+        }
         
         //execute function on given data binding (batch size)
         _data._funcs[fid](outputs.data(), linputs.data(), _data._ctx);
-        accumulateOutputs(localResults, localAddRes, r, r2);
+        // Pipelines whose output is produced by a kernel writing to the given
+        // view have already put it in place, all others replaced the view.
+        for(size_t o = 0; o < _data._numOutputs; ++o)
+            if(resultViews[o] && localResults[o] != resultViews[o])
+                DataObjectFactory::destroy(resultViews[o]);
+        accumulateOutputs(sinks, localResults, localAddRes, r);
         
         // cleanup
-        for (auto &localResult : localResults)
-            if(localResult) {
-                DataObjectFactory::destroy(localResult);
-                localResult = nullptr;
+        for(size_t o = 0; o < _data._numOutputs; ++o) {
+            if(localResults[o]) {
+                DataObjectFactory::destroy(localResults[o]);
+                localResults[o] = nullptr;
             }
+        }
         
         // Note that a pipeline manages the reference counters of its inputs
         // internally. Thus, we do not need to care about freeing the inputs
         // here.
     }
     
-    for(size_t o = 0; o < _data._numOutputs; ++o) {
-        if(_data._combines[o] == VectorCombine::ADD) {
-            auto &result = (*_res[o]);
-            _resLock.lock();
-            if(result == nullptr) {
-                result = localAddRes[o];
-                _resLock.unlock();
-            }
-            else {
-                ewBinaryMat(BinaryOpCode::ADD, result, result, localAddRes[o], _data._ctx);
-                _resLock.unlock();
-                //cleanup
-                DataObjectFactory::destroy(localAddRes[o]);
-            }
-        }
-    }
+    for(size_t o = 0; o < _data._numOutputs; ++o)
+        if(_data._combines[o] == VectorCombine::ADD)
+            sinks[o].add(localAddRes[o], 0);
 }
 
 template<typename VT>
-void CompiledPipelineTask<DenseMatrix<VT>>::accumulateOutputs(std::vector<DenseMatrix<VT> *> &localResults,
-        std::vector<DenseMatrix<VT> *> &localAddRes, uint64_t rowStart, uint64_t rowEnd) {
-    //TODO: in-place computation via better compiled pipelines
+void CompiledPipelineTask<DenseMatrix<VT>>::accumulateOutputs(std::vector<VectorizedDataSink<DenseMatrix<VT>>> &sinks,
+        std::vector<DenseMatrix<VT> *> &localResults, std::vector<DenseMatrix<VT> *> &localAddRes, uint64_t rowStart) {
     //TODO: multi-return
     for(auto o = 0u ; o < _data._numOutputs ; ++o) {
-        auto &result = (*_res[o]);
         switch (_data._combines[o]) {
-            case VectorCombine::ROWS: {
-                rowStart -= _data._offset;
-                rowEnd -= _data._offset;
-                auto slice = result->sliceRow(rowStart, rowEnd);
-                // TODO It's probably more efficient to memcpy than to get/set.
-                // But eventually, we don't want to copy at all.
-                for(auto i = 0u ; i < slice->getNumRows() ; ++i) {
-                    for(auto j = 0u ; j < slice->getNumCols() ; ++j) {
-                        slice->set(i, j, localResults[o]->get(i, j));
-                    }
-                }
-                DataObjectFactory::destroy(slice);
-                break;
-            }
+            case VectorCombine::ROWS:
             case VectorCombine::COLS: {
-                auto slice = result->sliceCol(rowStart-_data._offset, rowEnd-_data._offset);
-                // TODO It's probably more efficient to memcpy than to get/set.
-                // But eventually, we don't want to copy at all.
-                for(auto i = 0u ; i < slice->getNumRows() ; ++i) {
-                    for(auto j = 0u ; j < slice->getNumCols() ; ++j) {
-                        slice->set(i, j, localResults[o]->get(i, j));
-                    }
-                }
-                DataObjectFactory::destroy(slice);
+                sinks[o].add(localResults[o], rowStart - _data._offset);
+                localResults[o] = nullptr;
                 break;
             }
             case VectorCombine::ADD: {
@@ -120,6 +105,8 @@ void CompiledPipelineTask<DenseMatrix<VT>>::accumulateOutputs(std::vector<DenseM
 
 template<typename VT>
 void CompiledPipelineTask<CSRMatrix<VT>>::execute(uint32_t fid, uint32_t batchSize) {
+    if(auto profiler = _data._ctx->config.profiler.get())
+        profiler->countRows(_data._ru - _data._rl);
     std::vector<size_t> localResNumRows(_data._numOutputs);
     std::vector<size_t> localResNumCols(_data._numOutputs);
     for(size_t i = 0; i < _data._numOutputs; i++) {
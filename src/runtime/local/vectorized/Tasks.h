@@ -19,14 +19,18 @@
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/kernels/EwBinaryMat.h>
+#include <runtime/local/vectorized/LoadPartitioning.h>
 #include <runtime/local/vectorized/VectorizedDataSink.h>
 #include <runtime/local/context/DaphneContext.h>
 #include <ir/daphneir/Daphne.h>
 
+#include <chrono>
 #include <functional>
 #include <vector>
 #include <mutex>
 
+#include <cstring>
+
 using mlir::daphne::VectorSplit;
 using mlir::daphne::VectorCombine;
 
@@ -45,6 +49,61 @@ public:
     void execute(uint32_t fid, uint32_t batchSize) override {}
 };
 
+// task zeroing a memory range, such that its pages are first touched (and thus
+// placed on the NUMA node) by the executing worker
+class FirstTouchTask : public Task {
+    void* _ptr;
+    size_t _numBytes;
+public:
+    FirstTouchTask(void* ptr, size_t numBytes) : _ptr(ptr), _numBytes(numBytes) {}
+    ~FirstTouchTask() override = default;
+    void execute(uint32_t fid, uint32_t batchSize) override {
+        std::memset(_ptr, 0, _numBytes);
+    }
+};
+
+// state shared by the self-scheduling tasks of one pipeline
+struct SelfScheduler {
+    LoadPartitioning lp;
+    uint64_t nextRow;
+    std::mutex mtx;
+
+    SelfScheduler(LoadPartitioning lp, uint64_t startRow) : lp(std::move(lp)), nextRow(startRow) {}
+};
+
+// task acting as one worker of an adaptive self-scheduling scheme: requests
+// chunks on demand, executes them, and reports their execution time back
+class SelfSchedulingTask : public Task {
+    SelfScheduler& _sched;
+    uint32_t _worker;
+    std::function<Task*(uint64_t, uint64_t)> _createTask;
+public:
+    SelfSchedulingTask(SelfScheduler& sched, uint32_t worker, std::function<Task*(uint64_t, uint64_t)> createTask)
+            : _sched(sched), _worker(worker), _createTask(std::move(createTask)) {}
+    ~SelfSchedulingTask() override = default;
+    void execute(uint32_t fid, uint32_t batchSize) override {
+        uint64_t rl = 0, ru = 0;
+        double seconds = 0;
+        while(true) {
+            {
+                std::lock_guard<std::mutex> lg(_sched.mtx);
+                if(ru > rl)
+                    _sched.lp.recordChunk(_worker, ru - rl, seconds);
+                if(!_sched.lp.hasNextChunk())
+                    return;
+                rl = _sched.nextRow;
+                ru = rl + _sched.lp.getNextChunk(_worker);
+                _sched.nextRow = ru;
+            }
+            auto start = std::chrono::steady_clock::now();
+            Task* t = _createTask(rl, ru);
+            t->execute(fid, batchSize);
+            delete t;
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+};
+
 template<class DT>
 struct CompiledPipelineTaskData {
     std::vector<std::function<void(DT ***, Structure **, DCTX(ctx))>> _funcs;
@@ -94,10 +153,8 @@ protected:
                 // pipeline manages the reference counter itself.
                 // This might be a scalar disguised as a Structure*.
                 if(!_data._isScalar[i])
-                    // Note that increaseRefCounter() synchronizes the access
-                    // via a std::mutex. If that turns out to slow down things,
-                    // creating a shallow copy of the input would be an
-                    // alternative.
+                    // Note that increaseRefCounter() is an atomic operation,
+                    // which all workers perform on the same input.
                     _data._inputs[i]->increaseRefCounter();
             }
             else if (VectorSplit::ROWS == _data._splits[i]) {
@@ -126,8 +183,9 @@ public:
     void execute(uint32_t fid, uint32_t batchSize) override;
 
 private:
-    void accumulateOutputs(std::vector<DenseMatrix<VT>*>& localResults, std::vector<DenseMatrix<VT> *> &localAddRes,
-            uint64_t rowStart, uint64_t rowEnd);
+    void accumulateOutputs(std::vector<VectorizedDataSink<DenseMatrix<VT>>>& sinks,
+            std::vector<DenseMatrix<VT>*>& localResults, std::vector<DenseMatrix<VT> *> &localAddRes,
+            uint64_t rowStart);
 };
 
 template<typename VT>
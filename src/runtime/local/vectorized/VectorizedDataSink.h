@@ -17,12 +17,18 @@
 #pragma once
 
 #include <ir/daphneir/Daphne.h>
+#include <runtime/local/context/DaphneContext.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/EwBinaryMat.h>
 #include <runtime/local/kernels/Transpose.h>
 #include <util/preprocessor_defs.h>
 
 #include <mutex>
 #include <queue>
 
+#include <cstring>
+
 using mlir::daphne::VectorCombine;
 
 template<typename DT>
@@ -31,7 +37,98 @@ public:
     void add(DT *matrix, size_t startRow) = delete;
 };
 
-// TODO: VectorizedDataSink for DenseMatrix
+/**
+ * @brief Combines the partial results of a vectorized pipeline into a dense
+ * result.
+ *
+ * For ROWS and COLS combines, the result is allocated before the pipeline
+ * runs. The partial results cover disjoint parts of it and are copied there
+ * without locking. A pipeline may also compute its rows of a ROWS-combined
+ * result in place, in a view obtained by `getView`. For ADD combines, the
+ * partial results are summed up under the given lock, and the first one
+ * becomes the result, unless it already exists.
+ */
+template<typename VT>
+class VectorizedDataSink<DenseMatrix<VT>> {
+    VectorCombine _combine;
+    DenseMatrix<VT> *&_res;
+    std::mutex &_mtx;
+    DCTX(_ctx);
+public:
+    VectorizedDataSink(VectorCombine combine, DenseMatrix<VT> *&res, std::mutex &mtx, DCTX(ctx))
+        : _combine(combine), _res(res), _mtx(mtx), _ctx(ctx) {}
+
+    /**
+     * @brief Copies `src` into `dst` (of the same shape) with one `memcpy`
+     * per row, or a single one if both are contiguous.
+     */
+    static void copy(DenseMatrix<VT> *dst, const DenseMatrix<VT> *src) {
+        const size_t numRows = src->getNumRows();
+        const size_t numCols = src->getNumCols();
+        const size_t rowSkipDst = dst->getRowSkip();
+        const size_t rowSkipSrc = src->getRowSkip();
+        VT *valuesDst = dst->getValues();
+        const VT *valuesSrc = src->getValues();
+        if(valuesDst == valuesSrc && rowSkipDst == rowSkipSrc)
+            return; // already written in place
+        if(rowSkipDst == numCols && rowSkipSrc == numCols)
+            std::memcpy(valuesDst, valuesSrc, numRows * numCols * sizeof(VT));
+        else
+            for(size_t r = 0; r < numRows; r++) {
+                std::memcpy(valuesDst, valuesSrc, numCols * sizeof(VT));
+                valuesDst += rowSkipDst;
+                valuesSrc += rowSkipSrc;
+            }
+    }
+
+    /**
+     * @brief A view of the rows `rowStart` to `rowEnd` of a ROWS-combined
+     * result, such that they can be computed in place, or `nullptr` for
+     * other combines.
+     */
+    DenseMatrix<VT> *getView(uint64_t rowStart, uint64_t rowEnd) {
+        if(_combine != VectorCombine::ROWS)
+            return nullptr;
+        return _res->sliceRow(rowStart, rowEnd);
+    }
+
+    /**
+     * @brief Combines a partial result into the result and takes its
+     * ownership.
+     *
+     * @param matrix The partial result, which may be a view from `getView`.
+     * @param start The first row (ROWS) or column (COLS) of the result the
+     * partial result belongs to, ignored for ADD.
+     */
+    void add(DenseMatrix<VT> *matrix, uint64_t start) {
+        switch (_combine) {
+        case VectorCombine::ROWS:
+        case VectorCombine::COLS: {
+            auto *slice = _combine == VectorCombine::ROWS
+                    ? _res->sliceRow(start, start + matrix->getNumRows())
+                    : _res->sliceCol(start, start + matrix->getNumCols());
+            copy(slice, matrix);
+            DataObjectFactory::destroy(slice);
+            DataObjectFactory::destroy(matrix);
+            break;
+        }
+        case VectorCombine::ADD: {
+            std::lock_guard<std::mutex> lock(_mtx);
+            if(_res == nullptr)
+                _res = matrix;
+            else {
+                ewBinaryMat(BinaryOpCode::ADD, _res, _res, matrix, _ctx);
+                DataObjectFactory::destroy(matrix);
+            }
+            break;
+        }
+        default: {
+            throw std::runtime_error("VectorCombine case `"
+                    + std::to_string(static_cast<int64_t>(_combine)) + "` not supported");
+        }
+        }
+    }
+};
 
 template<typename VT>
 class VectorizedDataSink<CSRMatrix<VT>> {
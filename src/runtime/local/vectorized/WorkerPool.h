@@ -0,0 +1,289 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <runtime/local/instrumentation/Profiler.h>
+#include <runtime/local/vectorized/NumaTopology.h>
+#include <runtime/local/vectorized/TaskQueues.h>
+#include <runtime/local/vectorized/Tasks.h>
+#include <util/ParallelFor.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Tracks the completion of a set of tasks submitted to a `WorkerPool`.
+ *
+ * Each vectorized pipeline invocation uses its own group, such that it can
+ * wait for its own tasks while the pool's threads stay alive.
+ */
+class TaskGroup {
+    std::atomic<uint64_t> _pending{0};
+    std::mutex _mtx;
+    std::condition_variable _cv;
+
+public:
+    void add(uint64_t numTasks) {
+        _pending.fetch_add(numTasks, std::memory_order_relaxed);
+    }
+
+    void done() {
+        // The decrement happens under the lock, such that `wait` cannot see
+        // the group finished (and its owner destroy it) before we are done
+        // with the mutex and the condition variable.
+        std::lock_guard<std::mutex> lg(_mtx);
+        if(_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            _cv.notify_all();
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> ul(_mtx);
+        _cv.wait(ul, [this] { return _pending.load(std::memory_order_acquire) == 0; });
+    }
+};
+
+/**
+ * @brief Wraps a task submitted to a `WorkerPool` with the batch size of its
+ * pipeline and the group to notify once it has been executed.
+ *
+ * If profiling is enabled, it also records the execution of the task and how
+ * long it waited in the queue.
+ */
+class PoolTask : public Task {
+    Task* _task;
+    uint32_t _batchSize;
+    TaskGroup* _group;
+    Profiler* _profiler;
+    uint64_t _enqueued;
+
+public:
+    PoolTask(Task* task, uint32_t batchSize, TaskGroup* group, Profiler* profiler = nullptr)
+            : _task(task), _batchSize(batchSize), _group(group), _profiler(profiler),
+            _enqueued(profiler ? profiler->now() : 0) {}
+    ~PoolTask() override = default;
+
+    void execute(uint32_t fid, uint32_t batchSize) override {
+        if(_profiler) {
+            const uint64_t begin = _profiler->now();
+            _task->execute(fid, _batchSize);
+            _profiler->recordTask(begin, _profiler->now() - begin, begin - _enqueued);
+        }
+        else
+            _task->execute(fid, _batchSize);
+        delete _task;
+        _group->done();
+    }
+};
+
+/**
+ * @brief A process-wide pool of CPU worker threads for vectorized pipelines.
+ *
+ * The threads are started once and reused by all subsequent pipelines, such
+ * that the cost of spawning and joining threads is not paid per pipeline.
+ * Each worker owns a task queue (of the configured `TaskQueueType`).
+ * Submitted tasks are distributed round-robin over the queues, a worker takes
+ * up to `MAX_LOCAL_BATCH` tasks at once from its own queue and, once that is
+ * empty, steals single tasks from the other queues. Idle workers sleep until
+ * new tasks are submitted.
+ *
+ * In NUMA-aware mode, the workers are pinned to the CPUs of their NUMA node
+ * and all workers of a node share one queue. Tasks can be submitted to a
+ * particular node and are only stolen by other nodes once their own queue is
+ * exhausted.
+ */
+class WorkerPool {
+    static constexpr size_t MAX_LOCAL_BATCH = 8;
+    static constexpr uint64_t QUEUE_CAPACITY = 4096;
+
+    std::vector<std::unique_ptr<TaskQueue>> _queues;
+    std::vector<uint32_t> _workerQueue; // index of each worker's own queue
+    std::vector<std::thread> _threads;
+    uint32_t _numWorkers;
+    TaskQueueType _queueType;
+    bool _numaAware;
+    bool _verbose;
+    std::shared_ptr<Profiler> _profiler;
+
+    // number of tasks in all queues (may temporarily be negative, since
+    // workers can take tasks before the submitter updates it)
+    std::atomic<int64_t> _numQueued{0};
+    std::atomic<uint32_t> _nextQueue{0};
+    std::mutex _sleepMtx;
+    std::condition_variable _sleepCv;
+    bool _shutdown = false;
+
+    size_t steal(uint32_t own, Task** tasks) {
+        const auto numQueues = static_cast<uint32_t>(_queues.size());
+        for(uint32_t k = 1; k < numQueues; ++k)
+            if(_queues[(own + k) % numQueues]->tryDequeueTasks(tasks, 1))
+                return 1;
+        return 0;
+    }
+
+    void publish(int64_t numTasks) {
+        {
+            std::lock_guard<std::mutex> lg(_sleepMtx);
+            _numQueued.fetch_add(numTasks, std::memory_order_relaxed);
+        }
+        _sleepCv.notify_all();
+    }
+
+    void run(uint32_t id) {
+        Task* tasks[MAX_LOCAL_BATCH];
+        const uint32_t own = _workerQueue[id];
+        // kernels in the pipelines run single-threaded, the pool uses the cores
+        isVectorizedWorker = true;
+        if(_profiler)
+            _profiler->setThreadName("worker " + std::to_string(id));
+        // take a few tasks at once while there is plenty of local work, but
+        // leave enough of it for others to steal
+        while(true) {
+            auto& q = *_queues[own];
+            size_t batch = std::clamp<uint64_t>(q.size() / _numWorkers, 1, MAX_LOCAL_BATCH);
+            size_t n = q.tryDequeueTasks(tasks, batch);
+            if(!n)
+                n = steal(own, tasks);
+            if(n) {
+                _numQueued.fetch_sub(static_cast<int64_t>(n), std::memory_order_relaxed);
+                for(size_t i = 0; i < n; ++i) {
+                    if(_verbose)
+                        std::cerr << "WorkerPool: worker " << id << " executing task." << std::endl;
+                    tasks[i]->execute(0, 0);
+                    delete tasks[i];
+                }
+                continue;
+            }
+            std::unique_lock<std::mutex> ul(_sleepMtx);
+            const uint64_t idleBegin = _profiler ? _profiler->now() : 0;
+            _sleepCv.wait(ul, [this] { return _shutdown || _numQueued.load(std::memory_order_relaxed) > 0; });
+            if(_shutdown && _numQueued.load(std::memory_order_relaxed) <= 0)
+                break;
+            if(_profiler)
+                _profiler->recordIdle(idleBegin, _profiler->now() - idleBegin);
+        }
+        if(_verbose)
+            std::cerr << "WorkerPool: worker " << id << " finalized." << std::endl;
+    }
+
+public:
+    /**
+     * @param profiler The profiler to record the tasks and idle times of the
+     * workers to, if any.
+     */
+    WorkerPool(uint32_t numWorkers, TaskQueueType queueType, bool numaAware, bool verbose,
+            std::shared_ptr<Profiler> profiler = nullptr)
+            : _numWorkers(numWorkers), _queueType(queueType), _numaAware(numaAware), _verbose(verbose),
+            _profiler(std::move(profiler)) {
+        NumaTopology topo;
+        if(numaAware) {
+            topo = NumaTopology::detect();
+            // one queue per node that gets at least one worker
+            _queues.resize(std::min(topo.getNumNodes(), numWorkers));
+            // assign the workers block-wise to the nodes
+            for(uint32_t i = 0; i < numWorkers; ++i)
+                _workerQueue.push_back(static_cast<uint32_t>(uint64_t(i) * _queues.size() / numWorkers));
+        }
+        else {
+            _queues.resize(numWorkers);
+            for(uint32_t i = 0; i < numWorkers; ++i)
+                _workerQueue.push_back(i);
+        }
+        for(auto& q : _queues)
+            q = createTaskQueue(queueType, QUEUE_CAPACITY);
+
+        _threads.reserve(numWorkers);
+        for(uint32_t i = 0; i < numWorkers; ++i) {
+            _threads.emplace_back(&WorkerPool::run, this, i);
+            if(numaAware && !topo.pinToNode(_threads.back(), _workerQueue[i]) && _verbose)
+                std::cerr << "WorkerPool: could not pin worker " << i << " to NUMA node " << _workerQueue[i]
+                          << std::endl;
+        }
+    }
+
+    // The pool owns threads referring to it, so it must neither be copied nor moved.
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lg(_sleepMtx);
+            _shutdown = true;
+        }
+        _sleepCv.notify_all();
+        for(auto& t : _threads)
+            t.join();
+    }
+
+    [[nodiscard]] uint32_t getNumWorkers() const { return _numWorkers; }
+    [[nodiscard]] TaskQueueType getQueueType() const { return _queueType; }
+    [[nodiscard]] bool isNumaAware() const { return _numaAware; }
+    [[nodiscard]] Profiler* getProfiler() const { return _profiler.get(); }
+
+    /**
+     * @brief The number of NUMA nodes tasks can be submitted to (one if the
+     * pool is not NUMA-aware).
+     */
+    [[nodiscard]] uint32_t getNumNodes() const { return _numaAware ? static_cast<uint32_t>(_queues.size()) : 1; }
+
+    /**
+     * @brief Hands the given tasks over to the pool, which takes their
+     * ownership. Returns immediately; use `group.wait()` to wait for their
+     * completion.
+     *
+     * @param nodes Optional NUMA node (less than `getNumNodes()`) for each
+     * task; only considered if the pool is NUMA-aware.
+     */
+    void submit(const std::vector<Task*>& tasks, uint32_t batchSize, TaskGroup& group,
+            const std::vector<uint32_t>* nodes = nullptr) {
+        if(tasks.empty())
+            return;
+        group.add(tasks.size());
+        const bool useNodes = _numaAware && nodes;
+        const auto numQueues = static_cast<uint32_t>(_queues.size());
+        uint32_t next = _nextQueue.fetch_add(1, std::memory_order_relaxed);
+        // Publish the tasks once per round over all queues, such that
+        // workers already start while the remaining tasks are enqueued (the
+        // queues are bounded, so enqueueing may wait for the workers).
+        int64_t unpublished = 0;
+        for(size_t i = 0; i < tasks.size(); ++i) {
+            auto q = useNodes ? (*nodes)[i] : next++ % numQueues;
+            _queues[q]->enqueueTask(new PoolTask(tasks[i], batchSize, &group, _profiler.get()));
+            if(++unpublished == numQueues) {
+                publish(unpublished);
+                unpublished = 0;
+            }
+        }
+        if(unpublished)
+            publish(unpublished);
+    }
+
+    /**
+     * @brief Executes the given tasks on the pool and blocks until all of them
+     * are finished.
+     */
+    void execute(const std::vector<Task*>& tasks, uint32_t batchSize, const std::vector<uint32_t>* nodes = nullptr) {
+        TaskGroup group;
+        submit(tasks, batchSize, group, nodes);
+        group.wait();
+    }
+};
@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <util/ParallelFor.h>
+
 #include <thread>
 
 class Worker {
@@ -70,6 +72,8 @@ public:
     ~WorkerCPU() override = default;
 
     void run() override {
+        // kernels in the pipelines run single-threaded, the workers use the cores
+        isVectorizedWorker = true;
         Task* t = _q->dequeueTask();
 
         while( !isEOF(t) ) {
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+
+#include <cstddef>
+
+/**
+ * @brief Whether the calling thread is a worker of the vectorized engine.
+ *
+ * Set by the engine for its worker threads, which already occupy the cores.
+ */
+inline thread_local bool isVectorizedWorker = false;
+
+/**
+ * @brief The number of threads for a kernel with the given amount of work
+ * (e.g., the number of rows or non-zeros to process).
+ *
+ * Small inputs are not worth starting threads, and neither are kernels
+ * executed by a worker of the vectorized engine as part of a pipeline.
+ * Otherwise, this is the configured number of threads, or one per core if
+ * that is not positive.
+ *
+ * @param work The amount of work.
+ * @param numberOfThreads The number of threads from the user config.
+ */
+inline size_t parallelForNumThreads(size_t work, int numberOfThreads) {
+    constexpr size_t MIN_WORK_PARALLEL = 1 << 16;
+    if(work < MIN_WORK_PARALLEL || isVectorizedWorker)
+        return 1;
+    return numberOfThreads > 0
+            ? static_cast<size_t>(numberOfThreads)
+            : std::max(1u, std::thread::hardware_concurrency());
+}
+
+/**
+ * @brief Calls `fn(i)` for all `i` in `[0, numTasks)` on up to `numThreads`
+ * threads (including the calling one), which take the tasks one by one.
+ *
+ * Meant for kernels processing large inputs, which should determine the
+ * number of threads by `parallelForNumThreads`. The first exception thrown by
+ * `fn` is rethrown after all threads have finished.
+ */
+template<class Fn>
+void parallelFor(size_t numTasks, size_t numThreads, Fn fn) {
+    numThreads = std::max<size_t>(1, std::min(numThreads, numTasks));
+    if(numThreads == 1) {
+        for(size_t i = 0; i < numTasks; i++)
+            fn(i);
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    std::vector<std::exception_ptr> errors(numThreads);
+    auto run = [&](size_t t) {
+        try {
+            for(size_t i = next++; i < numTasks; i = next++)
+                fn(i);
+        }
+        catch(...) {
+            errors[t] = std::current_exception();
+            // let the other threads run out of tasks
+            next = numTasks;
+        }
+    };
+    std::vector<std::thread> threads;
+    for(size_t t = 1; t < numThreads; t++)
+        threads.emplace_back(run, t);
+    run(0);
+    for(auto & t : threads)
+        t.join();
+    for(auto & e : errors)
+        if(e)
+            std::rethrow_exception(e);
+}
+
+/**
+ * @brief Limits the number of threads of a kernel in which each thread fills
+ * its own histogram (or partial result) of `histSize` entries, such that the
+ * histograms do not outweigh the `work` (e.g., the non-zeros) to process.
+ */
+inline size_t limitThreadsByHistogram(size_t numThreads, size_t work, size_t histSize) {
+    return std::max<size_t>(1, std::min(numThreads, work / std::max<size_t>(histSize, 1)));
+}
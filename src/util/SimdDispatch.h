@@ -0,0 +1,94 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <utility>
+
+/**
+ * @brief The widest SIMD instruction set available on the executing CPU,
+ * which kernels can compile their inner loops for.
+ */
+enum class SimdLevel {
+    DEFAULT, // whatever the compiler targets by default
+    AVX2,
+    AVX512,
+};
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define DAPHNE_SIMD_DISPATCH 1
+#define DAPHNE_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define DAPHNE_TARGET_AVX512 __attribute__((target("avx512f,avx512dq,avx512vl,avx512bw,avx2,fma")))
+#define DAPHNE_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define DAPHNE_TARGET_AVX2
+#define DAPHNE_TARGET_AVX512
+#define DAPHNE_ALWAYS_INLINE inline
+#endif
+
+/**
+ * @brief Returns the SIMD instruction set of the executing CPU (detected once).
+ */
+inline SimdLevel getSimdLevel() {
+#ifdef DAPHNE_SIMD_DISPATCH
+    static const SimdLevel level = [] {
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq") &&
+                __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx512bw"))
+            return SimdLevel::AVX512;
+        if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            return SimdLevel::AVX2;
+        return SimdLevel::DEFAULT;
+    }();
+    return level;
+#else
+    return SimdLevel::DEFAULT;
+#endif
+}
+
+/**
+ * @brief Runs `Loop::run(args...)` compiled for the widest SIMD instruction
+ * set the executing CPU supports.
+ *
+ * `Loop::run` must be declared `DAPHNE_ALWAYS_INLINE`, such that it is
+ * inlined into (and thus compiled for the instruction set of) each of the
+ * entry points below. Kernels should call this once per invocation, outside
+ * of their loops.
+ */
+template<class Loop>
+struct SimdDispatch {
+    template<typename... Args>
+    DAPHNE_TARGET_AVX512 static decltype(auto) runAVX512(Args... args) {
+        return Loop::run(args...);
+    }
+
+    template<typename... Args>
+    DAPHNE_TARGET_AVX2 static decltype(auto) runAVX2(Args... args) {
+        return Loop::run(args...);
+    }
+
+    template<typename... Args>
+    static decltype(auto) run(Args... args) {
+#ifdef DAPHNE_SIMD_DISPATCH
+        switch(getSimdLevel()) {
+            case SimdLevel::AVX512: return runAVX512(args...);
+            case SimdLevel::AVX2: return runAVX2(args...);
+            default: break;
+        }
+#endif
+        return Loop::run(args...);
+    }
+};
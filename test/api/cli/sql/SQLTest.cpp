@@ -34,6 +34,15 @@ const std::string dirPath = "test/api/cli/sql/";
         } \
     }
 
+#define MAKE_SUCCESS_REF_TEST_CASE(name, count) \
+    TEST_CASE(name ", success", TAG_SQL) { \
+        for(unsigned i = 1; i <= count; i++) { \
+            DYNAMIC_SECTION(name "_success_" << i << ".daphne") { \
+                compareDaphneToRefSimple(dirPath, name "_success", i); \
+            } \
+        } \
+    }
+
 #define MAKE_PARSER_FAILURE_TEST_CASE(name, count) \
     TEST_CASE(name ", parser failure", TAG_SQL) { \
         for(unsigned i = 1; i <= count; i++) { \
@@ -69,7 +78,7 @@ MAKE_SUCCESS_TEST_CASE("cartesian", 2);
 
 MAKE_SUCCESS_TEST_CASE("where", 4);
 
-MAKE_SUCCESS_TEST_CASE("join", 1);
+MAKE_SUCCESS_REF_TEST_CASE("join", 6);
 
 MAKE_SUCCESS_TEST_CASE("group", 3);
 MAKE_PASS_FAILURE_TEST_CASE("group", 1);
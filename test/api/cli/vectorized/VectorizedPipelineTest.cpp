@@ -65,4 +65,4 @@ void compareDaphneToDaphneOtherArgs(const std::string &scriptFilePath) {
         } \
     }
 
-MAKE_TEST_CASE("pipeline", 2)
\ No newline at end of file
+MAKE_TEST_CASE("pipeline", 3)
\ No newline at end of file
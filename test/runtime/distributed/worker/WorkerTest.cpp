@@ -17,6 +17,8 @@
 
 #include "runtime/distributed/proto/worker.pb.h"
 #include "runtime/distributed/proto/worker.grpc.pb.h"
+#include "runtime/distributed/worker/FunctionCache.h"
+#include "runtime/distributed/worker/WorkerDataStore.h"
 #include "runtime/distributed/worker/WorkerImpl.h"
 #include "runtime/distributed/worker/ProtoDataConverter.h"
 #include "runtime/local/kernels/EwBinaryMat.h"
@@ -30,7 +32,9 @@
 #include <runtime/local/io/File.h>
 #include <runtime/local/io/ReadCsv.h>
 #include <api/cli/Utils.h>
+#include <set>
 #include <thread>
+#include <vector>
 
 const std::string dirPath = "test/runtime/distributed/worker/";
 
@@ -172,4 +176,171 @@ TEST_CASE("Simple distributed worker functionality test", TAG_DISTRIBUTED)
             REQUIRE(*received == *matOrigTimes2);
         }
     }
+    WHEN ("Sending only the hash of a function sent before")
+    {
+        const std::string code = "func @" + WorkerImpl::DISTRIBUTED_FUNCTION_NAME +
+            "() -> () {\n"
+            "  \"daphne.return\"() : () -> ()\n"
+            "}\n";
+        distributed::Task task;
+        task.set_mlir_code(code);
+        task.set_mlir_hash(hashMlirCode(code));
+
+        grpc::ServerContext context;
+        distributed::ComputeResult result;
+        grpc::Status status = workerImpl.Compute(&context, &task, &result);
+        REQUIRE(status.ok());
+
+        task.clear_mlir_code();
+        status = workerImpl.Compute(&context, &task, &result);
+
+        THEN ("The cached function is executed")
+        {
+            REQUIRE(status.ok());
+            REQUIRE(result.outputs_size() == 0);
+        }
+    }
+
+    WHEN ("Sending only the hash of an unknown function")
+    {
+        distributed::Task task;
+        task.set_mlir_hash(hashMlirCode("unknown"));
+
+        grpc::ServerContext context;
+        distributed::ComputeResult result;
+        grpc::Status status = workerImpl.Compute(&context, &task, &result);
+
+        THEN ("The worker asks for the code")
+        {
+            REQUIRE(status.error_code() == grpc::StatusCode::NOT_FOUND);
+        }
+    }
+}
+
+TEST_CASE("Streaming a matrix to and from a distributed worker", TAG_DISTRIBUTED)
+{
+    WorkerImpl workerImpl;
+
+    // more than one chunk
+    const size_t numRows = 1000;
+    const size_t numCols = 300;
+    auto *mat = DataObjectFactory::create<DenseMatrix<double>>(numRows, numCols, false);
+    for (size_t r = 0; r < numRows; r++)
+        for (size_t c = 0; c < numCols; c++)
+            mat->set(r, c, r * 0.5 + c);
+
+    DenseMatrix<double> *stored = nullptr;
+    size_t numCellsStored = 0;
+    distributed::MatrixChunk chunk;
+    size_t cell = 0;
+    size_t numChunks = 0;
+    do {
+        cell = ProtoDataConverter::convertToChunk(mat, &chunk, 0, numRows, 0, numCols, cell);
+        REQUIRE(workerImpl.StoreChunk(chunk, stored, numCellsStored).ok());
+        numChunks++;
+    } while (cell < numRows * numCols);
+    REQUIRE(numChunks > 1);
+    distributed::StoredData storedData;
+    REQUIRE(workerImpl.StoreFinish(stored, numCellsStored, &storedData).ok());
+
+    auto *received = DataObjectFactory::create<DenseMatrix<double>>(numRows, numCols, false);
+    cell = 0;
+    do {
+        REQUIRE(workerImpl.TransferChunk(&storedData, cell, &chunk, cell).ok());
+        ProtoDataConverter::convertFromChunk(chunk, received, 0, 0);
+    } while (cell < numRows * numCols);
+
+    CHECK(*received == *mat);
+
+    DataObjectFactory::destroy(mat, received);
+}
+
+TEST_CASE("Distributed worker rejects a short matrix stream", TAG_DISTRIBUTED)
+{
+    WorkerImpl workerImpl;
+
+    const size_t numRows = 1000;
+    const size_t numCols = 300;
+    auto *mat = DataObjectFactory::create<DenseMatrix<double>>(numRows, numCols, true);
+
+    DenseMatrix<double> *stored = nullptr;
+    size_t numCellsStored = 0;
+    distributed::MatrixChunk chunk;
+    // only the first chunk
+    ProtoDataConverter::convertToChunk(mat, &chunk, 0, numRows, 0, numCols, 0);
+    REQUIRE(workerImpl.StoreChunk(chunk, stored, numCellsStored).ok());
+    // chunks have to arrive in order
+    CHECK(workerImpl.StoreChunk(chunk, stored, numCellsStored).error_code() == grpc::StatusCode::INVALID_ARGUMENT);
+
+    distributed::StoredData storedData;
+    CHECK(workerImpl.StoreFinish(stored, numCellsStored, &storedData).error_code() == grpc::StatusCode::DATA_LOSS);
+
+    DataObjectFactory::destroy(mat, stored);
+}
+
+TEST_CASE("Distributed worker function cache", TAG_DISTRIBUTED)
+{
+    FunctionCache<int> cache(2);
+    cache.put(1, std::make_shared<int>(10));
+    cache.put(2, std::make_shared<int>(20));
+    // makes 2 the least recently used function
+    REQUIRE(*cache.get(1) == 10);
+    cache.put(3, std::make_shared<int>(30));
+
+    CHECK(cache.size() == 2);
+    CHECK(cache.get(2) == nullptr);
+    CHECK(*cache.get(1) == 10);
+    CHECK(*cache.get(3) == 30);
+}
+
+TEST_CASE("Distributed worker data store", TAG_DISTRIBUTED)
+{
+    WorkerDataStore store;
+
+    WHEN ("Freeing a matrix still in use")
+    {
+        auto *mat = DataObjectFactory::create<DenseMatrix<double>>(2, 2, true);
+        mat->set(1, 1, 3.0);
+        auto id = store.add(mat);
+        auto obj = store.get(id);
+        REQUIRE(obj.get() == mat);
+
+        REQUIRE(store.remove(id));
+
+        THEN ("It is only destroyed with its last reference")
+        {
+            CHECK(store.get(id) == nullptr);
+            CHECK_FALSE(store.remove(id));
+            CHECK(obj->get(1, 1) == 3.0);
+        }
+    }
+
+    WHEN ("Storing matrices from several threads")
+    {
+        const size_t numThreads = 4;
+        const size_t numMatrices = 500;
+        std::vector<std::vector<std::string>> ids(numThreads);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < numThreads; t++)
+            threads.emplace_back([&, t]() {
+                for (size_t i = 0; i < numMatrices; i++) {
+                    auto *mat = DataObjectFactory::create<DenseMatrix<double>>(1, 1, false);
+                    mat->set(0, 0, t * numMatrices + i);
+                    ids[t].push_back(store.add(mat));
+                }
+            });
+        for (auto &thread : threads)
+            thread.join();
+
+        THEN ("Each matrix gets its own identifier")
+        {
+            std::set<std::string> distinct;
+            for (size_t t = 0; t < numThreads; t++)
+                for (size_t i = 0; i < numMatrices; i++) {
+                    distinct.insert(ids[t][i]);
+                    CHECK(store.get(ids[t][i])->get(0, 0) == t * numMatrices + i);
+                }
+            CHECK(distinct.size() == numThreads * numMatrices);
+        }
+    }
 }
@@ -0,0 +1,160 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datastructures/BufferPool.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <cstdint>
+#include <cstring>
+
+TEST_CASE("BufferPool size classes", TAG_DATASTRUCTURES) {
+    size_t prevBytes = 0;
+    for(size_t numBytes : {size_t(1), size_t(64), size_t(65), size_t(100), size_t(128), size_t(129),
+            size_t(4000), size_t(4096), size_t(1000000), size_t(3) << 20, size_t(1) << 40}) {
+        const size_t classBytes = BufferPool::getClassBytes(BufferPool::getSizeClass(numBytes));
+        CHECK(classBytes >= numBytes);
+        CHECK(classBytes <= std::max(numBytes + numBytes / 4, size_t(64)));
+        CHECK(classBytes >= prevBytes);
+        prevBytes = classBytes;
+    }
+    for(size_t c = 0; c < 100; c++)
+        CHECK(BufferPool::getSizeClass(BufferPool::getClassBytes(c)) == c);
+}
+
+TEST_CASE("BufferPool reuses buffers", TAG_DATASTRUCTURES) {
+    auto & pool = BufferPool::instance();
+    pool.configure(BufferPool::DEFAULT_CAPACITY, false);
+
+    // small and mapped buffers
+    const size_t numBytes = GENERATE(size_t(1000), size_t(5) << 20);
+
+    void * address;
+    {
+        auto buffer = pool.allocate<uint8_t[]>(numBytes, true);
+        address = buffer.get();
+        CHECK(reinterpret_cast<uintptr_t>(address) % BufferPool::ALIGNMENT == 0);
+        CHECK(buffer[0] == 0);
+        CHECK(buffer[numBytes - 1] == 0);
+        memset(buffer.get(), 1, numBytes);
+    }
+    const auto before = pool.getStats();
+    CHECK(before.cachedBytes >= numBytes);
+    {
+        // the same buffer again, zeroed if requested
+        auto buffer = pool.allocate<uint8_t[]>(numBytes - 10, true);
+        CHECK(buffer.get() == address);
+        CHECK(buffer[0] == 0);
+        CHECK(buffer[numBytes - 11] == 0);
+    }
+    const auto after = pool.getStats();
+    CHECK(after.hits == before.hits + 1);
+    CHECK(after.misses == before.misses);
+
+    pool.trim();
+    CHECK(pool.getStats().cachedBytes == 0);
+}
+
+TEST_CASE("BufferPool allocates untouched buffers", TAG_DATASTRUCTURES) {
+    auto & pool = BufferPool::instance();
+    pool.configure(BufferPool::DEFAULT_CAPACITY, false);
+
+    const size_t numBytes = size_t(5) << 20;
+    pool.allocate<uint8_t[]>(numBytes, false).reset();
+    const auto before = pool.getStats();
+    CHECK(before.cachedBytes >= numBytes);
+    {
+        // a fresh buffer despite the cached one
+        auto buffer = pool.allocateUntouched<uint8_t[]>(numBytes);
+        CHECK(reinterpret_cast<uintptr_t>(buffer.get()) % BufferPool::ALIGNMENT == 0);
+        memset(buffer.get(), 1, numBytes);
+    }
+    const auto after = pool.getStats();
+    CHECK(after.hits == before.hits);
+    CHECK(after.misses == before.misses + 1);
+    // and returned to the pool afterwards
+    CHECK(after.cachedBytes > before.cachedBytes);
+
+    pool.trim();
+}
+
+TEST_CASE("BufferPool across threads", TAG_DATASTRUCTURES) {
+    auto & pool = BufferPool::instance();
+    pool.configure(BufferPool::DEFAULT_CAPACITY, false);
+    pool.trim();
+
+    // buffers released by threads that have exited are handed out again
+    std::vector<std::shared_ptr<double[]>> buffers(16);
+    std::thread t([&pool, &buffers]() {
+        for(auto & buffer : buffers)
+            buffer = pool.allocate<double[]>(1000, false);
+        buffers.clear();
+    });
+    t.join();
+    const auto before = pool.getStats();
+    CHECK(before.cachedBytes >= 16 * 1000 * sizeof(double));
+    for(size_t i = 0; i < 16; i++)
+        buffers.push_back(pool.allocate<double[]>(1000, false));
+    CHECK(pool.getStats().hits == before.hits + 16);
+    CHECK(pool.getStats().misses == before.misses);
+
+    buffers.clear();
+    pool.trim();
+}
+
+TEST_CASE("BufferPool capacity", TAG_DATASTRUCTURES) {
+    auto & pool = BufferPool::instance();
+    pool.configure(0, false);
+
+    const auto before = pool.getStats();
+    pool.allocate<double[]>(1000, false).reset();
+    pool.allocate<double[]>(1000, false).reset();
+    const auto after = pool.getStats();
+    CHECK(after.misses == before.misses + 2);
+    CHECK(after.evictions == before.evictions + 2);
+    CHECK(after.cachedBytes == 0);
+
+    pool.configure(BufferPool::DEFAULT_CAPACITY, false);
+}
+
+TEST_CASE("BufferPool provides the buffers of data objects", TAG_DATASTRUCTURES) {
+    auto & pool = BufferPool::instance();
+    pool.configure(BufferPool::DEFAULT_CAPACITY, false);
+
+    auto m1 = DataObjectFactory::create<DenseMatrix<double>>(100, 10, false);
+    const double * values = m1->getValues();
+    m1->getValues()[5] = 1.0;
+    DataObjectFactory::destroy(m1);
+
+    // a matrix of the same shape gets the same (zeroed) buffer
+    auto m2 = DataObjectFactory::create<DenseMatrix<double>>(100, 10, true);
+    CHECK(m2->getValues() == values);
+    CHECK(m2->getValues()[5] == 0.0);
+    DataObjectFactory::destroy(m2);
+
+    auto s1 = DataObjectFactory::create<CSRMatrix<double>>(100, 10, 50, true);
+    CHECK(s1->getRowOffsets()[100] == 0);
+    DataObjectFactory::destroy(s1);
+}
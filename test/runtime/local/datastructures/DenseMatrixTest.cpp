@@ -22,6 +22,9 @@
 
 #include <catch.hpp>
 
+#include <thread>
+#include <vector>
+
 #include <cstdint>
 
 TEMPLATE_TEST_CASE("DenseMatrix allocates enough space", TAG_DATASTRUCTURES, ALL_VALUE_TYPES) {
@@ -76,4 +79,26 @@ TEST_CASE("DenseMatrix sub-matrix works properly", TAG_DATASTRUCTURES) {
         DataObjectFactory::destroy(mSub);
         DataObjectFactory::destroy(mOrig);
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("DenseMatrix reference counter is thread-safe", TAG_DATASTRUCTURES) {
+    const size_t numThreads = 4;
+    const size_t numRefs = 10000;
+
+    auto m = DataObjectFactory::create<DenseMatrix<double>>(10, 10, true);
+
+    // Each thread acquires and releases many references concurrently.
+    std::vector<std::thread> threads;
+    for(size_t t = 0; t < numThreads; t++)
+        threads.emplace_back([m]() {
+            for(size_t i = 0; i < numRefs; i++)
+                m->increaseRefCounter();
+            for(size_t i = 0; i < numRefs; i++)
+                DataObjectFactory::destroy(m);
+        });
+    for(auto & t : threads)
+        t.join();
+    CHECK(m->getRefCounter() == 1);
+
+    DataObjectFactory::destroy(m);
+}
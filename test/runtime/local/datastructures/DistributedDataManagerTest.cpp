@@ -0,0 +1,76 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/datastructures/DistributedDataManager.h>
+#include <runtime/local/datastructures/Handle.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <memory>
+
+#include <cstdlib>
+
+TEST_CASE("DistributedDataManager", TAG_DATASTRUCTURES TAG_DISTRIBUTED) {
+    using Kind = DistributedDataManager::Kind;
+    setenv("DISTRIBUTED_WORKERS", "localhost:5000,localhost:5001", 1);
+    auto &manager = DistributedDataManager::instance();
+    manager.clear();
+
+    CHECK(manager.getWorkers() == std::vector<std::string>{"localhost:5000", "localhost:5001"});
+
+    auto m = DataObjectFactory::create<DenseMatrix<double>>(10, 4, true);
+    auto view = DataObjectFactory::create<DenseMatrix<double>>(m, 2, 6, 0, 4);
+    auto placement = std::make_shared<DistributedPlacement>(DistributedPlacement::HandleMap());
+    manager.remember(m, Kind::DISTRIBUTED, placement);
+
+    SECTION("reuse") {
+        CHECK(manager.lookup(m, Kind::DISTRIBUTED) == placement);
+        // not broadcast, and the view is a different matrix
+        CHECK(manager.lookup(m, Kind::BROADCAST) == nullptr);
+        CHECK(manager.lookup(view, Kind::DISTRIBUTED) == nullptr);
+    }
+    SECTION("invalidation") {
+        manager.remember(view, Kind::BROADCAST, placement);
+        manager.invalidate(view);
+        CHECK(manager.lookup(m, Kind::DISTRIBUTED) == nullptr);
+        CHECK(manager.lookup(view, Kind::BROADCAST) == nullptr);
+    }
+    SECTION("other workers") {
+        setenv("DISTRIBUTED_WORKERS", "localhost:5000", 1);
+        CHECK(manager.lookup(m, Kind::DISTRIBUTED) == nullptr);
+    }
+    SECTION("destroyed matrix") {
+        std::weak_ptr<DistributedPlacement> weak = placement;
+        placement.reset();
+        DataObjectFactory::destroy(view, m);
+        view = m = nullptr;
+        // the partitions are released with the next use of the manager
+        auto other = DataObjectFactory::create<DenseMatrix<double>>(1, 1, true);
+        manager.remember(other, Kind::DISTRIBUTED,
+                         std::make_shared<DistributedPlacement>(DistributedPlacement::HandleMap()));
+        CHECK(weak.expired());
+        DataObjectFactory::destroy(other);
+    }
+
+    manager.clear();
+    if (m)
+        DataObjectFactory::destroy(view, m);
+    unsetenv("DISTRIBUTED_WORKERS");
+}
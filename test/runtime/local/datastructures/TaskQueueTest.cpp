@@ -17,7 +17,10 @@
 #include <runtime/local/vectorized/TaskQueues.h>
 #include <tags.h>
 #include <catch.hpp>
+#include <algorithm>
 #include <cstdint>
+#include <thread>
+#include <vector>
 
 TEST_CASE("Task sequence", TAG_DATASTRUCTURES) {
     TaskQueue* bq = new BlockingTaskQueue(5);
@@ -83,3 +86,85 @@ TEST_CASE("EOF handling", TAG_DATASTRUCTURES) {
     delete t1;
     delete bq;
 }
+
+TEST_CASE("Lock-free queue task sequence and batched dequeue", TAG_DATASTRUCTURES) {
+    TaskQueue* q = new LockFreeTaskQueue(5);
+    std::mutex mtx;
+    CompiledPipelineTaskData<DenseMatrix<double>> data{{}, {}, {}, 0, 0, nullptr, nullptr, nullptr, nullptr, 0, 0,
+            nullptr, nullptr, 0, nullptr};
+    std::vector<Task*> ts;
+    for(size_t i = 0; i < 5; i++)
+        ts.push_back(new CompiledPipelineTask<DenseMatrix<double>>(data, mtx, nullptr));
+
+    for(auto t : ts)
+        q->enqueueTask(t);
+    CHECK(q->size() == 5);
+    CHECK(q->dequeueTask() == ts[0]);
+
+    // batched dequeue preserves the order and stops at the end of the queue
+    Task* batch[8];
+    CHECK(q->tryDequeueTasks(batch, 3) == 3);
+    CHECK(batch[0] == ts[1]);
+    CHECK(batch[1] == ts[2]);
+    CHECK(batch[2] == ts[3]);
+    CHECK(q->tryDequeueTasks(batch, 8) == 1);
+    CHECK(batch[0] == ts[4]);
+    CHECK(q->tryDequeueTasks(batch, 8) == 0);
+    CHECK(q->size() == 0);
+
+    // EOF after last task
+    q->enqueueTask(ts[0]);
+    q->closeInput();
+    CHECK(q->dequeueTask() == ts[0]);
+    CHECK(dynamic_cast<EOFTask*>(q->dequeueTask()));
+    CHECK(dynamic_cast<EOFTask*>(q->dequeueTask()));
+
+    for(auto t : ts)
+        delete t;
+    delete q;
+}
+
+TEST_CASE("Lock-free queue with concurrent producers and consumers", TAG_DATASTRUCTURES) {
+    const size_t numTasks = 10000;
+    const size_t numThreads = 4;
+    // small capacity, such that producers have to wait for consumers
+    TaskQueue* q = new LockFreeTaskQueue(16);
+    std::mutex mtx;
+    CompiledPipelineTaskData<DenseMatrix<double>> data{{}, {}, {}, 0, 0, nullptr, nullptr, nullptr, nullptr, 0, 0,
+            nullptr, nullptr, 0, nullptr};
+    std::vector<Task*> ts;
+    for(size_t i = 0; i < numTasks; i++)
+        ts.push_back(new CompiledPipelineTask<DenseMatrix<double>>(data, mtx, nullptr));
+
+    std::vector<std::vector<Task*>> received(numThreads);
+    std::vector<std::thread> consumers;
+    for(size_t c = 0; c < numThreads; c++)
+        consumers.emplace_back([q, &received, c]() {
+            for(Task* t = q->dequeueTask(); !dynamic_cast<EOFTask*>(t); t = q->dequeueTask())
+                received[c].push_back(t);
+        });
+    std::vector<std::thread> producers;
+    for(size_t p = 0; p < numThreads; p++)
+        producers.emplace_back([q, &ts, p, numTasks, numThreads]() {
+            for(size_t i = p; i < numTasks; i += numThreads)
+                q->enqueueTask(ts[i]);
+        });
+    for(auto& p : producers)
+        p.join();
+    q->closeInput();
+    for(auto& c : consumers)
+        c.join();
+
+    // every task is dequeued exactly once
+    std::vector<Task*> all;
+    for(auto& r : received)
+        all.insert(all.end(), r.begin(), r.end());
+    std::sort(all.begin(), all.end());
+    std::vector<Task*> expected(ts);
+    std::sort(expected.begin(), expected.end());
+    CHECK(all == expected);
+
+    for(auto t : ts)
+        delete t;
+    delete q;
+}
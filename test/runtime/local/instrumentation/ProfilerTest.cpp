@@ -0,0 +1,93 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/instrumentation/Profiler.h>
+#include <runtime/local/vectorized/WorkerPool.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+class RowsTask : public Task {
+    Profiler& _profiler;
+public:
+    explicit RowsTask(Profiler& profiler) : _profiler(profiler) {}
+    void execute(uint32_t fid, uint32_t batchSize) override {
+        _profiler.countRows(10);
+    }
+};
+
+TEST_CASE("Profiler records kernels", TAG_PROFILING) {
+    Profiler profiler;
+    const size_t outer = profiler.registerSite("_outer", "script.daphne:1:1");
+    const size_t inner = profiler.registerSite("_inner\"quoted\"", "script.daphne:2:5");
+
+    for(size_t i = 0; i < 3; i++) {
+        profiler.beginKernel(outer);
+        profiler.beginKernel(inner);
+        auto m = DataObjectFactory::create<DenseMatrix<double>>(1000, 100, false);
+        DataObjectFactory::destroy(m);
+        profiler.endKernel(inner);
+        profiler.endKernel(outer);
+    }
+    profiler.beginKernel(outer);
+    CHECK_THROWS_AS(profiler.endKernel(inner), std::runtime_error);
+
+    std::stringstream summary;
+    profiler.printSummary(summary);
+    // the outer kernel includes the inner one, so it comes first
+    const auto str = summary.str();
+    CHECK(str.find("_outer @ script.daphne:1:1") < str.find("_inner\"quoted\" @ script.daphne:2:5"));
+    CHECK(str.find("2.400") != std::string::npos); // 3 x 800000 bytes in MB
+    CHECK(str.find("Buffer pool:") != std::string::npos);
+
+    std::stringstream trace;
+    profiler.writeChromeTrace(trace);
+    CHECK(trace.str().find("\"name\":\"_inner\\\"quoted\\\"\",\"cat\":\"kernel\"") != std::string::npos);
+    CHECK(trace.str().find("\"allocatedBytes\":800000}") != std::string::npos);
+}
+
+TEST_CASE("Profiler records the workers of the vectorized engine", TAG_PROFILING TAG_VECTORIZED) {
+    auto profiler = std::make_shared<Profiler>();
+    {
+        WorkerPool pool(2, TaskQueueType::BLOCKING, false, false, profiler);
+        std::vector<Task*> tasks;
+        for(size_t i = 0; i < 100; i++)
+            tasks.push_back(new RowsTask(*profiler));
+        pool.execute(tasks, 1);
+    }
+
+    std::stringstream summary;
+    profiler->printSummary(summary);
+    CHECK(summary.str().find("worker 0") != std::string::npos);
+    CHECK(summary.str().find("worker 1") != std::string::npos);
+
+    std::stringstream trace;
+    profiler->writeChromeTrace(trace);
+    size_t numTasks = 0;
+    for(size_t pos = trace.str().find("\"rows\":10,"); pos != std::string::npos;
+            pos = trace.str().find("\"rows\":10,", pos + 1))
+        numTasks++;
+    CHECK(numTasks == 100);
+}
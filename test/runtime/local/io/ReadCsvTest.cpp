@@ -23,10 +23,12 @@
 
 #include <catch.hpp>
 
+#include <fstream>
 #include <vector>
 
 #include <cmath>
 #include <cstdint>
+#include <cstdio>
 #include <limits>
 
 TEMPLATE_PRODUCT_TEST_CASE("ReadCsv", TAG_IO, (DenseMatrix), (double)) {
@@ -267,3 +269,44 @@ TEST_CASE("ReadCsv, varying columns", TAG_IO) {
   DataObjectFactory::destroy(m);
 
 }
+
+TEST_CASE("ReadCsv, large file in multiple chunks", TAG_IO) {
+  // large enough to be split into several chunks parsed in parallel
+  const size_t numRows = 300000;
+  const size_t numCols = 3;
+  const char filename[] = "./test/runtime/local/io/ReadCsvLarge.csv";
+  {
+    std::ofstream ofs(filename);
+    for(size_t r = 0; r < numRows; r++) {
+      ofs << r << ',' << (r % 1000) * 0.25 << ',';
+      // some empty fields
+      if(r % 1000)
+        ofs << -static_cast<int64_t>(r);
+      ofs << '\n';
+    }
+  }
+
+  DenseMatrix<double> *m = nullptr;
+  readCsv(m, filename, numRows, numCols, ',');
+
+  ValueTypeCode schema[] = { ValueTypeCode::UI64, ValueTypeCode::F32, ValueTypeCode::SI64 };
+  Frame *f = nullptr;
+  readCsv(f, filename, numRows, numCols, ',', schema);
+
+  std::remove(filename);
+
+  REQUIRE(m->getNumRows() == numRows);
+  REQUIRE(f->getNumRows() == numRows);
+  size_t numMismatches = 0;
+  for(size_t r = 0; r < numRows; r++) {
+    const bool empty = r % 1000 == 0;
+    numMismatches += m->get(r, 0) != r || m->get(r, 1) != (r % 1000) * 0.25 ||
+        (empty ? !std::isnan(m->get(r, 2)) : m->get(r, 2) != -static_cast<double>(r));
+    numMismatches += f->getColumn<uint64_t>(0)->get(r, 0) != r || f->getColumn<float>(1)->get(r, 0) != static_cast<float>((r % 1000) * 0.25) ||
+        f->getColumn<int64_t>(2)->get(r, 0) != (empty ? 0 : -static_cast<int64_t>(r));
+  }
+  CHECK(numMismatches == 0);
+
+  DataObjectFactory::destroy(m);
+  DataObjectFactory::destroy(f);
+}
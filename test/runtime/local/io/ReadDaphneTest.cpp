@@ -14,17 +14,24 @@
  * limitations under the License.
  */
 
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DataObjectFactory.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/io/WriteDaphne.h>
+#include <runtime/local/kernels/CheckEq.h>
 
 #include <tags.h>
 
 #include <catch.hpp>
 
+#include <fstream>
+#include <utility>
 #include <vector>
 
 #include <cmath>
 #include <cstdint>
+#include <cstdio>
 #include <limits>
 
 #include <runtime/local/io/ReadDaphne.h>
@@ -578,3 +585,153 @@ TEST_CASE("ReadDaphne AIS (Frame)", TAG_IO) {
 
   DataObjectFactory::destroy(m);
 }
+
+TEST_CASE("ReadDaphne, sparse block (CSR)", TAG_IO) {
+  const size_t numRows = 3000;
+  const size_t numCols = 500;
+  const char filename[] = "./test/runtime/local/io/ReadDaphneSparse.dbdf";
+
+  // some empty rows, such that row offsets repeat
+  auto m = DataObjectFactory::create<CSRMatrix<double>>(numRows, numCols, numRows * numCols, false);
+  size_t *rowOffsets = m->getRowOffsets();
+  rowOffsets[0] = 0;
+  for (size_t r = 0; r < numRows; r++) {
+    size_t pos = rowOffsets[r];
+    if (r % 7)
+      for (size_t c = r % 11; c < numCols; c += 13) {
+        m->getColIdxs()[pos] = c;
+        m->getValues()[pos] = r + c * 0.5;
+        pos++;
+      }
+    rowOffsets[r + 1] = pos;
+  }
+  // a single block or blocks of at most 1000 non-zeros
+  const size_t blockBytes = GENERATE(DF_V2_BLOCK_BYTES, 1000 * (sizeof(size_t) + sizeof(double)));
+  writeDaphne(m, filename, false, blockBytes);
+
+  CSRMatrix<double> *res = nullptr;
+  readDaphne(res, filename);
+  std::remove(filename);
+
+  CHECK(*res == *m);
+
+  DataObjectFactory::destroy(m, res);
+}
+
+TEST_CASE("ReadDaphne, ultra-sparse block (COO)", TAG_IO) {
+  using VT = double;
+  const char filename[] = "./test/runtime/local/io/ReadDaphneCoo.dbdf";
+  const uint32_t numCols = GENERATE(1, 4);
+
+  // unsorted coordinates, one of them twice
+  std::vector<std::pair<uint32_t, uint32_t>> coords{{2, 3}, {0, 1}, {2, 0}, {0, 1}, {1, 2}};
+  std::vector<VT> vals{1, 2, 3, 4, 5};
+  if (numCols == 1)
+    for (auto &c : coords)
+      c.second = 0;
+  {
+    std::ofstream f(filename, std::ios::out | std::ios::binary);
+    DF_header h{1, DF_data_t::CSRMatrix_t, 3, numCols};
+    f.write((const char *)&h, sizeof(h));
+    const ValueTypeCode vt = ValueTypeUtils::codeFor<VT>;
+    f.write((const char *)&vt, sizeof(vt));
+    DF_body b{0, 0};
+    f.write((const char *)&b, sizeof(b));
+    DF_body_block bb{3, numCols, DF_body_t::ultra_sparse};
+    f.write((const char *)&bb, sizeof(bb));
+    f.write((const char *)&vt, sizeof(vt));
+    const uint64_t nzb = coords.size();
+    f.write((const char *)&nzb, sizeof(nzb));
+    for (size_t i = 0; i < coords.size(); i++) {
+      f.write((const char *)&coords[i].first, sizeof(uint32_t));
+      if (numCols > 1)
+        f.write((const char *)&coords[i].second, sizeof(uint32_t));
+      f.write((const char *)&vals[i], sizeof(VT));
+    }
+  }
+
+  CSRMatrix<VT> *res = nullptr;
+  readDaphne(res, filename);
+  std::remove(filename);
+
+  REQUIRE(res->getNumRows() == 3);
+  REQUIRE(res->getNumCols() == numCols);
+  CSRMatrix<VT> *exp = nullptr;
+  if (numCols == 1)
+    // all non-zeros are in the first column, of duplicates the last one wins
+    exp = genGivenVals<CSRMatrix<VT>>(3, {4, 5, 3});
+  else
+    exp = genGivenVals<CSRMatrix<VT>>(3, {
+      0, 4, 0, 0,
+      0, 0, 5, 0,
+      3, 0, 0, 1,
+    });
+  CHECK(*res == *exp);
+
+  DataObjectFactory::destroy(res, exp);
+}
+
+TEMPLATE_TEST_CASE("ReadDaphne, version 2 dense matrix", TAG_IO, double, int32_t) {
+  using VT = TestType;
+  const char filename[] = "./test/runtime/local/io/ReadDaphneV2.dbdf";
+  const size_t numRows = 1000;
+  const size_t numCols = 7;
+  const bool compress = GENERATE(false, true);
+
+  // a view, such that the row skip differs from the number of columns
+  auto orig = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols + 3, false);
+  for (size_t r = 0; r < numRows; r++)
+    for (size_t c = 0; c < numCols + 3; c++)
+      // runs of zeros for the compression
+      orig->set(r, c, (r / 100) % 2 ? 0 : static_cast<VT>(r * numCols + c));
+  auto m = DataObjectFactory::create<DenseMatrix<VT>>(orig, 0, numRows, 2, numCols + 2);
+  // blocks of 64 rows
+  writeDaphne(m, filename, compress, 64 * numCols * sizeof(VT));
+
+  DenseMatrix<VT> *res = nullptr;
+  readDaphne(res, filename);
+  CHECK(*res == *m);
+
+  // a range of rows across several blocks
+  DenseMatrix<VT> *part = nullptr;
+  readDaphneRows(part, filename, 100, 250);
+  auto expPart = DataObjectFactory::create<DenseMatrix<VT>>(m, 100, 250, 0, numCols);
+  CHECK(*part == *expPart);
+
+  std::remove(filename);
+  DataObjectFactory::destroy(orig, m, res, part, expPart);
+}
+
+TEST_CASE("ReadDaphne, version 2 frame", TAG_IO) {
+  const char filename[] = "./test/runtime/local/io/ReadDaphneV2Frame.dbdf";
+  const size_t numRows = 500;
+  const bool compress = GENERATE(false, true);
+
+  auto c0 = DataObjectFactory::create<DenseMatrix<int64_t>>(numRows, 1, false);
+  auto c1 = DataObjectFactory::create<DenseMatrix<float>>(numRows, 1, false);
+  auto c2 = DataObjectFactory::create<DenseMatrix<uint8_t>>(numRows, 1, false);
+  for (size_t r = 0; r < numRows; r++) {
+    c0->set(r, 0, -static_cast<int64_t>(r));
+    c1->set(r, 0, r * 0.5f);
+    c2->set(r, 0, r / 100);
+  }
+  std::vector<Structure *> cols{c0, c1, c2};
+  std::string labels[] = {"a", "bb", "some label"};
+  auto f = DataObjectFactory::create<Frame>(cols, labels);
+  writeDaphne(f, filename, compress, 64);
+
+  Frame *res = nullptr;
+  readDaphne(res, filename);
+  CHECK(*res == *f);
+
+  Frame *part = nullptr;
+  readDaphneRows(part, filename, 70, 300);
+  REQUIRE(part->getNumRows() == 230);
+  CHECK(part->getLabels()[2] == "some label");
+  CHECK(part->getColumn<int64_t>(0)->get(0, 0) == -70);
+  CHECK(part->getColumn<float>(1)->get(229, 0) == 149.5f);
+  CHECK(part->getColumn<uint8_t>(2)->get(229, 0) == 2);
+
+  std::remove(filename);
+  DataObjectFactory::destroy(c0, c1, c2, f, res, part);
+}
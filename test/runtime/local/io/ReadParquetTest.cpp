@@ -86,4 +86,49 @@ TEMPLATE_PRODUCT_TEST_CASE("ReadParquet, DenseMatrix", TAG_IO, (DenseMatrix), (d
   DataObjectFactory::destroy(m);
 }
 
+TEST_CASE("ReadParquet, Frame, multiple row groups", TAG_IO) {
+  // ReadParquet2.parquet has 10 rows in row groups of 4 rows, the second
+  // column is stored as int64
+  ValueTypeCode schema[] = { ValueTypeCode::F64, ValueTypeCode::SI64, ValueTypeCode::F32 };
+  Frame *m = NULL;
+
+  size_t numRows = 10;
+  size_t numCols = 3;
+
+  readParquet(m, "./test/runtime/local/io/ReadParquet2.parquet", numRows, numCols, schema);
+
+  REQUIRE(m->getNumRows() == numRows);
+  REQUIRE(m->getNumCols() == numCols);
+
+  for(size_t r = 0; r < numRows; r++) {
+    CHECK(m->getColumn<double>(0)->get(r, 0) == r * 0.5);
+    CHECK(m->getColumn<int64_t>(1)->get(r, 0) == static_cast<int64_t>(r * 10));
+    CHECK(m->getColumn<float>(2)->get(r, 0) == -static_cast<float>(r));
+  }
+
+  DataObjectFactory::destroy(m);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("ReadParquet, DenseMatrix, multiple row groups", TAG_IO, (DenseMatrix), (double, int64_t)) {
+  using DT = TestType;
+  using VT = typename DT::VT;
+  DT *m = nullptr;
+
+  // only the first rows and columns
+  size_t numRows = 6;
+  size_t numCols = 2;
+
+  readParquet(m, "./test/runtime/local/io/ReadParquet2.parquet", numRows, numCols);
+
+  REQUIRE(m->getNumRows() == numRows);
+  REQUIRE(m->getNumCols() == numCols);
+
+  for(size_t r = 0; r < numRows; r++) {
+    CHECK(m->get(r, 0) == static_cast<VT>(r * 0.5));
+    CHECK(m->get(r, 1) == static_cast<VT>(r * 10));
+  }
+
+  DataObjectFactory::destroy(m);
+}
+
 #endif
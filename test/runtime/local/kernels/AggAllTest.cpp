@@ -141,4 +141,28 @@ TEMPLATE_PRODUCT_TEST_CASE(TEST_NAME("mean"), TAG_KERNELS, (DATA_TYPES), (VALUE_
     DataObjectFactory::destroy(m0);
     DataObjectFactory::destroy(m1);
     DataObjectFactory::destroy(m2);
-}
\ No newline at end of file
+}
+
+TEMPLATE_TEST_CASE(TEST_NAME("sum, min, max on wide views"), TAG_KERNELS, double, uint32_t) {
+    using DT = DenseMatrix<TestType>;
+    
+    // more values per row than the kernel aggregates at once
+    const size_t numRows = 5;
+    const size_t numCols = 41;
+    auto m = DataObjectFactory::create<DT>(numRows, numCols, false);
+    for(size_t r = 0; r < numRows; r++)
+        for(size_t c = 0; c < numCols; c++)
+            m->set(r, c, r * numCols + c + 1);
+    // all columns but the first one, such that the rows are not contiguous
+    auto view = m->sliceCol(1, numCols);
+    
+    checkAggAll(AggOpCode::SUM, m, 205 * 206 / 2);
+    checkAggAll(AggOpCode::MIN, m, 1);
+    checkAggAll(AggOpCode::MAX, m, 205);
+    checkAggAll(AggOpCode::SUM, view, 205 * 206 / 2 - (1 + 42 + 83 + 124 + 165));
+    checkAggAll(AggOpCode::MIN, view, 2);
+    checkAggAll(AggOpCode::MAX, view, 205);
+    
+    DataObjectFactory::destroy(m);
+    DataObjectFactory::destroy(view);
+}
@@ -223,4 +223,23 @@ TEMPLATE_PRODUCT_TEST_CASE(TEST_NAME("mean"), TAG_KERNELS, (DATA_TYPES), (VALUE_
     checkAggRow(AggOpCode::MEAN, m2, m2exp);
     
     DataObjectFactory::destroy(m0, m0exp, m1, m1exp, m2, m2exp);
-}
\ No newline at end of file
+}
+
+TEMPLATE_TEST_CASE(TEST_NAME("sum, max on wide rows"), TAG_KERNELS, double, uint32_t) {
+    using DT = DenseMatrix<TestType>;
+    
+    // more values per row than the kernel aggregates at once
+    const size_t numCols = 37;
+    auto m = DataObjectFactory::create<DT>(2, numCols, false);
+    for(size_t c = 0; c < numCols; c++) {
+        m->set(0, c, c + 1);
+        m->set(1, c, 2 * (numCols - c));
+    }
+    auto sumExp = genGivenVals<DT>(2, {703, 1406});
+    auto maxExp = genGivenVals<DT>(2, {37, 74});
+    
+    checkAggRow(AggOpCode::SUM, m, sumExp);
+    checkAggRow(AggOpCode::MAX, m, maxExp);
+    
+    DataObjectFactory::destroy(m, sumExp, maxExp);
+}
@@ -0,0 +1,176 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/AggRow.h>
+#include <runtime/local/kernels/CheckEq.h>
+#include <runtime/local/kernels/CheckEqApprox.h>
+#include <runtime/local/kernels/EwBinaryMat.h>
+#include <runtime/local/kernels/EwFused.h>
+#include <runtime/local/kernels/EwUnaryMat.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <stdexcept>
+#include <vector>
+
+#define TEST_NAME(opName) "EwFused (" opName ")"
+#define VALUE_TYPES double, float
+
+template<typename VT>
+DenseMatrix<VT> * genSeq(size_t numRows, size_t numCols, VT start, VT step) {
+    auto m = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
+    VT * values = m->getValues();
+    for(size_t i = 0; i < numRows * numCols; i++)
+        values[i] = start + step * VT(i % 97);
+    return m;
+}
+
+template<typename VT>
+DenseMatrix<VT> * runFused(const std::vector<const DenseMatrix<VT> *> & args, const std::vector<VT> & scalars,
+        const char * program) {
+    DenseMatrix<VT> * res = nullptr;
+    ewFused<DenseMatrix<VT>, DenseMatrix<VT>>(res, const_cast<const DenseMatrix<VT> **>(args.data()), args.size(),
+            scalars.data(), scalars.size(), program, nullptr);
+    return res;
+}
+
+TEMPLATE_TEST_CASE(TEST_NAME("standardize"), TAG_KERNELS, VALUE_TYPES) {
+    using VT = TestType;
+    using DT = DenseMatrix<VT>;
+
+    // (X - mu) / sd with row vectors mu and sd; more columns than one tile
+    // to cover tiles that are parts of rows.
+    const size_t numCols = GENERATE(3, 2500);
+    auto X = genSeq<VT>(7, numCols, VT(1), VT(0.5));
+    auto mu = genSeq<VT>(1, numCols, VT(2), VT(0.25));
+    auto sd = genSeq<VT>(1, numCols, VT(1), VT(1));
+
+    DT * diff = nullptr;
+    ewBinaryMat<DT, DT, DT>(BinaryOpCode::SUB, diff, X, mu, nullptr);
+    DT * exp = nullptr;
+    ewBinaryMat<DT, DT, DT>(BinaryOpCode::DIV, exp, diff, sd, nullptr);
+
+    DT * res = runFused<VT>({X, mu, sd}, {}, "m0 m1 sub m2 div");
+    CHECK(*res == *exp);
+
+    DataObjectFactory::destroy(X, mu, sd, diff, exp, res);
+}
+
+TEMPLATE_TEST_CASE(TEST_NAME("scalars, unary, and column vectors"), TAG_KERNELS, VALUE_TYPES) {
+    using VT = TestType;
+    using DT = DenseMatrix<VT>;
+
+    auto X = genGivenVals<DT>(3, {
+        1, 4, 9,
+        16, 25, 36,
+        49, 64, 81,
+    });
+    auto c = genGivenVals<DT>(3, {
+        1,
+        2,
+        3,
+    });
+    auto exp = genGivenVals<DT>(3, {
+        3, 5, 7,
+        10, 12, 14,
+        17, 19, 21,
+    });
+
+    // sqrt(X) * 2 + c
+    DT * res = runFused<VT>({X, c}, {VT(2)}, "m0 sqrt s0 mul m1 add");
+    CHECK(*res == *exp);
+
+    DataObjectFactory::destroy(X, c, exp, res);
+}
+
+TEMPLATE_TEST_CASE(TEST_NAME("row aggregation"), TAG_KERNELS, VALUE_TYPES) {
+    using VT = TestType;
+    using DT = DenseMatrix<VT>;
+
+    const size_t numCols = GENERATE(5, 3000);
+    auto X = genSeq<VT>(9, numCols, VT(-3), VT(0.125));
+    auto Y = genSeq<VT>(9, numCols, VT(1), VT(0.25));
+
+    DT * prod = nullptr;
+    ewBinaryMat<DT, DT, DT>(BinaryOpCode::MUL, prod, X, Y, nullptr);
+    DT * absProd = nullptr;
+    ewUnaryMat<DT, DT>(UnaryOpCode::ABS, absProd, prod, nullptr);
+
+    for(auto opCode : {AggOpCode::SUM, AggOpCode::MIN, AggOpCode::MAX}) {
+        const char * program = opCode == AggOpCode::SUM ? "m0 m1 mul abs sumRow"
+                : opCode == AggOpCode::MIN ? "m0 m1 mul abs minRow" : "m0 m1 mul abs maxRow";
+        DT * exp = nullptr;
+        aggRow<DT, DT>(opCode, exp, absProd, nullptr);
+        DT * res = runFused<VT>({X, Y}, {}, program);
+        if(opCode == AggOpCode::SUM)
+            CHECK(checkEqApprox(res, exp, 1e-3, nullptr));
+        else
+            CHECK(*res == *exp);
+        DataObjectFactory::destroy(exp, res);
+    }
+
+    DataObjectFactory::destroy(X, Y, prod, absProd);
+}
+
+TEMPLATE_TEST_CASE(TEST_NAME("result view"), TAG_KERNELS, VALUE_TYPES) {
+    using VT = TestType;
+    using DT = DenseMatrix<VT>;
+
+    auto X = genGivenVals<DT>(2, {
+        1, 2,
+        3, 4,
+    });
+    auto whole = genGivenVals<DT>(2, {
+        0, 0, 0,
+        0, 0, 0,
+    });
+    auto exp = genGivenVals<DT>(2, {
+        0, 2, 3,
+        0, 4, 5,
+    });
+
+    // the result is written to the given view, respecting its row skip
+    DT * res = DataObjectFactory::create<DT>(whole, 0, 2, 1, 3);
+    DT * resBefore = res;
+    DT * args[] = {X};
+    const VT scalars[] = {VT(1)};
+    ewFused<DT, DT>(res, const_cast<const DT **>(args), 1, scalars, 1, "s0 m0 add", nullptr);
+    CHECK(res == resBefore);
+    CHECK(*whole == *exp);
+
+    DataObjectFactory::destroy(X, whole, exp, res);
+}
+
+TEST_CASE(TEST_NAME("invalid programs"), TAG_KERNELS) {
+    using DT = DenseMatrix<double>;
+
+    auto X = genGivenVals<DT>(2, {1, 2, 3, 4});
+    auto Y = genGivenVals<DT>(3, {1, 2, 3, 4, 5, 6});
+
+    CHECK_THROWS_AS(runFused<double>({X}, {}, "m0 add"), std::runtime_error);
+    CHECK_THROWS_AS(runFused<double>({X}, {}, "m0 m0"), std::runtime_error);
+    CHECK_THROWS_AS(runFused<double>({X}, {}, "m1"), std::runtime_error);
+    CHECK_THROWS_AS(runFused<double>({X}, {}, "m0 sumRow sqrt"), std::runtime_error);
+    CHECK_THROWS_AS(runFused<double>({X}, {}, "m0 foo"), std::runtime_error);
+    CHECK_THROWS_AS(runFused<double>({X, Y}, {}, "m0 m1 add"), std::runtime_error);
+
+    DataObjectFactory::destroy(X, Y);
+}
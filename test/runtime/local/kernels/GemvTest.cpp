@@ -0,0 +1,62 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/CheckEq.h>
+#include <runtime/local/kernels/Gemv.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <vector>
+
+template<class DTMat, class DTVec>
+void checkGemv(const DTMat * mat, const DTVec * vec, const DTVec * exp) {
+    DTVec * res = nullptr;
+    gemv(res, mat, vec, nullptr);
+    CHECK(*res == *exp);
+    DataObjectFactory::destroy(res);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("Gemv", TAG_KERNELS, (DenseMatrix, CSRMatrix), (float, double)) {
+    using DTMat = TestType;
+    using DTVec = DenseMatrix<typename DTMat::VT>;
+
+    auto m0 = genGivenVals<DTMat>(3, {
+        0, 0, 0,
+        0, 0, 0,
+        0, 0, 0,
+    });
+    auto m1 = genGivenVals<DTMat>(4, {
+        1, 0, 3,
+        0, 0, 2,
+        0, 0, 0,
+        4, 1, 0,
+    });
+    auto v0 = genGivenVals<DTVec>(3, {0, 0, 0});
+    auto v1 = genGivenVals<DTVec>(3, {1, 2, 3});
+    auto v2 = genGivenVals<DTVec>(4, {1, 2, 3, 4});
+    auto v3 = genGivenVals<DTVec>(3, {17, 4, 7});
+
+    // gemv computes t(mat) @ vec
+    checkGemv(m0, v1, v0);
+    checkGemv(m1, v2, v3);
+
+    DataObjectFactory::destroy(m0, m1, v0, v1, v2, v3);
+}
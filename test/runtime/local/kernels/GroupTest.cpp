@@ -25,6 +25,9 @@
 
 #include <tags.h>
 #include <catch.hpp>
+#include <algorithm>
+#include <map>
+#include <tuple>
 #include <vector>
 
 
@@ -201,4 +204,67 @@ TEMPLATE_TEST_CASE("Group", TAG_KERNELS, (Frame)) {
     delete aggFuncs;
     delete context;
     DataObjectFactory::destroy(arg, exp, res);
-}
\ No newline at end of file
+}
+
+TEST_CASE("Group, many rows", TAG_KERNELS) {
+    using mlir::daphne::GroupEnum;
+
+    const size_t numRows = 200000;
+    // few distinct keys use the hash-based grouping, unique keys fall back to sorting
+    const size_t numDistinct = GENERATE(1, 97, 200000);
+
+    auto c0 = DataObjectFactory::create<DenseMatrix<int64_t>>(numRows, 1, false);
+    auto c1 = DataObjectFactory::create<DenseMatrix<double>>(numRows, 1, false);
+    // reference results (count, sum, min, max) ordered by the key
+    std::map<int64_t, std::tuple<uint64_t, double, double, double>> ref;
+    for(size_t r = 0; r < numRows; r++) {
+        // scrambled, such that the keys are not sorted
+        const int64_t k = static_cast<int64_t>((r * 7919) % numDistinct) - 50;
+        const double v = static_cast<double>(r % 1000);
+        c0->getValues()[r] = k;
+        c1->getValues()[r] = v;
+        auto it = ref.find(k);
+        if(it == ref.end())
+            ref[k] = {1, v, v, v};
+        else {
+            auto & [cnt, sum, min, max] = it->second;
+            cnt++;
+            sum += v;
+            min = std::min(min, v);
+            max = std::max(max, v);
+        }
+    }
+    std::vector<Structure *> colsArg {c0, c1};
+    std::string labels[] = {"k", "v"};
+    auto arg = DataObjectFactory::create<Frame>(colsArg, labels);
+    DataObjectFactory::destroy(c0, c1);
+
+    const char * keyCols[] = {"k"};
+    const char * aggCols[] = {"v", "v", "v", "v", "v"};
+    GroupEnum aggFuncs[] = {GroupEnum::COUNT, GroupEnum::SUM, GroupEnum::MIN, GroupEnum::MAX, GroupEnum::AVG};
+    Frame * res = nullptr;
+    group(res, arg, keyCols, 1, aggCols, 5, aggFuncs, 5, nullptr);
+
+    REQUIRE(res->getNumRows() == ref.size());
+    REQUIRE(res->getNumCols() == 6);
+    CHECK(res->getLabels()[2] == "SUM(v)");
+    const int64_t * keys = static_cast<const int64_t *>(res->getColumnRaw(0));
+    const uint64_t * counts = static_cast<const uint64_t *>(res->getColumnRaw(1));
+    const double * sums = static_cast<const double *>(res->getColumnRaw(2));
+    const double * mins = static_cast<const double *>(res->getColumnRaw(3));
+    const double * maxs = static_cast<const double *>(res->getColumnRaw(4));
+    const double * avgs = static_cast<const double *>(res->getColumnRaw(5));
+    size_t i = 0;
+    for(auto & [k, agg] : ref) {
+        auto & [cnt, sum, min, max] = agg;
+        CHECK(keys[i] == k);
+        CHECK(counts[i] == cnt);
+        CHECK(sums[i] == sum);
+        CHECK(mins[i] == min);
+        CHECK(maxs[i] == max);
+        CHECK(avgs[i] == Approx(sum / cnt));
+        i++;
+    }
+
+    DataObjectFactory::destroy(arg, res);
+}
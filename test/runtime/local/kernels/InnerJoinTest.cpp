@@ -81,3 +81,91 @@ TEST_CASE("innerJoin", TAG_KERNELS) {
     DataObjectFactory::destroy(res);
     DataObjectFactory::destroy(resC0Exp, resC1Exp, resC2Exp, resC3Exp, resC4Exp);
 }
+
+TEST_CASE("innerJoin, key columns of different value types", TAG_KERNELS) {
+    auto lhsC0 = genGivenVals<DenseMatrix<int64_t>>(3, {1, 2, 3});
+    std::vector<Structure *> lhsCols = {lhsC0};
+    std::string lhsLabels[] = {"a"};
+    auto lhs = DataObjectFactory::create<Frame>(lhsCols, lhsLabels);
+
+    auto rhsC0 = genGivenVals<DenseMatrix<double>>(3, {2.0, 3.5, 1.0});
+    std::vector<Structure *> rhsCols = {rhsC0};
+    std::string rhsLabels[] = {"b"};
+    auto rhs = DataObjectFactory::create<Frame>(rhsCols, rhsLabels);
+
+    Frame * res = nullptr;
+    innerJoin(res, lhs, rhs, "a", "b", nullptr);
+
+    CHECK(res->getNumRows() == 2);
+    CHECK(res->getColumnType(0) == ValueTypeCode::SI64);
+    CHECK(res->getColumnType(1) == ValueTypeCode::F64);
+
+    auto resC0Exp = genGivenVals<DenseMatrix<int64_t>>(2, {1, 2});
+    auto resC1Exp = genGivenVals<DenseMatrix<double >>(2, {1.0, 2.0});
+    CHECK(*(res->getColumn<int64_t>(0)) == *resC0Exp);
+    CHECK(*(res->getColumn<double >(1)) == *resC1Exp);
+
+    DataObjectFactory::destroy(lhsC0, lhs, rhsC0, rhs, res, resC0Exp, resC1Exp);
+}
+
+TEMPLATE_TEST_CASE("innerJoin, many rows and duplicate keys", TAG_KERNELS, int32_t, double) {
+    using VTKey = TestType;
+    // enough rows for multiple partitions and threads; the smaller input is
+    // once on the left and once on the right
+    const size_t numRowsSmall = 20000;
+    const size_t numRowsLarge = 100000;
+    const size_t numKeys = 30000;
+    const bool smallLhs = GENERATE(true, false);
+    const size_t numRowsLhs = smallLhs ? numRowsSmall : numRowsLarge;
+    const size_t numRowsRhs = smallLhs ? numRowsLarge : numRowsSmall;
+
+    std::vector<VTKey> lhsKeys, rhsKeys;
+    for(size_t r = 0; r < numRowsLhs; r++)
+        lhsKeys.push_back(static_cast<VTKey>((r * 7) % numKeys));
+    for(size_t r = 0; r < numRowsRhs; r++)
+        rhsKeys.push_back(static_cast<VTKey>((r * 13) % numKeys));
+
+    auto lhsC0 = genGivenVals<DenseMatrix<VTKey>>(numRowsLhs, lhsKeys);
+    auto lhsC1 = DataObjectFactory::create<DenseMatrix<int64_t>>(numRowsLhs, 1, false);
+    for(size_t r = 0; r < numRowsLhs; r++)
+        lhsC1->set(r, 0, r);
+    auto rhsC0 = genGivenVals<DenseMatrix<VTKey>>(numRowsRhs, rhsKeys);
+    auto rhsC1 = DataObjectFactory::create<DenseMatrix<int64_t>>(numRowsRhs, 1, false);
+    for(size_t r = 0; r < numRowsRhs; r++)
+        rhsC1->set(r, 0, r);
+    std::vector<Structure *> lhsCols = {lhsC0, lhsC1};
+    std::vector<Structure *> rhsCols = {rhsC0, rhsC1};
+    std::string lhsLabels[] = {"a", "b"};
+    std::string rhsLabels[] = {"c", "d"};
+    auto lhs = DataObjectFactory::create<Frame>(lhsCols, lhsLabels);
+    auto rhs = DataObjectFactory::create<Frame>(rhsCols, rhsLabels);
+
+    Frame * res = nullptr;
+    innerJoin(res, lhs, rhs, "a", "c", nullptr);
+
+    // expected matches in the order of a nested-loop join
+    std::vector<std::vector<size_t>> rhsRowsOfKey(numKeys);
+    for(size_t r = 0; r < numRowsRhs; r++)
+        rhsRowsOfKey[static_cast<size_t>(rhsKeys[r])].push_back(r);
+    std::vector<std::pair<size_t, size_t>> exp;
+    for(size_t l = 0; l < numRowsLhs; l++)
+        for(size_t r : rhsRowsOfKey[static_cast<size_t>(lhsKeys[l])])
+            exp.emplace_back(l, r);
+
+    REQUIRE(res->getNumRows() == exp.size());
+    REQUIRE(res->getNumCols() == 4);
+    auto resA = res->getColumn<VTKey>(0);
+    auto resB = res->getColumn<int64_t>(1);
+    auto resC = res->getColumn<VTKey>(2);
+    auto resD = res->getColumn<int64_t>(3);
+    size_t numMismatches = 0;
+    for(size_t i = 0; i < exp.size(); i++)
+        numMismatches += resB->get(i, 0) != static_cast<int64_t>(exp[i].first) ||
+                resD->get(i, 0) != static_cast<int64_t>(exp[i].second) ||
+                resA->get(i, 0) != lhsKeys[exp[i].first] || resC->get(i, 0) != lhsKeys[exp[i].first];
+    CHECK(numMismatches == 0);
+
+    DataObjectFactory::destroy(lhsC0, lhsC1, lhs);
+    DataObjectFactory::destroy(rhsC0, rhsC1, rhs);
+    DataObjectFactory::destroy(resA, resB, resC, resD, res);
+}
@@ -14,7 +14,10 @@
  * limitations under the License.
  */
 
+#include <api/cli/DaphneUserConfig.h>
+#include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/kernels/CheckEq.h>
 #include <runtime/local/kernels/MatMul.h>
@@ -109,4 +112,112 @@ TEMPLATE_PRODUCT_TEST_CASE("MatMul", TAG_KERNELS, (DenseMatrix), (float, double)
     checkMatMul(v5, v2, v6);
 
     DataObjectFactory::destroy(m0, m1, m2, m3, m4, m5, v0, v1, v2, v3, v4, v5, v6);
-}
\ No newline at end of file
+}
+
+TEMPLATE_TEST_CASE("MatMul, sparse lhs", TAG_KERNELS, float, double) {
+    using VT = TestType;
+    using DTDense = DenseMatrix<VT>;
+    using DTSparse = CSRMatrix<VT>;
+
+    std::vector<VT> lhsVals {
+        1, 0, 3, 0,
+        0, 0, 0, 0,
+        0, 2, 0, 1,
+    };
+    std::vector<VT> rhsVals {
+        0, 1, 0,
+        2, 0, 0,
+        1, 1, 0,
+        0, 0, 4,
+    };
+    std::vector<VT> expVals {
+        3, 4, 0,
+        0, 0, 0,
+        4, 0, 4,
+    };
+    auto lhs = genGivenVals<DTSparse>(3, lhsVals);
+    auto rhsDense = genGivenVals<DTDense>(4, rhsVals);
+    auto rhsSparse = genGivenVals<DTSparse>(4, rhsVals);
+    auto expDense = genGivenVals<DTDense>(3, expVals);
+    auto expSparse = genGivenVals<DTSparse>(3, expVals);
+    auto vec = genGivenVals<DTDense>(4, {1, 2, 3, 4});
+    auto expVec = genGivenVals<DTDense>(3, {10, 0, 8});
+
+    DTDense * resDense = nullptr;
+    matMul(resDense, lhs, rhsDense, nullptr);
+    CHECK(*resDense == *expDense);
+    DataObjectFactory::destroy(resDense);
+
+    resDense = nullptr;
+    matMul(resDense, lhs, rhsSparse, nullptr);
+    CHECK(*resDense == *expDense);
+    DataObjectFactory::destroy(resDense);
+
+    DTSparse * resSparse = nullptr;
+    matMul(resSparse, lhs, rhsSparse, nullptr);
+    CHECK(*resSparse == *expSparse);
+    DataObjectFactory::destroy(resSparse);
+
+    DTDense * resVec = nullptr;
+    matMul(resVec, lhs, vec, nullptr);
+    CHECK(*resVec == *expVec);
+
+    DataObjectFactory::destroy(lhs, rhsDense, rhsSparse, expDense, expSparse, vec, expVec, resVec);
+}
+
+TEMPLATE_TEST_CASE("MatMul, large sparse matrices", TAG_KERNELS, float, double) {
+    using VT = TestType;
+
+    DaphneUserConfig config;
+    config.numberOfThreads = GENERATE(1, 4);
+    DaphneContext ctx(config);
+
+    // small integers, such that the results are exact
+    auto genSparse = [](size_t numRows, size_t numCols, size_t seed, size_t density) {
+        auto m = DataObjectFactory::create<CSRMatrix<VT>>(numRows, numCols, numRows * numCols, false);
+        size_t * rowOffsets = m->getRowOffsets();
+        rowOffsets[0] = 0;
+        for(size_t r = 0; r < numRows; r++) {
+            size_t pos = rowOffsets[r];
+            for(size_t c = 0; c < numCols; c++)
+                if((r * 7 + c * 13 + seed) % 100 < density) {
+                    m->getColIdxs()[pos] = c;
+                    m->getValues()[pos] = static_cast<VT>((r + c) % 5 + 1);
+                    pos++;
+                }
+            rowOffsets[r + 1] = pos;
+        }
+        return m;
+    };
+    auto toDense = [](const CSRMatrix<VT> * m) {
+        auto d = DataObjectFactory::create<DenseMatrix<VT>>(m->getNumRows(), m->getNumCols(), false);
+        for(size_t r = 0; r < m->getNumRows(); r++)
+            for(size_t c = 0; c < m->getNumCols(); c++)
+                d->set(r, c, m->get(r, c));
+        return d;
+    };
+
+    // very sparse rows use hash accumulators, denser ones dense accumulators
+    const size_t density = GENERATE(1, 30);
+    auto lhs = genSparse(400, 300, 1, density);
+    auto rhs = genSparse(300, 2000, 2, density);
+    auto lhsDense = toDense(lhs);
+    auto rhsDense = toDense(rhs);
+    DenseMatrix<VT> * exp = nullptr;
+    matMul(exp, lhsDense, rhsDense, nullptr);
+
+    CSRMatrix<VT> * resSparse = nullptr;
+    matMul(resSparse, lhs, rhs, &ctx);
+    auto resSparseDense = toDense(resSparse);
+    CHECK(*resSparseDense == *exp);
+
+    DenseMatrix<VT> * resDense1 = nullptr;
+    matMul(resDense1, lhs, rhs, &ctx);
+    CHECK(*resDense1 == *exp);
+
+    DenseMatrix<VT> * resDense2 = nullptr;
+    matMul(resDense2, lhs, rhsDense, &ctx);
+    CHECK(*resDense2 == *exp);
+
+    DataObjectFactory::destroy(lhs, rhs, lhsDense, rhsDense, exp, resSparse, resSparseDense, resDense1, resDense2);
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/DataObjectFactory.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/BinaryOpCode.h>
+#include <runtime/local/kernels/CheckEq.h>
+#include <runtime/local/kernels/EwBinaryMat.h>
+#include <runtime/local/kernels/InsertCol.h>
+#include <runtime/local/kernels/InsertRow.h>
+#include <runtime/local/kernels/ReuseForResult.h>
+
+#include <tags.h>
+
+#include <catch.hpp>
+
+#include <cstdint>
+
+#define VALUE_TYPES double, float, int64_t, uint64_t, uint8_t
+
+TEMPLATE_PRODUCT_TEST_CASE("ReuseForResult", TAG_KERNELS, (DenseMatrix), (VALUE_TYPES)) {
+    using DT = TestType;
+
+    auto arg = genGivenVals<DT>(2, {
+        1, 2, 3,
+        4, 5, 6,
+    });
+
+    SECTION("only reference") {
+        DT * res = nullptr;
+        reuseForResult(res, arg, nullptr);
+        CHECK(res == arg);
+        // decreased after the kernel as usual
+        CHECK(arg->getRefCounter() == 2);
+        DataObjectFactory::destroy(res);
+    }
+    SECTION("referenced elsewhere") {
+        arg->increaseRefCounter();
+        DT * res = arg;
+        reuseForResult(res, arg, nullptr);
+        CHECK(res == nullptr);
+        CHECK(arg->getRefCounter() == 2);
+        DataObjectFactory::destroy(arg);
+    }
+    SECTION("values referenced by a view") {
+        auto view = DataObjectFactory::create<DT>(arg, 0, 1, 0, 3);
+        DT * res = arg;
+        reuseForResult(res, arg, nullptr);
+        CHECK(res == nullptr);
+        CHECK(arg->getRefCounter() == 1);
+        DataObjectFactory::destroy(view);
+    }
+
+    DataObjectFactory::destroy(arg);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("ReuseForResult updates in place", TAG_KERNELS, (DenseMatrix), (VALUE_TYPES)) {
+    using DT = TestType;
+
+    auto arg = genGivenVals<DT>(3, {
+        1, 2, 3,
+        4, 5, 6,
+        7, 8, 9,
+    });
+    DT * res = nullptr;
+    reuseForResult(res, arg, nullptr);
+    REQUIRE(res == arg);
+    DT * exp = nullptr;
+
+    SECTION("ewBinaryMat") {
+        ewBinaryMat<DT, DT, DT>(BinaryOpCode::ADD, res, arg, arg, nullptr);
+        exp = genGivenVals<DT>(3, {
+            2, 4, 6,
+            8, 10, 12,
+            14, 16, 18,
+        });
+    }
+    SECTION("insertRow") {
+        auto ins = genGivenVals<DT>(1, {0, 0, 0});
+        insertRow(res, arg, ins, 1, 2, nullptr);
+        DataObjectFactory::destroy(ins);
+        exp = genGivenVals<DT>(3, {
+            1, 2, 3,
+            0, 0, 0,
+            7, 8, 9,
+        });
+    }
+    SECTION("insertCol") {
+        auto ins = genGivenVals<DT>(3, {0, 0, 0, 0, 0, 0});
+        insertCol(res, arg, ins, 1, 3, nullptr);
+        DataObjectFactory::destroy(ins);
+        exp = genGivenVals<DT>(3, {
+            1, 0, 0,
+            4, 0, 0,
+            7, 0, 0,
+        });
+    }
+
+    CHECK(res == arg);
+    CHECK(*res == *exp);
+
+    DataObjectFactory::destroy(exp);
+    DataObjectFactory::destroy(res);
+    DataObjectFactory::destroy(arg);
+}
@@ -15,6 +15,7 @@
  */
 
 #include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/kernels/CheckEq.h>
 #include <runtime/local/kernels/MatMul.h>
@@ -42,7 +43,31 @@ void checkSyrk(const DT * arg) {
     DataObjectFactory::destroy(resExp);
 }
 
-TEMPLATE_PRODUCT_TEST_CASE("Syrk", TAG_KERNELS, (DenseMatrix), (float, double)) {
+template<typename VT>
+void checkSyrk(const CSRMatrix<VT> * arg) {
+    // The CSR kernel is checked against the dense one on the same values.
+    const size_t numRows = arg->getNumRows();
+    const size_t numCols = arg->getNumCols();
+    auto argDense = DataObjectFactory::create<DenseMatrix<VT>>(numRows, numCols, false);
+    for(size_t r = 0; r < numRows; r++)
+        for(size_t c = 0; c < numCols; c++)
+            argDense->set(r, c, arg->get(r, c));
+    DenseMatrix<VT> * resExp = nullptr;
+    syrk(resExp, argDense, nullptr);
+
+    CSRMatrix<VT> * resAct = nullptr;
+    syrk(resAct, arg, nullptr);
+    REQUIRE(resAct->getNumRows() == numCols);
+    REQUIRE(resAct->getNumCols() == numCols);
+    for(size_t r = 0; r < numCols; r++)
+        for(size_t c = 0; c < numCols; c++)
+            CHECK(resAct->get(r, c) == resExp->get(r, c));
+    DataObjectFactory::destroy(resAct);
+    DataObjectFactory::destroy(resExp);
+    DataObjectFactory::destroy(argDense);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("Syrk", TAG_KERNELS, (DenseMatrix, CSRMatrix), (float, double)) {
     using DT = TestType;
     
     auto m0 = genGivenVals<DT>(3, {
@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <api/cli/DaphneUserConfig.h>
+#include <runtime/local/context/DaphneContext.h>
 #include <runtime/local/datastructures/CSRMatrix.h>
 #include <runtime/local/datastructures/DenseMatrix.h>
 #include <runtime/local/datagen/GenGivenVals.h>
@@ -24,6 +26,8 @@
 
 #include <catch.hpp>
 
+#include <algorithm>
+
 #include <cstdint>
 
 template<class DT>
@@ -87,4 +91,52 @@ TEMPLATE_PRODUCT_TEST_CASE("Transpose", TAG_KERNELS, (DenseMatrix, CSRMatrix), (
 
     DataObjectFactory::destroy(m);
     DataObjectFactory::destroy(mt);
-}
\ No newline at end of file
+}
+
+TEMPLATE_TEST_CASE("Transpose, large sparse matrix", TAG_KERNELS, double, uint32_t) {
+    using VT = TestType;
+
+    const size_t numRows = 700;
+    const size_t numCols = 300;
+    DaphneUserConfig config;
+    config.numberOfThreads = GENERATE(1, 4);
+    DaphneContext ctx(config);
+
+    // roughly every second cell is non-zero, some rows are empty
+    auto m = DataObjectFactory::create<CSRMatrix<VT>>(numRows, numCols, numRows * numCols, true);
+    size_t * rowOffsets = m->getRowOffsets();
+    for(size_t r = 0; r < numRows; r++) {
+        size_t pos = rowOffsets[r];
+        if(r % 10 != 3)
+            for(size_t c = 0; c < numCols; c++)
+                if((r * 31 + c * 17) % 5 < 3) {
+                    m->getColIdxs()[pos] = c;
+                    m->getValues()[pos] = static_cast<VT>(r * numCols + c + 1);
+                    pos++;
+                }
+        rowOffsets[r + 1] = pos;
+    }
+    // the whole matrix and a view on some rows
+    const size_t rowLower = GENERATE(0, 123);
+    const CSRMatrix<VT> * arg = rowLower ? DataObjectFactory::create<CSRMatrix<VT>>(m, rowLower, numRows - 5) : m;
+
+    CSRMatrix<VT> * res = nullptr;
+    transpose(res, arg, &ctx);
+
+    REQUIRE(res->getNumRows() == numCols);
+    REQUIRE(res->getNumCols() == arg->getNumRows());
+    CHECK(res->getNumNonZeros() == arg->getNumNonZeros());
+    bool sorted = true;
+    for(size_t c = 0; c < numCols; c++)
+        sorted &= std::is_sorted(res->getColIdxs(c), res->getColIdxs(c + 1));
+    CHECK(sorted);
+    bool equal = true;
+    for(size_t r = 0; r < arg->getNumRows(); r++)
+        for(size_t c = 0; c < numCols; c++)
+            equal &= res->get(c, r) == arg->get(r, c);
+    CHECK(equal);
+
+    if(arg != m)
+        DataObjectFactory::destroy(arg);
+    DataObjectFactory::destroy(m, res);
+}
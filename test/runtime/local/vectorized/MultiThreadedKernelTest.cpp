@@ -18,6 +18,7 @@
 #include <runtime/local/kernels/CheckEqApprox.h>
 #include <runtime/local/kernels/EwBinaryMat.h>
 #include <runtime/local/kernels/RandMatrix.h>
+#include <runtime/local/kernels/Transpose.h>
 #include <runtime/local/vectorized/MTWrapper.h>
 
 #include <tags.h>
@@ -45,6 +46,18 @@ void funMul(DT*** outputs, Structure** inputs, DCTX(ctx)) {
         ctx);
 }
 
+template<class DT>
+void funAddNewRes(DT*** outputs, Structure** inputs, DCTX(ctx)) {
+    // ignores the view of the result passed in, such that the output is copied
+    *outputs[0] = nullptr;
+    funAdd(outputs, inputs, ctx);
+}
+
+template<class DT>
+void funTranspose(DT*** outputs, Structure** inputs, DCTX(ctx)) {
+    transpose(*outputs[0], reinterpret_cast<DT*>(inputs[0]), ctx);
+}
+
 TEMPLATE_PRODUCT_TEST_CASE("Multi-threaded-scheduling", TAG_VECTORIZED, (DATA_TYPES), (VALUE_TYPES)){
     using DT = TestType;
     using VT = typename DT::VT;
@@ -156,3 +169,173 @@ TEMPLATE_PRODUCT_TEST_CASE("Multi-threaded X*Y", TAG_VECTORIZED, (DATA_TYPES), (
     DataObjectFactory::destroy(r1);
     DataObjectFactory::destroy(r2);
 }
+
+TEMPLATE_PRODUCT_TEST_CASE("Multi-threaded X+Y NUMA-aware", TAG_VECTORIZED, (DATA_TYPES), (VALUE_TYPES)) { // NOLINT(cert-err58-cpp)
+    using DT = TestType;
+    using VT = typename DT::VT;
+
+    DaphneUserConfig user_config{};
+    user_config.numaAware = true;
+    user_config.taskPartitioningScheme = GSS;
+    auto ctx = std::make_unique<DaphneContext>(user_config);
+
+    DT *m1 = nullptr, *m2 = nullptr;
+    randMatrix<DT, VT>(m1, 1234, 10, 0.0, 1.0, 1.0, 7, nullptr);
+    randMatrix<DT, VT>(m2, 1234, 10, 0.0, 1.0, 1.0, 3, nullptr);
+
+    DT *r1 = nullptr, *r2 = nullptr;
+    ewBinaryMat<DT, DT, DT>(BinaryOpCode::ADD, r1, m1, m2, nullptr); //single-threaded
+
+    auto wrapper = std::make_unique<MTWrapper<DT>>(4, 1, ctx.get());
+
+    DT **outputs[] = {&r2};
+    bool isScalar[] = {false, false};
+    Structure *inputs[] = {m1, m2};
+    int64_t outRows[] = {1234};
+    int64_t outCols[] = {10};
+    VectorSplit splits[] = {VectorSplit::ROWS, VectorSplit::ROWS};
+    VectorCombine combines[] = {VectorCombine::ROWS};
+
+    std::vector<std::function<void(DT ***, Structure **, DCTX(ctx))>> funcs;
+    funcs.push_back(std::function<void(DT***, Structure**, DCTX(ctx))>(reinterpret_cast<void (*)(DT***, Structure **,
+            DCTX(ctx))>(reinterpret_cast<void*>(&funAdd<DT>))));
+    wrapper->executeSingleQueue(funcs, outputs, isScalar, inputs, 2, 1, outRows, outCols, splits, combines, ctx.get(), false);
+
+    CHECK(checkEqApprox(r1, r2, 1e-6, nullptr));
+
+    DataObjectFactory::destroy(m1);
+    DataObjectFactory::destroy(m2);
+    DataObjectFactory::destroy(r1);
+    DataObjectFactory::destroy(r2);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("Multi-threaded X+Y with newly allocated outputs", TAG_VECTORIZED, (DATA_TYPES), (VALUE_TYPES)) { // NOLINT(cert-err58-cpp)
+    using DT = TestType;
+    using VT = typename DT::VT;
+
+    DaphneUserConfig user_config{};
+    auto ctx = std::make_unique<DaphneContext>(user_config);
+
+    DT *m1 = nullptr, *m2 = nullptr;
+    randMatrix<DT, VT>(m1, 1234, 10, 0.0, 1.0, 1.0, 7, nullptr);
+    randMatrix<DT, VT>(m2, 1234, 10, 0.0, 1.0, 1.0, 3, nullptr);
+
+    DT *r1 = nullptr, *r2 = nullptr;
+    ewBinaryMat<DT, DT, DT>(BinaryOpCode::ADD, r1, m1, m2, nullptr); //single-threaded
+
+    auto wrapper = std::make_unique<MTWrapper<DT>>(4, 1, ctx.get());
+
+    DT **outputs[] = {&r2};
+    bool isScalar[] = {false, false};
+    Structure *inputs[] = {m1, m2};
+    int64_t outRows[] = {1234};
+    int64_t outCols[] = {10};
+    VectorSplit splits[] = {VectorSplit::ROWS, VectorSplit::ROWS};
+    VectorCombine combines[] = {VectorCombine::ROWS};
+
+    std::vector<std::function<void(DT ***, Structure **, DCTX(ctx))>> funcs;
+    funcs.push_back(std::function<void(DT***, Structure**, DCTX(ctx))>(reinterpret_cast<void (*)(DT***, Structure **,
+            DCTX(ctx))>(reinterpret_cast<void*>(&funAddNewRes<DT>))));
+    wrapper->executeSingleQueue(funcs, outputs, isScalar, inputs, 2, 1, outRows, outCols, splits, combines, ctx.get(), false);
+
+    CHECK(checkEqApprox(r1, r2, 1e-6, nullptr));
+
+    DataObjectFactory::destroy(m1);
+    DataObjectFactory::destroy(m2);
+    DataObjectFactory::destroy(r1);
+    DataObjectFactory::destroy(r2);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("Multi-threaded t(X) column-wise combine", TAG_VECTORIZED, (DATA_TYPES), (VALUE_TYPES)) { // NOLINT(cert-err58-cpp)
+    using DT = TestType;
+    using VT = typename DT::VT;
+
+    DaphneUserConfig user_config{};
+    auto ctx = std::make_unique<DaphneContext>(user_config);
+
+    DT *m1 = nullptr;
+    randMatrix<DT, VT>(m1, 1234, 10, 0.0, 1.0, 1.0, 7, nullptr);
+
+    DT *r1 = nullptr, *r2 = nullptr;
+    transpose<DT, DT>(r1, m1, nullptr); //single-threaded
+
+    auto wrapper = std::make_unique<MTWrapper<DT>>(4, 1, ctx.get());
+
+    DT **outputs[] = {&r2};
+    bool isScalar[] = {false};
+    Structure *inputs[] = {m1};
+    int64_t outRows[] = {10};
+    int64_t outCols[] = {1234};
+    VectorSplit splits[] = {VectorSplit::ROWS};
+    VectorCombine combines[] = {VectorCombine::COLS};
+
+    std::vector<std::function<void(DT ***, Structure **, DCTX(ctx))>> funcs;
+    funcs.push_back(std::function<void(DT***, Structure**, DCTX(ctx))>(reinterpret_cast<void (*)(DT***, Structure **,
+            DCTX(ctx))>(reinterpret_cast<void*>(&funTranspose<DT>))));
+    wrapper->executeSingleQueue(funcs, outputs, isScalar, inputs, 1, 1, outRows, outCols, splits, combines, ctx.get(), false);
+
+    CHECK(checkEqApprox(r1, r2, 1e-6, nullptr));
+
+    DataObjectFactory::destroy(m1);
+    DataObjectFactory::destroy(r1);
+    DataObjectFactory::destroy(r2);
+}
+
+TEMPLATE_PRODUCT_TEST_CASE("Multi-threaded adaptive self-scheduling", TAG_VECTORIZED, (DATA_TYPES), (VALUE_TYPES)) { // NOLINT(cert-err58-cpp)
+    using DT = TestType;
+    using VT = typename DT::VT;
+
+    DaphneUserConfig user_config{};
+    user_config.taskPartitioningScheme = GENERATE(AWF, AF);
+    user_config.minimumTaskSize = 10;
+    auto ctx = std::make_unique<DaphneContext>(user_config);
+
+    DT *m1 = nullptr, *m2 = nullptr;
+    randMatrix<DT, VT>(m1, 1234, 10, 0.0, 1.0, 1.0, 7, nullptr);
+    randMatrix<DT, VT>(m2, 1234, 10, 0.0, 1.0, 1.0, 3, nullptr);
+
+    DT *r1 = nullptr, *r2 = nullptr;
+    ewBinaryMat<DT, DT, DT>(BinaryOpCode::ADD, r1, m1, m2, nullptr); //single-threaded
+
+    auto wrapper = std::make_unique<MTWrapper<DT>>(4, 1, ctx.get());
+
+    DT **outputs[] = {&r2};
+    bool isScalar[] = {false, false};
+    Structure *inputs[] = {m1, m2};
+    int64_t outRows[] = {1234};
+    int64_t outCols[] = {10};
+    VectorSplit splits[] = {VectorSplit::ROWS, VectorSplit::ROWS};
+    VectorCombine combines[] = {VectorCombine::ROWS};
+
+    std::vector<std::function<void(DT ***, Structure **, DCTX(ctx))>> funcs;
+    funcs.push_back(std::function<void(DT***, Structure**, DCTX(ctx))>(reinterpret_cast<void (*)(DT***, Structure **,
+            DCTX(ctx))>(reinterpret_cast<void*>(&funAdd<DT>))));
+    wrapper->executeSingleQueue(funcs, outputs, isScalar, inputs, 2, 1, outRows, outCols, splits, combines, ctx.get(), false);
+
+    CHECK(checkEqApprox(r1, r2, 1e-6, nullptr));
+
+    DataObjectFactory::destroy(m1);
+    DataObjectFactory::destroy(m2);
+    DataObjectFactory::destroy(r1);
+    DataObjectFactory::destroy(r2);
+}
+
+TEST_CASE("Adaptive self-scheduling favors faster workers", TAG_VECTORIZED) {
+    auto method = GENERATE(AWF, AF);
+    LoadPartitioning lp(method, 10000, 1, 2, false);
+    CHECK(lp.isAdaptive());
+
+    // worker 0 takes ten times as long per task as worker 1
+    auto c0 = lp.getNextChunk(0);
+    lp.recordChunk(0, c0, 10.0 * c0);
+    auto c1 = lp.getNextChunk(1);
+    lp.recordChunk(1, c1, 1.0 * c1);
+    auto fast = lp.getNextChunk(1);
+    auto slow = lp.getNextChunk(0);
+    CHECK(fast > slow);
+
+    uint64_t scheduled = c0 + c1 + fast + slow;
+    while(lp.hasNextChunk())
+        scheduled += lp.getNextChunk(scheduled % 2);
+    CHECK(scheduled == 10000);
+}
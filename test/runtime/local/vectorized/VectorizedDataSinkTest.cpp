@@ -0,0 +1,100 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/datagen/GenGivenVals.h>
+#include <runtime/local/datastructures/DenseMatrix.h>
+#include <runtime/local/kernels/CheckEq.h>
+#include <runtime/local/vectorized/VectorizedDataSink.h>
+
+#include <tags.h>
+#include <catch.hpp>
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+TEMPLATE_TEST_CASE("VectorizedDataSink<DenseMatrix>, rows", TAG_VECTORIZED, double, float, int64_t) {
+    using DT = DenseMatrix<TestType>;
+    std::mutex mtx;
+    auto res = DataObjectFactory::create<DT>(4, 2, false);
+    VectorizedDataSink<DT> sink(VectorCombine::ROWS, res, mtx, nullptr);
+
+    // rows 0-1 computed in place
+    auto view = sink.getView(0, 2);
+    REQUIRE(view != nullptr);
+    view->set(0, 0, 1); view->set(0, 1, 2);
+    view->set(1, 0, 3); view->set(1, 1, 4);
+    sink.add(view, 0);
+    // rows 2-3 computed separately and copied, from a view with a row skip
+    auto part = genGivenVals<DT>(2, {
+        5, 6, 0,
+        7, 8, 0,
+    });
+    sink.add(part->sliceCol(0, 2), 2);
+    DataObjectFactory::destroy(part);
+
+    auto exp = genGivenVals<DT>(4, {
+        1, 2,
+        3, 4,
+        5, 6,
+        7, 8,
+    });
+    CHECK(*res == *exp);
+    DataObjectFactory::destroy(res, exp);
+}
+
+TEMPLATE_TEST_CASE("VectorizedDataSink<DenseMatrix>, cols", TAG_VECTORIZED, double, float, int64_t) {
+    using DT = DenseMatrix<TestType>;
+    std::mutex mtx;
+    auto res = DataObjectFactory::create<DT>(2, 3, false);
+    VectorizedDataSink<DT> sink(VectorCombine::COLS, res, mtx, nullptr);
+    CHECK(sink.getView(0, 1) == nullptr);
+
+    sink.add(genGivenVals<DT>(2, {3, 6}), 2);
+    sink.add(genGivenVals<DT>(2, {1, 2, 4, 5}), 0);
+
+    auto exp = genGivenVals<DT>(2, {
+        1, 2, 3,
+        4, 5, 6,
+    });
+    CHECK(*res == *exp);
+    DataObjectFactory::destroy(res, exp);
+}
+
+TEMPLATE_TEST_CASE("VectorizedDataSink<DenseMatrix>, add", TAG_VECTORIZED, double, float, int64_t) {
+    using DT = DenseMatrix<TestType>;
+    const size_t numThreads = 4;
+    const size_t numAdds = 100;
+    std::mutex mtx;
+    DT * res = nullptr;
+    VectorizedDataSink<DT> sink(VectorCombine::ADD, res, mtx, nullptr);
+    CHECK(sink.getView(0, 1) == nullptr);
+
+    std::vector<std::thread> threads;
+    for(size_t t = 0; t < numThreads; t++)
+        threads.emplace_back([&sink]() {
+            for(size_t i = 0; i < numAdds; i++)
+                sink.add(genGivenVals<DT>(1, {1, 2}), 0);
+        });
+    for(auto & t : threads)
+        t.join();
+
+    const TestType n = numThreads * numAdds;
+    auto exp = genGivenVals<DT>(1, {n, 2 * n});
+    REQUIRE(res != nullptr);
+    CHECK(*res == *exp);
+    DataObjectFactory::destroy(res, exp);
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright 2021 The DAPHNE Consortium
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <runtime/local/vectorized/WorkerPool.h>
+
+#include <tags.h>
+#include <catch.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+class CountingTask : public Task {
+    std::atomic<uint64_t>& _count;
+    std::atomic<uint64_t>& _sumBatchSize;
+public:
+    CountingTask(std::atomic<uint64_t>& count, std::atomic<uint64_t>& sumBatchSize)
+            : _count(count), _sumBatchSize(sumBatchSize) {}
+    void execute(uint32_t fid, uint32_t batchSize) override {
+        _count++;
+        _sumBatchSize += batchSize;
+    }
+};
+
+TEST_CASE("WorkerPool executes all tasks", TAG_VECTORIZED) {
+    auto queueType = GENERATE(TaskQueueType::BLOCKING, TaskQueueType::LOCKFREE);
+    WorkerPool pool(4, queueType, false, false);
+    CHECK(pool.getNumWorkers() == 4);
+
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sumBatchSize{0};
+    std::vector<Task*> tasks;
+    for(size_t i = 0; i < 1000; i++)
+        tasks.push_back(new CountingTask(count, sumBatchSize));
+    pool.execute(tasks, 3);
+
+    CHECK(count == 1000);
+    CHECK(sumBatchSize == 3000);
+}
+
+class NumThreadsTask : public Task {
+    std::atomic<uint64_t>& _maxNumThreads;
+public:
+    explicit NumThreadsTask(std::atomic<uint64_t>& maxNumThreads) : _maxNumThreads(maxNumThreads) {}
+    void execute(uint32_t fid, uint32_t batchSize) override {
+        const uint64_t numThreads = parallelForNumThreads(size_t(1) << 20, 4);
+        uint64_t prev = _maxNumThreads;
+        while(prev < numThreads && !_maxNumThreads.compare_exchange_weak(prev, numThreads));
+    }
+};
+
+TEST_CASE("WorkerPool runs the kernels of its tasks single-threaded", TAG_VECTORIZED) {
+    WorkerPool pool(2, TaskQueueType::BLOCKING, false, false);
+    // outside of the pool, large inputs are processed by multiple threads
+    CHECK(parallelForNumThreads(size_t(1) << 20, 4) == 4);
+
+    std::atomic<uint64_t> maxNumThreads{0};
+    std::vector<Task*> tasks;
+    for(size_t i = 0; i < 10; i++)
+        tasks.push_back(new NumThreadsTask(maxNumThreads));
+    pool.execute(tasks, 1);
+    CHECK(maxNumThreads == 1);
+}
+
+TEST_CASE("WorkerPool is reused across submissions", TAG_VECTORIZED) {
+    auto queueType = GENERATE(TaskQueueType::BLOCKING, TaskQueueType::LOCKFREE);
+    WorkerPool pool(3, queueType, false, false);
+
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sumBatchSize{0};
+    for(size_t r = 0; r < 100; r++) {
+        // fewer tasks than workers, such that some workers stay idle
+        std::vector<Task*> tasks{new CountingTask(count, sumBatchSize), new CountingTask(count, sumBatchSize)};
+        pool.execute(tasks, 1);
+        CHECK(count == 2 * (r + 1));
+    }
+
+    // empty submissions must not block
+    pool.execute({}, 1);
+    CHECK(count == 200);
+}
+
+TEST_CASE("WorkerPool with concurrent task groups", TAG_VECTORIZED) {
+    auto queueType = GENERATE(TaskQueueType::BLOCKING, TaskQueueType::LOCKFREE);
+    WorkerPool pool(4, queueType, false, false);
+
+    std::atomic<uint64_t> count1{0}, count2{0};
+    std::atomic<uint64_t> sum1{0}, sum2{0};
+    std::vector<Task*> tasks1, tasks2;
+    // more tasks than the per-worker queues can hold at once
+    for(size_t i = 0; i < 20000; i++) {
+        tasks1.push_back(new CountingTask(count1, sum1));
+        tasks2.push_back(new CountingTask(count2, sum2));
+    }
+    TaskGroup g1, g2;
+    pool.submit(tasks1, 1, g1);
+    pool.submit(tasks2, 2, g2);
+    g1.wait();
+    g2.wait();
+
+    CHECK(count1 == 20000);
+    CHECK(count2 == 20000);
+    CHECK(sum1 == 20000);
+    CHECK(sum2 == 40000);
+}
+
+TEST_CASE("NUMA topology parsing", TAG_VECTORIZED) {
+    CHECK(NumaTopology::parseCpuList("0-3,8-9,12\n") == std::vector<uint32_t>{0, 1, 2, 3, 8, 9, 12});
+    CHECK(NumaTopology::parseCpuList("5") == std::vector<uint32_t>{5});
+
+    auto topo = NumaTopology::detect();
+    CHECK(topo.getNumNodes() >= 1);
+    for(auto& cpus : topo.nodeCpus)
+        CHECK(!cpus.empty());
+}
+
+TEST_CASE("NUMA-aware WorkerPool executes tasks submitted to nodes", TAG_VECTORIZED) {
+    WorkerPool pool(4, TaskQueueType::BLOCKING, true, false);
+    CHECK(pool.isNumaAware());
+    CHECK(pool.getNumNodes() >= 1);
+    CHECK(pool.getNumNodes() <= 4);
+
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sumBatchSize{0};
+    std::vector<Task*> tasks;
+    std::vector<uint32_t> nodes;
+    for(size_t i = 0; i < 1000; i++) {
+        tasks.push_back(new CountingTask(count, sumBatchSize));
+        nodes.push_back(static_cast<uint32_t>(i * pool.getNumNodes() / 1000));
+    }
+    pool.execute(tasks, 1, &nodes);
+
+    CHECK(count == 1000);
+}
@@ -38,6 +38,7 @@
 #define TAG_LITERALS "[literals]"
 #define TAG_OPERATIONS "[operations]"
 #define TAG_PARSER "[parser]"
+#define TAG_PROFILING "[profiling]"
 #define TAG_SCOPING "[scoping]"
 #define TAG_SCRIPTARGS "[scriptargs]"
 #define TAG_SQL "[sql]"